@@ -97,7 +97,7 @@
 int need_arp = 0; /* We set this if we need to listen to arp traffic */
 
 /* Imported */
-extern struct network *reverse;
+extern struct nettable *reverse;
 
 /* Internal */
 
@@ -345,6 +345,10 @@ void arp_recv_cb(u_char *u, const struct pcap_pkthdr *pkthdr, const u_char *pkt)
 		addr_pack(&dst.arp_pa, ADDR_TYPE_IP, IP_ADDR_BITS, &ethip->ar_tpa,
 				IP_ADDR_LEN);
 
+		/* Another worker answers for this address */
+		if (!interface_shard_owns(&dst.arp_pa))
+			return;
+
 		/* Check if we are responsible for this network or address */
 		req = arp_find(&dst.arp_pa);
 		if (network_lookup(reverse, &dst.arp_pa) == NULL && req == NULL )
@@ -362,7 +366,7 @@ void arp_recv_cb(u_char *u, const struct pcap_pkthdr *pkthdr, const u_char *pkt)
 		if (req != NULL && (req->flags & ARP_EXTERNAL))
 			goto ignore;
 
-		tmpl = template_find(addr_ntoa(&dst.arp_pa));
+		tmpl = template_find_addr(&dst.arp_pa);
 
 		/*
 		 * If this template points to an external host,
@@ -1,89 +1,373 @@
-/*This is a slightly modified code snippet from http://en.literateprograms.org/Bloom_filter_%28C%29.
-*/
-#include<limits.h>
-#include<stdarg.h>
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
 
-#include"bloom.h"
+#include <sys/types.h>
+#include <sys/param.h>
 
-#define SETBIT(a, n) (a[n/CHAR_BIT] |= (1<<(n%CHAR_BIT)))
-#define GETBIT(a, n) (a[n/CHAR_BIT] & (1<<(n%CHAR_BIT)))
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
 
-unsigned int sax_hash(const char *key)
+#include <err.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bloom.h"
+
+#define BLOOM_ROTL(x, r)	(((x) << (r)) | ((x) >> (64 - (r))))
+
+static __inline uint64_t
+bloom_fmix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return (h);
+}
+
+/*
+ * Computes two independent 64-bit hashes of the key.  The bits of a
+ * key are at h1 + i * h2 for i < nhashes, which is as good as using
+ * nhashes independent hash functions.
+ */
+
+static void
+bloom_hash(uint64_t seed, const void *key, size_t len,
+    uint64_t *h1, uint64_t *h2)
+{
+	const u_char *p = key;
+	uint64_t a = seed, b = ~seed, w;
+
+	for (; len >= sizeof(w); len -= sizeof(w), p += sizeof(w)) {
+		memcpy(&w, p, sizeof(w));
+		a = BLOOM_ROTL(a ^ (w * 0x87c37b91114253d5ULL), 31) *
+		    0x4cf5ad432745937fULL;
+		b = BLOOM_ROTL(b ^ (w * 0x4cf5ad432745937fULL), 33) *
+		    0x87c37b91114253d5ULL;
+	}
+	if (len) {
+		w = 0;
+		memcpy(&w, p, len);
+		a ^= w * 0x87c37b91114253d5ULL;
+		b ^= w * 0x4cf5ad432745937fULL;
+	}
+
+	*h1 = bloom_fmix(a);
+	/* An odd step visits every bit of a power of two sized filter */
+	*h2 = bloom_fmix(b + *h1) | 1;
+}
+
+int
+bloom_init(struct bloom *bloom, uint64_t capacity, double fprate,
+    uint64_t seed)
+{
+	double bits;
+	uint64_t nbits = 64;
+	int nhashes;
+
+	if (capacity == 0 || fprate <= 0 || fprate >= 1)
+		return (-1);
+
+	/* m = -n ln p / (ln 2)^2, rounded up to a power of two */
+	bits = -(double)capacity * log(fprate) / (M_LN2 * M_LN2);
+	while (nbits < bits && nbits < (1ULL << 40))
+		nbits <<= 1;
+
+	/* k = m / n ln 2 */
+	nhashes = (int)((double)nbits / capacity * M_LN2 + 0.5);
+	nhashes = MAX(1, MIN(nhashes, BLOOM_MAXHASHES));
+
+	memset(bloom, 0, sizeof(struct bloom));
+	if ((bloom->bits = calloc(nbits / 64, sizeof(uint64_t))) == NULL)
+		return (-1);
+	bloom->mask = nbits - 1;
+	bloom->nhashes = nhashes;
+	bloom->seed = seed;
+
+	return (0);
+}
+
+void
+bloom_free(struct bloom *bloom)
+{
+	free(bloom->bits);
+	bloom->bits = NULL;
+}
+
+void
+bloom_clear(struct bloom *bloom)
+{
+	memset(bloom->bits, 0, (bloom->mask + 1) / 8);
+	bloom->nset = 0;
+	bloom->nadded = 0;
+}
+
+void
+bloom_add(struct bloom *bloom, const void *key, size_t len)
+{
+	uint64_t h1, h2, bit, word;
+	u_int i;
+
+	bloom_hash(bloom->seed, key, len, &h1, &h2);
+	for (i = 0; i < bloom->nhashes; i++, h1 += h2) {
+		bit = h1 & bloom->mask;
+		word = 1ULL << (bit & 63);
+		if (!(bloom->bits[bit >> 6] & word)) {
+			bloom->bits[bit >> 6] |= word;
+			bloom->nset++;
+		}
+	}
+	bloom->nadded++;
+}
+
+int
+bloom_check(const struct bloom *bloom, const void *key, size_t len)
+{
+	uint64_t h1, h2, bit;
+	u_int i;
+
+	bloom_hash(bloom->seed, key, len, &h1, &h2);
+	for (i = 0; i < bloom->nhashes; i++, h1 += h2) {
+		bit = h1 & bloom->mask;
+		if (!(bloom->bits[bit >> 6] & (1ULL << (bit & 63))))
+			return (0);
+	}
+
+	return (1);
+}
+
+/* Fraction of bits that are set */
+
+double
+bloom_fill(const struct bloom *bloom)
 {
-  unsigned int h=0;
+	return ((double)bloom->nset / (bloom->mask + 1));
+}
 
-  while(*key) h^=(h<<5)+(h>>2)+(unsigned char)*key++;
+/* Chance that a key that was never added is reported as present */
 
-  return h;
+double
+bloom_fprate(const struct bloom *bloom)
+{
+	return (pow(bloom_fill(bloom), bloom->nhashes));
 }
 
-unsigned int sdbm_hash(const char *key)
+/*
+ * Generational filters hold capacity keys per generation.  A key is
+ * forgotten between (BLOOM_GENERATIONS - 1) and BLOOM_GENERATIONS
+ * intervals after it has been added.
+ */
+
+int
+bloomgen_init(struct bloomgen *bg, uint64_t capacity, double fprate,
+    u_int interval, uint64_t seed)
 {
-  unsigned int h=0;
-  while(*key) h=(unsigned char)*key++ + (h<<6) + (h<<16) - h;
-  return h;
+	int i;
+
+	memset(bg, 0, sizeof(struct bloomgen));
+	for (i = 0; i < BLOOM_GENERATIONS; i++) {
+		if (bloom_init(&bg->gen[i], capacity, fprate, seed) == -1) {
+			while (--i >= 0)
+				bloom_free(&bg->gen[i]);
+			return (-1);
+		}
+	}
+	bg->interval = interval;
+	bg->rotated = time(NULL);
+
+	return (0);
+}
+
+void
+bloomgen_free(struct bloomgen *bg)
+{
+	int i;
+
+	for (i = 0; i < BLOOM_GENERATIONS; i++)
+		bloom_free(&bg->gen[i]);
+}
+
+/*
+ * Clears the oldest generations whose time has come and returns how
+ * many have been cleared.  The current generation also moves on early
+ * when it is full, as its false positive rate would degrade otherwise.
+ */
+
+int
+bloomgen_rotate(struct bloomgen *bg, time_t now)
+{
+	struct bloom *cur = &bg->gen[bg->current];
+	int n = 0;
+
+	while (n < BLOOM_GENERATIONS &&
+	    ((bg->interval && now - bg->rotated >= bg->interval) ||
+		bloom_fill(cur) >= 0.5)) {
+		bg->current = (bg->current + 1) % BLOOM_GENERATIONS;
+		cur = &bg->gen[bg->current];
+		bloom_clear(cur);
+		bg->rotated = bg->interval && now - bg->rotated >= bg->interval ?
+		    bg->rotated + bg->interval : now;
+		n++;
+	}
+	if (n == BLOOM_GENERATIONS)
+		bg->rotated = now;
+
+	return (n);
 }
 
-BLOOM *bloom_create(size_t size) {
- return bloom_create_hash(size,2, sax_hash, sdbm_hash); 
+void
+bloomgen_add(struct bloomgen *bg, const void *key, size_t len)
+{
+	bloom_add(&bg->gen[bg->current], key, len);
 }
 
-BLOOM *bloom_create_hash(size_t size, size_t nfuncs, ...)
+int
+bloomgen_check(const struct bloomgen *bg, const void *key, size_t len)
 {
-  BLOOM *bloom;
-  va_list l;
-  int n;
-  
-  if(!(bloom=malloc(sizeof(BLOOM)))) return NULL;
-  if(!(bloom->a=calloc((size+CHAR_BIT-1)/CHAR_BIT, sizeof(char)))) {
-    free(bloom);
-    return NULL;
-  }
-  if(!(bloom->funcs=(hashfunc_t*)malloc(nfuncs*sizeof(hashfunc_t)))) {
-    free(bloom->a);
-    free(bloom);
-    return NULL;
-  }
+	int i;
 
-  va_start(l, nfuncs);
-  for(n=0; n<nfuncs; ++n) {
-    bloom->funcs[n]=va_arg(l, hashfunc_t);
-  }
-  va_end(l);
+	for (i = 0; i < BLOOM_GENERATIONS; i++)
+		if (bg->gen[i].nadded && bloom_check(&bg->gen[i], key, len))
+			return (1);
 
-  bloom->nfuncs=nfuncs;
-  bloom->asize=size;
+	return (0);
+}
+
+uint64_t
+bloomgen_count(const struct bloomgen *bg)
+{
+	uint64_t count = 0;
+	int i;
 
-  return bloom;
+	for (i = 0; i < BLOOM_GENERATIONS; i++)
+		count += bg->gen[i].nadded;
+
+	return (count);
 }
 
-int bloom_destroy(BLOOM *bloom)
+double
+bloomgen_fprate(const struct bloomgen *bg)
 {
-  free(bloom->a);
-  free(bloom->funcs);
-  free(bloom);
+	double pass = 1;
+	int i;
+
+	for (i = 0; i < BLOOM_GENERATIONS; i++)
+		pass *= 1 - bloom_fprate(&bg->gen[i]);
 
-  return 0;
+	return (1 - pass);
 }
 
-int bloom_add(BLOOM *bloom, const char *s)
+/* Unittests */
+
+static void
+bloom_test_rate(void)
 {
-  size_t n;
+	struct bloom bloom;
+	uint32_t key[4] = { 0x20010db8, 0, 0, 0 };
+	int i, fp = 0;
+
+	if (bloom_init(&bloom, 10000, 0.01, 1) == -1)
+		errx(1, "%s: bloom_init", __func__);
 
-  for(n=0; n<bloom->nfuncs; ++n) {
-    SETBIT(bloom->a, bloom->funcs[n](s)%bloom->asize);
-  }
+	for (i = 0; i < 10000; i++) {
+		key[3] = i;
+		bloom_add(&bloom, key, sizeof(key));
+	}
+	for (i = 0; i < 10000; i++) {
+		key[3] = i;
+		if (!bloom_check(&bloom, key, sizeof(key)))
+			errx(1, "%s: lost key %d", __func__, i);
+	}
 
-  return 0;
+	/* Keys that differ in the first word only */
+	for (i = 0; i < 100000; i++) {
+		key[0] = i + 1;
+		key[3] = 0;
+		fp += bloom_check(&bloom, key, sizeof(key));
+	}
+	if (fp > 1000)
+		errx(1, "%s: %d false positives in 100000", __func__, fp);
+	if (bloom_fprate(&bloom) > 0.01)
+		errx(1, "%s: estimated rate %f", __func__,
+		    bloom_fprate(&bloom));
+
+	bloom_free(&bloom);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
 }
 
-int bloom_check(BLOOM *bloom, const char *s)
+static void
+bloom_test_rotate(void)
 {
-  size_t n;
+	struct bloomgen bg;
+	uint32_t key = 1;
+	time_t now;
+
+	if (bloomgen_init(&bg, 1000, 0.01, 60, 2) == -1)
+		errx(1, "%s: bloomgen_init", __func__);
+	now = bg.rotated;
+
+	bloomgen_add(&bg, &key, sizeof(key));
+	if (!bloomgen_check(&bg, &key, sizeof(key)))
+		errx(1, "%s: key missing", __func__);
 
-  for(n=0; n<bloom->nfuncs; ++n) {
-    if(!(GETBIT(bloom->a, bloom->funcs[n](s)%bloom->asize))) return 0;
-  }
+	/* The key survives all but the last rotation */
+	if (bloomgen_rotate(&bg, now + 59) != 0)
+		errx(1, "%s: early rotation", __func__);
+	if (bloomgen_rotate(&bg, now + 60 * (BLOOM_GENERATIONS - 1)) !=
+	    BLOOM_GENERATIONS - 1)
+		errx(1, "%s: missed rotations", __func__);
+	if (!bloomgen_check(&bg, &key, sizeof(key)))
+		errx(1, "%s: key forgotten early", __func__);
+	if (bloomgen_rotate(&bg, now + 60 * BLOOM_GENERATIONS) != 1)
+		errx(1, "%s: missed last rotation", __func__);
+	if (bloomgen_check(&bg, &key, sizeof(key)))
+		errx(1, "%s: key not forgotten", __func__);
 
-  return 1;
+	bloomgen_free(&bg);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
+
+void
+bloom_test(void)
+{
+	bloom_test_rate();
+	bloom_test_rotate();
 }
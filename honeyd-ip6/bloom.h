@@ -1,23 +1,82 @@
-#ifndef __BLOOM_H__
-#define __BLOOM_H__
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
 
-#include<stdlib.h>
+#ifndef _BLOOM_H_
+#define _BLOOM_H_
 
-typedef unsigned int (*hashfunc_t)(const char *);
-typedef struct {
-  size_t asize;
-  unsigned char *a;
-  size_t nfuncs;
-  hashfunc_t *funcs;
-} BLOOM;
+/*
+ * Bloom filters over binary keys.  The number of bits and hashes is
+ * derived from the number of keys the filter should hold and the false
+ * positive rate that is acceptable at that point.  A generational
+ * filter spreads its keys over several filters and clears the oldest
+ * one at regular intervals, so that keys are forgotten again.
+ */
 
-BLOOM *bloom_create(size_t size);
-BLOOM *bloom_create_hash(size_t size, size_t nfuncs, ...);
-int bloom_destroy(BLOOM *bloom);
-int bloom_add(BLOOM *bloom, const char *s);
-int bloom_check(BLOOM *bloom, const char *s);
+#define BLOOM_MAXHASHES		16
+#define BLOOM_GENERATIONS	4
 
-unsigned int sax_hash(const char *key);
-unsigned int sdbm_hash(const char *key);
+struct bloom {
+	uint64_t *bits;
+	uint64_t mask;			/* number of bits - 1 */
+	u_int nhashes;
+	uint64_t seed;
 
-#endif
+	uint64_t nset;			/* bits that are set */
+	uint64_t nadded;
+};
+
+struct bloomgen {
+	struct bloom gen[BLOOM_GENERATIONS];
+	u_int current;			/* generation that takes new keys */
+	u_int interval;			/* seconds until the next rotation */
+	time_t rotated;
+};
+
+int bloom_init(struct bloom *, uint64_t, double, uint64_t);
+void bloom_free(struct bloom *);
+void bloom_clear(struct bloom *);
+void bloom_add(struct bloom *, const void *, size_t);
+int bloom_check(const struct bloom *, const void *, size_t);
+double bloom_fill(const struct bloom *);
+double bloom_fprate(const struct bloom *);
+
+int bloomgen_init(struct bloomgen *, uint64_t, double, u_int, uint64_t);
+void bloomgen_free(struct bloomgen *);
+int bloomgen_rotate(struct bloomgen *, time_t);
+void bloomgen_add(struct bloomgen *, const void *, size_t);
+int bloomgen_check(const struct bloomgen *, const void *, size_t);
+uint64_t bloomgen_count(const struct bloomgen *);
+double bloomgen_fprate(const struct bloomgen *);
+
+void bloom_test(void);
+
+#endif /* _BLOOM_H_ */
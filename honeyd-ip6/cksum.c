@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Internet checksum (RFC 1071) for everything that honeyd sends or
+ * verifies.  The sum is formed over native 16-bit words, which makes
+ * it independent of the byte order, and is accumulated in wide words
+ * so that the carries only have to be folded in at the very end.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <err.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dnet.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "cksum.h"
+
+/* Folds a 64-bit accumulator down to at most 16 bits */
+static __inline uint32_t
+cksum_fold(uint64_t acc)
+{
+	acc = (acc >> 32) + (acc & 0xffffffff);
+	acc = (acc >> 32) + (acc & 0xffffffff);
+	acc = (acc >> 16) + (acc & 0xffff);
+	acc = (acc >> 16) + (acc & 0xffff);
+	return ((uint32_t)acc);
+}
+
+#if defined(__AVX2__)
+/*
+ * Every 32-bit word is widened to 64 bits before it is added, so the
+ * lanes can not overflow for any packet that fits into memory.
+ */
+static uint64_t
+cksum_add_simd(const u_char **pp, size_t *plen)
+{
+	const u_char *p = *pp;
+	size_t n = *plen / 32;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i acc0 = zero, acc1 = zero, v;
+	uint64_t lanes[4];
+
+	for (; n; n--, p += 32) {
+		v = _mm256_loadu_si256((const __m256i *)p);
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
+	}
+	_mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(acc0, acc1));
+
+	*plen -= p - *pp;
+	*pp = p;
+	return (cksum_fold(lanes[0]) + cksum_fold(lanes[1]) +
+	    cksum_fold(lanes[2]) + cksum_fold(lanes[3]));
+}
+#define CKSUM_SIMD_MIN	64
+#elif defined(__SSE2__)
+static uint64_t
+cksum_add_simd(const u_char **pp, size_t *plen)
+{
+	const u_char *p = *pp;
+	size_t n = *plen / 16;
+	__m128i zero = _mm_setzero_si128();
+	__m128i acc0 = zero, acc1 = zero, v;
+	uint64_t lanes[2];
+
+	for (; n; n--, p += 16) {
+		v = _mm_loadu_si128((const __m128i *)p);
+		acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, zero));
+		acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, zero));
+	}
+	_mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(acc0, acc1));
+
+	*plen -= p - *pp;
+	*pp = p;
+	return (cksum_fold(lanes[0]) + cksum_fold(lanes[1]));
+}
+#define CKSUM_SIMD_MIN	64
+#endif
+
+/*
+ * Adds the buffer to a running sum.  The result is kept below 17 bits
+ * so that callers may add a few more words before they fold it.
+ */
+
+uint32_t
+cksum_add(const void *buf, size_t len, uint32_t sum)
+{
+	const u_char *p = buf;
+	uint64_t acc = sum;
+	uint32_t w32;
+	uint16_t w16;
+
+#ifdef CKSUM_SIMD_MIN
+	if (len >= CKSUM_SIMD_MIN)
+		acc += cksum_add_simd(&p, &len);
+#endif
+
+	for (; len >= 8; len -= 8, p += 8) {
+		uint32_t a, b;
+
+		memcpy(&a, p, sizeof(a));
+		memcpy(&b, p + 4, sizeof(b));
+		acc += (uint64_t)a + b;
+	}
+	if (len >= 4) {
+		memcpy(&w32, p, sizeof(w32));
+		acc += w32;
+		p += 4;
+		len -= 4;
+	}
+	if (len >= 2) {
+		memcpy(&w16, p, sizeof(w16));
+		acc += w16;
+		p += 2;
+		len -= 2;
+	}
+	if (len) {
+		/* The odd byte is padded with a zero byte on the right */
+		u_char pad[2] = { p[0], 0 };
+
+		memcpy(&w16, pad, sizeof(w16));
+		acc += w16;
+	}
+
+	return (cksum_fold(acc));
+}
+
+/*
+ * Locates the upper layer header of a packet that carries a checksum
+ * and returns the sum over its pseudo header.  Returns -1 if there is
+ * no such header, e.g. for fragments or truncated packets.
+ */
+
+static int
+cksum_transport(const u_char *pkt, size_t len, u_char *pproto,
+    size_t *poff, uint32_t *psum)
+{
+	const struct ip_hdr *ip = (const struct ip_hdr *)pkt;
+	const struct ip6_hdr *ip6 = (const struct ip6_hdr *)pkt;
+	const struct ip6_ext_hdr *ext;
+	size_t off, min;
+	u_char nxt;
+
+	if (len < IP_HDR_LEN)
+		return (-1);
+
+	if (ip->ip_v == 4) {
+		off = ip->ip_hl << 2;
+		if (off > len || (ntohs(ip->ip_off) & (IP_MF|IP_OFFMASK)))
+			return (-1);
+		nxt = ip->ip_p;
+		if (nxt == IP_PROTO_TCP || nxt == IP_PROTO_UDP)
+			*psum = cksum_add(&ip->ip_src, 2 * IP_ADDR_LEN,
+			    htons((u_short)(nxt + len - off)));
+		else if (nxt == IP_PROTO_ICMP || nxt == IP_PROTO_IGMP)
+			*psum = 0;
+		else
+			return (-1);
+	} else if (ip->ip_v == 6) {
+		if (len < IP6_HDR_LEN)
+			return (-1);
+		off = IP6_HDR_LEN;
+		nxt = ip6->ip6_nxt;
+		while (nxt == IP_PROTO_HOPOPTS || nxt == IP_PROTO_ROUTING ||
+		    nxt == IP_PROTO_DSTOPTS) {
+			if (off + 2 > len)
+				return (-1);
+			ext = (const struct ip6_ext_hdr *)(pkt + off);
+			nxt = ext->ext_nxt;
+			off += (ext->ext_len + 1) << 3;
+		}
+		if (off > len)
+			return (-1);
+		if (nxt == IP_PROTO_TCP || nxt == IP_PROTO_UDP ||
+		    nxt == IP_PROTO_ICMPV6)
+			*psum = cksum_add(&ip6->ip6_src, 2 * IP6_ADDR_LEN,
+			    htons((u_short)(nxt + len - off)));
+		else
+			return (-1);
+	} else
+		return (-1);
+
+	switch (nxt) {
+	case IP_PROTO_TCP:
+		min = TCP_HDR_LEN;
+		break;
+	case IP_PROTO_UDP:
+		min = UDP_HDR_LEN;
+		break;
+	default:
+		min = ICMP_HDR_LEN;
+		break;
+	}
+	if (len - off < min)
+		return (-1);
+
+	*pproto = nxt;
+	*poff = off;
+	return (0);
+}
+
+/* Returns the offset of the checksum field within the upper layer header */
+
+static __inline size_t
+cksum_field(u_char proto)
+{
+	switch (proto) {
+	case IP_PROTO_TCP:
+		return (offsetof(struct tcp_hdr, th_sum));
+	case IP_PROTO_UDP:
+		return (offsetof(struct udp_hdr, uh_sum));
+	default:
+		return (offsetof(struct icmp_hdr, icmp_cksum));
+	}
+}
+
+void
+cksum_ip_hdr(struct ip_hdr *ip)
+{
+	ip->ip_sum = 0;
+	ip->ip_sum = cksum_carry(cksum_add(ip, ip->ip_hl << 2, 0));
+}
+
+/* Computes the upper layer checksum of an IPv4 or IPv6 packet */
+
+static void
+cksum_upper(u_char *pkt, size_t len)
+{
+	uint32_t sum;
+	uint16_t cksum;
+	size_t off;
+	u_char proto, *p;
+
+	if (cksum_transport(pkt, len, &proto, &off, &sum) == -1)
+		return;
+
+	p = pkt + off + cksum_field(proto);
+	memset(p, 0, sizeof(cksum));
+	cksum = cksum_carry(cksum_add(pkt + off, len - off, sum));
+	if (proto == IP_PROTO_UDP && !cksum)
+		cksum = 0xffff;		/* RFC 768 */
+	memcpy(p, &cksum, sizeof(cksum));
+}
+
+/*
+ * Drop-in replacements for ip_checksum() and ip6_checksum() from
+ * libdnet.  IPv6 fragments are left alone, the checksum has to be
+ * computed before the packet is fragmented.
+ */
+
+void
+cksum_ip(struct ip_hdr *ip, size_t len)
+{
+	if (len < IP_HDR_LEN)
+		return;
+
+	cksum_ip_hdr(ip);
+	cksum_upper((u_char *)ip, len);
+}
+
+void
+cksum_ip6(struct ip6_hdr *ip6, size_t len)
+{
+	cksum_upper((u_char *)ip6, len);
+}
+
+/*
+ * Returns 1 if the upper layer checksum of a received packet is
+ * correct or can not be checked, and 0 otherwise.  The packet is not
+ * modified.  A zero UDP checksum means that none was computed.
+ */
+
+int
+cksum_verify(const void *pkt, size_t len)
+{
+	const u_char *p = pkt;
+	uint32_t sum;
+	uint16_t cksum;
+	size_t off;
+	u_char proto;
+
+	if (cksum_transport(p, len, &proto, &off, &sum) == -1)
+		return (1);
+
+	memcpy(&cksum, p + off + cksum_field(proto), sizeof(cksum));
+	if (proto == IP_PROTO_UDP && !cksum)
+		return (1);
+
+	return (cksum_carry(cksum_add(p + off, len - off, sum)) == 0);
+}
+
+/*
+ * Sets the TTL of an IPv4 packet and updates the header checksum
+ * incrementally.  A packet that had a valid checksum keeps it.
+ */
+
+void
+cksum_ip_ttl(struct ip_hdr *ip, u_char ttl)
+{
+	uint16_t old, new;
+
+	old = htons(ip->ip_ttl << 8 | ip->ip_p);
+	new = htons(ttl << 8 | ip->ip_p);
+	ip->ip_ttl = ttl;
+	ip->ip_sum = cksum_update16(ip->ip_sum, old, new);
+}
+
+/* Unittests */
+
+/* Straight from RFC 1071, one 16-bit word at a time */
+static uint16_t
+cksum_reference(const u_char *p, size_t len, uint32_t sum)
+{
+	uint16_t w;
+
+	for (; len > 1; len -= 2, p += 2) {
+		memcpy(&w, p, sizeof(w));
+		sum += w;
+	}
+	if (len) {
+		u_char pad[2] = { p[0], 0 };
+		memcpy(&w, pad, sizeof(w));
+		sum += w;
+	}
+	while (sum >> 16)
+		sum = (sum >> 16) + (sum & 0xffff);
+	return (~sum & 0xffff);
+}
+
+static void
+cksum_test_sum(void)
+{
+	u_char buf[1601];
+	size_t len, off;
+
+	for (len = 0; len < sizeof(buf); len++)
+		buf[len] = random();
+	/* Saturated words exercise the carries */
+	memset(buf + 1024, 0xff, 256);
+
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len + off <= sizeof(buf); len += 1 + len / 8) {
+			uint16_t a = cksum_carry(cksum_add(buf + off, len, 0));
+			uint16_t b = cksum_reference(buf + off, len, 0);
+			if (a != b)
+				errx(1, "%s: sum of %u bytes at %u: %04x != %04x",
+				    __func__, (u_int)len, (u_int)off, a, b);
+		}
+	}
+
+	/* Running sums may be continued */
+	if (cksum_carry(cksum_add(buf + 100, 900,
+		cksum_add(buf, 100, 0x1ffff))) !=
+	    cksum_reference(buf, 1000, 0x1ffff))
+		errx(1, "%s: running sum failed", __func__);
+}
+
+static void
+cksum_test_packet(void)
+{
+	u_char pkt[IP6_HDR_LEN + 8 + TCP_HDR_LEN + 333];
+	struct ip_hdr *ip = (struct ip_hdr *)pkt;
+	struct ip6_hdr *ip6 = (struct ip6_hdr *)pkt;
+	struct ip6_ext_hdr *ext;
+	struct tcp_hdr *tcp;
+	struct udp_hdr *udp;
+	struct addr src, dst;
+	size_t len;
+	uint16_t sum;
+	int i;
+
+	for (i = 0; i < sizeof(pkt); i++)
+		pkt[i] = random();
+
+	/* TCP over IPv4 */
+	addr_pton("10.0.0.1", &src);
+	addr_pton("192.168.1.77", &dst);
+	len = IP_HDR_LEN + TCP_HDR_LEN + 333;
+	ip_pack_hdr(pkt, 0, len, 0x1234, 0, 64, IP_PROTO_TCP,
+	    src.addr_ip, dst.addr_ip);
+	tcp = (struct tcp_hdr *)(pkt + IP_HDR_LEN);
+	tcp->th_off = TCP_HDR_LEN >> 2;
+	cksum_ip(ip, len);
+	if (cksum_carry(cksum_add(ip, IP_HDR_LEN, 0)) != 0)
+		errx(1, "%s: bad IPv4 header checksum", __func__);
+	if (!cksum_verify(pkt, len))
+		errx(1, "%s: TCP checksum does not verify", __func__);
+
+	/* Incremental updates keep the packet valid */
+	for (i = 255; i >= 0; i--) {
+		cksum_ip_ttl(ip, i);
+		if (cksum_carry(cksum_add(ip, IP_HDR_LEN, 0)) != 0)
+			errx(1, "%s: TTL %d breaks the checksum", __func__, i);
+	}
+	sum = tcp->th_sum;
+	tcp->th_sum = cksum_update32(tcp->th_sum, tcp->th_seq,
+	    htonl(0xdeadbeef));
+	tcp->th_seq = htonl(0xdeadbeef);
+	if (!cksum_verify(pkt, len))
+		errx(1, "%s: sequence number update failed", __func__);
+
+	pkt[len - 1] ^= 0x10;
+	if (cksum_verify(pkt, len))
+		errx(1, "%s: corrupted TCP segment verifies", __func__);
+	pkt[len - 1] ^= 0x10;
+
+	/* Fragments are not touched */
+	ip->ip_off = htons(IP_MF);
+	tcp->th_sum = sum;
+	cksum_ip(ip, len);
+	if (tcp->th_sum != sum)
+		errx(1, "%s: fragment was checksummed", __func__);
+	ip->ip_off = 0;
+
+	/* UDP never carries a zero checksum */
+	ip->ip_p = IP_PROTO_UDP;
+	udp = (struct udp_hdr *)tcp;
+	for (i = 0; i < 2; i++) {
+		uint32_t ulen;
+
+		cksum_ip(ip, len);
+		if (udp->uh_sum == 0 || !cksum_verify(pkt, len))
+			errx(1, "%s: bad UDP checksum", __func__);
+		/* Add the checksum to the data so that it sums up to zero */
+		ulen = udp->uh_ulen + udp->uh_sum;
+		udp->uh_ulen = (ulen & 0xffff) + (ulen >> 16);
+	}
+	if (udp->uh_sum != 0xffff)
+		errx(1, "%s: zero UDP checksum was sent", __func__);
+	udp->uh_sum = 0;
+	if (!cksum_verify(pkt, len))
+		errx(1, "%s: zero UDP checksum is not ignored", __func__);
+
+	/* TCP over IPv6 behind a destination options header */
+	addr_pton("2001:db8::1", &src);
+	addr_pton("2001:db8:1::42", &dst);
+	len = sizeof(pkt);
+	ip6_pack_hdr(pkt, 0, 0, len - IP6_HDR_LEN, IP_PROTO_DSTOPTS, 64,
+	    src.addr_ip6, dst.addr_ip6);
+	ext = (struct ip6_ext_hdr *)(pkt + IP6_HDR_LEN);
+	ext->ext_nxt = IP_PROTO_TCP;
+	ext->ext_len = 0;
+	cksum_ip6(ip6, len);
+	if (!cksum_verify(pkt, len))
+		errx(1, "%s: IPv6 TCP checksum does not verify", __func__);
+	tcp = (struct tcp_hdr *)(pkt + IP6_HDR_LEN + 8);
+	tcp->th_sport ^= 1;
+	if (cksum_verify(pkt, len))
+		errx(1, "%s: corrupted IPv6 segment verifies", __func__);
+}
+
+void
+cksum_test(void)
+{
+	cksum_test_sum();
+	cksum_test_packet();
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
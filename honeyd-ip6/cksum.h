@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _CKSUM_H_
+#define _CKSUM_H_
+
+/* One's complement sum of a buffer, accumulated onto sum */
+uint32_t cksum_add(const void *, size_t, uint32_t);
+
+/* Folds a sum into the final 16-bit checksum */
+static __inline uint16_t
+cksum_carry(uint32_t sum)
+{
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum += sum >> 16;
+	return (~sum & 0xffff);
+}
+
+/*
+ * Incremental update of a checksum after a 16-bit word of the data
+ * changed from old to new, RFC 1624 equation 3.  All values are in
+ * network byte order.
+ */
+static __inline uint16_t
+cksum_update16(uint16_t cksum, uint16_t old, uint16_t new)
+{
+	uint32_t sum = (uint16_t)~cksum + (uint16_t)~old + new;
+
+	return (cksum_carry(sum));
+}
+
+static __inline uint16_t
+cksum_update32(uint16_t cksum, uint32_t old, uint32_t new)
+{
+	uint32_t sum = (uint16_t)~cksum;
+
+	sum += (uint16_t)~(old >> 16) + (uint16_t)~(old & 0xffff);
+	sum += (new >> 16) + (new & 0xffff);
+	return (cksum_carry(sum));
+}
+
+void cksum_ip_hdr(struct ip_hdr *);
+void cksum_ip(struct ip_hdr *, size_t);
+void cksum_ip6(struct ip6_hdr *, size_t);
+int cksum_verify(const void *, size_t);
+
+void cksum_ip_ttl(struct ip_hdr *, u_char);
+
+void cksum_test(void);
+
+#endif /* _CKSUM_H_ */
@@ -215,7 +215,6 @@ void cmd_environment(struct template *tmpl, struct tuple *hdr)
 {
 	char line[256];
 	struct addr addr;
-	struct ip_hdr ip;
 	char *os_name;
 
 	if (tmpl->person != NULL )
@@ -228,8 +227,7 @@ void cmd_environment(struct template *tmpl, struct tuple *hdr)
 		return;
 
 	/* Determine the remote operating system */
-	ip.ip_src = hdr->ip_src;
-	os_name = honeyd_osfp_name(&ip);
+	os_name = honeyd_osfp_name(hdr);
 	if (os_name != NULL )
 	{
 		setenv("HONEYD_REMOTE_OS", os_name, 1);
@@ -68,17 +68,20 @@
 #include "pfvar.h"
 #include "osfp.h"
 
+/* The version nibble is at the same place in IPv4 and IPv6 */
+#define IP_VERSION(pkt)	((pkt)[0] >> 4)
+
 /*
  * Match an operating system (p0f) fingerprint
  */
 
 int
-condition_match_osfp(const struct template *tmpl, const struct ip_hdr *ip,
+condition_match_osfp(const struct template *tmpl, const u_char *pkt,
     u_short iplen, void *arg)
 {
 	pf_osfp_t fp = *(pf_osfp_t *)arg;
 
-	return (honeyd_osfp_match(ip, fp));
+	return (honeyd_osfp_match(pkt, iplen, fp));
 }
 
 /*
@@ -86,12 +89,27 @@ condition_match_osfp(const struct template *tmpl, const struct ip_hdr *ip,
  */
 
 int
-condition_match_addr(const struct template *tmpl, const struct ip_hdr *ip,
+condition_match_addr(const struct template *tmpl, const u_char *pkt,
     u_short iplen, void *arg)
 {
+	const struct ip_hdr *ip = (const struct ip_hdr *)pkt;
+	const struct ip6_hdr *ip6 = (const struct ip6_hdr *)pkt;
 	struct addr *tmp = arg;
 	struct addr addr_start, addr_end, src;
 
+	/* IPv6 sources are matched by prefix, addr_bcast is IPv4 only */
+	if (iplen >= IP6_HDR_LEN && IP_VERSION(pkt) == 6) {
+		if (tmp->addr_type != ADDR_TYPE_IP6)
+			return (0);
+		addr_pack(&src, ADDR_TYPE_IP6, tmp->addr_bits,
+		    &ip6->ip6_src, IP6_ADDR_LEN);
+		addr_net(&src, &addr_start);
+		addr_net(tmp, &addr_end);
+		return (addr_cmp(&addr_start, &addr_end) == 0);
+	}
+	if (iplen < IP_HDR_LEN || IP_VERSION(pkt) != 4)
+		return (0);
+
 	addr_pack(&src, ADDR_TYPE_IP, IP_ADDR_BITS, &ip->ip_src, IP_ADDR_LEN);
 
 	addr_start = *tmp;
@@ -113,11 +131,19 @@ condition_match_addr(const struct template *tmpl, const struct ip_hdr *ip,
  */
 
 int
-condition_match_proto(const struct template *tmpl, const struct ip_hdr *ip,
+condition_match_proto(const struct template *tmpl, const u_char *pkt,
     u_short iplen, void *arg)
 {
 	int *proto = arg;
-	return (ip->ip_p == *proto);
+	struct ip6_desc desc;
+
+	if (iplen < IP_HDR_LEN)
+		return (0);
+	if (IP_VERSION(pkt) == 6) {
+		ip6_desc_parse(&desc, (struct ip6_hdr *)pkt, iplen);
+		return (desc.proto == *proto);
+	}
+	return (((const struct ip_hdr *)pkt)->ip_p == *proto);
 }
 
 /*
@@ -125,7 +151,7 @@ condition_match_proto(const struct template *tmpl, const struct ip_hdr *ip,
  */
 
 int
-condition_match_otherwise(const struct template *tmpl, const struct ip_hdr *ip,
+condition_match_otherwise(const struct template *tmpl, const u_char *pkt,
     u_short iplen, void *arg)
 {
 	return 1;
@@ -146,7 +172,7 @@ daysec(const struct tm *tm)
  */
 
 int
-condition_match_time(const struct template *tmpl, const struct ip_hdr *ip,
+condition_match_time(const struct template *tmpl, const u_char *pkt,
     u_short iplen, void *arg)
 {
 	time_t tmp;
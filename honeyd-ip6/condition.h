@@ -34,7 +34,6 @@
 #define _CONDITION_
 
 struct template;
-struct ip_hdr;
 
 /* Conditonal template container */
 
@@ -42,7 +41,8 @@ struct condition
 {
 	TAILQ_ENTRY(condition) next;
 
-	int (*match)(const struct template *, const struct ip_hdr *, u_short,
+	/* Gets the IPv4 or IPv6 packet and its length */
+	int (*match)(const struct template *, const u_char *, u_short,
 			void *);
 	void *match_arg;
 	size_t match_arglen;
@@ -57,15 +57,15 @@ struct condition_time
 	struct tm tm_end;
 };
 
-int condition_match_osfp(const struct template *, const struct ip_hdr *,
+int condition_match_osfp(const struct template *, const u_char *,
 		u_short, void *);
-int condition_match_addr(const struct template *, const struct ip_hdr *,
+int condition_match_addr(const struct template *, const u_char *,
 		u_short, void *);
-int condition_match_time(const struct template *, const struct ip_hdr *,
+int condition_match_time(const struct template *, const u_char *,
 		u_short, void *);
-int condition_match_proto(const struct template *, const struct ip_hdr *,
+int condition_match_proto(const struct template *, const u_char *,
 		u_short, void *);
-int condition_match_otherwise(const struct template *, const struct ip_hdr *,
+int condition_match_otherwise(const struct template *, const u_char *,
 		u_short, void *);
 
 #endif /* _CONDITION_ */
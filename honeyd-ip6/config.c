@@ -74,9 +74,11 @@
 #include "arp.h"
 #include "icmp6.h"
 #include "pool.h"
+#include "pktbuf.h"
 #include "dhcpclient.h"
 #include "util.h"
 #include "log.h"
+#include "cksum.h"
 
 /* Tailq that holds all subsystems */
 struct subsystemqueue subsystems;
@@ -95,6 +97,266 @@ templ_compare(struct template *a, struct template *b)
 
 SPLAY_GENERATE(templtree, template, node, templ_compare);
 
+/*
+ * Templates that are named after an IP address are also kept in an
+ * open addressing hash table keyed on the raw address, so that the
+ * packet path does not need to format addresses as strings and walk
+ * the splay tree.  The tree remains the authoritative index for names.
+ */
+
+#define TEMPLATE_INDEX_MINSIZE	256
+
+static struct template **templ_index;
+static u_int templ_index_size;		/* always a power of two */
+static u_int templ_index_count;		/* live entries */
+static u_int templ_index_used;		/* live entries and tombstones */
+static struct template templ_index_tombstone;
+static struct template *templ_default;	/* the "default" template */
+
+static __inline uint32_t
+templ_index_hash(const struct addr *addr)
+{
+	uint32_t h;
+
+	if (addr->addr_type == ADDR_TYPE_IP)
+		h = addr->addr_data32[0];
+	else
+		h = addr->addr_data32[0] ^ addr->addr_data32[1] ^
+		    addr->addr_data32[2] ^ addr->addr_data32[3];
+
+	/* Finalizer from MurmurHash3 to spread the low bits */
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+
+	return (h);
+}
+
+static __inline int
+templ_index_match(const struct template *tmpl, const struct addr *addr)
+{
+	if (tmpl->addr.addr_type != addr->addr_type)
+		return (0);
+	if (addr->addr_type == ADDR_TYPE_IP)
+		return (tmpl->addr.addr_ip == addr->addr_ip);
+	return (memcmp(&tmpl->addr.addr_ip6, &addr->addr_ip6,
+		    IP6_ADDR_LEN) == 0);
+}
+
+/* Computes the binary key of a template; ADDR_TYPE_NONE if there is none */
+
+static void
+templ_index_key(struct template *tmpl)
+{
+	struct addr *addr = &tmpl->addr;
+
+	if (addr_pton(tmpl->name, addr) == -1 ||
+	    (addr->addr_type == ADDR_TYPE_IP &&
+		addr->addr_bits != IP_ADDR_BITS) ||
+	    (addr->addr_type == ADDR_TYPE_IP6 &&
+		addr->addr_bits != IP6_ADDR_BITS) ||
+	    (addr->addr_type != ADDR_TYPE_IP &&
+		addr->addr_type != ADDR_TYPE_IP6))
+		memset(addr, 0, sizeof(struct addr));
+}
+
+static void
+templ_index_resize(u_int size)
+{
+	struct template **old = templ_index;
+	u_int i, oldsize = templ_index_size;
+
+	if ((templ_index = calloc(size, sizeof(struct template *))) == NULL)
+		err(1, "%s: calloc", __func__);
+	templ_index_size = size;
+	templ_index_used = templ_index_count;
+
+	for (i = 0; i < oldsize; i++) {
+		struct template *tmpl = old[i];
+		u_int slot;
+
+		if (tmpl == NULL || tmpl == &templ_index_tombstone)
+			continue;
+
+		slot = templ_index_hash(&tmpl->addr) & (size - 1);
+		while (templ_index[slot] != NULL)
+			slot = (slot + 1) & (size - 1);
+		templ_index[slot] = tmpl;
+	}
+
+	free(old);
+}
+
+static void
+templ_index_insert(struct template *tmpl)
+{
+	u_int slot;
+
+	if (strcmp(tmpl->name, "default") == 0)
+		templ_default = tmpl;
+
+	templ_index_key(tmpl);
+	if (tmpl->addr.addr_type == ADDR_TYPE_NONE)
+		return;
+
+	/* Keep the load factor including tombstones below one half */
+	if ((templ_index_used + 1) * 2 > templ_index_size) {
+		u_int size = templ_index_size ?
+		    templ_index_size : TEMPLATE_INDEX_MINSIZE;
+		while ((templ_index_count + 1) * 2 > size)
+			size <<= 1;
+		templ_index_resize(size);
+	}
+
+	slot = templ_index_hash(&tmpl->addr) & (templ_index_size - 1);
+	while (templ_index[slot] != NULL &&
+	    templ_index[slot] != &templ_index_tombstone)
+		slot = (slot + 1) & (templ_index_size - 1);
+
+	if (templ_index[slot] == NULL)
+		templ_index_used++;
+	templ_index[slot] = tmpl;
+	templ_index_count++;
+}
+
+static void
+templ_index_remove(struct template *tmpl)
+{
+	u_int slot;
+
+	if (templ_default == tmpl)
+		templ_default = NULL;
+
+	if (tmpl->addr.addr_type == ADDR_TYPE_NONE || templ_index == NULL)
+		return;
+
+	slot = templ_index_hash(&tmpl->addr) & (templ_index_size - 1);
+	while (templ_index[slot] != NULL) {
+		if (templ_index[slot] == tmpl) {
+			templ_index[slot] = &templ_index_tombstone;
+			templ_index_count--;
+			return;
+		}
+		slot = (slot + 1) & (templ_index_size - 1);
+	}
+}
+
+/*
+ * A solicited-node multicast address carries nothing but the low 24 bits
+ * of the addresses it stands for, RFC 4291.  Templates that answer
+ * neighbor solicitations are hashed by these bits and chained through
+ * the template, so that a solicitation finds its members directly.
+ */
+
+#define TEMPLATE_SOLNODE_MINSIZE	256
+
+#define SOLNODE_SUFFIX(a)	((a)->addr_data8[13] << 16 | \
+				    (a)->addr_data8[14] << 8 | \
+				    (a)->addr_data8[15])
+
+LIST_HEAD(solnodelist, template);
+
+static struct solnodelist *templ_solnode;
+static u_int templ_solnode_size;		/* always a power of two */
+static u_int templ_solnode_count;
+
+static __inline u_int
+templ_solnode_slot(uint32_t suffix, u_int size)
+{
+	/* Fibonacci hashing; the low bits of the product mix poorly */
+	return ((suffix * 0x9e3779b1U) >> 8 & (size - 1));
+}
+
+static void
+templ_solnode_resize(u_int size)
+{
+	struct solnodelist *old = templ_solnode;
+	struct template *tmpl;
+	u_int i;
+
+	if ((templ_solnode = calloc(size, sizeof(struct solnodelist))) == NULL)
+		err(1, "%s: calloc", __func__);
+
+	for (i = 0; i < templ_solnode_size; i++) {
+		while ((tmpl = LIST_FIRST(&old[i])) != NULL) {
+			LIST_REMOVE(tmpl, solnode);
+			LIST_INSERT_HEAD(&templ_solnode[templ_solnode_slot(
+			    SOLNODE_SUFFIX(&tmpl->addr), size)], tmpl, solnode);
+		}
+	}
+	templ_solnode_size = size;
+
+	free(old);
+}
+
+static void
+templ_solnode_insert(struct template *tmpl)
+{
+	struct solnodelist *head;
+
+	if (tmpl->addr.addr_type != ADDR_TYPE_IP6 ||
+	    (tmpl->flags & TEMPLATE_SOLNODE))
+		return;
+
+	if (templ_solnode_count + 1 > templ_solnode_size)
+		templ_solnode_resize(templ_solnode_size ?
+		    templ_solnode_size << 1 : TEMPLATE_SOLNODE_MINSIZE);
+
+	head = &templ_solnode[templ_solnode_slot(SOLNODE_SUFFIX(&tmpl->addr),
+		templ_solnode_size)];
+	LIST_INSERT_HEAD(head, tmpl, solnode);
+	tmpl->flags |= TEMPLATE_SOLNODE;
+	templ_solnode_count++;
+}
+
+static void
+templ_solnode_remove(struct template *tmpl)
+{
+	if (!(tmpl->flags & TEMPLATE_SOLNODE))
+		return;
+
+	LIST_REMOVE(tmpl, solnode);
+	tmpl->flags &= ~TEMPLATE_SOLNODE;
+	templ_solnode_count--;
+}
+
+/* Returns a template in the solicited-node group addr, if any */
+
+static struct template *
+templ_solnode_find(const struct addr *addr)
+{
+	struct template *tmpl;
+	uint32_t suffix = SOLNODE_SUFFIX(addr);
+
+	if (templ_solnode_count == 0)
+		return (NULL);
+
+	LIST_FOREACH(tmpl, &templ_solnode[templ_solnode_slot(suffix,
+		    templ_solnode_size)], solnode) {
+		if (SOLNODE_SUFFIX(&tmpl->addr) == suffix)
+			return (tmpl);
+	}
+
+	return (NULL);
+}
+
+static __inline void
+templ_insert(struct template *tmpl)
+{
+	SPLAY_INSERT(templtree, &templates, tmpl);
+	templ_index_insert(tmpl);
+}
+
+static __inline void
+templ_remove(struct template *tmpl)
+{
+	SPLAY_REMOVE(templtree, &templates, tmpl);
+	templ_index_remove(tmpl);
+	templ_solnode_remove(tmpl);
+}
+
 int
 port_compare(struct port *a, struct port *b)
 {
@@ -143,26 +405,14 @@ struct template *
 template_find(const char *name)
 {
 	struct template tmp;
-	struct addr * multicast_member = NULL;
-	struct addr template_addr;
+	struct addr addr;
+
+	/* A solicited-node group stands for one of its members */
+	if (strncasecmp(name, "ff02:", 5) == 0 &&
+	    addr_pton(name, &addr) != -1 && ADDR_IS_SOLICITED_NODE(&addr))
+		return (templ_solnode_find(&addr));
+
 	tmp.name = (char *)name;
-	/* check if requested template is a solicited node multicast addr */	
-	char * solicited_node_prefix = "ff02::1:ff";
-	if(strncmp(name,solicited_node_prefix,strlen(solicited_node_prefix))==0){
-		if(addr_aton(name,&template_addr)==-1){
-			return NULL;
-		}
-		template_addr.addr_bits = IP6_ADDR_BITS;
-		/* XXX this is working but the code could use some improvement, if two hosts share the same multicast
-		address then the wrong template might be returned, currently the icmpv6 functions
-		take care of that, but it should be rewritten  */
-		multicast_member = get_first_member_of_multicast_group(&template_addr);
-		if(multicast_member != NULL){
-			tmp.name = addr_ntoa(multicast_member);
-		}else{
-			return NULL;
-		}
-	}	
 	return (SPLAY_FIND(templtree, &templates, &tmp));
 }
 
@@ -205,11 +455,12 @@ template_list_glob(struct evbuffer *buffer, const char *pattern)
 
 /*
  * Checks if condition for each template in the list is matched.
- * Return the first template that we match.
+ * Return the first template that we match.  The packet may be IPv4
+ * or IPv6.
  */
 
 struct template *
-template_dynamic(const struct template *tmpl, const struct ip_hdr *ip,
+template_dynamic(const struct template *tmpl, const u_char *pkt,
     u_short iplen)
 {
 	struct template *save = NULL;
@@ -221,7 +472,7 @@ template_dynamic(const struct template *tmpl, const struct ip_hdr *ip,
 
 		/* See if we match this template and return it on success */
 		if (cond->match == NULL ||
-		    cond->match(cond->tmpl, ip, iplen, cond->match_arg))
+		    cond->match(cond->tmpl, pkt, iplen, cond->match_arg))
 			return (cond->tmpl);
 	}
 
@@ -229,17 +480,47 @@ template_dynamic(const struct template *tmpl, const struct ip_hdr *ip,
 	return (save);
 }
 
+/*
+ * Looks up the template bound to a raw IPv4 or IPv6 address.  This is
+ * what the packet path should use; template_find() is for names.
+ */
+
 struct template *
-template_find_best(const char *addr, const struct ip_hdr *ip, u_short iplen)
+template_find_addr(const struct addr *addr)
 {
 	struct template *tmpl;
+	u_int slot;
+
+	/* Requests for solicited node multicast addresses go to a member */
+	if (ADDR_IS_SOLICITED_NODE(addr))
+		return (templ_solnode_find(addr));
+
+	if (templ_index_count == 0)
+		return (NULL);
+
+	slot = templ_index_hash(addr) & (templ_index_size - 1);
+	while ((tmpl = templ_index[slot]) != NULL) {
+		if (tmpl != &templ_index_tombstone &&
+		    templ_index_match(tmpl, addr))
+			return (tmpl);
+		slot = (slot + 1) & (templ_index_size - 1);
+	}
 
-	tmpl = template_find(addr);
+	return (NULL);
+}
+
+struct template *
+template_find_best(const struct addr *addr, const struct ip_hdr *ip,
+    u_short iplen)
+{
+	struct template *tmpl;
+
+	tmpl = template_find_addr(addr);
 	if (tmpl == NULL)
-		tmpl = template_find("default");
+		tmpl = templ_default;
 	
 	if (tmpl != NULL && tmpl->flags & TEMPLATE_DYNAMIC)
-		tmpl = template_dynamic(tmpl, ip, iplen);
+		tmpl = template_dynamic(tmpl, (const u_char *)ip, iplen);
 
 	return (tmpl);
 }
@@ -263,7 +544,7 @@ template_create(const char *name)
 	tmpl->udp.status = PORT_RESET;
 
 	SPLAY_INIT(&tmpl->ports);
-	SPLAY_INSERT(templtree, &templates, tmpl);
+	templ_insert(tmpl);
 
 	/* Configured subsystems */
 	TAILQ_INIT(&tmpl->subsystems);
@@ -294,6 +575,96 @@ template_iterate(int (*f)(struct template *, void *), void *arg)
 	return (0);
 }
 
+/*
+ * Templates created on demand for a packet are kept in least recently
+ * used order, so that idle ones can be reclaimed.  The clock only
+ * advances when idle templates are looked for, which keeps the packet
+ * path free of system calls and moves a template at most once per tick.
+ */
+
+static TAILQ_HEAD(templlru, template) templ_lru =
+    TAILQ_HEAD_INITIALIZER(templ_lru);
+static u_int templ_lru_count;
+static time_t templ_clock;
+
+static void
+templ_lru_remove(struct template *tmpl)
+{
+	TAILQ_REMOVE(&templ_lru, tmpl, lru);
+	templ_lru_count--;
+	tmpl->flags &= ~TEMPLATE_ONDEMAND;
+}
+
+void
+template_lru_insert(struct template *tmpl)
+{
+	if (tmpl->flags & TEMPLATE_ONDEMAND)
+		return;
+
+	templ_clock = time(NULL);
+	tmpl->lastuse = templ_clock;
+	tmpl->flags |= TEMPLATE_ONDEMAND;
+	TAILQ_INSERT_TAIL(&templ_lru, tmpl, lru);
+	templ_lru_count++;
+}
+
+void
+template_touch(struct template *tmpl)
+{
+	if (!(tmpl->flags & TEMPLATE_ONDEMAND) || tmpl->lastuse == templ_clock)
+		return;
+
+	tmpl->lastuse = templ_clock;
+	TAILQ_REMOVE(&templ_lru, tmpl, lru);
+	TAILQ_INSERT_TAIL(&templ_lru, tmpl, lru);
+}
+
+/*
+ * Takes an on-demand template out of the system.  It is deallocated
+ * once the connections that still refer to it are gone.
+ */
+
+void
+template_reclaim(struct template *tmpl)
+{
+	template_remove_ndp(tmpl);
+	template_remove(tmpl);
+	template_free(tmpl);
+}
+
+/* Reclaims templates that have not seen a packet for idle seconds */
+
+int
+template_reclaim_idle(time_t now, int idle)
+{
+	struct template *tmpl;
+	int n = 0;
+
+	templ_clock = now;
+	if (idle <= 0)
+		return (0);
+
+	while ((tmpl = TAILQ_FIRST(&templ_lru)) != NULL &&
+	    now - tmpl->lastuse >= idle) {
+		template_reclaim(tmpl);
+		n++;
+	}
+
+	return (n);
+}
+
+struct template *
+template_lru_oldest(void)
+{
+	return (TAILQ_FIRST(&templ_lru));
+}
+
+u_int
+template_lru_count(void)
+{
+	return (templ_lru_count);
+}
+
 /*
  * Removes all configured templates from the system, so that the
  * configuration file can be re-read.
@@ -304,8 +675,19 @@ template_free_all(int how)
 {
 	struct template *tmpl;
 
+	/* On-demand templates go first, as they may share their parent */
+	while ((tmpl = TAILQ_FIRST(&templ_lru)) != NULL) {
+		templ_lru_remove(tmpl);
+		if (template_find(tmpl->name) == tmpl)
+			templ_remove(tmpl);
+		if (how == TEMPLATE_FREE_REGULAR)
+			template_free(tmpl);
+		else
+			template_deallocate(tmpl);
+	}
+
 	while ((tmpl = SPLAY_ROOT(&templates)) != NULL) {
-		SPLAY_REMOVE(templtree, &templates, tmpl);
+		templ_remove(tmpl);
 		if (how == TEMPLATE_FREE_REGULAR)
 			template_free(tmpl);
 		else if (!(tmpl->flags & TEMPLATE_DYNAMIC_CHILD))
@@ -318,9 +700,12 @@ template_free_all(int how)
 void
 template_remove(struct template *tmpl)
 {
+	if (tmpl->flags & TEMPLATE_ONDEMAND)
+		templ_lru_remove(tmpl);
+
 	/* Remove ourselves from the searchable index */
 	if (template_find(tmpl->name) == tmpl)
-		SPLAY_REMOVE(templtree, &templates, tmpl);
+		templ_remove(tmpl);
 }
 
 /* Insert a template into the system */
@@ -331,7 +716,7 @@ template_insert(struct template *tmpl)
 	/* Insert ourselves into the searchable index */
 	if (template_find(tmpl->name) != NULL)
 		return (-1);
-	SPLAY_INSERT(templtree, &templates, tmpl);
+	templ_insert(tmpl);
 
 	return (0);
 }
@@ -344,7 +729,7 @@ template_deallocate(struct template *tmpl)
 
 	/* Remove ourselves from the searchable index */
 	if (template_find(tmpl->name) == tmpl)
-		SPLAY_REMOVE(templtree, &templates, tmpl);
+		templ_remove(tmpl);
 
 	/* Free conditions for dynamic templates */
 	for (cond = TAILQ_FIRST(&tmpl->dynamic); cond != NULL;
@@ -357,11 +742,17 @@ template_deallocate(struct template *tmpl)
 		free(cond);
 	}
 	
+	if (tmpl->flags & TEMPLATE_ONDEMAND)
+		templ_lru_remove(tmpl);
+
 	/* Remove ports from template */
 	while ((port = SPLAY_ROOT(&tmpl->ports)) != NULL)
 		port_free(tmpl, port);
 
-	if (tmpl->person != NULL)
+	/* The personality is only ours if we do not share with a parent */
+	if (tmpl->parent != NULL)
+		template_free(tmpl->parent);
+	else if (tmpl->person != NULL)
 		personality_declone(tmpl->person);
 
 
@@ -386,6 +777,37 @@ template_deallocate(struct template *tmpl)
 	free(tmpl);
 }
 
+/* Templates that share their parent's ports look them up there */
+
+static __inline struct porttree *
+templ_ports(const struct template *tmpl)
+{
+	if (tmpl->parent != NULL)
+		tmpl = tmpl->parent;
+
+	return ((struct porttree *)&tmpl->ports);
+}
+
+/*
+ * Gives a template its own copy of the ports and personality that it
+ * shares with its parent, before it changes them.
+ */
+
+static void
+template_unshare(struct template *tmpl)
+{
+	struct template *parent = tmpl->parent;
+	struct port *port;
+
+	tmpl->parent = NULL;
+	SPLAY_FOREACH(port, porttree, &parent->ports)
+		port_insert(tmpl, port->proto, port->number, &port->action);
+	if (tmpl->person != NULL)
+		tmpl->person = personality_clone(tmpl->person);
+
+	template_free(parent);
+}
+
 struct port *
 port_find(struct template *tmpl, int proto, int number)
 {
@@ -394,7 +816,7 @@ port_find(struct template *tmpl, int proto, int number)
 	tmpport.proto = proto;
 	tmpport.number = number;
 	
-	return (SPLAY_FIND(porttree, &tmpl->ports, &tmpport));
+	return (SPLAY_FIND(porttree, templ_ports(tmpl), &tmpport));
 }
 
 void
@@ -444,6 +866,15 @@ port_free(struct template *tmpl, struct port *port)
 {
 	struct port_encapsulate *tmp;
 
+	/* A shared port belongs to the parent, remove our own copy */
+	if (tmpl->parent != NULL) {
+		int proto = port->proto, number = port->number;
+
+		template_unshare(tmpl);
+		if ((port = port_find(tmpl, proto, number)) == NULL)
+			return;
+	}
+
 	/* Remove pending connections */
 	while ((tmp = TAILQ_FIRST(&port->pending)) != NULL) {
 		/* This might not be the correct way to clean this up */
@@ -484,6 +915,9 @@ port_insert(struct template *tmpl, int proto, int number,
 {
 	struct port *port, tmpport;
 	
+	if (tmpl->parent != NULL)
+		template_unshare(tmpl);
+
 	tmpport.proto = proto;
 	tmpport.number = number;
 	
@@ -569,12 +1003,16 @@ template_post_ndp(struct template *tmpl, struct addr *ipaddr){
 	
 	struct ndp_neighbor_req *req;
 	
-	req = ndp_neighbor_new(tmpl->inter,NULL,NULL,tmpl->ethernet_addr,ipaddr);
+	req = ndp_neighbor_new(tmpl->inter, NULL, NULL, tmpl->ethernet_addr,
+	    ipaddr, NDP_STATIC);
 	if(req == NULL){
 		errx(1,"%s, cannot create ndp entry");
 	}
 
 	req->owner = tmpl;	
+
+	/* Answer solicitations sent to our solicited-node group */
+	templ_solnode_insert(tmpl);
 }
 
 void
@@ -591,6 +1029,19 @@ template_post_arp(struct template *tmpl, struct addr *ipaddr)
 	req->owner = tmpl;
 }
 
+/* Withdraws the neighbor entry and solicited-node membership */
+
+void
+template_remove_ndp(struct template *tmpl)
+{
+	if (tmpl->ethernet_addr == NULL ||
+	    tmpl->addr.addr_type != ADDR_TYPE_IP6)
+		return;
+
+	ndp_neighbor_delete(&tmpl->addr);
+	templ_solnode_remove(tmpl);
+}
+
 void
 template_remove_arp(struct template *tmpl)
 {
@@ -608,31 +1059,39 @@ template_remove_arp(struct template *tmpl)
 /*
  * When the interface is specified, we do not need to do an address lookup
  * for a corresponding interface.  We use the interface for DHCP.
+ * A shared clone refers to the ports and personality of its parent
+ * instead of copying them.
  */
 
-struct template *
-template_clone(const char *newname, const struct template *tmpl, 
-    const struct interface *inter, int start)
+static struct template *
+template_clone_internal(const char *newname, struct template *tmpl,
+    const struct interface *inter, int start, int share)
 {
 	struct subsystem_container *container;
 	struct condition *condition;
 	struct template *newtmpl;
 	struct port *port;
-	struct addr addr,*solicited_node_addr;
+	struct addr addr;
 	int isipaddr = 0;
 
 	if ((newtmpl = template_create(newname)) == NULL)
 		return (NULL);
 
-	/* copy the ports to the new template (return if the port is already assigned to the template) */
-	SPLAY_FOREACH(port, porttree, (struct porttree *)&tmpl->ports) {
-		if (port_insert(newtmpl, port->proto, port->number,
-			&port->action) == NULL)
-			return (NULL);
-	}
+	if (share) {
+		newtmpl->parent = template_ref(tmpl);
+		newtmpl->person = tmpl->person;
+		newtmpl->person6 = tmpl->person6;
+	} else {
+		/* copy the ports to the new template (return if the port is already assigned to the template) */
+		SPLAY_FOREACH(port, porttree, templ_ports(tmpl)) {
+			if (port_insert(newtmpl, port->proto, port->number,
+				&port->action) == NULL)
+				return (NULL);
+		}
 
-	if (tmpl->person)
-		newtmpl->person = personality_clone(tmpl->person);
+		if (tmpl->person)
+			newtmpl->person = personality_clone(tmpl->person);
+	}
 
 	/* Keeps track of the type of template */
 	/* addr is able to store ip6 addresses */
@@ -665,19 +1124,11 @@ template_clone(const char *newname, const struct template *tmpl,
 				/* add arp entry in case of an ipv4 address */
 				template_post_arp(newtmpl, &addr);
 			}else{	
-				/* add ndp entry in case of an ipv6 address */
+				/*
+				 * add ndp entry in case of an ipv6 address,
+				 * this also joins the solicited node group
+				 */
 				template_post_ndp(newtmpl,&addr);	
-				/* add link local multicast */
-				solicited_node_addr = (struct addr *)malloc(sizeof(struct addr));
-				if(solicited_node_addr != NULL){
-					compute_solicited_node_address(&addr,solicited_node_addr);
-					multicast_group_new(solicited_node_addr);
-					syslog(LOG_DEBUG,"solicited node addr for %s is %s",addr_ntoa(&addr),addr_ntoa(solicited_node_addr));
-					add_host_to_multicast_group(&addr,solicited_node_addr);
-					free(solicited_node_addr);
-				}else{
-					errx(1, "%s: could not allocate memory for solicited node addr");
-				}
 			}
 		}
 	}
@@ -739,6 +1190,29 @@ template_clone(const char *newname, const struct template *tmpl,
 	return (newtmpl);
 }
 
+struct template *
+template_clone(const char *newname, const struct template *tmpl, 
+    const struct interface *inter, int start)
+{
+	return (template_clone_internal(newname, (struct template *)tmpl,
+		    inter, start, 0));
+}
+
+/*
+ * Clones a template that shares ports and personality with its parent
+ * until they are modified.  Subsystems bind to the ports of each
+ * template, so their templates are always copied.
+ */
+
+struct template *
+template_clone_shared(const char *newname, struct template *tmpl,
+    const struct interface *inter)
+{
+	int share = TAILQ_EMPTY(&tmpl->subsystems) && tmpl->parent == NULL;
+
+	return (template_clone_internal(newname, tmpl, inter, 0, share));
+}
+
 int
 template_subsystem(struct template *tmpl, char *subsystem, int flags)
 {
@@ -975,10 +1449,13 @@ template_print(struct evbuffer *buffer, struct template *tmpl)
 	evbuffer_add_printf(buffer, "  TCP seq: %lx\n", tmpl->seq);
 	evbuffer_add_printf(buffer, "  TCP drop: in: %d syn: %d\n",
 	    tmpl->drop_inrate, tmpl->drop_synrate);
-	evbuffer_add_printf(buffer, "  refcnt: %d\n", tmpl->refcnt);
+	evbuffer_add_printf(buffer, "  refcnt: %u\n", tmpl->refcnt);
+	if (tmpl->parent != NULL)
+		evbuffer_add_printf(buffer, "  shared with: %s\n",
+		    tmpl->parent->name);
 	evbuffer_add_printf(buffer, "  ports:\n");
 
-	SPLAY_FOREACH(port, porttree, &tmpl->ports) {
+	SPLAY_FOREACH(port, porttree, templ_ports(tmpl)) {
 		char *type;
 		switch (port->action.status) {
 		case PORT_OPEN:
@@ -1025,7 +1502,6 @@ template_print(struct evbuffer *buffer, struct template *tmpl)
 void
 template_delay_cb(int fd, short which, void *arg)
 {
-	extern struct pool *pool_pkt;
 	extern struct pool *pool_delay;
 	struct delay *delay = arg;
 	struct ip_hdr *ip = delay->ip;
@@ -1042,7 +1518,7 @@ template_delay_cb(int fd, short which, void *arg)
 		    &ip->ip_dst, IP_ADDR_LEN);
 
 		/* Internal delivery */
-		tmpl = template_find_best(addr_ntoa(&addr), ip, iplen);
+		tmpl = template_find_best(&addr, ip, iplen);
 		tmpl = template_ref(tmpl);
 
 		/* No Check for fragmentation */
@@ -1051,7 +1527,7 @@ template_delay_cb(int fd, short which, void *arg)
 	}
 
 	if (delay->flags & DELAY_FREEPKT)
-		pool_free(pool_pkt, ip);
+		pktbuf_free(ip);
 	template_free(tmpl);
 
 	if (delay->flags & DELAY_NEEDFREE)
@@ -1130,7 +1606,7 @@ template_test_measure(int count)
 		ip_pack_hdr(pkt, 0, iplen, rand_uint16(honeyd_rand),
 		    0, 64,
 		    IP_PROTO_TCP, src.addr_ip, dst.addr_ip);
-		ip_checksum(pkt, iplen);
+		cksum_ip((struct ip_hdr *)pkt, iplen);
 
 		honeyd_recv_cb((u_char *)&inter, &pkthdr, pkt);
 	}
@@ -1179,6 +1655,151 @@ template_packet_test(void)
 	fprintf(stderr, "\t%s: OK\n", __func__);
 }
 
+void
+template_index_test(void)
+{
+	struct template *tmpl, *tmpl6, *member;
+	struct addr addr, addr6, group;
+	char name[32];
+	int i;
+
+	addr_pton("192.0.2.1", &addr);
+	addr_pton("2001:db8::1", &addr6);
+
+	if ((tmpl = template_create("192.0.2.1")) == NULL)
+		errx(1, "%s: template_create failed", __func__);
+	/* Not in canonical form on purpose */
+	if ((tmpl6 = template_create("2001:db8:0::1")) == NULL)
+		errx(1, "%s: template_create failed", __func__);
+
+	if (template_find_addr(&addr) != tmpl)
+		errx(1, "%s: could not find IPv4 template", __func__);
+	if (template_find_addr(&addr6) != tmpl6)
+		errx(1, "%s: could not find IPv6 template", __func__);
+
+	/* Force the table to grow and rehash */
+	for (i = 0; i < TEMPLATE_INDEX_MINSIZE * 2; i++) {
+		snprintf(name, sizeof(name), "198.51.%d.%d", i / 256, i % 256);
+		template_create(name);
+	}
+	if (template_find_addr(&addr) != tmpl)
+		errx(1, "%s: lost IPv4 template after resize", __func__);
+
+	template_remove(tmpl);
+	if (template_find_addr(&addr) != NULL)
+		errx(1, "%s: found removed template", __func__);
+	if (template_find_addr(&addr6) != tmpl6)
+		errx(1, "%s: tombstone broke probe chain", __func__);
+
+	template_insert(tmpl);
+	if (template_find_addr(&addr) != tmpl)
+		errx(1, "%s: could not find reinserted template", __func__);
+
+	/* Solicited-node groups find their members, also after growing */
+	for (i = 0; i < TEMPLATE_SOLNODE_MINSIZE * 2; i++) {
+		snprintf(name, sizeof(name), "2001:db8::%x:%x", i, i);
+		templ_solnode_insert(template_create(name));
+	}
+	templ_solnode_insert(tmpl6);
+	addr_pton("ff02::1:ff00:1", &group);
+	if (template_find_addr(&group) != tmpl6 ||
+	    template_find("ff02::1:ff00:1") != tmpl6)
+		errx(1, "%s: could not find solicited-node member", __func__);
+	addr_pton("ff02::1:ff2a:2a", &group);
+	if ((member = template_find_addr(&group)) == NULL ||
+	    SOLNODE_SUFFIX(&member->addr) != 0x2a002a)
+		errx(1, "%s: wrong solicited-node member", __func__);
+	template_remove(tmpl6);
+	addr_pton("ff02::1:ff00:1", &group);
+	if (template_find_addr(&group) != NULL)
+		errx(1, "%s: removed template is still a member", __func__);
+	template_insert(tmpl6);
+
+	/* The members must not outlive the test in the group index */
+	for (i = 0; i < TEMPLATE_SOLNODE_MINSIZE * 2; i++) {
+		snprintf(name, sizeof(name), "2001:db8::%x:%x", i, i);
+		if ((member = template_find(name)) == NULL)
+			errx(1, "%s: lost template %s", __func__, name);
+		template_remove(member);
+		template_free(member);
+	}
+	addr_pton("ff02::1:ff2a:2a", &group);
+	if (templ_solnode_count != 0 || template_find_addr(&group) != NULL)
+		errx(1, "%s: stale solicited-node members", __func__);
+
+	template_free_all(TEMPLATE_FREE_REGULAR);
+	if (template_find_addr(&addr) != NULL ||
+	    template_find_addr(&addr6) != NULL)
+		errx(1, "%s: index not cleared", __func__);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
+
+void
+template_share_test(void)
+{
+	struct template *tmpl, *clone;
+	struct action action;
+	struct port *port;
+	char name[32];
+	u_int refcnt;
+	int n = 0;
+
+	memset(&action, 0, sizeof(action));
+	action.status = PORT_OPEN;
+
+	if ((tmpl = template_create("sharetest")) == NULL)
+		errx(1, "%s: template_create failed", __func__);
+	port_insert(tmpl, IP_PROTO_TCP, 22, &action);
+	port_insert(tmpl, IP_PROTO_TCP, 80, &action);
+
+	clone = template_clone_shared("sharetest-clone", tmpl, NULL);
+	if (clone == NULL || clone->parent != tmpl)
+		errx(1, "%s: clone does not share its ports", __func__);
+
+	/* Deleting a shared port must leave the parent alone */
+	if ((port = port_find(clone, IP_PROTO_TCP, 80)) == NULL)
+		errx(1, "%s: clone does not see the shared port", __func__);
+	port_free(clone, port);
+	if (clone->parent != NULL)
+		errx(1, "%s: clone still shares after a change", __func__);
+	if (port_find(clone, IP_PROTO_TCP, 80) != NULL ||
+	    port_find(clone, IP_PROTO_TCP, 22) == NULL)
+		errx(1, "%s: wrong ports in the clone", __func__);
+
+	SPLAY_FOREACH(port, porttree, &tmpl->ports) {
+		if (port->proto != IP_PROTO_TCP ||
+		    (port->number != 22 && port->number != 80))
+			errx(1, "%s: corrupted parent port", __func__);
+		n++;
+	}
+	if (n != 2)
+		errx(1, "%s: parent has %d ports instead of 2", __func__, n);
+
+	/* Unlimited random hosts may share one default template */
+	refcnt = tmpl->refcnt;
+	for (n = 0; n <= 65536; n++) {
+		snprintf(name, sizeof(name), "sharetest-%d", n);
+		if (template_clone_shared(name, tmpl, NULL) == NULL)
+			errx(1, "%s: could not clone %s", __func__, name);
+	}
+	if (tmpl->refcnt != refcnt + n)
+		errx(1, "%s: parent has %u references instead of %u",
+		    __func__, tmpl->refcnt, refcnt + n);
+	while (n--) {
+		snprintf(name, sizeof(name), "sharetest-%d", n);
+		clone = template_find(name);
+		template_remove(clone);
+		template_free(clone);
+	}
+	if (tmpl->refcnt != refcnt || port_find(tmpl, IP_PROTO_TCP, 22) == NULL)
+		errx(1, "%s: parent lost after freeing its clones", __func__);
+
+	template_free_all(TEMPLATE_FREE_REGULAR);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
+
 void
 template_test(void)
 {
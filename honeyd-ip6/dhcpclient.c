@@ -85,6 +85,7 @@
 #include "arp.h"
 #include "template.h"
 #include "dhcpclient.h"
+#include "cksum.h"
 
 extern rand_t *honeyd_rand;
 
@@ -369,7 +370,7 @@ static void _dhcp_reply(struct template *tmpl, u_char *buf, size_t buflen)
 
 		dhcp_abort(tmpl);
 
-		if (template_find(addr_ntoa(&addr)) != NULL )
+		if (template_find_addr(&addr) != NULL )
 		{
 			syslog(LOG_WARNING, "%s: Already got a template named %s", __func__,
 					addr_ntoa(&addr));
@@ -446,7 +447,7 @@ void dhcp_recv_cb(struct eth_hdr *eth, struct ip_hdr *ip, u_short iplen)
 
 	ip_sum = ip->ip_sum;
 	uh_sum = udp->uh_sum;
-	ip_checksum(ip, iplen);
+	cksum_ip(ip, iplen);
 	if (ip_sum != ip->ip_sum || uh_sum != udp->uh_sum)
 	{
 		syslog(LOG_WARNING, "%s: bad checksum for template %s", __func__,
@@ -504,7 +505,7 @@ static int _bcast(struct template *tmpl,
 	iph->ip_len = htons(iplen);
 	udph->uh_ulen = htons(iplen - IP_HDR_LEN);
 
-	ip_checksum(buf + ETH_HDR_LEN, iplen);
+	cksum_ip((struct ip_hdr *)(buf + ETH_HDR_LEN), iplen);
 
 	if (eth_send(inter->if_eth, buf, len) < 0)
 		err(1, "eth_send");
@@ -556,7 +557,7 @@ static int _unicast(struct template *tmpl,
 	iph->ip_len = htons(iplen);
 	udph->uh_ulen = htons(iplen - IP_HDR_LEN);
 
-	ip_checksum(buf + ETH_HDR_LEN, iplen);
+	cksum_ip((struct ip_hdr *)(buf + ETH_HDR_LEN), iplen);
 
 	if (eth_send(inter->if_eth, buf, len) < 0)
 		err(1, "eth_send");
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/queue.h>
+#include <sys/tree.h>
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dnet.h>
+#include <event.h>
+
+#include "honeyd.h"
+#include "flowtable.h"
+
+static struct flowbucket *flowtable_buckets(u_int);
+static void flowtable_grow(struct flowtable *);
+
+#define FLOW_ROTL(x, r)	(((x) << (r)) | ((x) >> (32 - (r))))
+
+static __inline uint32_t
+flow_mix(uint32_t h, uint32_t k)
+{
+	k *= 0xcc9e2d51;
+	k = FLOW_ROTL(k, 15);
+	k *= 0x1b873593;
+
+	h ^= k;
+	h = FLOW_ROTL(h, 13);
+	return (h * 5 + 0xe6546b64);
+}
+
+static __inline uint32_t
+flow_mix_ip6(uint32_t h, const struct addr *addr)
+{
+	uint32_t w[4];
+
+	memcpy(w, &addr->addr_ip6, sizeof(w));
+	h = flow_mix(h, w[0]);
+	h = flow_mix(h, w[1]);
+	h = flow_mix(h, w[2]);
+	return (flow_mix(h, w[3]));
+}
+
+/*
+ * Hashes the five tuple of a connection.  IPv4 connections keep their
+ * addresses in ip_src/ip_dst, IPv6 connections in src_addr/dst_addr.
+ * The protocol is implied by the table the connection lives in.
+ */
+
+uint32_t
+flowtable_hash(const struct flowtable *ft, const struct tuple *hdr)
+{
+	uint32_t h = ft->seed;
+
+	if (hdr->src_addr.addr_type == ADDR_TYPE_IP6) {
+		h = flow_mix_ip6(h, &hdr->src_addr);
+		h = flow_mix_ip6(h, &hdr->dst_addr);
+		h ^= 0x9e3779b9;
+	} else {
+		h = flow_mix(h, hdr->ip_src);
+		h = flow_mix(h, hdr->ip_dst);
+	}
+	h = flow_mix(h, ((uint32_t)hdr->sport << 16) | hdr->dport);
+
+	/* Final avalanche so that the low bits select the bucket */
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+
+	return (h);
+}
+
+/* Same notion of equality as conhdr_compare, without the ordering */
+
+static __inline int
+flow_equal(const struct tuple *a, const struct tuple *b)
+{
+	if (a->sport != b->sport || a->dport != b->dport)
+		return (0);
+
+	if (a->src_addr.addr_type == ADDR_TYPE_IP6) {
+		if (b->src_addr.addr_type != ADDR_TYPE_IP6)
+			return (0);
+		return (memcmp(&a->src_addr.addr_ip6, &b->src_addr.addr_ip6,
+			    IP6_ADDR_LEN) == 0 &&
+		    memcmp(&a->dst_addr.addr_ip6, &b->dst_addr.addr_ip6,
+			IP6_ADDR_LEN) == 0);
+	}
+
+	if (b->src_addr.addr_type == ADDR_TYPE_IP6)
+		return (0);
+	return (a->ip_src == b->ip_src && a->ip_dst == b->ip_dst);
+}
+
+static struct flowbucket *
+flowtable_buckets(u_int nbuckets)
+{
+	size_t size = nbuckets * sizeof(struct flowbucket);
+	void *p;
+	int rc;
+
+	/* p is only defined if the allocation succeeded */
+	if ((rc = posix_memalign(&p, FLOWTABLE_CACHELINE, size)) == 0) {
+		memset(p, 0, size);
+		return (p);
+	}
+
+	/* The error is returned, errno is left alone */
+	errno = rc;
+	err(1, "%s: posix_memalign", __func__);
+	return (NULL);
+}
+
+void
+flowtable_init(struct flowtable *ft, uint32_t seed)
+{
+	memset(ft, 0, sizeof(struct flowtable));
+
+	ft->nbuckets = FLOWTABLE_MIN_BUCKETS;
+	ft->buckets = flowtable_buckets(ft->nbuckets);
+	ft->seed = seed;
+}
+
+struct tuple *
+flowtable_find(struct flowtable *ft, struct tuple *key)
+{
+	struct flowbucket *fb;
+	uint32_t hash = flowtable_hash(ft, key);
+	int i;
+
+	fb = &ft->buckets[hash & (ft->nbuckets - 1)];
+	do {
+		for (i = 0; i < FLOWTABLE_BUCKET_ENTRIES; i++) {
+			if (fb->hash[i] != hash || fb->entry[i] == NULL)
+				continue;
+			if (flow_equal(fb->entry[i], key))
+				return (fb->entry[i]);
+		}
+	} while ((fb = fb->next) != NULL);
+
+	return (NULL);
+}
+
+/* Places an entry with a known hash into the first free slot */
+
+static void
+flowtable_place(struct flowtable *ft, struct tuple *hdr)
+{
+	struct flowbucket *fb, *last = NULL;
+	int i;
+
+	fb = &ft->buckets[hdr->hash & (ft->nbuckets - 1)];
+	for (; fb != NULL; last = fb, fb = fb->next) {
+		for (i = 0; i < FLOWTABLE_BUCKET_ENTRIES; i++) {
+			if (fb->entry[i] == NULL) {
+				fb->hash[i] = hdr->hash;
+				fb->entry[i] = hdr;
+				return;
+			}
+		}
+	}
+
+	/* All slots are taken; chain a new overflow bucket */
+	fb = flowtable_buckets(1);
+	fb->hash[0] = hdr->hash;
+	fb->entry[0] = hdr;
+	last->next = fb;
+	ft->noverflow++;
+}
+
+static void
+flowtable_free_chain(struct flowbucket *fb)
+{
+	struct flowbucket *next;
+
+	for (; fb != NULL; fb = next) {
+		next = fb->next;
+		free(fb);
+	}
+}
+
+/* Doubles the number of buckets, rehashing from the stored hashes */
+
+static void
+flowtable_grow(struct flowtable *ft)
+{
+	struct flowbucket *old = ft->buckets, *fb;
+	u_int i, nold = ft->nbuckets;
+	int j;
+
+	ft->nbuckets = nold * 2;
+	ft->buckets = flowtable_buckets(ft->nbuckets);
+	ft->noverflow = 0;
+
+	for (i = 0; i < nold; i++) {
+		for (fb = &old[i]; fb != NULL; fb = fb->next) {
+			for (j = 0; j < FLOWTABLE_BUCKET_ENTRIES; j++) {
+				if (fb->entry[j] != NULL)
+					flowtable_place(ft, fb->entry[j]);
+			}
+		}
+		flowtable_free_chain(old[i].next);
+	}
+
+	free(old);
+}
+
+void
+flowtable_insert(struct flowtable *ft, struct tuple *hdr)
+{
+	if (ft->count >= ft->nbuckets * (FLOWTABLE_BUCKET_ENTRIES / 2))
+		flowtable_grow(ft);
+
+	hdr->hash = flowtable_hash(ft, hdr);
+	flowtable_place(ft, hdr);
+	ft->count++;
+}
+
+void
+flowtable_remove(struct flowtable *ft, struct tuple *hdr)
+{
+	struct flowbucket *head, *fb, *prev;
+	int i;
+
+	head = &ft->buckets[hdr->hash & (ft->nbuckets - 1)];
+	for (prev = NULL, fb = head; fb != NULL; prev = fb, fb = fb->next) {
+		for (i = 0; i < FLOWTABLE_BUCKET_ENTRIES; i++) {
+			if (fb->entry[i] == hdr)
+				goto found;
+		}
+	}
+
+	errx(1, "%s: connection %p not in table", __func__, hdr);
+
+ found:
+	fb->entry[i] = NULL;
+	fb->hash[i] = 0;
+	ft->count--;
+
+	/* Release overflow buckets as soon as they are empty */
+	if (prev != NULL) {
+		for (i = 0; i < FLOWTABLE_BUCKET_ENTRIES; i++) {
+			if (fb->entry[i] != NULL)
+				return;
+		}
+		prev->next = fb->next;
+		free(fb);
+		ft->noverflow--;
+	}
+}
+
+/* Unittests */
+
+static void
+flowtable_test_v4(struct tuple *hdr, int i)
+{
+	memset(hdr, 0, sizeof(struct tuple));
+	hdr->ip_src = htonl(0x0a000000 | (i >> 4));
+	hdr->ip_dst = htonl(0xc0a80101);
+	hdr->sport = 1024 + (i & 0x0f);
+	hdr->dport = 80;
+}
+
+static void
+flowtable_test_v6(struct tuple *hdr, int i)
+{
+	memset(hdr, 0, sizeof(struct tuple));
+	addr_pton("2001:db8::1", &hdr->src_addr);
+	addr_pton("2001:db8::2", &hdr->dst_addr);
+	hdr->src_addr.addr_data8[14] = i >> 8;
+	hdr->src_addr.addr_data8[15] = i & 0xff;
+	hdr->sport = 1024 + (i & 0x0f);
+	hdr->dport = 80;
+}
+
+void
+flowtable_test(void)
+{
+	struct flowtable ft;
+	struct tuple *v4, *v6, key;
+	int i, n = 2000;
+
+	flowtable_init(&ft, 0x12345678);
+
+	if ((v4 = calloc(n, sizeof(struct tuple))) == NULL)
+		err(1, "%s: calloc", __func__);
+	if ((v6 = calloc(n, sizeof(struct tuple))) == NULL)
+		err(1, "%s: calloc", __func__);
+
+	for (i = 0; i < n; i++) {
+		flowtable_test_v4(&v4[i], i);
+		flowtable_insert(&ft, &v4[i]);
+		flowtable_test_v6(&v6[i], i);
+		flowtable_insert(&ft, &v6[i]);
+	}
+	if (ft.count != 2 * n)
+		errx(1, "%s: count %d", __func__, ft.count);
+	if (ft.nbuckets <= FLOWTABLE_MIN_BUCKETS)
+		errx(1, "%s: table did not grow", __func__);
+
+	for (i = 0; i < n; i++) {
+		flowtable_test_v4(&key, i);
+		if (flowtable_find(&ft, &key) != &v4[i])
+			errx(1, "%s: lost v4 connection %d", __func__, i);
+		flowtable_test_v6(&key, i);
+		if (flowtable_find(&ft, &key) != &v6[i])
+			errx(1, "%s: lost v6 connection %d", __func__, i);
+	}
+
+	/* An IPv4 key must never match an IPv6 entry and vice versa */
+	flowtable_test_v4(&key, n);
+	if (flowtable_find(&ft, &key) != NULL)
+		errx(1, "%s: found unknown connection", __func__);
+
+	for (i = 0; i < n; i += 2) {
+		flowtable_remove(&ft, &v4[i]);
+		flowtable_remove(&ft, &v6[i]);
+	}
+	for (i = 0; i < n; i++) {
+		struct tuple *res;
+
+		flowtable_test_v4(&key, i);
+		res = flowtable_find(&ft, &key);
+		if ((i & 1) ? res != &v4[i] : res != NULL)
+			errx(1, "%s: bad v4 lookup after remove %d", __func__, i);
+		flowtable_test_v6(&key, i);
+		res = flowtable_find(&ft, &key);
+		if ((i & 1) ? res != &v6[i] : res != NULL)
+			errx(1, "%s: bad v6 lookup after remove %d", __func__, i);
+	}
+	if (ft.count != n)
+		errx(1, "%s: count %d after remove", __func__, ft.count);
+
+	for (i = 1; i < n; i += 2) {
+		flowtable_remove(&ft, &v4[i]);
+		flowtable_remove(&ft, &v6[i]);
+	}
+	if (ft.count != 0 || ft.noverflow != 0)
+		errx(1, "%s: table not empty", __func__);
+
+	free(v4);
+	free(v6);
+	free(ft.buckets);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _FLOWTABLE_
+#define _FLOWTABLE_
+
+/*
+ * Hashed connection table.  Each bucket fills one cache line and
+ * holds the precomputed hashes of its entries next to the pointers,
+ * so that a lookup touches a connection only when the hashes match.
+ * Buckets that run full are chained to overflow buckets.
+ */
+
+#define FLOWTABLE_BUCKET_ENTRIES	4
+#define FLOWTABLE_MIN_BUCKETS		256
+#define FLOWTABLE_CACHELINE		64
+
+struct tuple;
+
+struct flowbucket {
+	uint32_t hash[FLOWTABLE_BUCKET_ENTRIES];
+	struct tuple *entry[FLOWTABLE_BUCKET_ENTRIES];
+	struct flowbucket *next;
+} __attribute__((aligned(FLOWTABLE_CACHELINE)));
+
+struct flowtable {
+	struct flowbucket *buckets;
+	u_int nbuckets;			/* always a power of two */
+	u_int count;
+	u_int noverflow;		/* chained overflow buckets */
+
+	uint32_t seed;			/* keeps the hash unpredictable */
+};
+
+void flowtable_init(struct flowtable *, uint32_t);
+uint32_t flowtable_hash(const struct flowtable *, const struct tuple *);
+struct tuple *flowtable_find(struct flowtable *, struct tuple *);
+void flowtable_insert(struct flowtable *, struct tuple *);
+void flowtable_remove(struct flowtable *, struct tuple *);
+
+void flowtable_test(void);
+
+#endif /* _FLOWTABLE_ */
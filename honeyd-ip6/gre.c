@@ -59,6 +59,7 @@
 
 #include "honeyd.h"
 #include "gre.h"
+#include "cksum.h"
 
 extern rand_t *honeyd_rand;
 extern int honeyd_ttl;
@@ -114,8 +115,8 @@ int gre_decapsulate(struct ip_hdr *oip, u_short oiplen, struct ip_hdr **pip,
 		u_int sum = gre->gre_sum, tmp;
 		gre->gre_sum = 0;
 
-		tmp = ip_cksum_add(gre, sizeof(struct gre_hdr) + iplen, 0);
-		tmp = ip_cksum_carry(tmp);
+		tmp = cksum_add(gre, sizeof(struct gre_hdr) + iplen, 0);
+		tmp = cksum_carry(tmp);
 		if (sum != tmp)
 		{
 			syslog(LOG_INFO,
@@ -158,10 +159,10 @@ int gre_encapsulate(ip_t *honeyd_ip, struct addr *src, struct addr *dst,
 	memcpy(data, iip, iiplen);
 
 	/* Calculate the checksum */
-	sum = ip_cksum_add(gre, iiplen + sizeof(struct gre_hdr), 0);
-	gre->gre_sum = ip_cksum_carry(sum);
+	sum = cksum_add(gre, iiplen + sizeof(struct gre_hdr), 0);
+	gre->gre_sum = cksum_carry(sum);
 
-	ip_checksum(oip, iplen);
+	cksum_ip(oip, iplen);
 
 	return (ip_send(honeyd_ip, pkt, iplen) != iplen ? -1 : 0);
 }
@@ -49,6 +49,10 @@
 #include <sys/tree.h>
 #include <sys/wait.h>
 #include <sys/queue.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
 
 #include <pcap.h>
 
@@ -78,6 +82,8 @@
 #include "subsystem.h"
 #include "personality.h"
 #include "xprobe_assoc.h"
+#include "persdb.h"
+#include "reasm.h"
 #include "ipfrag.h"
 #include "ip6frag.h"
 #include "router.h"
@@ -86,6 +92,7 @@
 #include "udp.h"
 #include "hooks.h"
 #include "pool.h"
+#include "pktbuf.h"
 #include "plugins_config.h"
 #include "plugins.h"
 #include "interface.h"
@@ -108,6 +115,12 @@
 #include "update.h"
 #include "util.h"
 #include "randomipv6.h"
+#include "bloom.h"
+#include "siphash.h"
+#include "cksum.h"
+#include "syncookie.h"
+#include "flowtable.h"
+#include "txqueue.h"
 
 #ifdef HAVE_PYTHON
 #include <Python.h>
@@ -122,7 +135,6 @@
 #define IPV6_RANDOM_MODE_DEACTIVATED 0
 #define DEFAULT_RANDOM_IPV6_PROBABILITY 0.0
 #define MAX_NUMBER_OF_IPV6_RANDOM_HOSTS
-#define SIZE_OF_IPV6_FRAGMENT_HEADER 8
 
 
 /* Prototypes */
@@ -140,9 +152,9 @@ void icmp_error_send(struct template *, struct addr *, uint8_t, uint8_t, struct
 /* IP6 specific prototypes */
 void honeyd_recv_cb6(u_char *, const struct pcap_pkthdr *, const u_char *);
 
-struct tree tcpcons;
+struct flowtable tcpcons;
 struct conlru tcplru;
-struct tree udpcons;
+struct flowtable udpcons;
 struct conlru udplru;
 
 struct spoof no_spoof; /* spoof settings for default packet processing */
@@ -162,25 +174,29 @@ struct config config =
 struct stats_network stats_network =
 {
     0, /* input bytes */
-    0 /* output bytes */
+    0, /* output bytes */
+    0 /* input drops */
 };
 
-SPLAY_PROTOTYPE(tree, tuple, node, conhdr_compare);
-SPLAY_GENERATE(tree, tuple, node, conhdr_compare);
-
 struct rrdtool_drv *honeyd_rrd_drv;
 struct rrdtool_db *honeyd_traffic_db;
 struct event honeyd_rrd_ev;
+static struct event honeyd_pool_ev;
 FILE *honeyd_servicefp;
 struct timeval honeyd_uptime;
 static FILE *honeyd_logfp;
 static ip_t *honeyd_ip;
-struct pool *pool_pkt;
 struct pool *pool_delay;
+struct pool *pool_con;
+struct pool *pool_source;
 rand_t *honeyd_rand;
 int honeyd_sig;
 int honeyd_nconnects;
 int honeyd_nchildren;
+int honeyd_worker;		/* 0 in the master process */
+static int honeyd_nworkers = 1;
+static pid_t honeyd_workerpids[HONEYD_MAX_WORKERS];
+static struct event_base *honeyd_evbase;
 int honeyd_ttl = HONEYD_DFL_TTL;
 struct tcp_con honeyd_tmp;
 int honeyd_show_include_dir;
@@ -201,6 +217,20 @@ int honeyd_webserver_port = 80;
 char *honeyd_webserver_root = PATH_HONEYDDATA "/webserver/htdocs";
 char *honeyd_rrdtool_path = PATH_RRDTOOL;
 
+struct conbudget honeyd_conbudget =
+{
+    HONEYD_MAX_CONNECTS,
+    HONEYD_MAX_CONNECTS / HONEYD_SOURCE_SHARE
+};
+static uint32_t honeyd_conclock;	/* orders connection activity */
+SPLAY_HEAD(sourcetree, consource) consources;
+
+/* Connection budget from the command line, overrides the config file */
+static int honeyd_opt_max_connects;
+static int honeyd_opt_max_persource;
+static size_t honeyd_opt_connect_memory;
+static char *honeyd_compile_personalities;
+
 /* can be used by unittests to do bad stuff */
 void (*honeyd_delay_callback)(int, short, void *) = honeyd_delay_cb;
 void (*honeyd_delay_callback6)(int, short, void *) = honeyd_delay_cb6;
@@ -224,6 +254,12 @@ static struct option honeyd_long_opts[] =
     { "verify-config", 0, &honeyd_verify_config, 1 },
     { "ignore-parse-errors", 0, &honeyd_ignore_parse_errors, 1 },
     { "fix-webserver-permissions", 0, &honeyd_webserver_fix_permissions, 1 },
+    { "max-connections", required_argument, NULL, 'C' },
+    { "max-connections-per-source", required_argument, NULL, 'N' },
+    { "connection-memory", required_argument, NULL, 'M' },
+    { "packet-ring", 0, NULL, 'K' },
+    { "workers", required_argument, NULL, 'w' },
+    { "compile-personalities", required_argument, NULL, 'D' },
     { 0, 0, 0, 0 }
 };
 
@@ -234,6 +270,8 @@ void usage(void)
             "where options include:\n"
             "  -d                     Do not daemonize, be verbose.\n"
             "  -P                     Enable polling mode.\n"
+            "  --packet-ring          Receive from a memory mapped packet ring.\n"
+            "  --workers=n            Split the traffic across n processes.\n"
             "  -l logfile             Log packets and connections to logfile.\n"
             "  -s logfile             Logs service status output to logfile.\n"
             "  -i interface           Listen on interface.\n"
@@ -241,6 +279,8 @@ void usage(void)
             "  -x file                Read xprobe-style fingerprints from file.\n"
             "  -a assocfile           Read nmap-xprobe associations from file.\n"
             "  -0 osfingerprints      Read pf-style OS fingerprints from file.\n"
+            "  --compile-personalities=file\n"
+            "                         Write the fingerprints as a database for -p.\n"
             "  -u uid		  Set the uid Honeyd should run as.\n"
             "  -g gid		  Set the gid Honeyd should run as.\n"
             "  -f configfile          Read configuration from file.\n"
@@ -253,6 +293,11 @@ void usage(void)
             "  --disable-webserver    Disables internal webserver\n"
             "  --disable-update       Disables checking for security fixes.\n"
             "  --verify-config        Verify configuration file then exit.\n"
+            "  --max-connections=n    Limit on concurrent connections.\n"
+            "  --max-connections-per-source=n\n"
+            "                         Share of the limit a single source may hold.\n"
+            "  --connection-memory=size[k|m|g]\n"
+            "                         Memory budget for connection state.\n"
             "  -V, --version          Print program version and exit.\n"
             "  -h, --help             Print this message and exit.\n"
             "\n"
@@ -365,9 +410,9 @@ void honeyd_setudp(struct udp_con *con, struct ip_hdr *ip, struct ip6_hdr *ip6,
 }
 
 struct tuple *
-tuple_find(struct tree *root, struct tuple *key)
+tuple_find(struct flowtable *table, struct tuple *key)
 {
-    return SPLAY_FIND(tree, root, key);
+    return flowtable_find(table, key);
 }
 
 /*
@@ -471,6 +516,22 @@ void honeyd_rrd_cb(int fd, short what, void *arg)
     }
 }
 
+/*
+ * Gives memory back that the pools no longer need after a burst.
+ */
+
+static void honeyd_pool_cb(int fd, short what, void *arg)
+{
+    struct event *ev = arg;
+    struct timeval tv;
+
+    pool_reclaim();
+
+    timerclear(&tv);
+    tv.tv_sec = POOL_RECLAIM_INTERVAL;
+    evtimer_add(ev, &tv);
+}
+
 void honeyd_rrd_start(const char *rrdtool_path)
 {
     /* Initialize our traffic stats for rrdtool */
@@ -512,10 +573,16 @@ void honeyd_init(void)
     }
 
     /* Initalize ongoing connection state */
-    SPLAY_INIT(&tcpcons);
+    flowtable_init(&tcpcons, rand_uint32(honeyd_rand));
     TAILQ_INIT(&tcplru);
-    SPLAY_INIT(&udpcons);
+    flowtable_init(&udpcons, rand_uint32(honeyd_rand));
     TAILQ_INIT(&udplru);
+    SPLAY_INIT(&consources);
+
+    /* Connections come from a slab sized by connection_budget_init() */
+    pool_con = pool_init("connection",
+                         MAX(sizeof(struct tcp_con), sizeof(struct udp_con)));
+    pool_source = pool_init("source", sizeof(struct consource));
 
     memset(&honeyd_tmp, 0, sizeof(honeyd_tmp));
 
@@ -542,6 +609,17 @@ void honeyd_init(void)
 
     stats_network.input_bytes = count_new();
     stats_network.output_bytes = count_new();
+    stats_network.input_drops = count_new();
+}
+
+/* The interfaces report packets that the kernel could not queue for us */
+
+static void honeyd_drops_cb(struct interface *inter, uint32_t drops)
+{
+    count_increment(stats_network.input_drops, drops);
+
+    syslog(LOG_DEBUG, "%s: kernel dropped %u packets",
+           inter->if_ent.intf_name, drops);
 }
 
 #ifdef HAVE_PYTHON
@@ -557,6 +635,25 @@ honeyd_is_webserver_enabled(void)
 }
 #endif
 
+/* Passes a signal from the master on to all workers */
+
+static void honeyd_workers_signal(int sig)
+{
+    int i;
+
+    if (honeyd_worker)
+        return;
+
+    for (i = 1; i < honeyd_nworkers; i++)
+        if (honeyd_workerpids[i] > 0)
+            kill(honeyd_workerpids[i], sig);
+}
+
+static int honeyd_workers_subsystem(struct template *tmpl, void *arg)
+{
+    return (TAILQ_EMPTY(&tmpl->subsystems) ? 0 : -1);
+}
+
 void honeyd_exit(int status)
 {
     honeyd_logend(honeyd_logfp);
@@ -564,12 +661,18 @@ void honeyd_exit(int status)
 
     template_free_all(TEMPLATE_FREE_DEALLOCATE);
 
+    /* Send whatever is still queued while the interfaces are open */
+    txqueue_flush();
     interface_close_all();
 
     rand_close(honeyd_rand);
     ip_close(honeyd_ip);
     closelog();
-    unlink(PIDFILE);
+
+    /* The workers go down with the master */
+    honeyd_workers_signal(SIGTERM);
+    if (!honeyd_worker)
+        unlink(PIDFILE);
 
 #ifdef HAVE_PYTHON
     if (honeyd_is_webserver_enabled())
@@ -589,8 +692,7 @@ void honeyd_ether_cb46(const struct interface * inter,
 {
     struct ip_hdr *ip = NULL;
     struct ip6_hdr *ip6 = NULL;
-    u_char pkt[HONEYD_MTU + 40]; /* XXX - Enough? */
-    u_int len = 0, iplen = 0;
+    u_int iplen = 0;
 
     switch (eth_type)
     {
@@ -604,37 +706,11 @@ void honeyd_ether_cb46(const struct interface * inter,
         break;
     }
 
-    eth_pack_hdr(pkt, dst_mac_addr->addr_eth, /* destination */
-                 src_mac_addr->addr_eth, /* source */
-                 eth_type);
-
-    len = ETH_HDR_LEN + iplen;
+    /* The transmit queue keeps its own copy of the frame */
+    txqueue_ether((struct interface *) inter, dst_mac_addr, src_mac_addr,
+                  eth_type, arg, iplen);
 
-    if (sizeof(pkt) < len)
-    {
-        syslog(LOG_WARNING, "%s: IP packet is larger than buffer: %d", __func__,
-               len);
-        goto out;
-    }
-
-    memcpy(pkt + ETH_HDR_LEN, arg, iplen);
-    if (eth_send(inter->if_eth, pkt, len) != len)
-    {
-        syslog(LOG_ERR, "%s: couldn't send packet size %d: %m", __func__, len);
-    }
-    else
-    {
-        count_increment(stats_network.output_bytes, iplen);
-    }
-
-out: if (eth_type == ETH_TYPE_IPV6)
-    {
-        pool_free(pool_pkt, ip6);
-    }
-    else
-    {
-        pool_free(pool_pkt, ip);
-    }
+    pktbuf_free(arg);
 }
 
 void honeyd_ether_cb(struct arp_req * req, int success, void *arg)
@@ -647,6 +723,13 @@ void honeyd_ether_cb(struct arp_req * req, int success, void *arg)
  */
 void honeyd_ether_cb6(struct ndp_neighbor_req * req, int success, void * arg)
 {
+    /* the neighbor did not answer */
+    if (!success)
+    {
+        pktbuf_free(arg);
+        return;
+    }
+
     honeyd_ether_cb46(req->inter, &req->target_mac_addr, &req->source_mac_addr,
                       arg, ETH_TYPE_IPV6);
 }
@@ -663,8 +746,6 @@ void honeyd_deliver_ethernet(struct interface *inter, struct addr *src_pa,
     /* the arp structure is just used to store the mac addresses -very confusing */
     struct arp_req *req;
 
-    ip_checksum(ip, iplen);
-
     /* Ethernet delivery if possible */
     if ((req = arp_find(dst_pa)) == NULL )
     {
@@ -686,74 +767,107 @@ void honeyd_deliver_ethernet(struct interface *inter, struct addr *src_pa,
          * Fall through in case that this packet needs
          * to be dropped.
          */
-        pool_free(pool_pkt, ip);
+        pktbuf_free(ip);
     }
 }
 
 /*
- * Returs 1 if the passed type id is an ext header id, else false.
+ * Extension headers that can be walked with the generic next header
+ * and length fields.  ESP and "no next header" end the chain.
  */
-int is_ext_hdr_id(int ext_hdr_id)
-{
-    int i;
-    /* TODO: replace magic numbers */
-    uint8_t ext_hdr_ids[] =
-    { 0, 43, 44, 51, 50, 60, 59 };
-    for (i = 0; i < sizeof(ext_hdr_ids); i++)
-    {
-        if (ext_hdr_ids[i] == ext_hdr_id)
-            return 1;
-    }
-    return 0;
-}
+#define IP6_EXT_WALK	0x01
+#define IP6_EXT_UNFRAG	0x02	/* may be part of the unfragmentable part */
 
-int get_ext_hdr_length(struct ip6_ext_hdr *ext_hdr) {
-	/* ext len given in 8 octets + first 8 bytes */
-	return ext_hdr->ext_len * 8 + 8;
-}
+static const uint8_t ip6_exthdr[256] =
+{
+    [IPPROTO_HOPOPTS] = IP6_EXT_WALK | IP6_EXT_UNFRAG,
+    [IPPROTO_ROUTING] = IP6_EXT_WALK | IP6_EXT_UNFRAG,
+    [IPPROTO_DSTOPTS] = IP6_EXT_WALK | IP6_EXT_UNFRAG,
+    [IPPROTO_FRAGMENT] = IP6_EXT_WALK,
+    [IPPROTO_AH] = IP6_EXT_WALK,
+};
 
 /*
- * Sets the pointer to the next (ext) header of the package, and returns its position, if the header
- * could not be found then it returns -1
+ * Walks the extension header chain of an IPv6 packet once and records
+ * where every header starts, where the upper layer header is and how
+ * long the unfragmentable part is.  Only len bytes starting at ip6 are
+ * looked at.  Returns -1 if the chain is truncated or too long, in that
+ * case the descriptor has no upper layer protocol.
  */
-int get_ip6_next_hdr(u_char **next_hdr, struct ip6_hdr *ip6,
-                     uint8_t requested_next_hdr_id)
+int ip6_desc_parse(struct ip6_desc *desc, struct ip6_hdr *ip6, u_int len)
 {
-    u_char *pkt_ptr = (u_char *) (ip6 + 1);
-    uint8_t nxt_ext_hdr_id;
-    int position_in_pkt = IP6_HDR_LEN;
-    int ext_hdr_len;
-
-    if (ip6->ip6_nxt == requested_next_hdr_id)
-    {
-        *next_hdr = pkt_ptr;
-        return IP6_HDR_LEN;
-    }
-    else if (!is_ext_hdr_id(ip6->ip6_nxt))
-    {
-        return -1;
+    struct ip6_ext_hdr *ext;
+    u_int off = IP6_HDR_LEN, hlen;
+    uint8_t nxt;
+    int unfrag = 1;
+
+    desc->ip6 = ip6;
+    desc->nexts = 0;
+    desc->frag_off = 0;
+    desc->unfrag_len = IP6_HDR_LEN;
+    desc->unfrag_last = -1;
+    desc->proto = IPPROTO_NONE;
+    desc->off = IP6_HDR_LEN;
+
+    if (len < IP6_HDR_LEN)
+    {
+        desc->len = 0;
+        return (-1);
     }
+    if (len > IP6_HDR_LEN + ntohs(ip6->ip6_plen))
+        len = IP6_HDR_LEN + ntohs(ip6->ip6_plen);
+    desc->len = len;
 
-    /* walk through the package and try to find the requested header */
-    while (pkt_ptr < ((u_char*) ip6) + ip6->ip6_plen)
+    nxt = ip6->ip6_nxt;
+    while (ip6_exthdr[nxt] & IP6_EXT_WALK)
     {
-        nxt_ext_hdr_id = ((struct ip6_ext_hdr *) pkt_ptr)->ext_nxt;
-        if (nxt_ext_hdr_id != requested_next_hdr_id && !is_ext_hdr_id(nxt_ext_hdr_id))
+        if (desc->nexts == IP6_DESC_MAXEXT || off + 8 > len)
+            return (-1);
+
+        ext = (struct ip6_ext_hdr *) ((u_char *) ip6 + off);
+        if (nxt == IPPROTO_FRAGMENT)
+            hlen = 8;
+        else if (nxt == IPPROTO_AH)
+            hlen = (ext->ext_len + 2) << 2;
+        else
+            hlen = (ext->ext_len + 1) << 3;
+        if (off + hlen > len)
+            return (-1);
+
+        desc->ext_type[desc->nexts] = nxt;
+        desc->ext_off[desc->nexts] = off;
+
+        /* Destination options are only unfragmentable before routing */
+        if (unfrag && (ip6_exthdr[nxt] & IP6_EXT_UNFRAG) &&
+                (nxt != IPPROTO_DSTOPTS || ext->ext_nxt == IPPROTO_ROUTING))
         {
-            return -1;
+            desc->unfrag_len = off + hlen;
+            desc->unfrag_last = desc->nexts;
         }
-        ext_hdr_len = get_ext_hdr_length((struct ip6_ext_hdr *)pkt_ptr);
-        pkt_ptr += ext_hdr_len;
-        position_in_pkt += ext_hdr_len;
-        if (nxt_ext_hdr_id == requested_next_hdr_id)
+        else
+            unfrag = 0;
+
+        desc->nexts++;
+        off += hlen;
+        nxt = ext->ext_nxt;
+
+        if (desc->ext_type[desc->nexts - 1] == IPPROTO_FRAGMENT)
         {
-            *next_hdr = pkt_ptr;
-            return position_in_pkt;
+            desc->frag_off = off - hlen;
+            /* Later fragments do not carry the upper layer header */
+            if (ext->ext_data.fragment.offlg & IP6_OFF_MASK)
+            {
+                desc->proto = IPPROTO_FRAGMENT;
+                desc->off = desc->frag_off;
+                return (0);
+            }
         }
-
     }
 
-    return -1;
+    desc->proto = nxt;
+    desc->off = off;
+
+    return (0);
 }
 
 u_int get_number_of_fragments(u_int iplen, u_int unfrag_fraghdr_size, u_int size_of_fragmentable_part)
@@ -801,18 +915,22 @@ void ip6_copy_chunk_to_fragment(u_char *ip6_fragment_pkt, u_char *unfragmented_i
 
 /* TODO: path mtu discovery */
 void ip6_send_fragments(const struct interface *inter, struct addr *src_mac_addr,
-                        struct addr *target_mac_addr, struct ip6_hdr *ip6, u_int iplen)
+                        struct addr *target_mac_addr, const struct ip6_desc *desc)
 {
-    struct ip6_hdr *ip6_fragment;
+    struct ip6_hdr *ip6 = desc->ip6, *ip6_fragment;
     u_char *unfragmented_ip6_pkt, *ip6_fragment_pkt;
     struct ip6_ext_hdr *frag_hdr, *last_unfragmentable_ext_hdr = NULL;
     u_int number_of_fragments, fragment_size, size_of_fragmentable_part, current_fragment_number;
-    u_int bytes_left = iplen - IP6_HDR_LEN, bytes_sent = 0, is_not_last_fragment;
-
-    u_int size_of_unfragmentable_part = get_size_of_unfragmentable_part(ip6);
+    u_int iplen = desc->len;
+    u_int size_of_unfragmentable_part = desc->unfrag_len;
+    u_int bytes_left = iplen - size_of_unfragmentable_part, bytes_sent = 0, is_not_last_fragment;
     u_int unfrag_fraghdr_size = size_of_unfragmentable_part + SIZE_OF_IPV6_FRAGMENT_HEADER;
+    uint8_t nxt = ip6->ip6_nxt;
 
     unfragmented_ip6_pkt = (u_char *) ip6;
+    if (desc->unfrag_last != -1)
+        nxt = ((struct ip6_ext_hdr *) (unfragmented_ip6_pkt +
+                desc->ext_off[desc->unfrag_last]))->ext_nxt;
 
     /* calculate the size of the fragmentable part (it needs to be a multiple of 8) */
     size_of_fragmentable_part = HONEYD_MTU - unfrag_fraghdr_size;
@@ -824,7 +942,7 @@ void ip6_send_fragments(const struct interface *inter, struct addr *src_mac_addr
     for (current_fragment_number = 0; current_fragment_number < number_of_fragments; current_fragment_number++)
     {
 
-        ip6_fragment = (struct ip6_hdr *) pool_alloc(pool_pkt);
+        ip6_fragment = (struct ip6_hdr *) pktbuf_alloc(HONEYD_MTU);
         ip6_fragment_pkt = (u_char*) ip6_fragment;
 
         is_not_last_fragment = bytes_left > size_of_fragmentable_part;
@@ -846,15 +964,10 @@ void ip6_send_fragments(const struct interface *inter, struct addr *src_mac_addr
 
         /* create the fragment header */
         frag_hdr = (struct ip6_ext_hdr*) (ip6_fragment_pkt + size_of_unfragmentable_part);
-        get_last_unfragmentable_ext_hdr(ip6_fragment, last_unfragmentable_ext_hdr);
-        if (last_unfragmentable_ext_hdr == NULL )
-        {
-            frag_hdr->ext_nxt = ip6->ip6_nxt;
-        }
-        else
-        {
-            frag_hdr->ext_nxt = last_unfragmentable_ext_hdr->ext_nxt;
-        }
+        if (desc->unfrag_last != -1)
+            last_unfragmentable_ext_hdr = (struct ip6_ext_hdr *)
+                (ip6_fragment_pkt + desc->ext_off[desc->unfrag_last]);
+        frag_hdr->ext_nxt = nxt;
 
         /* set the fragment offset */
         frag_hdr->ext_data.fragment.offlg |= (htons(bytes_sent) & IP6_OFF_MASK);
@@ -880,12 +993,6 @@ void ip6_send_fragments(const struct interface *inter, struct addr *src_mac_addr
     return;
 }
 
-int is_fragmented_ipv6_packet(struct ip6_hdr *ip6)
-{
-	u_char *next_hdr = NULL;
-	return get_ip6_next_hdr(&next_hdr, ip6, IPPROTO_FRAGMENT) != -1;
-}
-
 /***
  * Function requires valid router advertisements
  */
@@ -916,7 +1023,7 @@ void ip6_deliver_packet_to_local_neighbor(const struct interface *inter,struct i
 	struct ndp_neighbor_req *ndp_req = ndp_neighbor_find(target_ip_addr);
 	struct template *gw_template = NULL;
 
-	if (ndp_req != NULL )
+	if (ndp_req != NULL && NDP_RESOLVED(ndp_req))
 	{
 	     honeyd_ether_cb46(inter, &ndp_req->target_mac_addr, source_mac_addr, ip6, ETH_TYPE_IPV6);
 	}
@@ -925,15 +1032,18 @@ void ip6_deliver_packet_to_local_neighbor(const struct interface *inter,struct i
 		/* send packet with gateway source or host source depending on whether we use a gateway */
 	    if (router_used)
 	    {
-	        gw = entry_routers_ip6->data;
+	        gw = network_first(entry_routers_ip6);
 	        if (gw != NULL )
 	        {
-	              gw_template = template_find(addr_ntoa(&gw->addr));
+	              gw_template = template_find_addr(&gw->addr);
 	              if (gw_template != NULL )
 	              {
 	                 icmp6_send_neighbor_sol(inter, &gw->addr, gw_template->ethernet_addr, target_ip_addr, honeyd_ether_cb6, ip6);
+	                 return;
 	              }
 	         }
+	         /* Nobody to ask for the neighbor */
+	         pktbuf_free(ip6);
 	    }
 	    else
 	    {
@@ -954,6 +1064,7 @@ void ip6_deliver_packet_to_router(const struct interface *inter, struct ip6_hdr
 	else
 	{
 	     syslog(LOG_DEBUG, "cannot send packet because no ethernet address and router advertisement is available...");
+	     pktbuf_free(ip6);
 	 }
 }
 
@@ -962,18 +1073,16 @@ void honeyd_deliver_ethernet6(const struct interface *inter,
                               struct ip6_hdr *ip6, u_int iplen)
 {
     struct addr target_ip_addr, source_ip_addr;
+    struct ip6_desc desc;
     int target_in_same_net = 1;
 
-
-    if (!is_fragmented_ipv6_packet(ip6))
-    {
-        ip6_checksum(ip6, iplen);
-    }
-
     /* fragment if necessary  */
     if (iplen > HONEYD_MTU)
     {
-        ip6_send_fragments(inter, source_mac_addr, target_mac_addr, ip6, iplen);
+        ip6_desc_parse(&desc, ip6, iplen);
+        ip6_send_fragments(inter, source_mac_addr, target_mac_addr, &desc);
+        /* The fragments are copies */
+        pktbuf_free(ip6);
         return;
     }
 
@@ -1001,60 +1110,58 @@ void honeyd_deliver_ethernet6(const struct interface *inter,
 }
 
 /*
- * Makes sure that we end up owning the memory referenced by
- * the delay descriptor.  We either tell to not free the
- * memory or just make our own copy.
+ * Returns a reference to the packet of the delay descriptor that can
+ * be handed to code that frees it later, e.g. the ARP handler.  If the
+ * delay holds a packet buffer, it is shared; only a captured frame that
+ * we do not own has to be copied.
  */
 
 struct ip_hdr *
 honeyd_delay_own_memory(struct delay *delay, struct ip_hdr *ip, u_int iplen)
 {
-    /* If we are not supposed to free the buffer then we do not own it */
-    if (!(delay->flags & DELAY_FREEPKT))
-    {
-        void *tmp = pool_alloc(pool_pkt);
-
-        memcpy(tmp, ip, iplen);
-        ip = tmp;
-    }
-    else
-    {
-        /*
-         * We are handling the memory ourselves: if we
-         * delegate the memory to the ARP handler, it will get
-         * freed later.
-         */
-        delay->flags &= ~DELAY_FREEPKT;
-    }
+    if (delay->flags & DELAY_FREEPKT)
+        return (pktbuf_ref(ip));
 
-    return (ip);
+    return (pktbuf_copy(ip, iplen));
 }
 
-/**
- * XXX do we want to merge this function with honeyd_delay_own_memory?
- */
 struct ip6_hdr *
 honeyd_delay_own_memory6(struct delay *delay, struct ip6_hdr *ip6, u_int iplen)
 {
-    /* If we are not supposed to free the buffer then we do not own it */
-    if (!(delay->flags & DELAY_FREEPKT))
-    {
-        void *tmp = pool_alloc(pool_pkt);
+    if (delay->flags & DELAY_FREEPKT)
+        return (pktbuf_ref(ip6));
 
-        memcpy(tmp, ip6, iplen);
-        ip6 = tmp;
-    }
-    else
+    return (pktbuf_copy(ip6, iplen));
+}
+
+/*
+ * Ethernet delivery for the delay pipeline.  If the destination has
+ * already been resolved, the frame goes straight to the transmit queue
+ * which keeps its own copy.  A reference is only needed when ARP has to
+ * hold on to the packet.
+ */
+
+static void
+honeyd_delay_ethernet(struct delay *delay, struct interface *inter,
+                      struct addr *src_pa, struct addr *src_ha, struct addr *dst_pa,
+                      struct ip_hdr *ip, u_int iplen)
+{
+    struct arp_req *req;
+
+    if (!(delay->flags & DELAY_CKSUM))
+        cksum_ip(ip, iplen);
+
+    if ((req = arp_find(dst_pa)) != NULL && req->cnt == -1)
     {
-        /*
-         * We are handling the memory ourselves: if we
-         * delegate the memory to the ARP handler, it will get
-         * freed later.
-         */
-        delay->flags &= ~DELAY_FREEPKT;
+        /* See honeyd_deliver_ethernet */
+        req->src_ha = *src_ha;
+        txqueue_ether(req->inter, &req->ha, &req->src_ha, ETH_TYPE_IP, ip,
+                      iplen);
+        return;
     }
 
-    return (ip6);
+    ip = honeyd_delay_own_memory(delay, ip, iplen);
+    honeyd_deliver_ethernet(inter, src_pa, src_ha, dst_pa, ip, iplen);
 }
 
 /*
@@ -1076,21 +1183,14 @@ honeyd_delay_own_memory6(struct delay *delay, struct ip6_hdr *ip6, u_int iplen)
  * It needs to unreference the passed template value.
  */
 
-static __inline void honeyd_send_normally(struct ip_hdr *ip, u_int iplen)
+static __inline void honeyd_send_normally(struct delay *delay,
+                                          struct ip_hdr *ip, u_int iplen)
 {
-    ip_checksum(ip, iplen);
+    if (!(delay->flags & DELAY_CKSUM))
+        cksum_ip(ip, iplen);
 
-    if (ip_send(honeyd_ip, ip, iplen) != iplen)
-    {
-        int level = LOG_ERR;
-        if (errno == EHOSTDOWN || errno == EHOSTUNREACH)
-            level = LOG_DEBUG;
-        syslog(level, "couldn't send packet: %m");
-    }
-    else
-    {
-        count_increment(stats_network.output_bytes, iplen);
-    }
+    /* Sent in a batch at the end of this event loop iteration */
+    txqueue_ip(ip, iplen);
 }
 
 void honeyd_delay_cb(int fd, short which, void *arg)
@@ -1104,7 +1204,7 @@ void honeyd_delay_cb(int fd, short which, void *arg)
     {
         /* Fix up TTL */
         ip->ip_ttl++;
-        ip_checksum(ip, ip->ip_hl << 2);
+        cksum_ip_hdr(ip);
         icmp_error_send(tmpl, &delay->src, ICMP_TIMEXCEED,
                         ICMP_TIMEXCEED_INTRANS, ip, delay->spoof);
     }
@@ -1112,7 +1212,7 @@ void honeyd_delay_cb(int fd, short which, void *arg)
     {
         /* Fix up TTL */
         ip->ip_ttl++;
-        ip_checksum(ip, ip->ip_hl << 2);
+        cksum_ip_hdr(ip);
         icmp_error_send(tmpl, &delay->src, ICMP_UNREACH, ICMP_UNREACH_NET, ip,
                         delay->spoof);
         /* this is if we have to delay the request to an external machine */
@@ -1132,20 +1232,18 @@ void honeyd_delay_cb(int fd, short which, void *arg)
             addr_pack(&src, ADDR_TYPE_IP, IP_ADDR_BITS, &ip->ip_src,
                       IP_ADDR_LEN);
 
-            ip = honeyd_delay_own_memory(delay, ip, iplen);
-
             /* This function computes the IP checksum for us */
-            honeyd_deliver_ethernet(tmpl->inter, &src, tmpl->ethernet_addr,
-                                    &dst, ip, iplen);
+            honeyd_delay_ethernet(delay, tmpl->inter, &src,
+                                  tmpl->ethernet_addr, &dst, ip, iplen);
         }
         else
         {
-            honeyd_send_normally(ip, iplen);
+            honeyd_send_normally(delay, ip, iplen);
         }
     }
     else if (delay->flags & DELAY_TUNNEL)
     {
-        ip_checksum(ip, iplen);
+        cksum_ip(ip, iplen);
 
         if (gre_encapsulate(honeyd_ip, &delay->src, &delay->dst, ip, iplen)
                 == -1)
@@ -1156,7 +1254,7 @@ void honeyd_delay_cb(int fd, short which, void *arg)
     }
     else if (delay->flags & DELAY_ETHERNET)
     {
-        extern struct network *reverse;
+        extern struct nettable *reverse;
         struct interface *inter = tmpl->inter;
         struct router *router;
         struct addr addr;
@@ -1177,10 +1275,9 @@ void honeyd_delay_cb(int fd, short which, void *arg)
          * buffer.
          */
 
-        ip = honeyd_delay_own_memory(delay, ip, iplen);
         /* This function computes the IP checksum for us */
-        honeyd_deliver_ethernet(inter, &router->addr,
-                                &inter->if_ent.intf_link_addr, &addr, ip, iplen);
+        honeyd_delay_ethernet(delay, inter, &router->addr,
+                              &inter->if_ent.intf_link_addr, &addr, ip, iplen);
         /* this should be the most used condition */
     }
     else
@@ -1193,7 +1290,7 @@ void honeyd_delay_cb(int fd, short which, void *arg)
         addr_pack(&addr, ADDR_TYPE_IP, IP_ADDR_BITS, &ip->ip_dst, IP_ADDR_LEN);
 
         /* Internal delivery */
-        tmpl = template_find_best(addr_ntoa(&addr), ip, iplen);
+        tmpl = template_find_best(&addr, ip, iplen);
         tmpl = template_ref(tmpl);
 
         /* Check for fragmentation */
@@ -1211,7 +1308,7 @@ void honeyd_delay_cb(int fd, short which, void *arg)
     }
 
     if (delay->flags & DELAY_FREEPKT)
-        pool_free(pool_pkt, ip);
+        pktbuf_free(delay->ip);
     template_free(tmpl);
 
     if (delay->flags & DELAY_NEEDFREE)
@@ -1236,21 +1333,22 @@ void honeyd_send_normally6(struct ip6_hdr *ip6, int iplen)
         /* just take the first entry router on the list */
         if (gw == NULL )
         {
-            gw = entry_routers_ip6->data;
+            gw = network_first(entry_routers_ip6);
         }
 
         if (gw == NULL )
         {
             syslog(LOG_DEBUG, "honeyd_send_normally6: could not find a gateway for %s, %d", addr_ntoa(&src), ip6->ip6_hlim);
+            pktbuf_free(ip6);
             return;
         }
 
         /* find the entry routers template to get the interface and the ethernet address */
-        tmpl = template_find(addr_ntoa(&gw->addr));
+        tmpl = template_find_addr(&gw->addr);
     }
     else
     {
-        tmpl = template_find(addr_ntoa(&src));
+        tmpl = template_find_addr(&src);
     }
 
 
@@ -1262,6 +1360,7 @@ void honeyd_send_normally6(struct ip6_hdr *ip6, int iplen)
     {
         syslog(LOG_DEBUG,
                "could not send packet because source or the ethernet address of the source is unknown");
+        pktbuf_free(ip6);
     }
 
 }
@@ -1275,6 +1374,8 @@ void ip6_delay_external(struct delay *delay)
 	u_int iplen = delay->iplen, is_packet_for_hardware_interface;
 	addr_pack(&dst, ADDR_TYPE_IP6, IP6_ADDR_BITS, &ip6->ip6_dst, IP6_ADDR_LEN);
 	is_packet_for_hardware_interface = tmpl != NULL && tmpl->ethernet_addr != NULL && interface_find_responsible(&dst) == tmpl->inter;
+	if (!(delay->flags & DELAY_CKSUM))
+		cksum_ip6(ip6, iplen);
 	if (is_packet_for_hardware_interface)
 	{
 	    ip6_addr_t_to_addr(&src,&ip6->ip6_src);
@@ -1283,6 +1384,7 @@ void ip6_delay_external(struct delay *delay)
 	}
 	else
 	{
+	    ip6 = honeyd_delay_own_memory6(delay, ip6, iplen);
 	    honeyd_send_normally6(ip6, iplen);
 	}
 }
@@ -1292,36 +1394,42 @@ void ip6_delay_internal(struct delay *delay)
 	struct ip6_hdr *ip6 = delay->ip6;
 	struct template *tmpl = delay->tmpl;
 	struct addr addr;
-	struct ip6_ext_hdr *frag_hdr = NULL;
+	struct ip6_desc desc;
 
 	template_free(tmpl);
 
 	addr_pack(&addr, ADDR_TYPE_IP6, IP6_ADDR_BITS, &ip6->ip6_dst, IP6_ADDR_LEN);
 
 	/* Internal delivery */
-	tmpl = template_find(addr_ntoa(&addr));
+	tmpl = template_find_addr(&addr);
+	if (tmpl != NULL && tmpl->flags & TEMPLATE_DYNAMIC)
+		tmpl = template_dynamic(tmpl, (const u_char *)ip6,
+		    delay->iplen);
 	tmpl = template_ref(tmpl);
 
 	/* Check for fragmentation */
-	get_ip6_next_hdr((u_char**) &frag_hdr, ip6, IPPROTO_FRAGMENT);
-	if (frag_hdr != NULL )
+	ip6_desc_parse(&desc, ip6, delay->iplen);
+	if (desc.frag_off)
 	{
 		/* tmpl may be null */
 		/* if packet assembling is not finished the return */
-		if (ip6_fragment(tmpl, &ip6, frag_hdr))
+		if (ip6_fragment(tmpl, &ip6, &desc))
 		{
-			honeyd_dispatch6(tmpl, ip6);
+			/* The reassembled packet has a chain of its own */
+			ip6_desc_parse(&desc, ip6,
+			    IP6_HDR_LEN + ntohs(ip6->ip6_plen));
+			honeyd_dispatch6(tmpl, &desc);
 		}
 	}
 	else
 	{
-		honeyd_dispatch6(tmpl, ip6);
+		honeyd_dispatch6(tmpl, &desc);
 	}
 }
 
 void ip6_delay_ethernet(struct delay *delay)
 {
-	extern struct network *reverse6;
+	extern struct nettable *reverse6;
 	struct ip6_hdr *ip6 = delay->ip6;
 	struct template *tmpl = delay->tmpl;
 	struct interface *inter = tmpl->inter;
@@ -1346,19 +1454,12 @@ void ip6_delay_ethernet(struct delay *delay)
 	 */
 
 	ip6 = honeyd_delay_own_memory6(delay, ip6, iplen);
+	if (!(delay->flags & DELAY_CKSUM))
+		cksum_ip6(ip6, iplen);
 
-	/* This function computes the IP checksum for us */
 	honeyd_deliver_ethernet6(inter, &router->addr,
 			&inter->if_ent.intf_link_addr, ip6, iplen);
 
-	/* XXX deliver ethernet automatically frees the pool, hence we need
-	 not to free the pool when using honeyd_send_normally6, but in this
-	 case an explicit free is needed, this is very confusing
-	 - should the ethernet send function really do a clear?  */
-	if (delay->flags & DELAY_FREEPKT)
-	{
-		pool_free(pool_pkt, ip6);
-	}
 	template_free(tmpl);
 	/* this should be the most used condition */
 }
@@ -1397,6 +1498,8 @@ void honeyd_delay_cb6(int fd, short which, void *arg)
         ip6_delay_internal(delay);
     }
 
+    if (delay->flags & DELAY_FREEPKT)
+        pktbuf_free(delay->ip6);
     if (delay->flags & DELAY_NEEDFREE)
         pool_free(pool_delay, delay);
     /* TODO: verify */
@@ -1414,7 +1517,6 @@ void honeyd_delay_packet46(struct template *tmpl, struct ip_hdr *ip,
                            int addr_family)
 {
     struct delay *delay, tmp_delay;
-    struct timeval tv;
 
     if (ms)
     {
@@ -1422,28 +1524,16 @@ void honeyd_delay_packet46(struct template *tmpl, struct ip_hdr *ip,
         flags |= DELAY_NEEDFREE;
 
         /*
-         * If the IP packet is not allocated separately, we
-         * need to allocate it here.
+         * A captured frame only lives as long as the receive
+         * callback, so it has to be copied before we can hold
+         * on to it.  Packet buffers are simply passed along.
          */
         if ((flags & DELAY_FREEPKT) == 0)
         {
-            void *tmp;
-
-            if (iplen < HONEYD_MTU)
-                tmp = pool_alloc(pool_pkt);
-            else
-                tmp = pool_alloc_size(pool_pkt, iplen);
-
             if (addr_family == AF_INET)
-            {
-                memcpy(tmp, ip, iplen);
-                ip = tmp;
-            }
+                ip = pktbuf_copy(ip, iplen);
             else if (addr_family == AF_INET6)
-            {
-                memcpy(tmp, ip6, iplen);
-                ip6 = tmp;
-            }
+                ip6 = pktbuf_copy(ip6, iplen);
 
             flags |= DELAY_FREEPKT;
         }
@@ -1476,15 +1566,13 @@ void honeyd_delay_packet46(struct template *tmpl, struct ip_hdr *ip,
 
     if (ms)
     {
+        /* Delayed packets are released in batches by the timer wheel */
+        delay->timeout.tw_list = NULL;
         if (addr_family == AF_INET)
-            evtimer_set(&delay->timeout, honeyd_delay_callback, delay);
+            timerwheel_add(&delay->timeout, ms, honeyd_delay_callback, delay);
         if (addr_family == AF_INET6)
-            evtimer_set(&delay->timeout, honeyd_delay_callback6, delay);
-
-        timerclear(&tv);
-        tv.tv_sec = ms / 1000;
-        tv.tv_usec = (ms % 1000) * 1000;
-        evtimer_add(&delay->timeout, &tv);
+            timerwheel_add(&delay->timeout, ms, honeyd_delay_callback6,
+                           delay);
     }
     else
     {
@@ -1543,16 +1631,16 @@ void honeyd_ip_send(u_char *pkt, u_int iplen, struct spoof spoof)
     addr_pack(&src, ADDR_TYPE_IP, IP_ADDR_BITS, &ip->ip_src, IP_ADDR_LEN);
 
     /* Find the template for the external address */
-    tmpl = template_find_best(addr_ntoa(&addr), ip, iplen);
+    tmpl = template_find_best(&addr, ip, iplen);
     if (tmpl != NULL && tmpl->flags & TEMPLATE_EXTERNAL)
         flags |= DELAY_ETHERNET;
 
     /* But all sending decisions are really based on the source template */
-    tmpl = template_find_best(addr_ntoa(&src), ip, iplen);
+    tmpl = template_find_best(&src, ip, iplen);
 
     if (router_used)
     {
-        extern struct network *reverse;
+        extern struct nettable *reverse;
         struct router *router;
 
         router = network_lookup(reverse, &src);
@@ -1596,7 +1684,7 @@ void honeyd_ip_send(u_char *pkt, u_int iplen, struct spoof spoof)
 
 drop:
     /* Deallocate the packet */
-    pool_free(pool_pkt, pkt);
+    pktbuf_free(pkt);
 }
 
 void honeyd_ip6_send(u_char *pkt, u_int iplen, struct spoof spoof)
@@ -1617,18 +1705,18 @@ void honeyd_ip6_send(u_char *pkt, u_int iplen, struct spoof spoof)
     ip6_addr_t_to_addr(&src, &ip6->ip6_src);
 
     /* Find the template for the external address */
-    tmpl = template_find(addr_ntoa(&addr));
+    tmpl = template_find_addr(&addr);
     if (tmpl != NULL && tmpl->flags & TEMPLATE_EXTERNAL)
     {
         flags |= DELAY_ETHERNET;
     }
 
     /* But all sending decisions are really based on the source template */
-    tmpl = template_find(addr_ntoa(&src));
+    tmpl = template_find_addr(&src);
 
     if (router_used)
     {
-        extern struct network *reverse6;
+        extern struct nettable *reverse6;
         struct router *router;
         router = network_lookup(reverse6, &src);
         if (router == NULL )
@@ -1663,22 +1751,94 @@ void honeyd_ip6_send(u_char *pkt, u_int iplen, struct spoof spoof)
 drop:
     /* Deallocate the packet */
     syslog(LOG_DEBUG, "packet drop");
-    pool_free(pool_pkt, pkt);
+    pktbuf_free(pkt);
+}
+
+static int consource_compare(struct consource *a, struct consource *b)
+{
+    return (addr_cmp(&a->addr, &b->addr));
 }
 
-static void connection_insert(struct tree *tree, struct conlru *head,
+SPLAY_PROTOTYPE(sourcetree, consource, node, consource_compare);
+SPLAY_GENERATE(sourcetree, consource, node, consource_compare);
+
+/*
+ * Fills in the address that a connection is accounted to.  IPv6 hosts
+ * can pick any address from their /64, so we hold the prefix responsible.
+ */
+
+static void consource_key(struct addr *key, const ip_addr_t *ip_src,
+                          const ip6_addr_t *ip6_src)
+{
+    memset(key, 0, sizeof(struct addr));
+    if (ip6_src != NULL )
+    {
+        key->addr_type = ADDR_TYPE_IP6;
+        key->addr_bits = 64;
+        memcpy(&key->addr_ip6, ip6_src, 8);
+    }
+    else
+    {
+        addr_pack(key, ADDR_TYPE_IP, IP_ADDR_BITS, ip_src, IP_ADDR_LEN);
+    }
+}
+
+static struct consource *consource_get(struct tuple *hdr)
+{
+    struct consource tmp, *source;
+
+    if (hdr->src_addr.addr_type == ADDR_TYPE_IP6)
+        consource_key(&tmp.addr, NULL, &hdr->src_addr.addr_ip6);
+    else
+        consource_key(&tmp.addr, &hdr->ip_src, NULL);
+
+    if ((source = SPLAY_FIND(sourcetree, &consources, &tmp)) != NULL )
+        return (source);
+
+    source = pool_alloc(pool_source);
+    memset(source, 0, sizeof(struct consource));
+    source->addr = tmp.addr;
+    TAILQ_INIT(&source->cons);
+    SPLAY_INSERT(sourcetree, &consources, source);
+    honeyd_conbudget.nsources++;
+
+    return (source);
+}
+
+static void connection_insert(struct flowtable *table, struct conlru *head,
                               struct tuple *hdr)
 {
-    SPLAY_INSERT(tree, tree, hdr);
+    struct consource *source = consource_get(hdr);
+
+    flowtable_insert(table, hdr);
     TAILQ_INSERT_HEAD(head, hdr, next);
+
+    hdr->source = source;
+    hdr->lastuse = ++honeyd_conclock;
+    TAILQ_INSERT_HEAD(&source->cons, hdr, source_next);
+    source->count++;
+
+    honeyd_nconnects++;
 }
 
-static void connection_remove(struct tree *tree, struct conlru *head,
+static void connection_remove(struct flowtable *table, struct conlru *head,
                               struct tuple *hdr)
 {
-    SPLAY_REMOVE(tree, tree, hdr);
+    struct consource *source = hdr->source;
+
+    flowtable_remove(table, hdr);
     TAILQ_REMOVE(head, hdr, next);
 
+    TAILQ_REMOVE(&source->cons, hdr, source_next);
+    if (--source->count == 0)
+    {
+        SPLAY_REMOVE(sourcetree, &consources, source);
+        pool_free(pool_source, source);
+        honeyd_conbudget.nsources--;
+    }
+
+    honeyd_nconnects--;
+
     evtimer_del(&hdr->timeout);
 }
 
@@ -1689,8 +1849,163 @@ static void connection_update(struct conlru *head, struct tuple *hdr)
     TAILQ_REMOVE(head, hdr, next);
     TAILQ_INSERT_HEAD(head, hdr, next);
 
+    TAILQ_REMOVE(&hdr->source->cons, hdr, source_next);
+    TAILQ_INSERT_HEAD(&hdr->source->cons, hdr, source_next);
+    hdr->lastuse = ++honeyd_conclock;
+
     generic_timeout(&hdr->timeout, HONEYD_IDLE_TIMEOUT);
 }
+
+const char *connection_evict_name(enum con_evict reason)
+{
+    static const char *names[CON_EVICT_MAX] =
+    { "idle", "source" };
+
+    return (reason < CON_EVICT_MAX ? names[reason] : "unknown");
+}
+
+/*
+ * Makes room for a new connection from the given source once the
+ * connection budget has been exhausted.  A source that already holds
+ * its share pays with its own least recently used connection, otherwise
+ * the least recently active TCP or UDP connection goes.
+ */
+
+static void connection_make_room(const struct addr *key)
+{
+    struct consource tmp, *source;
+    struct tuple *victim, *tcptail, *udptail;
+    enum con_evict reason;
+
+    while (honeyd_nconnects >= honeyd_conbudget.max_connects)
+    {
+        tmp.addr = *key;
+        source = SPLAY_FIND(sourcetree, &consources, &tmp);
+        if (source != NULL
+                && source->count >= honeyd_conbudget.max_per_source)
+        {
+            victim = TAILQ_LAST(&source->cons, conlru);
+            reason = CON_EVICT_SOURCE;
+        }
+        else
+        {
+            tcptail = TAILQ_LAST(&tcplru, conlru);
+            udptail = TAILQ_LAST(&udplru, conlru);
+            if (tcptail == NULL )
+                victim = udptail;
+            else if (udptail == NULL )
+                victim = tcptail;
+            else
+                victim = (int32_t)(tcptail->lastuse - udptail->lastuse) <= 0 ?
+                         tcptail : udptail;
+            reason = CON_EVICT_IDLE;
+        }
+
+        if (victim == NULL )
+            break;
+
+        honeyd_conbudget.evictions[reason]++;
+        syslog(LOG_DEBUG, "Evicting %s %s: %s",
+               victim->type == SOCK_STREAM ? "tcp" : "udp",
+               honeyd_contoa(victim), connection_evict_name(reason));
+
+        if (victim->type == SOCK_STREAM)
+            tcp_free((struct tcp_con *) victim);
+        else
+            udp_free((struct udp_con *) victim);
+    }
+}
+
+/*
+ * Sizes the connection table from the command line or the config file
+ * and preallocates the connection slab.  The memory budget is converted
+ * into a number of connections; if both are given the smaller one wins.
+ */
+
+void connection_budget_init(void)
+{
+    const struct honeyd_plugin_cfg *cfg;
+    struct conbudget *budget = &honeyd_conbudget;
+    size_t cost = sizeof(struct pool_entry) + pool_con->size;
+    size_t bytes = honeyd_opt_connect_memory;
+    int max = honeyd_opt_max_connects;
+    int persource = honeyd_opt_max_persource;
+
+    if (max <= 0 && (cfg = plugins_config_find_item("honeyd",
+                           "max_connections", HD_CONFIG_INT)) != NULL )
+        max = cfg->cfg_int;
+    if (bytes == 0 && (cfg = plugins_config_find_item("honeyd",
+                             "connection_memory", HD_CONFIG_INT)) != NULL
+            && cfg->cfg_int > 0)
+        bytes = (size_t)cfg->cfg_int << 20;
+    if (persource <= 0 && (cfg = plugins_config_find_item("honeyd",
+                                 "max_connections_per_source", HD_CONFIG_INT)) != NULL )
+        persource = cfg->cfg_int;
+
+    if (max <= 0 && bytes == 0)
+        max = HONEYD_MAX_CONNECTS;
+    if (bytes != 0 && (max <= 0 || bytes / cost < (size_t)max))
+        max = bytes / cost;
+    if (max <= 0)
+        errx(1, "Connection memory of %lu bytes does not hold a connection",
+             (u_long)bytes);
+
+    /* Every worker holds its share of the connections */
+    max = MAX(max / honeyd_nworkers, 1);
+    bytes /= honeyd_nworkers;
+
+    if (persource <= 0)
+        persource = MAX(max / HONEYD_SOURCE_SHARE, 1);
+    if (persource > max)
+        persource = max;
+
+    budget->max_connects = max;
+    budget->max_per_source = persource;
+    budget->max_bytes = bytes;
+
+    pool_prealloc(pool_con, max);
+
+    syslog(LOG_INFO, "Connection budget: %d connections, %d per source, "
+           "%lu KB", max, persource, (u_long)(max * cost) >> 10);
+}
+
+/*
+ * Parses a size with an optional k, m or g suffix.  Plain numbers are
+ * megabytes like in the configuration file.
+ */
+
+static size_t honeyd_parse_size(const char *str)
+{
+    unsigned long long size;
+    char *ep;
+
+    size = strtoull(str, &ep, 10);
+    switch (*ep)
+    {
+    case 'k':
+    case 'K':
+        size <<= 10;
+        ep++;
+        break;
+    case 'g':
+    case 'G':
+        size <<= 30;
+        ep++;
+        break;
+    case 'm':
+    case 'M':
+        ep++;
+        /* FALLTHROUGH */
+    default:
+        size <<= 20;
+        break;
+    }
+
+    if (ep == str || *ep != '\0' || size == 0)
+        return (0);
+
+    return (size);
+}
 /**
  * Creates a new TCP connection.
  */
@@ -1699,23 +2014,16 @@ tcp_new46(struct ip_hdr *ip, struct ip6_hdr *ip6, struct tcp_hdr *tcp,
           int local)
 {
     struct tcp_con *con;
-    if (honeyd_nconnects >= HONEYD_MAX_CONNECTS)
-    {
-        /*
-         * We seem to be in an overload situation - remove the
-         * oldest connection available.
-         */
-        con = (struct tcp_con *) TAILQ_LAST(&tcplru, conlru);
-        tcp_free(con);
-    }
+    struct addr key;
 
-    if ((con = calloc(1, sizeof(struct tcp_con))) == NULL )
-    {
-        syslog(LOG_WARNING, "calloc: %m");
-        return (NULL );
-    }
+    /* We might be in an overload situation - apply the eviction policy */
+    consource_key(&key, ip6 == NULL ? &ip->ip_src : NULL,
+                  ip6 != NULL ? &ip6->ip6_src : NULL);
+    connection_make_room(&key);
+
+    con = pool_alloc(pool_con);
+    memset(con, 0, sizeof(struct tcp_con));
 
-    honeyd_nconnects++;
     if (ip6 == NULL )
     {
         con->addr_family = AF_INET;
@@ -1770,15 +2078,12 @@ void tcp_free(struct tcp_con *con)
 
     if (con->cmd_pfd > 0)
         cmd_free(&con->cmd);
-    if (con->payload != NULL )
-        free(con->payload);
-    if (con->readbuf != NULL )
-        free(con->readbuf);
+    tcpbuf_free(&con->sendbuf);
+    tcpbuf_free(&con->readbuf);
     if (con->tmpl != NULL )
         template_free(con->tmpl);
 
-    honeyd_nconnects--;
-    free(con);
+    pool_free(pool_con, con);
 }
 
 void tcp_retrans_timeout(int fd, short event, void *arg)
@@ -1826,12 +2131,14 @@ udp_new(struct ip_hdr *ip, struct ip6_hdr *ip6, struct udp_hdr *udp, int local,
         int addr_family)
 {
     struct udp_con *con;
+    struct addr key;
 
-    if ((con = calloc(1, sizeof(struct udp_con))) == NULL )
-    {
-        syslog(LOG_WARNING, "calloc: %m");
-        return (NULL );
-    }
+    consource_key(&key, addr_family != AF_INET6 ? &ip->ip_src : NULL,
+                  addr_family == AF_INET6 ? &ip6->ip6_src : NULL);
+    connection_make_room(&key);
+
+    con = pool_alloc(pool_con);
+    memset(con, 0, sizeof(struct udp_con));
 
     if (ip6 == NULL )
         con->addr_family = AF_INET;
@@ -1886,7 +2193,7 @@ void udp_free(struct udp_con *con)
     if (con->tmpl != NULL )
         template_free(con->tmpl);
 
-    free(con);
+    pool_free(pool_con, con);
 }
 
 void honeyd_tcp_timeout(int fd, short event, void *arg)
@@ -2026,43 +2333,20 @@ int proxy_connect(struct tuple *hdr, struct command *cmd, struct addrinfo *ai,
 
 void tcp_connectfail(struct tcp_con *con)
 {
-    if (con->payload)
-    {
-        free(con->payload);
-        con->payload = NULL;
-    }
-    if (con->readbuf)
-    {
-        free(con->readbuf);
-        con->readbuf = NULL;
-    }
+    tcpbuf_free(&con->sendbuf);
+    tcpbuf_free(&con->readbuf);
+    con->poff = 0;
 }
 
 /* Sets up buffers for a fully connected TCP connection */
 
 int tcp_setupconnect(struct tcp_con *con)
 {
-    struct tuple *hdr = &con->conhdr;
-
-    /* Allocate buffers */
-    if ((con->payload = malloc(TCP_DEFAULT_SIZE)) == NULL )
-    {
-        syslog(LOG_WARNING, "malloc %s: %m", honeyd_contoa(hdr));
-        goto err;
-    }
-    if ((con->readbuf = malloc(TCP_DEFAULT_SIZE)) == NULL )
-    {
-        syslog(LOG_WARNING, "malloc %s: %m", honeyd_contoa(hdr));
-        goto err;
-    }
-    con->psize = TCP_DEFAULT_SIZE;
-    con->rsize = TCP_DEFAULT_SIZE;
-
+    /*
+     * Both buffers start out empty and take segments from the pool
+     * as data arrives, so there is nothing to allocate up front.
+     */
     return (0);
-
-err: tcp_connectfail(con);
-
-    return (-1);
 }
 
 void generic_connect(struct template *tmpl, struct tuple *hdr,
@@ -2178,18 +2462,38 @@ out: syslog(LOG_DEBUG, "Connection established: %s %s",
                 proto == IP_PROTO_TCP ? "tcp" : "udp", honeyd_contoa(hdr));
 }
 
-int tcp_send46(struct tcp_con *con, uint8_t flags, u_char *payload, u_int len,
-               int addr_family)
+/*
+ * Copies the payload that is described by the io vectors behind the
+ * TCP header.  This is the only copy of stream data on the way out.
+ */
+static void tcp_gather(u_char *p, const struct iovec *iov, int niov)
+{
+    int i;
+
+    for (i = 0; i < niov; i++)
+    {
+        memcpy(p, iov[i].iov_base, iov[i].iov_len);
+        p += iov[i].iov_len;
+    }
+}
+
+int tcp_sendv46(struct tcp_con *con, uint8_t flags, const struct iovec *iov,
+                int niov, int addr_family)
 {
     u_char *pkt;
     struct tcp_hdr *tcp;
-    u_int iplen = 0;
+    u_int iplen = 0, len = 0;
     int window = 16000;
     int dontfragment = 0;
-    char *options;
+    const struct persopts *options;
     uint16_t id = rand_uint16(honeyd_rand);
     struct spoof spoof;
     struct template *tmpl = con->tmpl;
+    int i;
+
+    for (i = 0; i < niov; i++)
+        len += iov[i].iov_len;
+
     if (con->window)
         window = con->window;
 
@@ -2211,7 +2515,7 @@ int tcp_send46(struct tcp_con *con, uint8_t flags, u_char *payload, u_int len,
         }
         else if (flags & TH_SYN)
         {
-            options = "m";
+            options = &persopts_mss;
         }
     }
 
@@ -2226,14 +2530,14 @@ int tcp_send46(struct tcp_con *con, uint8_t flags, u_char *payload, u_int len,
         con->window = window;
 
     /* Simple window tracking */
-    if (window && con->rlen)
+    if (window && con->readbuf.len)
     {
-        window -= con->rlen;
+        window -= con->readbuf.len;
         if (window < 0)
             window = 0;
     }
 
-    pkt = pool_alloc(pool_pkt);
+    pkt = pktbuf_alloc(HONEYD_MTU);
 
     /*TODO: consider ipv6 extension header length, in case of ipv4 */
     if (addr_family != AF_INET6)
@@ -2282,7 +2586,7 @@ int tcp_send46(struct tcp_con *con, uint8_t flags, u_char *payload, u_int len,
         ip_pack_hdr(pkt, 0, iplen, id, dontfragment ? IP_DF : 0, honeyd_ttl,
                     IP_PROTO_TCP, con->con_ipdst, con->con_ipsrc);
 
-        memcpy(pkt + IP_HDR_LEN + (tcp->th_off << 2), payload, len);
+        tcp_gather(pkt + IP_HDR_LEN + (tcp->th_off << 2), iov, niov);
 
         hooks_dispatch(IP_PROTO_TCP, HD_OUTGOING, &con->conhdr, pkt, iplen);
 
@@ -2303,7 +2607,7 @@ int tcp_send46(struct tcp_con *con, uint8_t flags, u_char *payload, u_int len,
         /* set the playload length by hand */
         //ip6 = pkt;
         //ip6->ip6_plen = htons(iplen - IP6_HDR_LEN);
-        memcpy(pkt + IP6_HDR_LEN + (tcp->th_off << 2), payload, len);
+        tcp_gather(pkt + IP6_HDR_LEN + (tcp->th_off << 2), iov, niov);
         /* TODO: check if the hooks face any problems with ipv6 addresses */
         hooks_dispatch(IP_PROTO_TCP, HD_OUTGOING, &con->conhdr, pkt, iplen);
 
@@ -2313,23 +2617,39 @@ int tcp_send46(struct tcp_con *con, uint8_t flags, u_char *payload, u_int len,
     return (len);
 }
 
+int tcp_send46(struct tcp_con *con, uint8_t flags, u_char *payload, u_int len,
+               int addr_family)
+{
+    struct iovec iov;
+
+    iov.iov_base = payload;
+    iov.iov_len = len;
+
+    return tcp_sendv46(con, flags, &iov, len ? 1 : 0, addr_family);
+}
+
 int tcp_send(struct tcp_con *con, uint8_t flags, u_char *payload, u_int len)
 {
     return tcp_send46(con, flags, payload, len, con->addr_family);
 }
 
+/*
+ * Sends the data that has not been sent yet in segments of the size
+ * that the peer asked for.  The segments point into the send buffer,
+ * so a retransmit only rewinds poff and sends from the buffer again.
+ */
 void tcp_senddata46(struct tcp_con *con, uint8_t flags, int addr_family)
 {
-    int space, sent = 0;
+    struct iovec iov[TCPBUF_IOVMAX];
+    u_int space, segsize = tcp_segsize(con);
+    int niov, sent = 0;
     int needretrans = 0;
 
     do
     {
-        space = TCP_MAX_INFLIGHT - TCP_BYTESINFLIGHT(con);
-        if (space > TCP_MAX_SEND)
-            space = TCP_MAX_SEND;
-        if (con->plen - con->poff < space)
-            space = con->plen - con->poff;
+        space = con->sendbuf.len - TCP_BYTESINFLIGHT(con);
+        if (space > segsize)
+            space = segsize;
 
         /* Reduce the amount of data that we can send */
         if (space && (con->flags & TCP_TARPIT))
@@ -2337,7 +2657,7 @@ void tcp_senddata46(struct tcp_con *con, uint8_t flags, int addr_family)
 
         if (con->sentfin && !con->finacked)
             flags |= TH_FIN;
-        if (con->plen > space)
+        if (con->sendbuf.len > space)
             flags &= ~TH_FIN;
 
         /*
@@ -2347,16 +2667,11 @@ void tcp_senddata46(struct tcp_con *con, uint8_t flags, int addr_family)
         if (space == 0 && con->last_acked == con->rcv_next && !(flags & TH_FIN))
             break;
 
-        con->snd_una += con->poff;
-        if (addr_family == AF_INET)
-        {
-            sent = tcp_send(con, flags, con->payload + con->poff, space);
-        }
-        else if (addr_family == AF_INET6)
-        {
-            sent = tcp_send(con, flags, con->payload + con->poff, space);
-        }
+        niov = TCPBUF_IOVMAX;
+        tcpbuf_iovec(&con->sendbuf, con->poff, space, iov, &niov);
 
+        con->snd_una += con->poff;
+        sent = tcp_sendv46(con, flags, iov, niov, addr_family);
         con->snd_una -= con->poff;
         con->poff += sent;
 
@@ -2462,7 +2777,7 @@ void icmp_error_send(struct template *tmpl, struct addr *addr, uint8_t type,
 
     iplen = IP_HDR_LEN + ICMP_HDR_LEN + 4 + quotelen;
 
-    pkt = pool_alloc(pool_pkt);
+    pkt = pktbuf_alloc(HONEYD_MTU);
 
     icmp_pack_hdr_quote(pkt + IP_HDR_LEN, type, code, 0, rip, quotelen);
     icmp_send(tmpl, pkt, tos, iplen, df ? IP_DF : 0, ttl, IP_PROTO_ICMP,
@@ -2513,10 +2828,7 @@ void icmp_echo_reply(struct template *tmpl, struct ip_hdr *rip, uint8_t code,
 
     iplen = IP_HDR_LEN + ICMP_HDR_LEN + 4 + len;
 
-    if (iplen < HONEYD_MTU)
-        pkt = pool_alloc(pool_pkt);
-    else
-        pkt = pool_alloc_size(pool_pkt, iplen);
+    pkt = pktbuf_alloc(iplen);
 
     icmp_pack_hdr_echo(pkt + IP_HDR_LEN, ICMP_ECHOREPLY, code,
                        ntohs(icmp_echo->icmp_id), ntohs(icmp_echo->icmp_seq), payload,
@@ -2554,7 +2866,7 @@ void icmp_timestamp_reply(struct template *tmpl, struct ip_hdr *rip,
     time_t now;
     uint32_t milliseconds;
 
-    pkt = pool_alloc(pool_pkt);
+    pkt = pktbuf_alloc(HONEYD_MTU);
 
     now = time(NULL );
     now_tm = localtime(&now);
@@ -2607,7 +2919,7 @@ void icmp_mask_reply(struct template *tmpl, struct ip_hdr *rip,
     u_int iplen;
     struct icmp_mesg_mask mask;
 
-    pkt = pool_alloc(pool_pkt);
+    pkt = pktbuf_alloc(HONEYD_MTU);
 
     iplen = IP_HDR_LEN + ICMP_HDR_LEN + 8;
 
@@ -2647,7 +2959,7 @@ void icmp_info_reply(struct template *tmpl, struct ip_hdr *rip,
     u_int iplen;
     struct icmp_msg_inforeply inforeply;
 
-    pkt = pool_alloc(pool_pkt);
+    pkt = pktbuf_alloc(HONEYD_MTU);
 
     iplen = IP_HDR_LEN + ICMP_HDR_LEN + 4;
 
@@ -2675,8 +2987,7 @@ void icmp6_send_pkt(const struct interface * inter, struct addr *src_eth,
 
 
     /* ICMP_HDR_LEN should be 32 byte - just to test it */
-    u_char *pkg = pool_alloc_size(pool_pkt,
-                                  ETH_HDR_LEN + IP6_HDR_LEN + icmp_pkt_len); //[ETH_HDR_LEN+IP6_HDR_LEN+icmp_pkt_len];
+    u_char *pkg = pktbuf_alloc(ETH_HDR_LEN + IP6_HDR_LEN + icmp_pkt_len); //[ETH_HDR_LEN+IP6_HDR_LEN+icmp_pkt_len];
 
     //eth_pack_hdr(pkg,dst_eth->addr_eth,src_eth->addr_eth,ETH_TYPE_IPV6);
     /*
@@ -2694,7 +3005,7 @@ void icmp6_send_pkt(const struct interface * inter, struct addr *src_eth,
     /* calculate the cecksum */
     ip6 = (struct ip6_hdr *) (pkg);
 
-    ip6_checksum(ip6, icmp_pkt_len + IP6_HDR_LEN);
+    cksum_ip6(ip6, icmp_pkt_len + IP6_HDR_LEN);
 
     if (inter == NULL || src_eth == NULL || dst_eth == NULL )
     {
@@ -2738,6 +3049,13 @@ void tcp_do_options(struct tcp_con *con, struct tcp_hdr *tcp, int isonsyn)
         switch (opt.opt_type)
         {
         case TCP_OPT_MSS:
+            /*
+             * The MSS is only announced on a SYN and we may not send
+             * larger segments.  Tiny values would only multiply the
+             * packets that we send, so they are raised to a floor.
+             */
+            if (tcp->th_flags & TH_SYN)
+                con->snd_mss = MAX(ntohs(opt.opt_data.mss), TCP_MIN_MSS);
             if (!isonsyn)
             {
                 con->mss = ntohs(opt.opt_data.mss);
@@ -2810,21 +3128,22 @@ void generic_timeout(struct event *ev, int seconds)
 \
 		con->conhdr.received += dlen; \
 \
-		if (con->plen || con->cmd_pfd > 0) { \
+		if (con->sendbuf.len || con->cmd_pfd > 0) { \
 			int ackinc = 0; \
 			dlen = tcp_add_readbuf(con, data + doff, dlen); \
 \
 			acked = th_ack - con->snd_una; \
-			if (acked > con->plen) { \
-				if (con->sentfin && acked == con->plen + 1){ \
+			if (acked > con->sendbuf.len) { \
+				if (con->sentfin && acked == con->sendbuf.len + 1){ \
 					con->finacked = 1; \
 					ackinc = 1; \
 				} \
-				acked = con->plen; \
+				acked = con->sendbuf.len; \
 			} \
 			tcp_drain_payload(con, acked); \
 			acked += ackinc; \
-			if (con->cmd_pfd == -1 && con->plen <= TCP_MAX_SEND) \
+			if (con->cmd_pfd == -1 && \
+			    con->sendbuf.len <= tcp_segsize(con)) \
 				con->sentfin = 1; \
 		} else if (con->cmd_pfd == -1) { \
 			tcp_add_readbuf(con, data + doff, dlen); \
@@ -2848,6 +3167,68 @@ void generic_timeout(struct event *ev, int seconds)
 		} \
 } while (0)
 
+/*
+ * Answers a SYN on a SYN cookie port.  The SYN-ACK is sent from a
+ * temporary connection, so nothing is allocated until the handshake
+ * completes.  Only a tag for the chosen ISN and the options of the SYN
+ * are remembered.
+ */
+static void tcp_syncookie_reply(struct template *tmpl, struct tcp_hdr *tcp)
+{
+    struct syncookie_opts opts;
+    struct tcp_con con;
+
+    memset(&con, 0, sizeof(con));
+    con.conhdr = honeyd_tmp.conhdr;
+    con.addr_family = honeyd_tmp.addr_family;
+    con.cmd.pfd = con.cmd.perrfd = -1;
+    con.tmpl = tmpl;
+    con.rcv_flags = tcp->th_flags;
+    con.rcv_next = ntohl(tcp->th_seq) + 1;
+
+    tcp_do_options(&con, tcp, 1);
+
+    con.state = TCP_STATE_LISTEN;
+    tcp_send(&con, TH_SYN | TH_ACK, NULL, 0);
+
+    memset(&opts, 0, sizeof(opts));
+    opts.mss = con.snd_mss;
+    opts.sawtimestamp = con.sawtimestamp;
+    opts.echotimestamp = con.echotimestamp;
+    syncookie_add(&con.conhdr, con.snd_una, &opts);
+}
+
+/*
+ * Creates the connection for an ACK that completes a SYN cookie
+ * handshake.  The connection is left in SYN_RECEIVED so that the
+ * regular state machine establishes it.
+ */
+static struct tcp_con *
+tcp_syncookie_accept(struct template *tmpl, struct ip_hdr *ip,
+                     struct ip6_hdr *ip6, struct tcp_hdr *tcp)
+{
+    struct syncookie_opts opts;
+    struct tcp_con *con;
+    uint32_t th_ack = ntohl(tcp->th_ack);
+
+    if (syncookie_check(&honeyd_tmp.conhdr, th_ack - 1, &opts) == -1)
+        return (NULL);
+
+    con = tcp_new46(ip, ip6, tcp, 0);
+    con->tmpl = template_ref(tmpl);
+    /* As if tcp_do_options() had seen the SYN */
+    con->snd_mss = opts.mss;
+    con->sawtimestamp = opts.sawtimestamp;
+    con->echotimestamp = opts.echotimestamp;
+    con->rcv_next = ntohl(tcp->th_seq);
+    con->snd_una = th_ack;
+    con->state = TCP_STATE_SYN_RECEIVED;
+
+    generic_timeout(&con->conhdr.timeout, HONEYD_SYN_WAIT);
+
+    return (con);
+}
+
 void tcp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
                    int addr_family)
 {
@@ -2859,7 +3240,6 @@ void tcp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
     struct action *action;
     uint32_t th_seq, th_ack;
     uint32_t acked = 0;
-    uint16_t th_sum;
     u_char *data;
     u_int dlen = 0, doff;
     uint8_t tiflags, flags;
@@ -2878,9 +3258,14 @@ void tcp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
     }
     else if (addr_family == AF_INET6)
     {
+        struct ip6_desc desc;
+
         ip6 = (struct ip6_hdr *) pkt;
-        get_ip6_next_hdr((u_char **) &tcp, ip6, IP_PROTO_TCP);
-        data = (u_char *) (pkt + IP6_HDR_LEN + (tcp->th_off * 4));
+        ip6_desc_parse(&desc, ip6, pktlen);
+        if (desc.proto != IP_PROTO_TCP || desc.off + TCP_HDR_LEN > pktlen)
+            return;
+        tcp = (struct tcp_hdr *) (pkt + desc.off);
+        data = (u_char *) tcp + (tcp->th_off * 4);
 
         honeyd_settcp6(&honeyd_tmp, ip6, tcp, 0);
 
@@ -2898,7 +3283,7 @@ void tcp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
      */
     /* honeyd_settcp copies the tcp header information like addresses and ports
      into the honeyd_tmp connection structure */
-    con = (struct tcp_con *) SPLAY_FIND(tree, &tcpcons, &honeyd_tmp.conhdr);
+    con = (struct tcp_con *) tuple_find(&tcpcons, &honeyd_tmp.conhdr);
 
     /* call all the hooks callbacks */
     hooks_dispatch(IP_PROTO_TCP, HD_INCOMING,
@@ -2907,17 +3292,8 @@ void tcp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
     if (honeyd_block(tmpl, IP_PROTO_TCP, ntohs(tcp->th_dport)))
         goto justlog;
 
-    /* Check the checksum the brutal way, until libdnet supports */
-    th_sum = tcp->th_sum;
-    if (addr_family == AF_INET)
-    {
-        ip_checksum(ip, pktlen);
-    }
-    else if (addr_family == AF_INET6)
-    {
-        ip6_checksum(ip6, pktlen);
-    }
-    if (th_sum != tcp->th_sum)
+    /* Segments with a bad checksum are only logged */
+    if (!cksum_verify(pkt, pktlen))
         goto justlog;
 
     /* find out what to do for the specific port/template */
@@ -2932,6 +3308,13 @@ void tcp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
     TCP_STATE_LISTEN : TCP_STATE_CLOSED;
 
     tiflags = tcp->th_flags;
+
+    /* An ACK might complete a handshake that we answered with a cookie */
+    if (con == NULL && honeyd_tmp.state == TCP_STATE_LISTEN &&
+        action != NULL && (action->flags & PORT_SYNCOOKIE) &&
+        (tiflags & (TH_SYN | TH_RST | TH_ACK)) == TH_ACK)
+        con = tcp_syncookie_accept(tmpl, ip, ip6, tcp);
+
     /* if there is no existing connection? */
     if (con == NULL )
     {
@@ -2992,6 +3375,15 @@ void tcp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
                 goto justlog;
         }
 
+        /* Half-open connections on cookie ports do not keep state */
+        if (action != NULL && (action->flags & PORT_SYNCOOKIE))
+        {
+            tcp_syncookie_reply(tmpl, tcp);
+            honeyd_log_probe(honeyd_logfp, IP_PROTO_TCP, &honeyd_tmp.conhdr,
+                             pktlen, tcp->th_flags, comment);
+            return;
+        }
+
         /* Out of memory is dealt with by killing the connection */
         /* tcp new also adds the connection to the "database" */
         if (addr_family != AF_INET6 && (con = tcp_new(ip, tcp, 0)) == NULL )
@@ -3127,7 +3519,7 @@ void tcp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
         {
             if (con->cmd_pfd > 0)
             {
-                if (con->rlen == 0)
+                if (con->readbuf.len == 0)
                 {
                     /*
                      * If we already transmitted all data,
@@ -3334,7 +3726,7 @@ int udp_send(struct udp_con *con, u_char *payload, u_int len)
     if (addr_family == AF_INET)
         ip_personality(tmpl, &id);
 
-    pkt = pool_alloc(pool_pkt);
+    pkt = pktbuf_alloc(HONEYD_MTU);
 
     if (addr_family == AF_INET6)
     {
@@ -3377,9 +3769,9 @@ int udp_send(struct udp_con *con, u_char *payload, u_int len)
         spoof = no_spoof;
 
     if (addr_family == AF_INET6)
-        ip6_checksum(pkt, iplen);
+        cksum_ip6((struct ip6_hdr *)pkt, iplen);
     else
-        ip_checksum(pkt, iplen);
+        cksum_ip((struct ip_hdr *)pkt, iplen);
 
     hooks_dispatch(IP_PROTO_UDP, HD_OUTGOING, &con->conhdr, pkt, iplen);
 
@@ -3403,7 +3795,6 @@ void udp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
     struct addr addr;
     struct spoof spoof;
 
-    uint16_t uh_sum;
     u_char *data = NULL;
     u_int dlen = 0;
     u_short portnum;
@@ -3419,8 +3810,13 @@ void udp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
     }
     else if (addr_family == AF_INET6)
     {
+        struct ip6_desc desc;
+
         ip6 = (struct ip6_hdr *) pkt;
-        get_ip6_next_hdr((u_char **) &udp, ip6, IP_PROTO_UDP);
+        ip6_desc_parse(&desc, ip6, pktlen);
+        if (desc.proto != IP_PROTO_UDP || desc.off + UDP_HDR_LEN > pktlen)
+            return;
+        udp = (struct udp_hdr *) (pkt + desc.off);
     }
 
     /*
@@ -3428,7 +3824,7 @@ void udp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
      * that we can look at potential flags like local origination.
      */
     honeyd_setudp(&honeyd_udp, ip, ip6, udp, 0, addr_family);
-    con = (struct udp_con *) SPLAY_FIND(tree, &udpcons, &honeyd_udp.conhdr);
+    con = (struct udp_con *) tuple_find(&udpcons, &honeyd_udp.conhdr);
 
     if (addr_family == AF_INET)
     {
@@ -3456,13 +3852,7 @@ void udp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
         goto justlog;
 
     /* Check the packet checksum, if no uh_sum is set, we ignore it */
-    uh_sum = udp->uh_sum;
-    if (addr_family == AF_INET6)
-        ip6_checksum(ip6, pktlen);
-    else
-        ip_checksum(ip, pktlen);
-
-    if ((uh_sum && uh_sum != udp->uh_sum))
+    if (!cksum_verify(pkt, pktlen))
         goto justlog;
 
     if (con == NULL )
@@ -3492,6 +3882,7 @@ void udp_recv_cb46(struct template *tmpl, u_char *pkt, u_short pktlen,
     }
 
     /* Keep this state active */
+    connection_update(&udplru, &con->conhdr);
     generic_timeout(&con->conhdr.timeout, HONEYD_UDP_WAIT);
     con->softerrors = 0;
 
@@ -3560,7 +3951,6 @@ void icmp_recv_cb(struct template *tmpl, u_char *pkt, u_short pktlen)
     char osrc[100], odst[100];
     char ssrc[100], sdst[100];
     u_char *dat;
-    uint16_t cksum;
     int dlen;
 
     ip = (struct ip_hdr *) pkt;
@@ -3595,9 +3985,7 @@ void icmp_recv_cb(struct template *tmpl, u_char *pkt, u_short pktlen)
     }
 
     /* return if the checksum in incorrect */
-    cksum = icmp->icmp_cksum;
-    ip_checksum(ip, pktlen);
-    if (cksum != icmp->icmp_cksum)
+    if (!cksum_verify(ip, pktlen))
         return;
 
     dlen = pktlen - IP_HDR_LEN - ICMP_HDR_LEN;
@@ -3665,7 +4053,7 @@ void icmp_recv_cb(struct template *tmpl, u_char *pkt, u_short pktlen)
         honeyd_setudp(&honeyd_udp, &tmpip, NULL, &tmpudp, 0, AF_INET);
 
         /* Find matching state */
-        con = (struct udp_con *) SPLAY_FIND(tree, &udpcons,
+        con = (struct udp_con *) tuple_find(&udpcons,
                                             &honeyd_udp.conhdr);
         if (con == NULL )
             break;
@@ -3761,33 +4149,24 @@ void honeyd_dispatch(struct template *tmpl, struct ip_hdr *ip, u_short iplen)
     }
 }
 
-void honeyd_dispatch6(struct template *tmpl, struct ip6_hdr *ip6)
+void honeyd_dispatch6(struct template *tmpl, const struct ip6_desc *desc)
 {
-
-    u_char * next_hdr = NULL;
-    /* ICMP6 */
-    if (get_ip6_next_hdr(&next_hdr, ip6, IP_PROTO_ICMPV6) != -1)
+    switch (desc->proto)
     {
-        icmp6_recv_cb(tmpl->inter, ip6, (struct icmp6_hdr*) next_hdr);
-        return;
-    }
-    /* TCP */
-    if (get_ip6_next_hdr(&next_hdr, ip6, IP_PROTO_TCP) != -1)
-    {
-        tcp_recv_cb6(tmpl, (u_char *) ip6, ntohs(ip6->ip6_plen) + IP6_HDR_LEN);
-        return;
-    }
-
-    /* UDP */
-    if (get_ip6_next_hdr(&next_hdr, ip6, IP_PROTO_UDP) != -1)
-    {
-        udp_recv_cb46(tmpl, (u_char *) ip6, ntohs(ip6->ip6_plen) + IP6_HDR_LEN,
-                      AF_INET6);
-        return;
+    case IP_PROTO_ICMPV6:
+        icmp6_recv_cb(tmpl->inter, desc);
+        break;
+    case IP_PROTO_TCP:
+        tcp_recv_cb6(tmpl, (u_char *) desc->ip6, desc->len);
+        break;
+    case IP_PROTO_UDP:
+        udp_recv_cb46(tmpl, (u_char *) desc->ip6, desc->len, AF_INET6);
+        break;
+    default:
+        syslog(LOG_DEBUG, "unknown packet type received, type: %u",
+               desc->proto);
+        break;
     }
-    syslog(LOG_DEBUG, "unknown packet type received, type: %u", ip6->ip6_nxt);
-    return;
-
 }
 
 /*
@@ -3833,61 +4212,66 @@ enum forward honeyd_route_packet46(struct ip_hdr *ip, struct ip6_hdr *ip6,
                                    u_int iplen, struct addr *gw, struct addr *addr, int *pdelay,
                                    int addr_family)
 {
-    struct router *r, *lastrouter = NULL;
+    struct routepath *path;
+    struct routehop *hop;
     struct router_entry *rte = NULL;
-    struct link_entry *link = NULL;
+    struct link_entry *link;
     struct template *tmpl;
     struct addr host;
+    struct timeval now, tv;
     double packetloss = 1;
     int delay = 0, external = 0;
+    int ttl, need, nhops, i;
 
-    char * solicited_node_prefix = "ff02::1:ff";
-    if (addr != NULL
-            && strncmp(addr_ntoa(addr), solicited_node_prefix,
-                       strlen(solicited_node_prefix)) == 0)
+    /* solicited node multicast addresses are always handled internally */
+    if (addr != NULL && ADDR_IS_SOLICITED_NODE(addr))
     {
         return FW_INTERNAL;
     }
 
-    host = *gw;
-    r = router_find(&host);
-
-    int ttl = (addr_family == AF_INET ? ip->ip_ttl : ip6->ip6_hlim);
+    path = router_path(gw, addr);
+    ttl = (addr_family == AF_INET ? ip->ip_ttl : ip6->ip6_hlim);
 
-    while (addr_cmp(&host, addr) != 0 && --ttl)
+    /*
+     * Every hop and the final route lookup cost one TTL.  If the TTL
+     * runs out, the packet expires at the router it has reached.
+     */
+    need = path->nhops + (path->end != ROUTE_END_ARRIVED);
+    if (ttl > need)
     {
-        if ((rte = network_lookup(r->routes, addr)) == NULL )
-        {
-            if (r->flags & ROUTER_ISENTRY)
-            {
-                external = 1;
-                break;
-            }
-            syslog(LOG_DEBUG, "No route to %s", addr_ntoa(addr));
-            return (FW_DROP);
-        }
-
-        if (rte->gw != NULL && lastrouter == rte->gw)
-            if (rte->type == ROUTE_TUNNEL)
-                break;
-
-        if (rte->type == ROUTE_LINK || rte->type == ROUTE_UNREACH)
-            break;
+        nhops = path->nhops;
+        ttl -= need;
+    }
+    else
+    {
+        nhops = ttl > 0 ? ttl - 1 : 0;
+        ttl = 0;
+    }
 
-        /* Get the attributes for this link */
-        link = rte->link;
+    if (nhops)
+    {
+        hop = &path->hops[nhops - 1];
+        host = hop->router->addr;
+        delay = hop->delay;
+        packetloss = hop->survive;
+    }
+    else
+        host = *gw;
 
-        if (link->latency)
-            delay += link->latency;
-        else
-            delay += 3;
+    /* Only the queues of bandwidth limited links change per packet */
+    if (path->bandwidth)
+    {
+        gettimeofday(&now, NULL );
 
-        if (link->bandwidth)
+        for (i = 0; i < nhops; i++)
         {
-            int ms = iplen * link->bandwidth / link->divider;
-            struct timeval now, tv;
-            gettimeofday(&now, NULL );
+            int ms;
 
+            link = path->hops[i].link;
+            if (!link->bandwidth)
+                continue;
+
+            ms = iplen * link->bandwidth / link->divider;
             if (timercmp(&now, &link->tv_busy, <))
             {
                 /* Router is busy for a while */
@@ -3913,12 +4297,24 @@ enum forward honeyd_route_packet46(struct ip_hdr *ip, struct ip6_hdr *ip6,
 
             delay += ms;
         }
-        if (link->packetloss)
-            packetloss *= 1 - ((double) link->packetloss / 10000.0);
+    }
 
-        lastrouter = r;
-        r = rte->gw;
-        host = r->addr;
+    if (ttl)
+    {
+        switch (path->end)
+        {
+        case ROUTE_END_NOROUTE:
+            syslog(LOG_DEBUG, "No route to %s", addr_ntoa(addr));
+            return (FW_DROP);
+        case ROUTE_END_EXTERNAL:
+            external = 1;
+            break;
+        case ROUTE_END_ROUTE:
+            rte = path->rte;
+            break;
+        default:
+            break;
+        }
     }
 
     /* Calculate the packet loss rate */
@@ -3933,7 +4329,7 @@ enum forward honeyd_route_packet46(struct ip_hdr *ip, struct ip6_hdr *ip6,
         {
             syslog(LOG_DEBUG, "TTL exceeded for dst %s at gw %s",
                    addr_ntoa(addr), addr_ntoa(&host));
-            tmpl = template_find(addr_ntoa(&host));
+            tmpl = template_find_addr(&host);
             honeyd_delay_packet6(tmpl, ip6, iplen, &host, NULL, delay, 0,
                                  no_spoof);
             return (FW_DROP);
@@ -3942,7 +4338,8 @@ enum forward honeyd_route_packet46(struct ip_hdr *ip, struct ip6_hdr *ip6,
 
     if (addr_family == AF_INET)
     {
-        ip->ip_ttl = ttl;
+        /* Keeps the header checksum of forwarded packets valid */
+        cksum_ip_ttl(ip, ttl);
         /* Send ICMP_TIMEXCEED from router address */
         if (!ttl)
         {
@@ -3956,7 +4353,7 @@ enum forward honeyd_route_packet46(struct ip_hdr *ip, struct ip6_hdr *ip6,
              * We need to use the template of the host that will
              * send the ICMP error message.
              */
-            tmpl = template_find_best(addr_ntoa(&host), ip, iplen);
+            tmpl = template_find_best(&host, ip, iplen);
             honeyd_delay_packet(tmpl, ip, iplen, &host, NULL, delay, 0, spoof);
             return (FW_DROP);
         }
@@ -3971,7 +4368,7 @@ enum forward honeyd_route_packet46(struct ip_hdr *ip, struct ip6_hdr *ip6,
              * We need to use the template of the host that will
              * send the ICMP error message.
              */
-            tmpl = template_find_best(addr_ntoa(&host), ip, iplen);
+            tmpl = template_find_best(&host, ip, iplen);
             honeyd_delay_packet(tmpl, ip, iplen, &host, NULL, delay,
                                 DELAY_UNREACH, no_spoof);
             return (FW_DROP);
@@ -3990,7 +4387,7 @@ enum forward honeyd_route_packet46(struct ip_hdr *ip, struct ip6_hdr *ip6,
             struct template *tmpl;
 
             /* Check if a template specific drop rate applies */
-            tmpl = template_find_best(addr_ntoa(addr), ip, iplen);
+            tmpl = template_find_best(addr, ip, iplen);
             if (tmpl != NULL && tmpl->drop_inrate)
             {
                 uint16_t value;
@@ -4021,20 +4418,20 @@ enum forward honeyd_route_packet6(struct ip6_hdr *ip6, u_int iplen,
 void honeyd_input(const struct interface *inter, struct ip_hdr *ip,
                   u_short iplen)
 {
-    extern struct network *reverse;
+    extern struct nettable *reverse;
     struct template *tmpl = NULL;
     struct router *gw;
     struct addr gw_addr;
     struct router_entry *rte;
     enum forward res = FW_INTERNAL;
-    int delay = 0, flags = 0;
+    int delay = 0, flags = DELAY_CKSUM;
     struct addr src, addr;
 
     addr_pack(&addr, ADDR_TYPE_IP, IP_ADDR_BITS, &ip->ip_dst, IP_ADDR_LEN);
     if (!router_used)
     {
         /* Check if a template specific drop rate applies */
-        tmpl = template_find_best(addr_ntoa(&addr), ip, iplen);
+        tmpl = template_find_best(&addr, ip, iplen);
 
         if (tmpl != NULL && tmpl->drop_inrate)
         {
@@ -4103,7 +4500,7 @@ void honeyd_input(const struct interface *inter, struct ip_hdr *ip,
     else
     {
         /* Pick the first one on the list */
-        gw = entry_routers_ip4->data;
+        gw = network_first(entry_routers_ip4);
         gw_addr = gw->addr;
     }
 
@@ -4133,7 +4530,7 @@ void honeyd_input(const struct interface *inter, struct ip_hdr *ip,
             flags |= DELAY_EXTERNAL;
     }
     else
-        tmpl = template_find_best(addr_ntoa(&addr), ip, iplen);
+        tmpl = template_find_best(&addr, ip, iplen);
 
     if (tmpl != NULL && tmpl->flags & TEMPLATE_EXTERNAL)
         flags |= DELAY_ETHERNET;
@@ -4143,14 +4540,14 @@ void honeyd_input(const struct interface *inter, struct ip_hdr *ip,
 }
 
 void honeyd_input6(const struct interface *inter, struct ip6_hdr *ip6,
-                   u_short iplen)
+                   u_int iplen)
 {
-    extern struct network *reverse6;
+    extern struct nettable *reverse6;
     struct template *tmpl = NULL;
     struct router *gw;
     struct addr gw_addr;
     enum forward res = FW_INTERNAL;
-    int delay = 0, flags = 0;
+    int delay = 0, flags = DELAY_CKSUM;
     struct addr src, addr;
 
     addr_pack(&addr, ADDR_TYPE_IP6, IP6_ADDR_BITS, &ip6->ip6_dst, IP6_ADDR_LEN);
@@ -4158,7 +4555,7 @@ void honeyd_input6(const struct interface *inter, struct ip6_hdr *ip6,
     if (!router_used)
     {
         /* handle drop rate */
-        tmpl = template_find(addr_ntoa(&addr));
+        tmpl = template_find_addr(&addr);
         if (tmpl != NULL && tmpl->drop_inrate)
         {
             uint16_t value;
@@ -4185,7 +4582,7 @@ void honeyd_input6(const struct interface *inter, struct ip6_hdr *ip6,
     else
     {
         /* Pick the first one on the list */
-        gw = entry_routers_ip6->data;
+        gw = network_first(entry_routers_ip6);
         gw_addr = gw->addr;
     }
 
@@ -4215,7 +4612,7 @@ void honeyd_input6(const struct interface *inter, struct ip6_hdr *ip6,
             flags |= DELAY_EXTERNAL;
     }
     else
-        tmpl = template_find(addr_ntoa(&addr));
+        tmpl = template_find_addr(&addr);
 
     if (tmpl != NULL && tmpl->flags & TEMPLATE_EXTERNAL)
         flags |= DELAY_ETHERNET;
@@ -4340,43 +4737,64 @@ void honeyd_recv_cb6(u_char *ag, const struct pcap_pkthdr *pkthdr,
     const struct interface *inter = (const struct interface *) ag;
     struct template *tmpl_from_dst = NULL, *tmpl_from_src = NULL;
     struct ip6_hdr * ip6;
-    struct icmp6_hdr * icmp6 = NULL;
-    struct addr src;
-    char * template_name = malloc(INET6_ADDRSTRLEN);
+    struct icmp6_hdr * icmp6;
+    struct ip6_desc desc;
+    struct addr src, dst;
+
+    if (pkthdr->caplen < inter->if_dloff + IP6_HDR_LEN)
+        return;
     ip6 = (struct ip6_hdr*) (pkt + inter->if_dloff);
-    
-    /* get the source address */
+
+    /* the extension headers are only walked once */
+    if (ip6_desc_parse(&desc, ip6, pkthdr->caplen - inter->if_dloff) == -1)
+        return;
+
+    /* get the source and destination addresses */
     addr_pack(&src, ADDR_TYPE_IP6, IP6_ADDR_BITS, &ip6->ip6_src, IP6_ADDR_LEN);
+    addr_pack(&dst, ADDR_TYPE_IP6, IP6_ADDR_BITS, &ip6->ip6_dst, IP6_ADDR_LEN);
 
     /* handle icmpv6 directly */
-    get_ip6_next_hdr((u_char**) &icmp6, ip6, IPPROTO_ICMPV6);
-    if (icmp6 != NULL && icmp6->icmp6_type == ND_ROUTER_ADVERT)
+    icmp6 = (struct icmp6_hdr *) IP6_DESC_UPPER(&desc, IPPROTO_ICMPV6);
+    if (icmp6 != NULL && desc.len >= desc.off + sizeof(struct icmp6_hdr) &&
+            icmp6->icmp6_type == ND_ROUTER_ADVERT)
     {
-        icmp6_recv_cb(inter, ip6, icmp6);
+        icmp6_recv_cb(inter, &desc);
     }
 
     /* check if we have a template with the message's dst address */
-    inet_ntop(AF_INET6, &ip6->ip6_dst, template_name, INET6_ADDRSTRLEN);
-    tmpl_from_dst = template_find(template_name);
-    free(template_name);
+    tmpl_from_dst = template_find_addr(&dst);
 
     /* ignore our own packets if internal routing is not enabled */
-    tmpl_from_src = template_find(addr_ntoa(&src));
+    tmpl_from_src = template_find_addr(&src);
     if (!router_used && tmpl_from_src != NULL )
     {
         return;
     }
 
 
-    /* if random mode is enabled and there is no existing template the maybe create one */
-    if (tmpl_from_dst == NULL && tmpl_from_src == NULL && config.randomipv6mode)
+    /*
+     * if random mode is enabled and there is no existing template the
+     * maybe create one.  Only the worker owning the destination does
+     * this, so each one keeps its share of the random hosts.
+     */
+    if (tmpl_from_dst == NULL && tmpl_from_src == NULL && config.randomipv6mode
+            && interface_shard_owns(&dst))
     {
-      const char *template_name = get_template_name_from_packet(ip6);
+      char *template_name = get_template_name_from_packet(&desc);
         if(template_name != NULL)
         {
-           random_create_ipv6_template(template_name, inter, config.randomipv6_percentage, config.max_random_ipv6_hosts, honeyd_logfp);
+           unsigned long long max_hosts = config.max_random_ipv6_hosts;
+
+           if (max_hosts != 0)
+               max_hosts = (max_hosts + honeyd_nworkers - 1) / honeyd_nworkers;
+           /* solicitations for a template that exists already */
+           if ((tmpl_from_dst = template_find(template_name)) == NULL)
+           {
+               random_create_ipv6_template(template_name, inter, config.randomipv6_percentage, max_hosts, honeyd_logfp);
+               tmpl_from_dst = template_find(template_name);
+           }
+           free(template_name);
         }
-        tmpl_from_dst = template_find(template_name);
     }
 
 
@@ -4388,7 +4806,11 @@ void honeyd_recv_cb6(u_char *ag, const struct pcap_pkthdr *pkthdr,
     }
     else
     {
-        honeyd_input6(inter, ip6, ip6->ip6_plen);
+        /* Keeps on-demand templates from being reclaimed as idle */
+        if (tmpl_from_dst->flags & TEMPLATE_ONDEMAND)
+            template_touch(tmpl_from_dst);
+        /* desc.len is bounded by both the header and the capture */
+        honeyd_input6(inter, ip6, desc.len);
     }
 
 }
@@ -4396,15 +4818,94 @@ void honeyd_recv_cb6(u_char *ag, const struct pcap_pkthdr *pkthdr,
 void honeyd_sigchld(int fd, short what, void *arg)
 {
     pid_t pid;
-    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0)
+    int i, status;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
     {
         /* Ignore the rrdtool driver for children accounting */
         if (honeyd_rrd_drv != NULL && honeyd_rrd_drv->pid == pid)
             continue;
+        for (i = 1; i < honeyd_nworkers; i++)
+            if (honeyd_workerpids[i] == pid)
+                break;
+        if (i < honeyd_nworkers)
+        {
+            /*
+             * Nobody else would handle the addresses of its shard.
+             * The master has dropped its privileges and cannot reopen
+             * the capture, so everything goes down and is restarted.
+             */
+            syslog(LOG_ERR, "worker %d (pid %d) exited with status %d",
+                   i, pid, status);
+            honeyd_workerpids[i] = 0;
+            honeyd_exit(1);
+        }
         honeyd_nchildren--;
     }
 }
 
+/*
+ * Forks the workers once all the shared state - personalities,
+ * templates and configuration - has been set up.  The workers inherit
+ * it copy-on-write and never change it, apart from the dynamic
+ * templates that every worker only creates for its own addresses.
+ * Each worker then captures only the traffic for its share of the
+ * destination addresses, so that connections, timers and pools stay
+ * private to the process that handles them.
+ */
+
+static void honeyd_workers_start(void)
+{
+    pid_t pid;
+    int i;
+
+    if (honeyd_nworkers <= 1)
+        return;
+
+    if (template_iterate(honeyd_workers_subsystem, NULL) == -1)
+        errx(1, "%s: subsystems cannot be shared by several workers",
+             __func__);
+
+    for (i = 1; i < honeyd_nworkers; i++)
+    {
+        if ((pid = fork()) == -1)
+            err(1, "%s: fork", __func__);
+        if (pid == 0)
+            break;
+        honeyd_workerpids[i] = pid;
+    }
+
+    if (i == honeyd_nworkers)
+    {
+        /* The master is worker 0 */
+        i = 0;
+    }
+    else
+    {
+        honeyd_worker = i;
+#ifdef __linux__
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+        if (event_reinit(honeyd_evbase) == -1)
+            errx(1, "%s: event_reinit", __func__);
+
+        /* Do not hand out the same sequence numbers and IP ids */
+        pid = getpid();
+        rand_add(honeyd_rand, &pid, sizeof(pid));
+
+        /* The management interfaces stay with the master */
+        ui_close();
+#ifdef HAVE_PYTHON
+        if (honeyd_is_webserver_enabled())
+            pyextend_webserver_exit();
+#endif
+    }
+
+    interface_shard(i, honeyd_nworkers);
+
+    syslog(LOG_INFO, "worker %d of %d running as pid %d",
+           i, honeyd_nworkers, getpid());
+}
+
 void honeyd_signal(int fd, short what, void *arg)
 {
     syslog(LOG_NOTICE, "exiting on signal %d", fd);
@@ -4415,16 +4916,23 @@ void honeyd_sighup(int fd, short what, void *arg)
 {
     syslog(LOG_NOTICE, "rereading configuration on signal %d", fd);
 
+    honeyd_workers_signal(SIGHUP);
+
     template_free_all(TEMPLATE_FREE_REGULAR);
     router_end();
     if (config.config != NULL )
         config_read(config.config);
+
+    connection_budget_init();
+    tcp_config();
 }
 
 void honeyd_sigusr(int fd, short what, void *arg)
 {
     syslog(LOG_NOTICE, "rotating log files on signal %d", fd);
 
+    honeyd_workers_signal(SIGUSR1);
+
     honeyd_logend(honeyd_logfp);
     honeyd_logend(honeyd_servicefp);
 
@@ -4448,7 +4956,22 @@ struct _unittest
 //	{ "ethernet", ethernet_test },
 //	{ "interface", interface_test },
     { "network", network_test },
+    { "router", router_test },
     { "icmpv6", icmp6_test },
+    { "templateindex", template_index_test },
+    { "templateshare", template_share_test },
+    { "flowtable", flowtable_test },
+    { "timerwheel", timerwheel_test },
+    { "pool", pool_test },
+    { "bloom", bloom_test },
+    { "siphash", siphash_test },
+    { "reasm", reasm_test },
+    { "persdb", persdb_test },
+    { "personality", personality_test },
+    { "osfp", osfp_test },
+    { "cksum", cksum_test },
+    { "syncookie", syncookie_test },
+    { "tcpbuf", tcpbuf_test },
 //	{ "template", template_test },
     { NULL, NULL }
 };
@@ -4470,6 +4993,7 @@ void unittest(void)
 int main(int argc, char *argv[])
 {
     extern int interface_dopoll;
+    extern int interface_doring;
     struct event sigterm_ev, sigint_ev, sighup_ev, sigchld_ev, sigusr_ev;
     char *dev[HONEYD_MAX_INTERFACES];
     char **orig_argv;
@@ -4479,7 +5003,7 @@ int main(int argc, char *argv[])
     char *stats_password = NULL;
     int want_unittest = 0;
     int setrand = 0;
-    int i, c, orig_argc, ninterfaces = 0;
+    int i, c, orig_argc, ninterfaces = 0, persdb;
     FILE *fp;
 
     fprintf(stderr, "Honeyd V%s Copyright (c) 2002-2007 Niels Provos\n",
@@ -4512,9 +5036,44 @@ int main(int argc, char *argv[])
         case 'X':
             honeyd_webserver_root = optarg;
             break;
+        case 'C':
+            honeyd_opt_max_connects = atoi(optarg);
+            if (honeyd_opt_max_connects <= 0)
+            {
+                fprintf(stderr, "Bad connection limit: %s\n", optarg);
+                usage();
+            }
+            break;
+        case 'N':
+            honeyd_opt_max_persource = atoi(optarg);
+            if (honeyd_opt_max_persource <= 0)
+            {
+                fprintf(stderr, "Bad per source limit: %s\n", optarg);
+                usage();
+            }
+            break;
+        case 'M':
+            honeyd_opt_connect_memory = honeyd_parse_size(optarg);
+            if (honeyd_opt_connect_memory == 0)
+            {
+                fprintf(stderr, "Bad memory size: %s\n", optarg);
+                usage();
+            }
+            break;
+        case 'w':
+            honeyd_nworkers = atoi(optarg);
+            if (honeyd_nworkers <= 0 || honeyd_nworkers > HONEYD_MAX_WORKERS)
+            {
+                fprintf(stderr, "Bad number of workers: %s\n", optarg);
+                usage();
+            }
+            break;
         case 'T':
             want_unittest = 1;
             break;
+        case 'D':
+            honeyd_compile_personalities = optarg;
+            break;
         case 'R':
             /* For regression testing */
             setrand = atoi(optarg);
@@ -4581,6 +5140,9 @@ int main(int argc, char *argv[])
         case 'P':
             interface_dopoll = 1;
             break;
+        case 'K':
+            interface_doring = 1;
+            break;
         case 'd':
             honeyd_debug++;
             break;
@@ -4654,7 +5216,7 @@ int main(int argc, char *argv[])
     interface_prevent_init();
 
     /* Initalize libevent */
-    event_init();
+    honeyd_evbase = event_init();
 
     /* Three priorities - UI connections always get a better priority */
     event_priority_init(3);
@@ -4662,8 +5224,12 @@ int main(int argc, char *argv[])
     syslog_init(orig_argc, orig_argv);
 
     /* Initalize pool allocator */
-    pool_pkt = pool_init(HONEYD_MTU);
-    pool_delay = pool_init(sizeof(struct delay));
+    pktbuf_init();
+    tcpbuf_init();
+    pool_delay = pool_init("delay", sizeof(struct delay));
+
+    evtimer_set(&honeyd_pool_ev, honeyd_pool_cb, &honeyd_pool_ev);
+    honeyd_pool_cb(-1, EV_TIMEOUT, &honeyd_pool_ev);
 
     /* Initialize honeyd's callback hooks */
     hooks_init();
@@ -4671,8 +5237,8 @@ int main(int argc, char *argv[])
     tagging_init();
     arp_init();
     ndp_init();
-    multicast_init();
     interface_initialize(honeyd_recv_cb);
+    interface_drops_callback(honeyd_drops_cb);
     config_init();
     router_init();
     plugins_config_init();
@@ -4690,26 +5256,41 @@ int main(int argc, char *argv[])
     xprobe_personality_init();
     associations_init();
 
-    /* Xprobe2 fingerprints */
-    if ((fp = fopen(config.xprobe, "r")) == NULL )
-        err(1, "fopen(%s)", config.xprobe);
-    if (xprobe_personality_parse(fp) == -1)
-        errx(1, "parsing xprobe personality file failed");
-    fclose(fp);
-
-    /* Association between xprobe and nmap fingerprints */
-    if ((fp = fopen(config.assoc, "r")) == NULL )
-        err(1, "fopen(%s)", config.assoc);
-    if (parse_associations(fp) == -1)
-        errx(1, "parsing associations file failed");
-    fclose(fp);
-
-    /* Nmap fingerprints */
-    if ((fp = fopen(config.pers, "r")) == NULL )
-        err(1, "fopen(%s)", config.pers);
-    if (personality_parse(fp) == -1)
-        errx(1, "parsing personality file failed");
-    fclose(fp);
+    /* A compiled database already contains all three files below */
+    if ((persdb = persdb_load(config.pers)) == -1)
+        errx(1, "loading personality database %s failed", config.pers);
+    if (persdb == 0)
+    {
+        /* Xprobe2 fingerprints */
+        if ((fp = fopen(config.xprobe, "r")) == NULL )
+            err(1, "fopen(%s)", config.xprobe);
+        if (xprobe_personality_parse(fp) == -1)
+            errx(1, "parsing xprobe personality file failed");
+        fclose(fp);
+
+        /* Association between xprobe and nmap fingerprints */
+        if ((fp = fopen(config.assoc, "r")) == NULL )
+            err(1, "fopen(%s)", config.assoc);
+        if (parse_associations(fp) == -1)
+            errx(1, "parsing associations file failed");
+        fclose(fp);
+
+        /* Nmap fingerprints */
+        if ((fp = fopen(config.pers, "r")) == NULL )
+            err(1, "fopen(%s)", config.pers);
+        if (personality_parse(fp) == -1)
+            errx(1, "parsing personality file failed");
+        fclose(fp);
+    }
+
+    if (honeyd_compile_personalities != NULL)
+    {
+        if (persdb_compile(honeyd_compile_personalities) == -1)
+            errx(1, "writing personality database failed");
+        fprintf(stderr, "Wrote personality database to %s\n",
+                honeyd_compile_personalities);
+        exit(0);
+    }
 
     /* PF OS fingerprints */
     if (honeyd_osfp_init(config.osfp) == -1)
@@ -4733,6 +5314,9 @@ int main(int argc, char *argv[])
             err(1, "ip_open");
     }
 
+    /* Needs privileges to open its raw socket */
+    txqueue_init(honeyd_ip);
+
     if (honeyd_verify_config)
     {
         extern int interface_verify_config;
@@ -4773,6 +5357,15 @@ int main(int argc, char *argv[])
     if (config.config != NULL )
         config_read(config.config);
 
+    /* The config file may override the default connection budget */
+    connection_budget_init();
+    ndp_config();
+    tcp_config();
+
+    /* Size the filter of rejected random IPv6 addresses */
+    if (config.randomipv6mode)
+        randomipv6_config();
+
     /* Just verify the configuration - exit with success */
     if (honeyd_verify_config)
         errx(0, "parsing configuration file successful");
@@ -4819,6 +5412,9 @@ int main(int argc, char *argv[])
 
     chmod(PIDFILE, 0644);
 
+    /* Needs privileges to reopen the capture of every worker */
+    honeyd_workers_start();
+
     // Drop privileges if we do not need them
     if (honeyd_needsroot <= 0)
     {
@@ -4837,7 +5433,7 @@ int main(int argc, char *argv[])
      * security holes.
      */
 
-    if (!honeyd_disable_update)
+    if (!honeyd_disable_update && !honeyd_worker)
         update_check();
 
 #ifdef HAVE_PYTHON
@@ -4868,7 +5464,8 @@ int main(int argc, char *argv[])
     signal_add(&sigusr_ev, NULL);
 
     /* Start logging via rrd */
-    if (honeyd_rrdtool_path != NULL && strlen(honeyd_rrdtool_path))
+    if (honeyd_rrdtool_path != NULL && strlen(honeyd_rrdtool_path) &&
+            !honeyd_worker)
         honeyd_rrd_start(honeyd_rrdtool_path);
 
     /* Potential dependency on the timestamp used for rrdtool */
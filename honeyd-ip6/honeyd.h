@@ -32,16 +32,22 @@
 #ifndef _HONEYD_H_
 #define _HONEYD_H_
 
+#include "timerwheel.h"
+#include "tcpbuf.h"
+
 #define PIDFILE			"/var/run/honeyd.pid"
 
-#define TCP_DEFAULT_SIZE	512
-#define TCP_MAX_SIZE		4096
-#define TCP_MAX_SEND		512
+#define TCP_MAX_SIZE		4096	/* default buffer limit per direction */
+#define TCP_MAX_SEND		1460	/* default segment size limit */
+#define TCP_DEFAULT_MSS		536	/* if the peer did not tell us */
+#define TCP_MIN_MSS		48	/* smaller announcements are raised */
 
 #define HONEYD_MTU		1500
 #define HONEYD_MAX_INTERFACES	8
+#define HONEYD_MAX_WORKERS	64
 
-#define HONEYD_MAX_CONNECTS	5 /*32000*/
+#define HONEYD_MAX_CONNECTS	32000	/* default connection budget */
+#define HONEYD_SOURCE_SHARE	16	/* one source may hold 1/16th */
 
 #define HONEYD_CLOSE_WAIT 60	
 #define HONEYD_SYN_WAIT		60
@@ -71,6 +77,7 @@ struct stats_network
 {
 	struct count *input_bytes;
 	struct count *output_bytes;
+	struct count *input_drops;	/* packets dropped by the kernel */
 };
 
 struct spoof
@@ -83,7 +90,7 @@ extern struct spoof no_spoof;
 
 struct delay
 {
-	struct event timeout;
+	struct twentry timeout;
 
 	struct addr src;
 	struct addr dst;
@@ -103,6 +110,7 @@ struct delay
 #define DELAY_TUNNEL	0x0008
 #define DELAY_UNREACH	0x0010
 #define DELAY_ETHERNET	0x0020	/* packet needs to be sent via ethernet */
+#define DELAY_CKSUM	0x0040	/* checksums are still valid from the wire */
 
 enum status
 {
@@ -137,6 +145,7 @@ struct action
 };
 
 #define PORT_TARPIT	0x01
+#define PORT_SYNCOOKIE	0x02
 
 struct port_encapsulate;
 
@@ -170,6 +179,13 @@ struct tuple
 	SPLAY_ENTRY(tuple) node;
 	TAILQ_ENTRY(tuple) next;
 
+	uint32_t hash;	/* flow table hash of the five tuple */
+
+	/* Per-source accounting for fair eviction */
+	struct consource *source;
+	TAILQ_ENTRY(tuple) source_next;
+	uint32_t lastuse;	/* connection clock at last activity */
+
 	/* currently used to store the ipv4 addresses */
 	ip_addr_t ip_src;
 	ip_addr_t ip_dst;
@@ -198,6 +214,59 @@ struct tuple
 SPLAY_HEAD( tree, tuple);
 TAILQ_HEAD( conlru, tuple);
 
+/* All connections that originate from one address (or IPv6 /64) */
+
+struct consource
+{
+	SPLAY_ENTRY(consource) node;
+
+	struct addr addr;
+	u_int count;
+	struct conlru cons;	/* least recently used at the tail */
+};
+
+enum con_evict
+{
+	CON_EVICT_IDLE = 0,	/* least recently active connection */
+	CON_EVICT_SOURCE,	/* source exceeded its fair share */
+	CON_EVICT_MAX
+};
+
+struct conbudget
+{
+	u_int max_connects;	/* limit on concurrent connections */
+	u_int max_per_source;
+	size_t max_bytes;	/* memory budget, 0 if only counted */
+
+	u_int nsources;
+	uint64_t evictions[CON_EVICT_MAX];
+};
+
+#define IP6_DESC_MAXEXT	8	/* extension headers we are willing to walk */
+#define SIZE_OF_IPV6_FRAGMENT_HEADER 8
+
+/* Where the headers of an IPv6 packet are, see ip6_desc_parse() */
+struct ip6_desc
+{
+	struct ip6_hdr *ip6;
+	u_int len;		/* bytes of the packet that have been parsed */
+
+	u_int nexts;
+	uint8_t ext_type[IP6_DESC_MAXEXT];
+	uint16_t ext_off[IP6_DESC_MAXEXT];
+
+	uint8_t proto;		/* upper layer protocol */
+	uint16_t off;		/* offset of the upper layer header */
+	uint16_t frag_off;	/* offset of the fragment header, 0 if none */
+	uint16_t unfrag_len;	/* length of the unfragmentable part */
+	int unfrag_last;	/* its last extension header or -1 */
+};
+
+#define IP6_DESC_UPPER(d, p)	((d)->proto == (p) ? \
+	(u_char *)(d)->ip6 + (d)->off : NULL)
+#define IP6_DESC_FRAG(d)	((d)->frag_off ? (struct ip6_ext_hdr *) \
+	((u_char *)(d)->ip6 + (d)->frag_off) : NULL)
+
 struct command
 {
 	pid_t pid;
@@ -263,19 +332,16 @@ struct tcp_con
 #define cmd_pfd	cmd.pfd
 #define cmd_perrfd cmd.perrfd
 
-	u_char *payload;
-	u_int psize;
-	u_int plen; /* date in buffer */
+	struct tcpbuf sendbuf;	/* data from the service, until acked */
 	u_int poff; /* current send offset */
 
-	u_char *readbuf;
-	u_int rsize;
-	u_int rlen;
+	struct tcpbuf readbuf;	/* data for the service */
 
 	uint8_t state;
 	uint8_t sentfin :1, finacked :1, sawwscale :1, sawtimestamp :1, unused :4;
 
 	u_short mss;
+	u_short snd_mss;	/* from the SYN of the peer, at least 48 */
 	u_short window;
 	uint32_t echotimestamp;
 
@@ -365,16 +431,16 @@ struct icmp_msg_inforeply
 };
 
 #define TCP_BYTESINFLIGHT(x)	(x)->poff
-#define TCP_MAX_INFLIGHT	4096
 
 /* Iterate over all active connections */
 int tuple_iterate(struct conlru *, int (*f)(struct tuple *, void *), void *);
-struct tuple *tuple_find(struct tree *, struct tuple *);
+struct flowtable;
+struct tuple *tuple_find(struct flowtable *, struct tuple *);
 
 void honeyd_ip_send(u_char *, u_int, struct spoof spoof);
 void honeyd_ip6_send(u_char *, u_int, struct spoof spoof);
 void honeyd_dispatch(struct template *, struct ip_hdr *, u_short);
-void honeyd_dispatch6(struct template *, struct ip6_hdr *);
+void honeyd_dispatch6(struct template *, const struct ip6_desc *);
 char *honeyd_contoa(const struct tuple *);
 
 void honeyd_input(const struct interface *, struct ip_hdr *, u_short);
@@ -408,6 +474,8 @@ struct tcp_con *tcp_new(struct ip_hdr *, struct tcp_hdr *, int);
 struct udp_con *udp_new(struct ip_hdr *, struct ip6_hdr *, struct udp_hdr *,
 		int, int);
 int tcp_setupconnect(struct tcp_con *);
+void connection_budget_init(void);
+const char *connection_evict_name(enum con_evict);
 void tcp_connectfail(struct tcp_con *con);
 
 void generic_timeout(struct event *, int);
@@ -432,7 +500,7 @@ struct port *port_find(struct template *, int, int);
 void port_free(struct template *, struct port *);
 void port_encapsulation_free(struct port_encapsulate *);
 
-int get_ip6_next_hdr(u_char **, struct ip6_hdr *, uint8_t);
+int ip6_desc_parse(struct ip6_desc *, struct ip6_hdr *, u_int);
 
 void icmp_echo_reply(struct template *, struct ip_hdr *, uint8_t, uint8_t,
 		uint16_t, uint8_t, u_char *, u_int, struct spoof spoof);
@@ -83,7 +83,7 @@ int pcap_datalink(void *some)
 {
 	return (-1);
 }
-char *honeyd_osfp_name(struct ip_hdr *hdr)
+char *honeyd_osfp_name(const struct tuple *hdr)
 {
 	return (NULL );
 }
@@ -57,6 +57,9 @@
 #include "template.h"
 #include "log.h"
 #include "interface.h"
+#include "siphash.h"
+#include "cksum.h"
+#include "plugins_config.h"
 #include "err.h"
 
 #define ALL_ROUTER_MULTICAST_ADDR "FF02::02"
@@ -67,45 +70,30 @@
 void (*icmp6_send_neighbor_advertisement)(const struct interface * inter,
         struct addr *src_eth, struct addr *dst_eth, struct in6_addr *src_ip6,
         struct in6_addr *dst_ip6) = icmp6_send_neighbor_adv;
-struct template *(*find_template)(const char *) = template_find; //XXX we need a proper name for mocked function pointer
+struct template *(*find_template)(const struct addr *) = template_find_addr; //XXX we need a proper name for mocked function pointer
 
 /* timer and event for sending the first router solicitation */
 struct event *router_sol_ev;
 struct timeval *router_sol_tv;
 
-/* tree where we store our neighbor requests in */
-SPLAY_HEAD(ndp_req_tree,ndp_neighbor_req) ndp_reqs;
-
-/* compare function for the tree macro */
-static int ndp_req_compare(struct ndp_neighbor_req *a,
-                           struct ndp_neighbor_req *b)
-{
-    return (addr_cmp(&a->target_ip_addr, &b->target_ip_addr));
-}
-
-/* generate prototypes */
-SPLAY_PROTOTYPE(ndp_req_tree, ndp_neighbor_req, next, ndp_req_compare);
-SPLAY_GENERATE(ndp_req_tree, ndp_neighbor_req, next, ndp_req_compare);
-
-/* multicast groups */
-SPLAY_HEAD(multicast_group_tree,multicast_group) multicast_groups;
-
-static int multicast_group_compare(struct multicast_group *a,
-                                   struct multicast_group *b)
-{
-    return (addr_cmp(&a->multicast_addr, &b->multicast_addr));
-}
-
-SPLAY_PROTOTYPE(multicast_group_tree, multicast_group, next,multicast_group_compare);
-SPLAY_GENERATE(multicast_group_tree, multicast_group, next,multicast_group_compare);
+/*
+ * The neighbor cache is an open addressed table with linear probing.
+ * The hash is keyed, so that neighbors picked by an attacker do not
+ * pile up in one cluster.  Neighbors learned from the network are
+ * limited to ndp_limit entries, our own templates are not.
+ */
+static struct ndp_neighbor_req *ndp_cache;
+static u_int ndp_cache_mask;
+static u_int ndp_count;		/* all entries */
+static u_int ndp_dynamic;	/* entries that are not ours */
+static u_int ndp_limit = NDP_CACHE_SIZE;
+static u_int ndp_hand;		/* where eviction looks next */
+static struct siphash_key ndp_key;
 
-static int addr_entry_compare(struct addr_entry *a, struct addr_entry *b)
-{
-    return (addr_cmp(&a->addr, &b->addr));
-}
+/* one timer ages the whole cache */
+static struct event ndp_sweep_ev;
 
-SPLAY_PROTOTYPE(addr_tree, addr_entry, next, addr_entry_compare);
-SPLAY_GENERATE(addr_tree, addr_entry, next, addr_entry_compare);
+static void ndp_send_solicitation(struct ndp_neighbor_req *);
 
 /* router adds that we receive */
 /* currently one router is supported */
@@ -143,34 +131,170 @@ struct addr * allocate_memory_for_eth_address(void)
     return address;
 }
 
-struct ndp_neighbor_req *
-find_or_create_neighbor_entry(struct addr * target_ip_addr)
+static uint32_t ndp_hash(struct addr *addr)
 {
-    struct ndp_neighbor_req *ret;
-    /* if an entry does exist then update it, if not create a new one */
-    ret = ndp_neighbor_find(target_ip_addr);
-    if (ret == NULL )
+    return (uint32_t) siphash(&ndp_key, &addr->addr_ip6, IP6_ADDR_LEN);
+}
+
+static struct ndp_neighbor_req *ndp_slot_find(struct addr *addr, uint32_t hash)
+{
+    struct ndp_neighbor_req *req;
+    u_int i;
+
+    for (i = hash & ndp_cache_mask; ndp_cache[i].state != NDP_FREE;
+            i = (i + 1) & ndp_cache_mask)
+    {
+        req = &ndp_cache[i];
+        if (req->hash == hash && memcmp(&req->target_ip_addr.addr_ip6,
+                                        &addr->addr_ip6, IP6_ADDR_LEN) == 0)
+            return req;
+    }
+
+    return NULL;
+}
+
+static struct ndp_neighbor_req *ndp_slot_new(uint32_t hash)
+{
+    u_int i;
+
+    for (i = hash & ndp_cache_mask; ndp_cache[i].state != NDP_FREE;
+            i = (i + 1) & ndp_cache_mask)
+        ;
+
+    return &ndp_cache[i];
+}
+
+/* Keeps the table at most half full, moving all entries */
+static void ndp_cache_grow(void)
+{
+    struct ndp_neighbor_req *old = ndp_cache;
+    u_int i, size = ndp_cache_mask + 1;
+
+    if ((ndp_cache = calloc(size * 2, sizeof(struct ndp_neighbor_req))) == NULL)
+        err(1, "%s: calloc", __func__);
+    ndp_cache_mask = size * 2 - 1;
+
+    for (i = 0; i < size; i++)
+    {
+        if (old[i].state != NDP_FREE)
+            *ndp_slot_new(old[i].hash) = old[i];
+    }
+    free(old);
+}
+
+/*
+ * Frees a slot and moves entries behind it back, so that no lookup
+ * has to skip over deleted slots.
+ */
+static void ndp_slot_delete(u_int i)
+{
+    u_int j = i, home;
+
+    for (;;)
     {
-        if ((ret = calloc(1, sizeof(struct ndp_neighbor_req))) == NULL )
+        ndp_cache[i].state = NDP_FREE;
+        do
         {
-            syslog(LOG_DEBUG, "not enough memory for neighbor ad");
-            return NULL ;
+            j = (j + 1) & ndp_cache_mask;
+            if (ndp_cache[j].state == NDP_FREE)
+                return;
+            home = ndp_cache[j].hash & ndp_cache_mask;
         }
-        ret->source_ip_addr.addr_type = ADDR_TYPE_NONE;
-        ret->target_ip_addr.addr_type = ADDR_TYPE_NONE;
+        while (i <= j ? (i < home && home <= j) : (i < home || home <= j));
+
+        ndp_cache[i] = ndp_cache[j];
+        i = j;
     }
-    return ret;
 }
 
+static void ndp_remove(struct ndp_neighbor_req *req)
+{
+    /* the packet that waits for the neighbor cannot be sent */
+    if (req->cb != NULL)
+        (*req->cb)(req, 0, req->arg);
+
+    if (req->state != NDP_STATIC)
+        ndp_dynamic--;
+    ndp_count--;
+    ndp_slot_delete(req - ndp_cache);
+}
+
+static void ndp_sweep_cb(int fd, short event, void *arg)
+{
+    struct timeval tv = { NDP_RETRANS_TIMER, 0 };
+
+    ndp_neighbor_age(time(NULL));
+
+    if (ndp_dynamic)
+        evtimer_add(&ndp_sweep_ev, &tv);
+}
 
-void insert_into_neighbor_cache(struct ndp_neighbor_req * entry)
+static void ndp_set_state(struct ndp_neighbor_req *req, int state)
 {
-    if (SPLAY_FIND(ndp_req_tree,&ndp_reqs,entry) == NULL )
+    struct timeval tv = { NDP_RETRANS_TIMER, 0 };
+    time_t now = time(NULL);
+
+    if (req->state == NDP_STATIC || req->state == NDP_FREE)
     {
-        SPLAY_INSERT(ndp_req_tree, &ndp_reqs, entry);
+        if (state != NDP_STATIC)
+            ndp_dynamic++;
     }
+    else if (state == NDP_STATIC)
+        ndp_dynamic--;
+
+    req->state = state;
+    req->probes = 0;
+    switch (state)
+    {
+    case NDP_INCOMPLETE:
+        req->expire = now + NDP_RETRANS_TIMER;
+        break;
+    case NDP_REACHABLE:
+        req->expire = now + NDP_REACHABLE_TIME;
+        break;
+    case NDP_STALE:
+        req->expire = now + NDP_STALE_TIME;
+        break;
+    case NDP_FAILED:
+        req->expire = now + NDP_FAILED_TIME;
+        break;
+    }
+
+    if (ndp_dynamic && !evtimer_pending(&ndp_sweep_ev, NULL))
+        evtimer_add(&ndp_sweep_ev, &tv);
 }
 
+/*
+ * The cache is full.  Looks at the next few neighbors and throws out
+ * the one we are least interested in: failures first, then stale
+ * entries and pending resolutions.
+ */
+static void ndp_evict(void)
+{
+    static const u_char rank[] = { 0, 2, 3, 1, 0, 0 };
+    struct ndp_neighbor_req *req, *victim = NULL;
+    u_int i, n = 0;
+
+    for (i = 0; i <= ndp_cache_mask && n < NDP_EVICT_SCAN; i++)
+    {
+        ndp_hand = (ndp_hand + 1) & ndp_cache_mask;
+        req = &ndp_cache[ndp_hand];
+        if (req->state == NDP_FREE || req->state == NDP_STATIC)
+            continue;
+        n++;
+        if (victim == NULL || rank[req->state] < rank[victim->state] ||
+                (rank[req->state] == rank[victim->state] &&
+                 req->expire < victim->expire))
+            victim = req;
+    }
+
+    if (victim != NULL)
+    {
+        syslog(LOG_DEBUG, "neighbor cache full, evicting %s",
+               addr_ntoa(&victim->target_ip_addr));
+        ndp_remove(victim);
+    }
+}
 
 struct ndp_neighbor_req* assign_source_and_target_to_neighbor_entry(
     struct ndp_neighbor_req* entry, struct addr* source_mac_addr,
@@ -200,37 +324,110 @@ struct ndp_neighbor_req* assign_source_and_target_to_neighbor_entry(
 }
 
 
-/* create a new ndp entry and add it to the tree - called when a new template is created*/
+/*
+ * Creates or updates the entry for target_ip_addr in the given state.
+ * The entries of our templates are not changed by anything we learn
+ * from the network.
+ */
 struct ndp_neighbor_req *
 ndp_neighbor_new(const struct interface *inter, struct addr * source_mac_addr,
                  struct addr * source_ip_addr, struct addr *target_mac_addr,
-                 struct addr *target_ip_addr)
+                 struct addr *target_ip_addr, int state)
 {
     struct ndp_neighbor_req *ret;
+    uint32_t hash = ndp_hash(target_ip_addr);
+
+    if ((ret = ndp_slot_find(target_ip_addr, hash)) != NULL)
+    {
+        if (ret->state == NDP_STATIC && state != NDP_STATIC)
+            return ret;
+    }
+    else
+    {
+        if (state != NDP_STATIC && ndp_dynamic >= ndp_limit)
+            ndp_evict();
+        if (++ndp_count > (ndp_cache_mask + 1) / 2)
+            ndp_cache_grow();
+
+        ret = ndp_slot_new(hash);
+        memset(ret, 0, sizeof(struct ndp_neighbor_req));
+        ret->hash = hash;
+        ret->source_ip_addr.addr_type = ADDR_TYPE_NONE;
+        ret->target_ip_addr.addr_type = ADDR_TYPE_NONE;
+    }
 
-    ret = find_or_create_neighbor_entry(target_ip_addr);
     ret->inter = inter;
     ret = assign_source_and_target_to_neighbor_entry(ret, source_mac_addr,
             source_ip_addr, target_mac_addr, target_ip_addr);
+    ndp_set_state(ret, state);
 
-    insert_into_neighbor_cache(ret);
     return ret;
 }
 
 struct ndp_neighbor_req *
 ndp_neighbor_find(struct addr * target_ip_addr)
 {
-    struct ndp_neighbor_req req;
-    req.target_ip_addr = *target_ip_addr;
+    return ndp_slot_find(target_ip_addr, ndp_hash(target_ip_addr));
+}
+
+int ndp_neighbor_delete(struct addr * target_ip_addr)
+{
+    struct ndp_neighbor_req *req;
+
+    if ((req = ndp_neighbor_find(target_ip_addr)) == NULL)
+        return 0;
 
-    return SPLAY_FIND(ndp_req_tree,&ndp_reqs,&req);
+    ndp_remove(req);
+    return 1;
 }
 
-struct ndp_neighbor_req * ndp_neighbor_delete(struct addr * target_ip_addr)
+/*
+ * Runs the state machine of all neighbors whose timer ran out:
+ * pending resolutions are solicited again or fail, reachable
+ * neighbors become stale, and stale and failed ones are dropped.
+ */
+void ndp_neighbor_age(time_t now)
 {
-    struct ndp_neighbor_req req;
-    req.target_ip_addr = *target_ip_addr;
-    return SPLAY_REMOVE(ndp_req_tree,&ndp_reqs,&req);
+    struct ndp_neighbor_req *req;
+    u_int i = 0;
+
+    while (i <= ndp_cache_mask)
+    {
+        req = &ndp_cache[i];
+        if (req->state == NDP_FREE || req->state == NDP_STATIC ||
+                now < req->expire)
+        {
+            i++;
+            continue;
+        }
+
+        switch (req->state)
+        {
+        case NDP_INCOMPLETE:
+            if (req->probes < NDP_MAX_SOLICIT)
+            {
+                ndp_send_solicitation(req);
+                req->expire = now + NDP_RETRANS_TIMER;
+                break;
+            }
+            syslog(LOG_DEBUG, "no answer from neighbor %s",
+                   addr_ntoa(&req->target_ip_addr));
+            if (req->cb != NULL)
+                (*req->cb)(req, 0, req->arg);
+            req->cb = NULL;
+            req->arg = NULL;
+            ndp_set_state(req, NDP_FAILED);
+            break;
+        case NDP_REACHABLE:
+            ndp_set_state(req, NDP_STALE);
+            break;
+        default:
+            /* the next entry may have moved into this slot */
+            ndp_remove(req);
+            continue;
+        }
+        i++;
+    }
 }
 
 /*
@@ -266,31 +463,53 @@ void schedule_router_solicitation(void)
 
 void ndp_init(void)
 {
-    SPLAY_INIT(&ndp_reqs);
+    extern rand_t *honeyd_rand;
+    u_char seed[SIPHASH_KEY_LEN];
+
+    rand_get(honeyd_rand, seed, sizeof(seed));
+    siphash_key_init(&ndp_key, seed, sizeof(seed));
+
+    ndp_cache_mask = 2 * NDP_CACHE_SIZE - 1;
+    if ((ndp_cache = calloc(ndp_cache_mask + 1,
+                            sizeof(struct ndp_neighbor_req))) == NULL)
+        err(1, "%s: calloc", __func__);
+    evtimer_set(&ndp_sweep_ev, ndp_sweep_cb, NULL);
+
     schedule_router_solicitation();
 }
 
-void multicast_init(void)
+/* The configuration may change how many neighbors we remember */
+void ndp_config(void)
 {
-    SPLAY_INIT(&multicast_groups);
+    const struct honeyd_plugin_cfg *cfg;
+
+    if ((cfg = plugins_config_find_item("honeyd", "ndp_cache_size",
+                                        HD_CONFIG_INT)) != NULL && cfg->cfg_int > 0)
+        ndp_limit = cfg->cfg_int;
 }
 
 int is_icmp6_checksum_correct(struct ip6_hdr *ip6, struct icmp6_hdr *icmp6)
 {
     int iplen = ntohs(ip6->ip6_plen) + IP6_HDR_LEN;
-    u_int16_t cksum = icmp6->icmp6_cksum;
-    ip6_checksum(ip6, iplen);
-    if (icmp6->icmp6_cksum != cksum)
-        return 0;
-    return 1;
+
+    return cksum_verify(ip6, iplen);
 }
 
 /**
  * ICMPv6 dispatcher, all incoming ICMPv6 packets get passed to the corresponding handler.
  */
-void icmp6_recv_cb(const struct interface * inter, struct ip6_hdr *ip6,
-                   struct icmp6_hdr * icmp6)
+void icmp6_recv_cb(const struct interface * inter, const struct ip6_desc *desc)
 {
+    struct ip6_hdr *ip6 = desc->ip6;
+    struct icmp6_hdr *icmp6;
+    u_int icmp6len;
+
+    if (desc->proto != IPPROTO_ICMPV6 ||
+            desc->len < desc->off + sizeof(struct icmp6_hdr))
+        return;
+    icmp6 = (struct icmp6_hdr *) ((u_char *) ip6 + desc->off);
+    icmp6len = desc->len - desc->off;
+
     if (!is_icmp6_checksum_correct(ip6, icmp6))
     {
         syslog(LOG_DEBUG, "icmp packet with invalid checksum received");
@@ -300,16 +519,16 @@ void icmp6_recv_cb(const struct interface * inter, struct ip6_hdr *ip6,
     switch (icmp6->icmp6_type)
     {
     case ND_NEIGHBOR_SOLICIT:
-        handle_neighbor_solicitation(inter, ip6, icmp6);
+        handle_neighbor_solicitation(inter, ip6, icmp6, icmp6len);
         break;
     case ND_NEIGHBOR_ADVERT:
-        handle_neighbor_advertisement(inter, ip6, icmp6);
+        handle_neighbor_advertisement(inter, ip6, icmp6, icmp6len);
         break;
     case ND_ROUTER_ADVERT:
         handle_router_advertisement(inter, ip6, icmp6);
         break;
     case ICMP6_ECHO_REQUEST:
-        handle_echo_request(inter, ip6, icmp6);
+        handle_echo_request(inter, ip6, icmp6, icmp6len);
         break;
     default:
         syslog(LOG_DEBUG, "unhandled icmp6 type: %d", icmp6->icmp6_type);
@@ -319,32 +538,63 @@ void icmp6_recv_cb(const struct interface * inter, struct ip6_hdr *ip6,
     return;
 }
 
-/**
- * Searches through neibor solicitation options for an ehternet address and returns the first one found.
+/*
+ * Searches len bytes of neighbor discovery options for a link-layer
+ * address option of the given type and stores the first one found.
+ * Returns 0 if there is none.
  */
-struct addr * get_link_addr_from_neighbor_solicitation(
-    struct nd_neighbor_solicit *neighbor_solicit, int ip_plen)
+static int get_link_addr_from_options(struct nd_opt_hdr *current_opt,
+                                      int len, int type, struct addr *eth_addr)
 {
+    int processed_bytes = 0;
 
-    struct nd_opt_hdr *current_opt = (struct nd_opt_hdr *) (neighbor_solicit + 1);
-    struct addr * eth_addr = allocate_memory_for_eth_address();
-    int processed_bytes = sizeof(struct nd_neighbor_solicit);
-
-    while (processed_bytes < ip_plen)
+    while (processed_bytes + (int) sizeof(struct nd_opt_hdr) <= len)
     {
-        switch (current_opt->nd_opt_type)
+        /* options of length zero must be discarded, RFC 4861 */
+        if (current_opt->nd_opt_len == 0 ||
+                processed_bytes + current_opt->nd_opt_len * 8 > len)
+            return 0;
+
+        if (current_opt->nd_opt_type == type)
         {
-        case ND_OPT_SOURCE_LINKADDR:
+            eth_addr->addr_type = ADDR_TYPE_ETH;
+            eth_addr->addr_bits = ETH_ADDR_BITS;
             memcpy(&eth_addr->addr_eth, current_opt + 1, ETH_ADDR_LEN);
-            return eth_addr;
-        default:
-            break;
+            return 1;
         }
 
         processed_bytes += current_opt->nd_opt_len * 8;/* len in 8 octets */
         current_opt = current_opt + (current_opt->nd_opt_len * 4);/* 1 octet is 4xsizeof(opt header) */
     }
-    return NULL ;
+    return 0;
+}
+
+/**
+ * Searches through neibor solicitation options for an ehternet address and stores the first one found.
+ * Returns 0 if there is none.
+ */
+int get_link_addr_from_neighbor_solicitation(
+    struct nd_neighbor_solicit *neighbor_solicit, int ip_plen,
+    struct addr *eth_addr)
+{
+    return get_link_addr_from_options(
+               (struct nd_opt_hdr *) (neighbor_solicit + 1),
+               ip_plen - (int) sizeof(struct nd_neighbor_solicit),
+               ND_OPT_SOURCE_LINKADDR, eth_addr);
+}
+
+/* Hands the packet that waited for the neighbor over, once */
+void call_ndp_callback(struct ndp_neighbor_req * req)
+{
+    void (*cb)(struct ndp_neighbor_req *, int, void *) = req->cb;
+    void *arg = req->arg;
+
+    if (cb != NULL && NDP_RESOLVED(req))
+    {
+        req->cb = NULL;
+        req->arg = NULL;
+        (*cb)(req, 1, arg);
+    }
 }
 
 /**
@@ -353,28 +603,27 @@ struct addr * get_link_addr_from_neighbor_solicitation(
  * is the sender of the neighbor solicitation.
  */
 void handle_neighbor_solicitation(const struct interface *inter,
-                                  struct ip6_hdr *ip6, struct icmp6_hdr *icmp6)
+                                  struct ip6_hdr *ip6, struct icmp6_hdr *icmp6,
+                                  u_int icmp6len)
 {
 
-    struct addr * src_eth_addr, *dst_eth_addr = NULL, *src_ip_addr, *dst_ip_addr;
+    struct addr src_eth_addr, dst_eth_addr, src_ip_addr, dst_ip_addr;
     /* the option header might be set and contains the source address */
     struct nd_neighbor_solicit *neighbor_solicit;
-    char * template_name;
+    struct ndp_neighbor_req *req;
+    struct addr target_ip_addr;
     struct template *tmpl;
+    int have_lladdr;
 
-    src_eth_addr = allocate_memory_for_eth_address();
-    src_ip_addr = allocate_memory_for_ipv6_address();
-    dst_ip_addr = allocate_memory_for_ipv6_address();
-
-    memcpy(&src_ip_addr->addr_ip6, &ip6->ip6_src, IP6_ADDR_LEN);
-    memcpy(&dst_ip_addr->addr_ip6, &ip6->ip6_dst, IP6_ADDR_LEN);
+    ip6_addr_t_to_addr(&src_ip_addr, &ip6->ip6_src);
+    ip6_addr_t_to_addr(&dst_ip_addr, &ip6->ip6_dst);
 
     neighbor_solicit = (struct nd_neighbor_solicit*) icmp6;
 
     /* check if this address concerns us - this is if a template exists */
-    template_name = get_solicited_addr_as_str(icmp6);
+    in6_addr_to_addr(&target_ip_addr, &neighbor_solicit->nd_ns_target);
 
-    tmpl = find_template(template_name);
+    tmpl = find_template(&target_ip_addr);
 
     if (tmpl == NULL )
     {
@@ -383,7 +632,7 @@ void handle_neighbor_solicitation(const struct interface *inter,
     else
     {
         syslog(LOG_DEBUG, "received a neighbor solicitation for %s from %s",
-               template_name, addr_ntoa(src_ip_addr));
+               addr_ntoa(&target_ip_addr), addr_ntoa(&src_ip_addr));
     }
 
     /* set the ethernet address of our template */
@@ -391,37 +640,42 @@ void handle_neighbor_solicitation(const struct interface *inter,
     {
         syslog(LOG_DEBUG,
                "Cant handle neighbor solicitation because no ethernet address for template %s configured.",
-               template_name);
+               tmpl->name);
     }
     else
     {
 
-        memcpy(src_eth_addr, tmpl->ethernet_addr, sizeof(struct addr));
-        dst_eth_addr = get_link_addr_from_neighbor_solicitation(neighbor_solicit,ntohs(ip6->ip6_plen));
+        memcpy(&src_eth_addr, tmpl->ethernet_addr, sizeof(struct addr));
+        have_lladdr = get_link_addr_from_neighbor_solicitation(neighbor_solicit,
+                      icmp6len, &dst_eth_addr);
 
-        icmp6_send_neighbor_advertisement(inter, src_eth_addr, dst_eth_addr,
+        icmp6_send_neighbor_advertisement(inter, &src_eth_addr,
+                                          have_lladdr ? &dst_eth_addr : NULL,
                                           &neighbor_solicit->nd_ns_target,
-                                          (struct in6_addr*) &src_ip_addr->addr_ip6);
-
-        ndp_neighbor_new(inter, src_eth_addr, dst_ip_addr, dst_eth_addr, src_ip_addr);
-        syslog(LOG_DEBUG, "added solicitation source to neighbor cache (%s)",
-               addr_ntoa(dst_eth_addr));
-
-    }
-
-    free(src_eth_addr);
-    free(template_name);
-
-    if (dst_eth_addr != NULL )
-    {
-        free(dst_eth_addr);
+                                          (struct in6_addr*) &src_ip_addr.addr_ip6);
+
+        /*
+         * The solicitation tells us where its source is, but not
+         * that it can hear us, RFC 4861 section 7.2.3.
+         */
+        req = ndp_neighbor_find(&src_ip_addr);
+        if (have_lladdr && (req == NULL || req->state != NDP_REACHABLE ||
+                            memcmp(&req->target_mac_addr.addr_eth,
+                                   &dst_eth_addr.addr_eth, ETH_ADDR_LEN) != 0))
+        {
+            req = ndp_neighbor_new(inter, &src_eth_addr, &dst_ip_addr,
+                                   &dst_eth_addr, &src_ip_addr, NDP_STALE);
+            call_ndp_callback(req);
+            syslog(LOG_DEBUG, "added solicitation source to neighbor cache (%s)",
+                   addr_ntoa(&dst_eth_addr));
+        }
     }
 }
 
 int is_address_managed_by_honeyd(struct addr *ip6_addr)
 {
 
-    if (template_find(addr_ntoa(ip6_addr)) != NULL )
+    if (template_find_addr(ip6_addr) != NULL )
     {
         return 1;
     }
@@ -456,23 +710,70 @@ void in6_addr_to_addr(struct addr * addr_struct,struct in6_addr * in6)
 }
 
 
-void call_ndp_callback(struct ndp_neighbor_req * req)
+/*
+ * Applies a neighbor advertisement to the cache entry of its target,
+ * RFC 4861 section 7.2.5.  lladdr is NULL if the advertisement did not
+ * carry the link-layer address of the target.  Only a solicited
+ * advertisement confirms that the neighbor is reachable, and only one
+ * with the override flag may replace an address that we know.
+ */
+static void ndp_neighbor_advert(const struct interface *inter,
+                                struct ndp_neighbor_req *req,
+                                struct addr *source_mac_addr,
+                                struct addr *source_ip_addr,
+                                struct addr *lladdr, uint32_t flags)
 {
-    if (req->cb != NULL )
+    int changed, state;
+
+    if (req->state == NDP_STATIC)
+        return;
+
+    if (req->state == NDP_INCOMPLETE || req->state == NDP_FAILED)
     {
-        (*req->cb)(req, 0, req->arg);
+        /* there is nothing to learn without the address */
+        if (lladdr == NULL)
+            return;
+        state = flags & ND_NA_FLAG_SOLICITED ? NDP_REACHABLE : NDP_STALE;
     }
+    else
+    {
+        changed = lladdr != NULL &&
+                  memcmp(&req->target_mac_addr.addr_eth, &lladdr->addr_eth,
+                         ETH_ADDR_LEN) != 0;
+        if (changed && !(flags & ND_NA_FLAG_OVERRIDE))
+        {
+            if (req->state == NDP_REACHABLE)
+                ndp_set_state(req, NDP_STALE);
+            return;
+        }
+
+        if (flags & ND_NA_FLAG_SOLICITED)
+            state = NDP_REACHABLE;
+        else if (changed)
+            state = NDP_STALE;
+        else
+            return;
+    }
+
+    req->inter = inter;
+    assign_source_and_target_to_neighbor_entry(req, source_mac_addr,
+            source_ip_addr, lladdr, NULL);
+    ndp_set_state(req, state);
 }
 
 void handle_neighbor_advertisement(const struct interface *inter,
-                                   struct ip6_hdr *ip6, struct icmp6_hdr *icmp6)
+                                   struct ip6_hdr *ip6, struct icmp6_hdr *icmp6,
+                                   u_int icmp6len)
 {
     struct ndp_neighbor_req * req;
     struct nd_neighbor_advert *neighbor_advert;
-    struct nd_opt_hdr *opt;
     struct addr source_mac_addr, source_ip_addr, target_mac_addr,
            target_ip_addr;
     struct template * tmpl;
+    int have_lladdr;
+
+    if (icmp6len < sizeof(struct nd_neighbor_advert))
+        return;
 
     neighbor_advert = (struct nd_neighbor_advert*) icmp6;
     in6_addr_to_addr(&target_ip_addr,&neighbor_advert->nd_na_target);
@@ -485,18 +786,11 @@ void handle_neighbor_advertisement(const struct interface *inter,
 
     syslog(LOG_DEBUG, "received neighbor advertisement for %s",
            addr_ntoa(&target_ip_addr));
-    
-    /* return if no option followes the advert header */
-    if (ip6->ip6_plen - sizeof(struct nd_neighbor_advert) <= 0)
-    {
-        syslog(LOG_DEBUG,
-               "the advertisement has no link layer address attached");
-        return;
-    }
 
-    /* Get requested ethernet address, TODO: check if there are more options possible */
-    opt = (struct nd_opt_hdr*) (neighbor_advert + 1);
-    bytes_to_ethernet_addr(&target_mac_addr,(char*)(opt+1));
+    have_lladdr = get_link_addr_from_options(
+                      (struct nd_opt_hdr *) (neighbor_advert + 1),
+                      icmp6len - sizeof(struct nd_neighbor_advert),
+                      ND_OPT_TARGET_LINKADDR, &target_mac_addr);
 
     ip6_addr_t_to_addr(&source_ip_addr,&ip6->ip6_dst);
 
@@ -509,13 +803,21 @@ void handle_neighbor_advertisement(const struct interface *inter,
     }
 
     /* get the source addresses needed to create a new neighbor entry */
-    tmpl = template_find(addr_ntoa(&source_ip_addr));
+    tmpl = template_find_addr(&source_ip_addr);
     memcpy(&source_mac_addr, tmpl->ethernet_addr, sizeof(struct addr));
 
 
-    /* TODO: decide whether we want to process advertisements triggered by others? */
-    req = ndp_neighbor_new(inter, &source_mac_addr, &source_ip_addr,
-                           &target_mac_addr, &target_ip_addr);
+    /* advertisements for neighbors we never asked for are ignored */
+    if ((req = ndp_neighbor_find(&target_ip_addr)) == NULL)
+    {
+        syslog(LOG_DEBUG, "unsolicited advertisement for %s",
+               addr_ntoa(&target_ip_addr));
+        return;
+    }
+
+    ndp_neighbor_advert(inter, req, &source_mac_addr, &source_ip_addr,
+                        have_lladdr ? &target_mac_addr : NULL,
+                        neighbor_advert->nd_na_flags_reserved);
 
     call_ndp_callback(req);
 }
@@ -632,12 +934,9 @@ void set_source_eth_option_in_ns(struct nd_opt_hdr* opt,struct addr * src_eth_ad
 }
 
 
-void icmp6_send_neighbor_sol(const struct interface *inter,
-                             struct addr *src_ip_addr, struct addr *src_eth_addr,
-                             struct addr *request_ip_addr,
-                             void (*cb)(struct ndp_neighbor_req *, int, void *), void *arg)
+/* Solicits the neighbor of a pending entry from the address it names */
+static void ndp_send_solicitation(struct ndp_neighbor_req *req)
 {
-
     /* create the icmp packet */
     int pkt_len = sizeof(struct nd_neighbor_solicit) + sizeof(struct nd_opt_hdr)	+ ETH_ADDR_LEN;
     u_char pkt[pkt_len];
@@ -645,34 +944,72 @@ void icmp6_send_neighbor_sol(const struct interface *inter,
     struct nd_opt_hdr * opt = (struct nd_opt_hdr*) (pkt+ sizeof(struct nd_neighbor_solicit));
     struct addr dst_eth_addr, dst_solicited_node_ip;
 
-    /* create a neighbor req to store the callback */
-    struct ndp_neighbor_req * req;
-    req = ndp_neighbor_new(inter, src_eth_addr, src_ip_addr, NULL,request_ip_addr);
-    req->cb = cb;
-    req->arg = arg;
-
     set_icmpv6_type_and_code_for_ns(neighbor_solicit);
 
     //create the broadcast ip and eth address
-    compute_solicited_node_address(request_ip_addr, &dst_solicited_node_ip);
+    compute_solicited_node_address(&req->target_ip_addr, &dst_solicited_node_ip);
     compute_multicast_eth_addr(&dst_solicited_node_ip, &dst_eth_addr);
 
     /* set the target */
-    memcpy(&neighbor_solicit->nd_ns_target, &request_ip_addr->addr_data8,
+    memcpy(&neighbor_solicit->nd_ns_target, &req->target_ip_addr.addr_data8,
            IP6_ADDR_LEN);
 
     /* set our address as option */
-    set_source_eth_option_in_ns(opt,src_eth_addr);
+    set_source_eth_option_in_ns(opt, &req->source_mac_addr);
 
     syslog(LOG_DEBUG, "sending neighbor solicitation for %s",
-           addr_ntoa(request_ip_addr));
+           addr_ntoa(&req->target_ip_addr));
 
-    icmp6_send_pkt(inter, src_eth_addr, &dst_eth_addr,
-                   (struct in6_addr*) (&src_ip_addr->addr_data8),
+    req->probes++;
+    icmp6_send_pkt(req->inter, &req->source_mac_addr, &dst_eth_addr,
+                   (struct in6_addr*) (&req->source_ip_addr.addr_data8),
                    (struct in6_addr*) (&dst_solicited_node_ip.addr_data8), pkt,
                    pkt_len);
 }
 
+/*
+ * Resolves request_ip_addr and calls cb once we know where it is, or
+ * with success 0 once we give up.  Only the most recent packet waits
+ * for a neighbor, and neighbors that did not answer recently are not
+ * solicited again until their negative entry runs out.
+ */
+void icmp6_send_neighbor_sol(const struct interface *inter,
+                             struct addr *src_ip_addr, struct addr *src_eth_addr,
+                             struct addr *request_ip_addr,
+                             void (*cb)(struct ndp_neighbor_req *, int, void *), void *arg)
+{
+    struct ndp_neighbor_req * req;
+
+    if ((req = ndp_neighbor_find(request_ip_addr)) != NULL)
+    {
+        switch (req->state)
+        {
+        case NDP_INCOMPLETE:
+            if (req->cb != NULL)
+                (*req->cb)(req, 0, req->arg);
+            req->cb = cb;
+            req->arg = arg;
+            return;
+        case NDP_FAILED:
+            syslog(LOG_DEBUG, "neighbor %s did not answer recently",
+                   addr_ntoa(request_ip_addr));
+            (*cb)(req, 0, arg);
+            return;
+        default:
+            (*cb)(req, 1, arg);
+            return;
+        }
+    }
+
+    /* create a neighbor req to store the callback */
+    req = ndp_neighbor_new(inter, src_eth_addr, src_ip_addr, NULL,
+                           request_ip_addr, NDP_INCOMPLETE);
+    req->cb = cb;
+    req->arg = arg;
+
+    ndp_send_solicitation(req);
+}
+
 void set_icmpv6_type_and_code_for_rs(struct nd_router_solicit *router_solicit)
 {
     router_solicit->nd_rs_type = ND_ROUTER_SOLICIT;
@@ -760,15 +1097,14 @@ void set_icmpv6_type_and_code_for_echo_reply(struct icmp6_hdr *icmp6_response_hd
  * requests to multicast adresses are not supported
  */
 void handle_echo_request(const struct interface *inter, struct ip6_hdr *ip6,
-                         struct icmp6_hdr *icmp6)
+                         struct icmp6_hdr *icmp6, u_int icmp6len)
 {
     struct addr src_ip_addr, dst_ip_addr;
     struct icmp6_hdr *icmp6_request_hdr = NULL, *icmp6_response_hdr = NULL;
-    u_int request_pkt_len = ntohs(ip6->ip6_plen) + IP6_HDR_LEN + ETH_HDR_LEN;
 
     struct template * tmpl = NULL;
     int data_field_len;
-    data_field_len = request_pkt_len - ETH_HDR_LEN - IP6_HDR_LEN - sizeof(struct icmp6_hdr);
+    data_field_len = icmp6len - sizeof(struct icmp6_hdr);
     int response_pkt_len = sizeof(struct icmp6_hdr) + data_field_len;
 
     u_char *request_data_field = NULL;
@@ -795,7 +1131,7 @@ void handle_echo_request(const struct interface *inter, struct ip6_hdr *ip6,
     memcpy(icmp_response_pkt+sizeof(struct icmp6_hdr),request_data_field,data_field_len);
 
     /* send echo reply */
-    tmpl = template_find(addr_ntoa(&dst_ip_addr));
+    tmpl = template_find_addr(&dst_ip_addr);
 
     syslog(LOG_DEBUG, "received echo request for %s from %s with sequence number %d", addr_ntoa(&dst_ip_addr),
            addr_ntoa(&src_ip_addr), ntohs(icmp6_request_hdr->icmp6_seq));
@@ -847,7 +1183,7 @@ void icmp6_error_send(struct addr *src, struct ip6_hdr *invoking_ip6, int type,
     memcpy(response_pkt + sizeof(struct icmp6_hdr), invoking_ip6,
            response_pkt_len - sizeof(struct icmp6_hdr));
 
-    tmpl = template_find(addr_ntoa(src));
+    tmpl = template_find_addr(src);
     if (tmpl != NULL )
     {
         icmp6_send_pkt(tmpl->inter, tmpl->ethernet_addr, NULL,
@@ -885,153 +1221,6 @@ struct router_advertisement * find_router_adv()
     return router_adv;
 }
 
-void add_to_multicast_group_cache(struct multicast_group *group_to_add)
-{
-    SPLAY_INSERT(multicast_group_tree, &multicast_groups, group_to_add);
-    syslog(LOG_DEBUG, "added multicast group %s",
-           addr_ntoa(&group_to_add->multicast_addr));
-}
-
-/*
- * Adds a new multicast group to the multicast group tree. Template adresses can
- * be added to a multicast address which is stored in this tree. This way we can
- * lookup an address belonging to a multicast group.
- */
-int multicast_group_new(struct addr *multicast_addr)
-{
-    struct multicast_group *tmp, *res;
-
-    tmp = (struct multicast_group*) malloc(sizeof(struct multicast_group));
-    if (tmp == NULL )
-    {
-        syslog(LOG_DEBUG, "could not allocate memory for new multicast group");
-        return -1;
-    }
-
-    tmp->multicast_addr = *multicast_addr;
-
-    res = SPLAY_FIND(multicast_group_tree,&multicast_groups,tmp);
-    if (res != NULL )
-    {
-        syslog(LOG_DEBUG,
-               "cannot add multicast group because it does already exist");
-        free(tmp);
-        return -1;
-    }
-    else
-    {
-        SPLAY_INIT(&tmp->templates);
-        add_to_multicast_group_cache(tmp);
-    }
-    return 0;
-}
-
-int is_multicast_group_registered(struct multicast_group *group)
-{
-    struct multicast_group *registered_group;
-    registered_group = SPLAY_FIND(multicast_group_tree,&multicast_groups,group);
-    if (registered_group == NULL )
-    {
-        return 0;
-    }
-    else
-    {
-        return 1;
-    }
-}
-
-int is_member_of_multicast_group(struct addr_entry *entry, struct multicast_group *group)
-{
-    if (SPLAY_FIND(addr_tree,&group->templates,entry) != NULL )
-    {
-        return 1;
-    }
-    else
-    {
-        return 0;
-    }
-}
-
-/*
- * Adds a new host to a multicast addr.
- */
-int add_host_to_multicast_group(struct addr *host, struct addr *multicast_addr)
-{
-    struct multicast_group tmp_group,*group;
-    struct addr_entry * host_entry = NULL;
-    struct addr_entry tmp_entry;
-
-    tmp_group.multicast_addr = *multicast_addr;
-    tmp_entry.addr = *host;
-
-    if (!is_multicast_group_registered(&tmp_group))
-    {
-        syslog(LOG_DEBUG,
-               "cannot add host to multicast group because group does not exist");
-        return -1;
-    }
-    else
-    {
-        /* check if host is already member of group */
-        group = SPLAY_FIND(multicast_group_tree,&multicast_groups,&tmp_group);
-        if (is_member_of_multicast_group(&tmp_entry,group))
-        {
-            syslog(LOG_DEBUG,
-                   "cannot add host to multicast group. host is already member.");
-            return -1;
-        }
-        else
-        {
-            /* insert host */
-            host_entry = (struct addr_entry *) malloc(	sizeof(struct addr_entry));
-            if (host_entry == NULL )
-            {
-                syslog(LOG_DEBUG,
-                       "could not allocate memory for new host entry");
-                return -1;
-            }
-            else
-            {
-                host_entry->addr = *host;
-                SPLAY_INSERT(addr_tree, &group->templates, host_entry);
-            }
-        }
-    }
-
-    syslog(LOG_DEBUG, "added %s to multicast group %s", addr_ntoa(host),
-           addr_ntoa(multicast_addr));
-    return 0;
-}
-
-struct addr *
-get_first_member_of_multicast_group(struct addr * multicast_addr)
-{
-    struct multicast_group tmp_group, *group;
-    struct addr_entry * res;
-
-    if (multicast_addr == NULL )
-    {
-        return NULL ;
-    }
-
-    tmp_group.multicast_addr = *multicast_addr;
-
-    /* check if group exists */
-    group = SPLAY_FIND(multicast_group_tree,&multicast_groups,&tmp_group);
-    if (group == NULL )
-    {
-        return NULL ;
-    }
-    else
-    {
-        res = SPLAY_MIN(addr_tree,&group->templates);
-        if (res != NULL )
-            return &res->addr;
-        else
-            return NULL ;
-    }
-}
-
 /* Unit tests */
 
 void assert_is_true(int value, char * error_message)
@@ -1064,7 +1253,7 @@ void test_ndp_neighbor_delete(void)
     addr_aton("2001:db8::1", &target_ip_addr);
 
     req = ndp_neighbor_new(NULL, &source_mac_addr, &source_ip_addr,
-                           &target_mac_addr, &target_ip_addr);
+                           &target_mac_addr, &target_ip_addr, NDP_REACHABLE);
     assert_is_true(req != NULL,
                    "ndp_neighbor_new does not return a valid neighbor request");
 
@@ -1072,9 +1261,8 @@ void test_ndp_neighbor_delete(void)
     assert_is_true(req != NULL,
                    "ndp_neighbor_find does not return a valid neighbor request");
 
-    req = ndp_neighbor_delete(&target_ip_addr);
-    assert_is_true(req != NULL,
-                   "ndp_neighbor_delete does not return a valid neighbor request");
+    assert_is_true(ndp_neighbor_delete(&target_ip_addr),
+                   "ndp_neighbor_delete does not find the neighbor request");
 
     req = ndp_neighbor_find(&target_ip_addr);
     assert_is_true(req == NULL,
@@ -1096,7 +1284,7 @@ void test_ndp_neighbor_new(void)
     addr_aton("2001:db8::2", &target_ip_addr);
 
     req = ndp_neighbor_new(NULL, &source_mac_addr, &source_ip_addr,
-                           &target_mac_addr, &target_ip_addr);
+                           &target_mac_addr, &target_ip_addr, NDP_REACHABLE);
 
     assert_is_true(req != NULL,
                    "ndp_neighbor_new does not return a valid neighbor request");
@@ -1131,6 +1319,146 @@ void test_ndp_neighbor_new(void)
 
 }
 
+static int test_ndp_failures;
+
+static void test_ndp_cb(struct ndp_neighbor_req *req, int success, void *arg)
+{
+    if (!success)
+        test_ndp_failures++;
+}
+
+void test_ndp_neighbor_cache(void)
+{
+    struct addr source_mac_addr, source_ip_addr, target_mac_addr,
+           target_ip_addr;
+    struct ndp_neighbor_req * req;
+    u_int limit = ndp_limit, i, found = 0;
+    time_t now = time(NULL);
+
+    initialize_addresses_with_test_values(&source_mac_addr, &target_mac_addr,
+                                          &source_ip_addr, &target_ip_addr);
+
+    /* a full cache makes room, and evictions keep all others reachable */
+    ndp_limit = ndp_dynamic + 100;
+    for (i = 0; i < 1000; i++)
+    {
+        target_ip_addr.addr_data16[7] = htons(i);
+        ndp_neighbor_new(NULL, &source_mac_addr, &source_ip_addr,
+                         &target_mac_addr, &target_ip_addr, NDP_REACHABLE);
+        assert_is_true(ndp_dynamic <= ndp_limit,
+                       "neighbor cache grows beyond its limit");
+    }
+    for (i = 0; i < 1000; i++)
+    {
+        target_ip_addr.addr_data16[7] = htons(i);
+        if ((req = ndp_neighbor_find(&target_ip_addr)) != NULL)
+        {
+            found++;
+            assert_is_true(ndp_neighbor_delete(&target_ip_addr),
+                           "cannot delete a neighbor that was found");
+        }
+    }
+    assert_is_true(found >= 100 && ndp_neighbor_find(&target_ip_addr) == NULL,
+                   "neighbors got lost during eviction");
+    ndp_limit = limit;
+
+    /* reachable neighbors become stale and are forgotten */
+    addr_aton("2001:db8::7", &target_ip_addr);
+    ndp_neighbor_new(NULL, &source_mac_addr, &source_ip_addr,
+                     &target_mac_addr, &target_ip_addr, NDP_REACHABLE);
+    ndp_neighbor_age(now + NDP_REACHABLE_TIME);
+    req = ndp_neighbor_find(&target_ip_addr);
+    assert_is_true(req != NULL && req->state == NDP_STALE,
+                   "reachable neighbor does not become stale");
+    ndp_neighbor_age(now + NDP_REACHABLE_TIME + NDP_STALE_TIME);
+    assert_is_true(ndp_neighbor_find(&target_ip_addr) == NULL,
+                   "stale neighbor is not removed");
+
+    /* a neighbor that does not answer is cached as a failure */
+    addr_aton("2001:db8::8", &target_ip_addr);
+    req = ndp_neighbor_new(NULL, &source_mac_addr, &source_ip_addr, NULL,
+                           &target_ip_addr, NDP_INCOMPLETE);
+    req->cb = test_ndp_cb;
+    req->probes = NDP_MAX_SOLICIT;
+    ndp_neighbor_age(now + NDP_RETRANS_TIMER);
+    req = ndp_neighbor_find(&target_ip_addr);
+    assert_is_true(req != NULL && req->state == NDP_FAILED &&
+                   test_ndp_failures == 1,
+                   "unanswered solicitation is not cached as failure");
+    icmp6_send_neighbor_sol(NULL, &source_ip_addr, &source_mac_addr,
+                            &target_ip_addr, test_ndp_cb, NULL);
+    assert_is_true(test_ndp_failures == 2,
+                   "failed neighbor is solicited again");
+    ndp_neighbor_age(now + NDP_RETRANS_TIMER + NDP_FAILED_TIME);
+    assert_is_true(ndp_neighbor_find(&target_ip_addr) == NULL,
+                   "failed neighbor is not forgotten");
+
+    /* our own neighbors are not touched by what we learn */
+    addr_aton("2001:db8::9", &target_ip_addr);
+    ndp_neighbor_new(NULL, NULL, NULL, &source_mac_addr, &target_ip_addr,
+                     NDP_STATIC);
+    req = ndp_neighbor_new(NULL, &source_mac_addr, &source_ip_addr,
+                           &target_mac_addr, &target_ip_addr, NDP_STALE);
+    ndp_neighbor_age(now + NDP_STALE_TIME * 2);
+    req = ndp_neighbor_find(&target_ip_addr);
+    assert_is_true(req != NULL && req->state == NDP_STATIC &&
+                   addr_cmp(&req->target_mac_addr, &source_mac_addr) == 0,
+                   "static neighbor was changed");
+    ndp_neighbor_delete(&target_ip_addr);
+
+    fprintf(stderr, "\t%s: OK\n", __func__);
+}
+
+/* Neighbor advertisements follow RFC 4861 section 7.2.5 */
+void test_ndp_neighbor_advert(void)
+{
+    struct addr source_mac_addr, source_ip_addr, target_mac_addr,
+           target_ip_addr, other_mac_addr;
+    struct ndp_neighbor_req * req;
+
+    initialize_addresses_with_test_values(&source_mac_addr, &target_mac_addr,
+                                          &source_ip_addr, &target_ip_addr);
+    addr_aton("2001:db8::a", &target_ip_addr);
+    addr_aton("66:77:88:99:10:12", &other_mac_addr);
+
+    /* a pending resolution needs the address of the neighbor */
+    req = ndp_neighbor_new(NULL, &source_mac_addr, &source_ip_addr, NULL,
+                           &target_ip_addr, NDP_INCOMPLETE);
+    ndp_neighbor_advert(NULL, req, &source_mac_addr, &source_ip_addr, NULL,
+                        ND_NA_FLAG_SOLICITED);
+    assert_is_true(req->state == NDP_INCOMPLETE,
+                   "advertisement without address resolved a neighbor");
+
+    /* an unsolicited advertisement does not confirm reachability */
+    ndp_neighbor_advert(NULL, req, &source_mac_addr, &source_ip_addr,
+                        &target_mac_addr, ND_NA_FLAG_OVERRIDE);
+    assert_is_true(req->state == NDP_STALE &&
+                   addr_cmp(&req->target_mac_addr, &target_mac_addr) == 0,
+                   "unsolicited advertisement did not leave neighbor stale");
+
+    ndp_neighbor_advert(NULL, req, &source_mac_addr, &source_ip_addr,
+                        &target_mac_addr, ND_NA_FLAG_SOLICITED);
+    assert_is_true(req->state == NDP_REACHABLE,
+                   "solicited advertisement did not confirm neighbor");
+
+    /* without override, a known address is not replaced */
+    ndp_neighbor_advert(NULL, req, &source_mac_addr, &source_ip_addr,
+                        &other_mac_addr, ND_NA_FLAG_SOLICITED);
+    assert_is_true(req->state == NDP_STALE &&
+                   addr_cmp(&req->target_mac_addr, &target_mac_addr) == 0,
+                   "advertisement without override replaced the address");
+
+    ndp_neighbor_advert(NULL, req, &source_mac_addr, &source_ip_addr,
+                        &other_mac_addr, ND_NA_FLAG_OVERRIDE);
+    assert_is_true(req->state == NDP_STALE &&
+                   addr_cmp(&req->target_mac_addr, &other_mac_addr) == 0,
+                   "advertisement with override kept the old address");
+
+    ndp_neighbor_delete(&target_ip_addr);
+
+    fprintf(stderr, "\t%s: OK\n", __func__);
+}
+
 char * get_packet_from_hex_string(char * hex_string, int packet_length_in_bytes)
 {
     char *pos = hex_string;
@@ -1153,7 +1481,7 @@ char * get_packet_from_hex_string(char * hex_string, int packet_length_in_bytes)
     return ip6_packet_bytes;
 }
 
-struct template *template_find_mock(const char *ip_addr_str)
+struct template *template_find_mock(const struct addr *addr)
 {
     struct template * tmpl;
     struct addr * eth_addr;
@@ -1212,7 +1540,8 @@ void test_handle_neighbor_solicitation()
 
     icmp6_send_neighbor_advertisement = icmp6_send_neighbor_adv_mock;
     find_template = template_find_mock;
-    handle_neighbor_solicitation(inter, ip6, icmp6);
+    handle_neighbor_solicitation(inter, ip6, icmp6,
+                                 packet_length - IP6_HDR_LEN);
 
     fprintf(stderr, "\t%s: OK\n", __func__);
 }
@@ -1221,5 +1550,7 @@ void icmp6_test(void)
 {
     test_ndp_neighbor_delete();
     test_ndp_neighbor_new();
+    test_ndp_neighbor_cache();
+    test_ndp_neighbor_advert();
     test_handle_neighbor_solicitation();
 }
@@ -37,9 +37,26 @@
 #include <netinet/icmp6.h>
 #include <stdio.h>
 
-struct ndp_neighbor_req{
+/* Neighbor cache states, RFC 4861 section 7.3.2 */
+#define NDP_FREE	0	/* unused slot */
+#define NDP_INCOMPLETE	1	/* solicited, no answer yet */
+#define NDP_REACHABLE	2
+#define NDP_STALE	3	/* not confirmed lately, still used */
+#define NDP_FAILED	4	/* negative entry, nobody answered */
+#define NDP_STATIC	5	/* one of our templates */
+
+#define NDP_RESOLVED(req) ((req)->state == NDP_REACHABLE || \
+	(req)->state == NDP_STALE || (req)->state == NDP_STATIC)
+
+#define NDP_CACHE_SIZE		4096	/* neighbors learned from the network */
+#define NDP_MAX_SOLICIT		3	/* MAX_MULTICAST_SOLICIT */
+#define NDP_RETRANS_TIMER	1	/* seconds, also the sweep interval */
+#define NDP_REACHABLE_TIME	30
+#define NDP_STALE_TIME		600	/* unused stale entries are dropped */
+#define NDP_FAILED_TIME		20	/* how long a failure is remembered */
+#define NDP_EVICT_SCAN		32	/* entries looked at to find a victim */
 
-	SPLAY_ENTRY(ndp_neighbor_req) next;
+struct ndp_neighbor_req{
 
 	const struct interface * inter;
 
@@ -56,21 +73,21 @@ struct ndp_neighbor_req{
 	void *arg;
 	
 	struct template *owner;
-};
 
-struct addr_entry{
-	SPLAY_ENTRY(addr_entry) next;
-	struct addr addr;
+	uint32_t hash;
+	u_char state;
+	u_char probes;		/* solicitations sent */
+	time_t expire;		/* when the state runs out */
 };
 
-SPLAY_HEAD(addr_tree,addr_entry);
+/* ff02::1:ffXX:XXXX, RFC 4291 section 2.7.1 */
+#define SOLICITED_NODE_PREFIX \
+	"\xff\x02\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\xff"
+#define SOLICITED_NODE_PREFIX_LEN	13
 
-struct multicast_group{
-	SPLAY_ENTRY(multicast_group) next;
-	struct addr multicast_addr;
-	struct addr_tree templates;	
-	/* associated templates */
-};
+#define ADDR_IS_SOLICITED_NODE(a) ((a)->addr_type == ADDR_TYPE_IP6 && \
+	memcmp(&(a)->addr_ip6, SOLICITED_NODE_PREFIX, \
+	    SOLICITED_NODE_PREFIX_LEN) == 0)
 
 struct router_advertisement{
 	int prefix_len;
@@ -79,26 +96,32 @@ struct router_advertisement{
 };
 
 void ndp_init(void);
-void multicast_init(void);
+void ndp_config(void);
+
+struct ip6_desc;
 
-void icmp6_recv_cb(const struct interface*, struct ip6_hdr*, struct icmp6_hdr*);
+void icmp6_recv_cb(const struct interface*, const struct ip6_desc *);
 
 int checksum_pseudo_header(unsigned char *, unsigned char *, unsigned char, unsigned char *, int); 
 
-void handle_neighbor_solicitation(const struct interface *, struct ip6_hdr*, struct icmp6_hdr*);
+void handle_neighbor_solicitation(const struct interface *, struct ip6_hdr*, struct icmp6_hdr*, u_int);
 
-void handle_neighbor_advertisement(const struct interface *,struct ip6_hdr*, struct icmp6_hdr*);
+void handle_neighbor_advertisement(const struct interface *,struct ip6_hdr*, struct icmp6_hdr*, u_int);
 
 void handle_router_advertisement(const struct interface *,struct ip6_hdr*, struct icmp6_hdr*);
 
 struct router_advertisement * find_router_adv();
 
-void handle_echo_request(const struct interface *, struct ip6_hdr*, struct icmp6_hdr*);
+void handle_echo_request(const struct interface *, struct ip6_hdr*, struct icmp6_hdr*, u_int);
 
-struct ndp_neighbor_req * ndp_neighbor_new(const struct interface *, struct addr *, struct addr *, struct addr*, struct addr*);
+struct ndp_neighbor_req * ndp_neighbor_new(const struct interface *, struct addr *, struct addr *, struct addr*, struct addr*, int);
 
 struct ndp_neighbor_req * ndp_neighbor_find(struct addr *);
 
+int ndp_neighbor_delete(struct addr *);
+
+void ndp_neighbor_age(time_t);
+
 void icmp6_send_neighbor_adv(const struct interface *,struct addr *,struct addr *,struct in6_addr *,struct in6_addr *);
 
 void icmp6_send_neighbor_sol(const struct interface *, struct addr *, struct addr *,
@@ -110,17 +133,12 @@ void icmp6_error_send(struct addr *src ,struct ip6_hdr *invoking_ip6,int type, i
 
 char *get_solicited_addr_as_str(struct icmp6_hdr *icmp6);
 
-int multicast_group_new(struct addr *multicast_addr);
-
-int add_host_to_multicast_group(struct addr *host, struct addr *multicast_addr);
-
-struct addr *
-get_first_member_of_multicast_group(struct addr * multicast_addr);
-
 void compute_solicited_node_address(struct addr *ip6_addr, struct addr *dst);
 
 void ip6_addr_t_to_addr(struct addr *addr_struct,ip6_addr_t *ip6);
 
+void in6_addr_to_addr(struct addr *addr_struct,struct in6_addr *in6);
+
 void icmp6_test(void);
 
 #endif
@@ -56,6 +56,17 @@
 #include <syslog.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#ifdef TPACKET3_HDRLEN
+#define HAVE_TPACKET_V3
+#endif
+#endif
+
 #include <event.h>
 #include <pcap.h>
 #include <dnet.h>
@@ -76,14 +87,18 @@ void honeyd_recv_cb(u_char *, const struct pcap_pkthdr *, const u_char *);
 static char *interface_expandips(int, char **, int);
 static void interface_recv(int, short, void *);
 static void interface_poll_recv(int, short, void *);
+static void interface_stats(int, short, void *);
 
 int interface_verify_config = 0;
 int interface_dopoll;
+int interface_doring;
 char *interface_filter = NULL;
 
 static TAILQ_HEAD(ifq, interface) interfaces;
+static int if_shard = 0, if_nshards = 1;
 static intf_t *intf;
 static pcap_handler if_recv_cb = NULL;
+static void (*if_drops_cb)(struct interface *, uint32_t) = NULL;
 
 void
 interface_prevent_init(void)
@@ -110,6 +125,14 @@ interface_initialize(pcap_handler cb)
 	if_recv_cb = cb;
 }
 
+/* Gets told how many packets the kernel dropped on an interface */
+
+void
+interface_drops_callback(void (*cb)(struct interface *, uint32_t))
+{
+	if_drops_cb = cb;
+}
+
 static void addr_remove_scope_id(struct addr* ip6) {
   /* TODO: remove magic numbers */
   if (ip6->addr_data8[0]==0xfe && ip6->addr_data8[1]==0x80) {
@@ -139,6 +162,8 @@ interface_new(char *dev)
 	
 	TAILQ_INSERT_TAIL(&interfaces, inter, next);
 
+	inter->if_ringfd = -1;
+	inter->if_txfd = -1;
 	inter->if_ent.intf_len = sizeof(struct intf_entry) + sizeof(struct addr)*NUMBER_OF_ALIASES;
 	strlcpy(inter->if_ent.intf_name, dev, sizeof(inter->if_ent.intf_name));
 
@@ -286,6 +311,24 @@ interface_find_responsible(struct addr *addr)
 	return (NULL);
 }
 
+static void
+interface_capture_close(struct interface *inter)
+{
+	if (event_initialized(&inter->if_recvev))
+		event_del(&inter->if_recvev);
+	if (inter->if_ringfd != -1) {
+		munmap(inter->if_ring, inter->if_ringsize);
+		close(inter->if_ringfd);
+		inter->if_ring = NULL;
+		inter->if_ringfd = -1;
+	}
+	if (inter->if_pcap != NULL) {
+		pcap_close(inter->if_pcap);
+		inter->if_pcap = NULL;
+	}
+	inter->if_pcapdrops = 0;
+}
+
 void
 interface_close(struct interface *inter)
 {
@@ -293,7 +336,11 @@ interface_close(struct interface *inter)
 
 	if (inter->if_eth != NULL)
 		eth_close(inter->if_eth);
-	pcap_close(inter->if_pcap);
+	if (inter->if_txfd != -1)
+		close(inter->if_txfd);
+	if (evtimer_initialized(&inter->if_statev))
+		evtimer_del(&inter->if_statev);
+	interface_capture_close(inter);
 
 	free(inter);
 }
@@ -348,60 +395,242 @@ interface_regular_filter(struct interface *inter,
 		errx(1, "%s: pcap filter exceeds maximum length", __func__);
 }
 
-void
-interface_init(char *dev, int naddresses, char **addresses)
+#ifdef HAVE_TPACKET_V3
+#ifndef ETH_P_ALL
+#define ETH_P_ALL	0x0003
+#endif
+
+/*
+ * Sets up a TPACKET_V3 receive ring on a packet socket.  The kernel
+ * fills whole blocks of frames that we hand to the receive callback
+ * straight out of the mapping: no copy and no read call per packet.
+ * The pcap compiled filter is attached as a socket filter.
+ */
+
+static int
+interface_ring_open(struct interface *inter, struct bpf_program *fcode,
+    int promisc)
 {
-	struct bpf_program fcode;
-	char ebuf[PCAP_ERRBUF_SIZE];
-	struct interface *inter;
-	int time, promisc = 0;
-	int pcap_fd;
+	struct tpacket_req3 req;
+	struct sockaddr_ll sll;
+	struct sock_fprog fprog;
+	int fd, version = TPACKET_V3;
+	u_int ifindex;
+
+	if ((ifindex = if_nametoindex(inter->if_ent.intf_name)) == 0)
+		return (-1);
+	if ((fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL))) == -1)
+		return (-1);
+
+	/* struct bpf_insn and struct sock_filter share their layout */
+	fprog.len = fcode->bf_len;
+	fprog.filter = (struct sock_filter *)fcode->bf_insns;
+	if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER,
+		&fprog, sizeof(fprog)) == -1)
+		goto fail;
+
+	if (setsockopt(fd, SOL_PACKET, PACKET_VERSION,
+		&version, sizeof(version)) == -1)
+		goto fail;
+
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = INTERFACE_RING_BLOCKSIZE;
+	req.tp_block_nr = INTERFACE_RING_BLOCKS;
+	req.tp_frame_size = INTERFACE_RING_FRAMESIZE;
+	req.tp_frame_nr = INTERFACE_RING_BLOCKS *
+	    (INTERFACE_RING_BLOCKSIZE / INTERFACE_RING_FRAMESIZE);
+	req.tp_retire_blk_tov = INTERFACE_RING_TIMEOUT;
+	if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) == -1)
+		goto fail;
+
+	inter->if_ringsize = req.tp_block_size * req.tp_block_nr;
+	inter->if_ring = mmap(NULL, inter->if_ringsize,
+	    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (inter->if_ring == MAP_FAILED) {
+		inter->if_ring = NULL;
+		goto fail;
+	}
 
-	if (dev != NULL && interface_find(dev) != NULL) {
-		fprintf(stderr, "Warning: Interface %s already configured\n",
-		    dev);
-		return;
+	memset(&sll, 0, sizeof(sll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = htons(ETH_P_ALL);
+	sll.sll_ifindex = ifindex;
+	if (bind(fd, (struct sockaddr *)&sll, sizeof(sll)) == -1)
+		goto fail;
+
+	if (promisc) {
+		struct packet_mreq mr;
+
+		memset(&mr, 0, sizeof(mr));
+		mr.mr_ifindex = ifindex;
+		mr.mr_type = PACKET_MR_PROMISC;
+		if (setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP,
+			&mr, sizeof(mr)) == -1)
+			goto fail;
 	}
 
-	/* creates a new interface - reserves memory and hangs the interface into the queue */
-	/* at the moment this function returns an error if just an ipv6 address has been entered */
-	inter = interface_new(dev);
-	if (interface_filter == NULL) {
-		/* 
-		 * Compute the monitored IP addresses.  If we are ethernet,
-		 * ignore our own packets.
-		 */
-		if (inter->if_ent.intf_link_addr.addr_type == ADDR_TYPE_ETH) {
-			interface_ether_filter(inter, naddresses, addresses);
+	inter->if_ringfd = fd;
+	inter->if_ringblock = 0;
 
-			/* 
-			 * We open all interfaces before parsing the
-			 * configuration, this means that for now, we
-			 * open all ethernet interfaces in promiscuous
-			 * mode.
-			 */
+	return (0);
 
-			promisc = 1;
-		} else {
-			syslog(LOG_DEBUG,"Your interface type is not ethernet but %d",inter->if_ent.intf_link_addr.addr_type);
-			interface_regular_filter(inter, naddresses, addresses);
+ fail:
+	syslog(LOG_WARNING, "%s: %s: %m", __func__, inter->if_ent.intf_name);
+	if (inter->if_ring != NULL) {
+		munmap(inter->if_ring, inter->if_ringsize);
+		inter->if_ring = NULL;
+	}
+	close(fd);
+	return (-1);
+}
+
+/* Walks all blocks that the kernel has passed to us */
+
+static void
+interface_ring_recv(struct interface *inter)
+{
+	struct tpacket_block_desc *block;
+	struct tpacket3_hdr *frame;
+	struct sockaddr_ll *sll;
+	struct pcap_pkthdr hdr;
+	u_int i;
+
+	for (;;) {
+		block = (struct tpacket_block_desc *)(inter->if_ring +
+		    inter->if_ringblock * INTERFACE_RING_BLOCKSIZE);
+		if (!(block->hdr.bh1.block_status & TP_STATUS_USER))
+			break;
+		__sync_synchronize();
+
+		frame = (struct tpacket3_hdr *)((u_char *)block +
+		    block->hdr.bh1.offset_to_first_pkt);
+		for (i = 0; i < block->hdr.bh1.num_pkts; i++) {
+			sll = (struct sockaddr_ll *)((u_char *)frame +
+			    TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+			/* Our own transmissions come back as outgoing */
+			if (sll->sll_pkttype != PACKET_OUTGOING) {
+				hdr.ts.tv_sec = frame->tp_sec;
+				hdr.ts.tv_usec = frame->tp_nsec / 1000;
+				hdr.caplen = frame->tp_snaplen;
+				hdr.len = frame->tp_len;
+
+				(*if_recv_cb)((u_char *)inter, &hdr,
+				    (u_char *)frame + frame->tp_mac);
+			}
+
+			frame = (struct tpacket3_hdr *)((u_char *)frame +
+			    frame->tp_next_offset);
 		}
-	} else {
-		promisc = 1;
 
-		/* Use an externally supplied filter */
-		strlcpy(inter->if_filter, interface_filter,
-		    sizeof(inter->if_filter));
+		/* Return the block to the kernel */
+		__sync_synchronize();
+		block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+		inter->if_ringblock =
+		    (inter->if_ringblock + 1) % INTERFACE_RING_BLOCKS;
 	}
+}
+
+/* Reading the ring statistics also resets them */
+
+static uint32_t
+interface_ring_drops(struct interface *inter)
+{
+	struct tpacket_stats_v3 st;
+	socklen_t len = sizeof(st);
+
+	if (getsockopt(inter->if_ringfd, SOL_PACKET, PACKET_STATISTICS,
+		&st, &len) == -1) {
+		syslog(LOG_WARNING, "%s: getsockopt: %m", __func__);
+		return (0);
+	}
+
+	return (st.tp_drops);
+}
+#endif /* HAVE_TPACKET_V3 */
+
+/*
+ * Opens a packet socket that only transmits, so that the transmit queue
+ * can hand it many frames with one system call.  libdnet does not let
+ * us get at the descriptor behind eth_t.
+ */
+
+static int
+interface_tx_open(struct interface *inter)
+{
+#ifdef __linux__
+	struct sockaddr_ll sll;
+	int fd;
+
+	/* Protocol 0 means that we do not receive anything */
+	if ((fd = socket(AF_PACKET, SOCK_RAW, 0)) == -1)
+		goto fail;
+
+	memset(&sll, 0, sizeof(sll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_ifindex = if_nametoindex(inter->if_ent.intf_name);
+	if (sll.sll_ifindex == 0 ||
+	    bind(fd, (struct sockaddr *)&sll, sizeof(sll)) == -1) {
+		close(fd);
+		goto fail;
+	}
+
+	return (fd);
+
+ fail:
+	syslog(LOG_WARNING, "%s: %s: %m", __func__, inter->if_ent.intf_name);
+#endif
+	return (-1);
+}
+
+/*
+ * Tries to receive from a memory mapped ring instead of pcap.  We still
+ * need a pcap handle to compile the filter and to know the link layer.
+ */
+
+static int
+interface_ring_init(struct interface *inter, int promisc)
+{
+#ifdef HAVE_TPACKET_V3
+	struct bpf_program fcode;
+
+	if (inter->if_ent.intf_link_addr.addr_type != ADDR_TYPE_ETH)
+		return (-1);
+
+	if ((inter->if_pcap = pcap_open_dead(DLT_EN10MB,
+		 inter->if_ent.intf_mtu + 40)) == NULL)
+		return (-1);
+	inter->if_dloff = pcap_dloff(inter->if_pcap);
+
+	if (pcap_compile(inter->if_pcap, &fcode, inter->if_filter, 1, 0) < 0)
+		errx(1, "bad pcap filter: %s", pcap_geterr(inter->if_pcap));
+
+	if (interface_ring_open(inter, &fcode, promisc) == -1) {
+		pcap_freecode(&fcode);
+		pcap_close(inter->if_pcap);
+		inter->if_pcap = NULL;
+		return (-1);
+	}
+	pcap_freecode(&fcode);
+
+	syslog(LOG_INFO, "listening %son %s with %d KB ring: %s",
+	    promisc ? "promiscuously " : "", inter->if_ent.intf_name,
+	    (int)(inter->if_ringsize >> 10), inter->if_filter);
+
+	return (inter->if_ringfd);
+#else
+	return (-1);
+#endif
+}
+
+static int
+interface_pcap_init(struct interface *inter, int promisc)
+{
+	struct bpf_program fcode;
+	char ebuf[PCAP_ERRBUF_SIZE];
+	int time;
+	int pcap_fd;
 
-	/* In most cases, we want to compare the addresses directly */
-	inter->if_addrbits = inter->if_ent.intf_addr.addr_bits;
-	inter->if_ent.intf_addr.addr_bits = IP_ADDR_BITS;
-	
-	/* Don't open interfaces for real if we just want to verify config */
-	if (interface_verify_config)
-		return;
-	
 	time = interface_dopoll ? 10 : 30;
 	if ((inter->if_pcap = pcap_open_live(inter->if_ent.intf_name,
 		 inter->if_ent.intf_mtu + 40, promisc, time, ebuf)) == NULL)
@@ -436,6 +665,23 @@ interface_init(char *dev, int naddresses, char **addresses)
 			warn("BIOCIMMEDIATE");
 	}
 #endif
+	return (pcap_fd);
+}
+
+/* Opens the capture for an interface and starts receiving from it */
+
+static void
+interface_capture_open(struct interface *inter)
+{
+	int pcap_fd = -1;
+
+	if (interface_doring &&
+	    (pcap_fd = interface_ring_init(inter, inter->if_promisc)) == -1)
+		syslog(LOG_WARNING, "%s: no packet ring on %s, using pcap",
+		    __func__, inter->if_ent.intf_name);
+	if (pcap_fd == -1)
+		pcap_fd = interface_pcap_init(inter, inter->if_promisc);
+
 	/* this is the part where the interface callbacks get registered */
 	if (!interface_dopoll) {
 		event_set(&inter->if_recvev, pcap_fd,
@@ -451,7 +697,136 @@ interface_init(char *dev, int naddresses, char **addresses)
 		evtimer_set(&inter->if_recvev, interface_poll_recv, inter);
 		evtimer_add(&inter->if_recvev, &tv);
 	}
+}
+
+void
+interface_init(char *dev, int naddresses, char **addresses)
+{
+	struct interface *inter;
+	struct timeval tv = INTERFACE_STATS_INTERVAL;
+	int promisc = 0;
+
+	if (dev != NULL && interface_find(dev) != NULL) {
+		fprintf(stderr, "Warning: Interface %s already configured\n",
+		    dev);
+		return;
+	}
+
+	/* creates a new interface - reserves memory and hangs the interface into the queue */
+	/* at the moment this function returns an error if just an ipv6 address has been entered */
+	inter = interface_new(dev);
+	if (interface_filter == NULL) {
+		/* 
+		 * Compute the monitored IP addresses.  If we are ethernet,
+		 * ignore our own packets.
+		 */
+		if (inter->if_ent.intf_link_addr.addr_type == ADDR_TYPE_ETH) {
+			interface_ether_filter(inter, naddresses, addresses);
+
+			/* 
+			 * We open all interfaces before parsing the
+			 * configuration, this means that for now, we
+			 * open all ethernet interfaces in promiscuous
+			 * mode.
+			 */
+
+			promisc = 1;
+		} else {
+			syslog(LOG_DEBUG,"Your interface type is not ethernet but %d",inter->if_ent.intf_link_addr.addr_type);
+			interface_regular_filter(inter, naddresses, addresses);
+		}
+	} else {
+		promisc = 1;
+
+		/* Use an externally supplied filter */
+		strlcpy(inter->if_filter, interface_filter,
+		    sizeof(inter->if_filter));
+	}
+
+	/* In most cases, we want to compare the addresses directly */
+	inter->if_addrbits = inter->if_ent.intf_addr.addr_bits;
+	inter->if_ent.intf_addr.addr_bits = IP_ADDR_BITS;
 	
+	/* Don't open interfaces for real if we just want to verify config */
+	inter->if_promisc = promisc;
+	if (interface_verify_config)
+		return;
+
+	interface_capture_open(inter);
+
+	if (inter->if_eth != NULL)
+		inter->if_txfd = interface_tx_open(inter);
+
+	/* Collect the kernel drop counters */
+	evtimer_set(&inter->if_statev, interface_stats, inter);
+	evtimer_add(&inter->if_statev, &tv);
+}
+
+/*
+ * Restricts the capture of this process to its share of the traffic
+ * when several workers are running.  Packets are steered by their
+ * destination address, so that all flows to a virtual host end up in
+ * the same worker.  ARP and the neighbor advertisements that answer
+ * our own requests are seen by every worker; neighbor solicitations
+ * go to the solicited-node address which shares the last byte with
+ * the target and are steered like everything else.
+ */
+
+void
+interface_shard(int shard, int nshards)
+{
+	struct interface *inter;
+	char filter[sizeof(inter->if_filter)];
+
+	if_shard = shard;
+	if_nshards = nshards;
+
+	TAILQ_FOREACH(inter, &interfaces, next) {
+		if (snprintf(filter, sizeof(filter),
+			"(%s) and (not (ip or ip6) or "
+			"(ip and ip[19] - ip[19] / %d * %d = %d) or "
+			"(ip6 and ip6[39] - ip6[39] / %d * %d = %d) or "
+			"(icmp6 and (ip6[40] = 134 or ip6[40] = 136)))",
+			inter->if_filter, nshards, nshards, shard,
+			nshards, nshards, shard) >= sizeof(filter))
+			errx(1, "%s: pcap filter exceeds maximum length",
+			    __func__);
+		strlcpy(inter->if_filter, filter, sizeof(inter->if_filter));
+
+		if (interface_verify_config)
+			continue;
+
+		/* The capture we inherited is shared with the other workers */
+		interface_capture_close(inter);
+		interface_capture_open(inter);
+	}
+}
+
+/*
+ * Returns 1 if the destination address belongs to the share of traffic
+ * that this process handles.  It has to agree with interface_shard().
+ */
+
+int
+interface_shard_owns(const struct addr *addr)
+{
+	u_char last;
+
+	if (if_nshards <= 1)
+		return (1);
+
+	switch (addr->addr_type) {
+	case ADDR_TYPE_IP:
+		last = ((const u_char *)&addr->addr_ip)[IP_ADDR_LEN - 1];
+		break;
+	case ADDR_TYPE_IP6:
+		last = addr->addr_data8[IP6_ADDR_LEN - 1];
+		break;
+	default:
+		return (1);
+	}
+
+	return (last % if_nshards == if_shard);
 }
 
 /*
@@ -570,6 +945,13 @@ interface_recv(int fd, short type, void *arg)
 	if (!interface_dopoll)
 		event_add(&inter->if_recvev, NULL);
 
+#ifdef HAVE_TPACKET_V3
+	if (inter->if_ringfd != -1) {
+		interface_ring_recv(inter);
+		return;
+	}
+#endif
+
 	/* dispatch the just received packet */
 	/* the parameter inter->if_pcap was set in the main method with the result of pcap_open_live */
 	if (pcap_dispatch(inter->if_pcap, -1, if_recv_cb, (u_char *)inter) < 0)
@@ -588,6 +970,35 @@ interface_poll_recv(int fd, short type, void *arg)
 	interface_recv(fd, type, arg);
 }
 
+static void
+interface_stats(int fd, short type, void *arg)
+{
+	struct interface *inter = arg;
+	struct timeval tv = INTERFACE_STATS_INTERVAL;
+	struct pcap_stat ps;
+	uint32_t drops = 0;
+
+	evtimer_add(&inter->if_statev, &tv);
+
+#ifdef HAVE_TPACKET_V3
+	if (inter->if_ringfd != -1)
+		drops = interface_ring_drops(inter);
+	else
+#endif
+	if (pcap_stats(inter->if_pcap, &ps) != -1) {
+		/* pcap reports the total since the handle was opened */
+		drops = ps.ps_drop - inter->if_pcapdrops;
+		inter->if_pcapdrops = ps.ps_drop;
+	}
+
+	if (drops == 0)
+		return;
+
+	inter->if_drops += drops;
+	if (if_drops_cb != NULL)
+		(*if_drops_cb)(inter, drops);
+}
+
 /* Unittests */
 static void
 interface_test_insert_and_find(void)
@@ -33,6 +33,14 @@
 #ifndef _INTERFACE_
 #define _INTERFACE_
 
+/* Geometry of the optional TPACKET_V3 receive ring */
+#define INTERFACE_RING_BLOCKSIZE	(1 << 18)
+#define INTERFACE_RING_BLOCKS		64
+#define INTERFACE_RING_FRAMESIZE	2048
+#define INTERFACE_RING_TIMEOUT		10	/* ms to retire a partial block */
+
+#define INTERFACE_STATS_INTERVAL	{1, 0}
+
 struct interface
 {
 	TAILQ_ENTRY(interface) next;
@@ -44,10 +52,24 @@ struct interface
 
 	/* is the fd for the interface */
 	eth_t *if_eth;
+	int if_txfd;			/* packet socket for batched sends */
 	int if_dloff;
 
 	char if_filter[1024];
+	int if_promisc;
+
+	/* Memory mapped receive ring, if_ringfd is -1 when using pcap */
+	int if_ringfd;
+	u_char *if_ring;
+	size_t if_ringsize;
+	u_int if_ringblock;		/* next block to hand to us */
 
+	/* Kernel drop counters, collected periodically */
+	struct event if_statev;
+	uint32_t if_pcapdrops;		/* last ps_drop seen from pcap */
+	uint64_t if_drops;
+
+	/* Has to stay last, aliases are allocated behind it */
 	struct intf_entry if_ent;
 };
 
@@ -55,6 +77,7 @@ struct interface
 void interface_prevent_init(void);
 
 void interface_initialize(pcap_handler);
+void interface_drops_callback(void (*)(struct interface *, uint32_t));
 void interface_init(char *, int, char **);
 struct interface *interface_get(int);
 struct interface *interface_find(char *);
@@ -63,6 +86,9 @@ struct interface *interface_find_responsible(struct addr *);
 
 int interface_count(void);
 
+void interface_shard(int, int);
+int interface_shard_owns(const struct addr *);
+
 void interface_close(struct interface *);
 void interface_close_all(void);
 
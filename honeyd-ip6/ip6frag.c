@@ -40,22 +40,40 @@
 
 #include <sys/queue.h>
 #include <sys/tree.h>
+#include <err.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 //#include <dumbnet.h>
 #include <dnet.h>
 #include <event.h>
 #include <syslog.h>
 #include "honeyd.h"
 #include "template.h"
+#include "personality.h"
+#include "reasm.h"
 #include "ip6frag.h"
-#include <string.h>
-
-/* note that dstopts may be part of the fragmentable part too */
-uint8_t unfragmentable_header[] = { IPPROTO_HOPOPTS, IPPROTO_ROUTING };
+#include "pool.h"
 
 SPLAY_HEAD(frag6tree, fragment6)
 fragments6;
 
+SPLAY_HEAD(frag6srctree, frag6src)
+fragsources6;
+
+/* least recently used datagrams are at the end */
+TAILQ_HEAD(frag6lru, fragment6)
+fraglru6;
+
+/* for the complete packet */
+static u_char buf6[IP6_HDR_LEN + IP6_LEN_MAX];
+
+static struct pool *pool_frag6;
+static struct pool *pool_frag6src;
+
+int nfragments6;
+int nfragmem6;
+
 #define DIFF(a,b) do { \
 	if ((a) < (b)) return -1; \
 	if ((a) > (b)) return 1; \
@@ -84,9 +102,25 @@ int frag6compare(struct fragment6 *a, struct fragment6 *b)
 SPLAY_PROTOTYPE(frag6tree, fragment6, node, frag6compare);
 SPLAY_GENERATE(frag6tree, fragment6, node, frag6compare);
 
+static int frag6srccompare(struct frag6src *a, struct frag6src *b)
+{
+    return (memcmp(a->prefix, b->prefix, sizeof(a->prefix)));
+}
+
+SPLAY_PROTOTYPE(frag6srctree, frag6src, node, frag6srccompare);
+SPLAY_GENERATE(frag6srctree, frag6src, node, frag6srccompare);
+
 void ip6_fragment_init(void)
 {
     SPLAY_INIT(&fragments6);
+    SPLAY_INIT(&fragsources6);
+    TAILQ_INIT(&fraglru6);
+
+    nfragments6 = 0;
+    nfragmem6 = 0;
+
+    pool_frag6 = pool_init("frag6", sizeof(struct fragment6));
+    pool_frag6src = pool_init("frag6src", sizeof(struct frag6src));
 }
 
 struct fragment6* ip6_fragment_find(struct addr *src_addr,
@@ -99,365 +133,204 @@ struct fragment6* ip6_fragment_find(struct addr *src_addr,
     tmp.ip6_id = id;
 
     result = SPLAY_FIND(frag6tree, &fragments6, &tmp);
-    return result;
-}
-
-int is_first_fragment_received(struct fragment6 *fragment)
-{
-    struct frag6ent *first = TAILQ_FIRST(&fragment->fraglist);
-    if (first->off == 0)
-    {
-        return 1;
-    }
-    else
+    if (result != NULL)
     {
-        return 0;
+        TAILQ_REMOVE(&fraglru6, result, next);
+        TAILQ_INSERT_HEAD(&fraglru6, result, next);
     }
+
+    return result;
 }
 
-int is_last_fragment_received(struct fragment6 *fragment)
+/*
+ * Sources are accounted by their /64, as a single host can pick any
+ * address within it.
+ */
+static struct frag6src *ip6_fragment_source(struct addr *src_addr)
 {
-    if (fragment->total_len != -1)
+    struct frag6src tmp, *source;
+
+    memcpy(tmp.prefix, &src_addr->addr_ip6, sizeof(tmp.prefix));
+    source = SPLAY_FIND(frag6srctree, &fragsources6, &tmp);
+    if (source == NULL)
     {
-        return 1;
-    }
-    else
-    {
-        return 0;
+        source = pool_alloc(pool_frag6src);
+        memset(source, 0, sizeof(struct frag6src));
+        memcpy(source->prefix, tmp.prefix, sizeof(source->prefix));
+        SPLAY_INSERT(frag6srctree, &fragsources6, source);
     }
+
+    return source;
 }
 
-int is_gap_beetween_fragments(struct fragment6 *fragment)
+/* Charges memory to the datagram, its source and the global budget */
+static void ip6_fragment_charge(struct fragment6 *frag, int mem)
 {
-    uint32_t total_len = 0;
-    struct frag6ent *tmp = TAILQ_FIRST(&fragment->fraglist);
-    TAILQ_FOREACH(tmp,&fragment->fraglist,next)
-    {
-        total_len += tmp->len;
-        /* if there is a gap between the offset and the last packet then we are not finished */
-        if (tmp->off > total_len)
-        {
-            return 1;
-        }
-
-    }
-    return 0;
+    frag->mem += mem;
+    frag->source->nfragmem += mem;
+    nfragmem6 += mem;
 }
 
-int is_fragment_complete(struct fragment6 *fragment)
+void free_fragments(struct fragment6 *frag)
 {
-    /* we havent received the last fragment yet */
-    if (!is_last_fragment_received(fragment))
-    {
-        return 0;
-    }
+    struct frag6src *source = frag->source;
 
-    if (!is_first_fragment_received(fragment))
-    {
-        syslog(LOG_DEBUG, "first fragment not yet received");
-        return 0;
-    }
+    evtimer_del(&frag->timeout);
+    reasm_free(&frag->reasm);
 
-    if (is_gap_beetween_fragments(fragment))
+    ip6_fragment_charge(frag, -(int)frag->mem);
+    if (--source->nfragments == 0)
     {
-        return 0;
+        SPLAY_REMOVE(frag6srctree, &fragsources6, source);
+        pool_free(pool_frag6src, source);
     }
 
-    return 1;
+    SPLAY_REMOVE(frag6tree, &fragments6, frag);
+    TAILQ_REMOVE(&fraglru6, frag, next);
+    nfragments6--;
+    pool_free(pool_frag6, frag);
 }
 
-int is_no_fragments_received(struct fragment6 *fragment)
+void ip6_fragment_reclaim(int count)
 {
-    if (TAILQ_FIRST(&fragment->fraglist) == NULL)
-    {
-        return 1;
-    }
-    else
-    {
-        return 0;
-    }
-}
+    struct fragment6 *tmp;
 
-void insert_fragment_entry_into_existing_queue(struct frag6ent *entry,struct fragment6 *fragment)
-{
-    struct frag6ent *tmp, *before;
-    /* walk through the queue and check where we can insert the fragment */
-    tmp = TAILQ_FIRST(&fragment->fraglist);
-    before = tmp;
-    while (tmp != NULL && entry->off > tmp->off)
+    for (tmp = TAILQ_LAST(&fraglru6, frag6lru); tmp && count;
+            tmp = TAILQ_LAST(&fraglru6, frag6lru))
     {
-        before = tmp;
-        tmp = TAILQ_NEXT(tmp,next);
+        free_fragments(tmp);
+        count--;
     }
-
-    if (tmp != NULL )
-        TAILQ_INSERT_BEFORE(tmp, entry, next);
-    else
-        TAILQ_INSERT_AFTER(&fragment->fraglist, before, entry, next);
 }
 
 /**
- * Inserts a new fragment into the fragment list of a fragmented packet.
+ * Inserts a new fragment into the payload of a fragmented packet.
  * It returns 0 if the fragment could be added successfully but some
  * fragments are still missing, it returns 1 if all fragments are available
- * and no error occured. 
+ * and no error occured, and -1 if the datagram has to be dropped.
  */
 int ip6_insert_fragment(struct fragment6 *fragment, uint16_t off,
-                        uint16_t frag_len, u_char *data)
+                        uint16_t frag_len, u_char *data, int more)
 {
-    struct frag6ent *entry;
-
-    entry = (struct frag6ent*) calloc(1, sizeof(struct frag6ent));
-    if (entry == NULL )
-    {
-        syslog(LOG_DEBUG,
-               "was not able to allocate memory for a fragment entry");
-    }
-
-    entry->data = malloc(frag_len);
-    if (entry->data == NULL )
-    {
-        syslog(LOG_DEBUG, "could not allocate memory for ipv6 fragment entry");
-        return 0;
-    }
+    struct reasm *r = &fragment->reasm;
+    u_int mem;
+    int res;
 
-    memcpy(entry->data, data, frag_len);
-    entry->off = off;
-    entry->len = frag_len;
-
-    if (is_no_fragments_received(fragment))
+    if (fragment->source->nfragmem + reasm_need(r, off, frag_len, more) >
+            IP6FRAG_SRC_MEM)
     {
-        TAILQ_INSERT_HEAD(&fragment->fraglist, entry, next);
-        return 0;
+        syslog(LOG_DEBUG, "IPv6 fragments from %s exceed their quota",
+               addr_ntoa(&fragment->src_addr));
+        return -1;
     }
 
-    insert_fragment_entry_into_existing_queue(entry,fragment);
+    mem = reasm_mem(r);
+    res = reasm_insert(r, off, data, frag_len, more);
+    ip6_fragment_charge(fragment, reasm_mem(r) - mem);
 
-    /* check if we received all fragments */
-    if (is_fragment_complete(fragment))
-    {
-        return 1;
-    }
-
-    return 0;
+    return res;
 }
 
-ip6_fragment_timeout(int fd, short which, void *arg)
+void ip6_fragment_timeout(int fd, short which, void *arg)
 {
   struct fragment6 *tmp = arg;
-  struct addr src;
  
   syslog(LOG_DEBUG, "Expiring IPv6 fragment from %s, id %d",
-      addr_ntoa(&tmp->src_addr), ntohs(tmp->ip6_id));
+      addr_ntoa(&tmp->src_addr), ntohl(tmp->ip6_id));
   
   free_fragments(tmp);
 } 
 
 struct fragment6* ip6_fragment_new(struct addr *src_addr, struct addr *dst_addr,
-                                   uint32_t id)
+                                   uint32_t id, enum fragpolicy fragp)
 {
     struct fragment6 *result = NULL;
+    struct frag6src *source;
     struct timeval tv = { IP6FRAG_TIMEOUT, 0};
 
-    result = calloc(1, sizeof(struct fragment6));
-    if (result == NULL )
+    if (nfragmem6 > IP6FRAG_MAX_MEM || nfragments6 > IP6FRAG_MAX_FRAGS)
+        ip6_fragment_reclaim(nfragments6/10 + 1);
+
+    source = ip6_fragment_source(src_addr);
+    if (source->nfragments >= IP6FRAG_SRC_FRAGS ||
+            source->nfragmem >= IP6FRAG_SRC_MEM)
     {
-        syslog(LOG_DEBUG, "was not able to alloc memory for ipv6 fragment");
+        syslog(LOG_DEBUG, "too many IPv6 fragments from %s",
+               addr_ntoa(src_addr));
         return NULL ;
     }
 
+    result = pool_alloc(pool_frag6);
+    memset(result, 0, sizeof(struct fragment6));
+
     memcpy(&result->src_addr, src_addr, sizeof(struct addr));
     memcpy(&result->dst_addr, dst_addr, sizeof(struct addr));
     result->ip6_id = id;
-    result->total_len = -1;
+    result->source = source;
+    source->nfragments++;
+    ip6_fragment_charge(result, sizeof(struct fragment6));
+
+    reasm_init(&result->reasm, fragp);
 
-    /* create a new fragment list */
-    TAILQ_INIT(&result->fraglist);
-  
     /* set fragment timeout */
     evtimer_set(&result->timeout, ip6_fragment_timeout, result);
     evtimer_add(&result->timeout, &tv);
 
-
     SPLAY_INSERT(frag6tree, &fragments6, result);
+    TAILQ_INSERT_HEAD(&fraglru6, result, next);
+    nfragments6++;
 
     return result;
 }
 
-int array_contains(void *array, void *element, int element_size, int length)
-{
-    int i;
-    for (i = 0; i < length; i++)
-    {
-        if (!memcmp(array + i, element, element_size))
-            return 1;
-    }
-
-    return 0;
-}
-
-int is_ext_header_fragmentable(uint8_t nxt_ext_hdr)
-{
-    if (array_contains(unfragmentable_header, &nxt_ext_hdr,
-                       sizeof(uint8_t),
-                       sizeof(unfragmentable_header) / sizeof(uint8_t)))
-    {
-        return 0;
-    }
-    else
-    {
-        return 1;
-    }
-}
-
-int is_destination_options_followed_by_routing_hdr(uint8_t ext_hdr_id,struct ip6_ext_hdr * ext_hdr)
-{
-    if (ext_hdr_id == IPPROTO_DSTOPTS && ((struct ip6_ext_hdr *) ext_hdr)->ext_nxt == IPPROTO_ROUTING)
-    {
-        return 1;
-    }
-    else
-    {
-        return 0;
-    }
-}
-
-int is_complete_payload_fragmentable(struct ip6_hdr *ip6)
-{
-    if (is_ext_header_fragmentable(ip6->ip6_nxt))
-    {
-        /* nxt header may be destination options which may also be part of the umfragmentable header, if the next
-         * header is a routing header
-         */
-        u_char *pkt_ptr = (u_char *) (ip6 + 1);
-
-        if (!is_destination_options_followed_by_routing_hdr(ip6->ip6_nxt,(struct ip6_ext_hdr *) pkt_ptr))
-        {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-
-
-/**
- * Sets last_ext_hdr to the last header of the unfragmentable ip6 packet part. If the passed
- * ip6 packet does not comtain any extension headers then the last_ext_hdr pointer is set to NULL.
- * Returns the length of the unfragmentable part (length of the fragment header not included)
- */
-int get_last_unfragmentable_ext_hdr(struct ip6_hdr *ip6,
-                                    struct ip6_ext_hdr *last_ext_hdr)
-{
-
-    u_char *pkt_ptr = (u_char *) (ip6 + 1);
-    uint8_t nxt_ext_hdr;
-    int len = IP6_HDR_LEN;
-
-    last_ext_hdr = NULL;
-
-    if(is_complete_payload_fragmentable(ip6))
-    {
-        return IP6_HDR_LEN;
-    }
-
-    /* add the ext header lenght as long as we dont face a fragmentable header */
-    while (pkt_ptr < ((u_char*) ip6) + ip6->ip6_plen)
-    {
-        last_ext_hdr = (struct ip6_ext_hdr *) pkt_ptr;
-        /* TODO: replace magic number 8 */
-        nxt_ext_hdr = ((struct ip6_ext_hdr *) pkt_ptr)->ext_nxt;
-        /* ext len given in 8 octets */
-        pkt_ptr = pkt_ptr + (1 + ((struct ip6_ext_hdr *) pkt_ptr)->ext_len) * 8;
-        len += (1 + ((struct ip6_ext_hdr *) pkt_ptr)->ext_len) * 8;
-        if (is_ext_header_fragmentable(nxt_ext_hdr))
-        {
-
-            if (!is_destination_options_followed_by_routing_hdr(nxt_ext_hdr,(struct ip6_ext_hdr *) pkt_ptr))
-            {
-                return len;
-            }
-        }
-    }
-    return -1;
-}
-
-/**
- * Returns the size of all unfragmentable ip headers up to the fragment header.
- * You can use this function to calculate the acutal data length.
- * Its the total ip len - this size - length of fragment header.
+/*
+ * Puts the unfragmentable part of the packet in front of the payload.
+ * The result lives in a static buffer until the next packet is
+ * reassembled.
  */
-int get_size_of_unfragmentable_part(struct ip6_hdr *ip6)
-{
-    return get_last_unfragmentable_ext_hdr(ip6, NULL );
-}
-
-struct ip6_hdr * assemble_fragments(struct ip6_hdr *ip6, struct fragment6 *frag)
+struct ip6_hdr * assemble_fragments(const struct ip6_desc *desc,
+                                    struct fragment6 *frag)
 {
     int size_of_unfragmentable_part;
-    struct ip6_hdr *ip6_assembled;
-    struct frag6ent * tmp;
-
-    /* alloc space for the assembled packet */
-    size_of_unfragmentable_part = get_size_of_unfragmentable_part(ip6);
-    ip6_assembled = (struct ip6_hdr*) malloc(
-                        size_of_unfragmentable_part + frag->total_len);
-    if (ip6 == NULL )
-    {
-        syslog(LOG_DEBUG,
-               "could not realloc memory for assembling ipv6 packet");
-        return NULL ;
-    }
+    struct ip6_hdr *ip6 = desc->ip6, *ip6_assembled;
+
+    size_of_unfragmentable_part = desc->unfrag_len;
+    ip6_assembled = (struct ip6_hdr *) buf6;
 
     /* copy the unfragmentable part */
     memcpy(ip6_assembled, ip6, size_of_unfragmentable_part);
-
-    TAILQ_FOREACH(tmp,&frag->fraglist,next)
-    {
-        memcpy(
-            ((u_char *) ip6_assembled) + size_of_unfragmentable_part
-            + tmp->off, tmp->data, tmp->len);
-    }
+    memcpy(buf6 + size_of_unfragmentable_part, frag->reasm.data,
+           frag->reasm.end);
 
     ip6_assembled->ip6_plen = htons(
-                                  size_of_unfragmentable_part + frag->total_len - IP6_HDR_LEN);
-    /* TODO: set the nxt header of the last header in the unfragmentable part */
-    ip6_assembled->ip6_nxt = frag->nxt_hdr;
+                                  size_of_unfragmentable_part + frag->reasm.end - IP6_HDR_LEN);
+    /* the last unfragmentable header used to point at the fragment header */
+    if (desc->unfrag_last == -1)
+        ip6_assembled->ip6_nxt = frag->nxt_hdr;
+    else
+        ((struct ip6_ext_hdr *) ((u_char *) ip6_assembled +
+            desc->ext_off[desc->unfrag_last]))->ext_nxt = frag->nxt_hdr;
 
     return ip6_assembled;
 }
 
-void free_fragments(struct fragment6 *frag)
-{
-    struct frag6ent *frag_ent, *nxt;
-    evtimer_del(&frag->timeout);
-
-    for (frag_ent = TAILQ_FIRST(&frag->fraglist);
-            frag_ent != TAILQ_END(&frag->fraglist); frag_ent = nxt)
-    {
-        nxt = TAILQ_NEXT(frag_ent, next);
-        free(frag_ent);
-    }
-
-    SPLAY_REMOVE(frag6tree, &fragments6, frag);
-    free(frag);
-}
-
 /**
  * returns 1 if all fragments have been received, sets pip6 to the
  * assembled packets.
  */
 int ip6_fragment(struct template *tmpl, struct ip6_hdr **pip6,
-                 struct ip6_ext_hdr *frag_hdr)
+                 const struct ip6_desc *desc)
 {
+    struct ip6_ext_hdr *frag_hdr = IP6_DESC_FRAG(desc);
     struct addr src, dst;
     struct fragment6 *existing_fragment;
+    struct personality *person;
+    enum fragpolicy fragp = FRAG_OLD;
     struct ip6_ext_data_fragment *frag_hdr_data;
     u_char *data = NULL;
     uint16_t off;
-    uint16_t plen;
     uint16_t data_len;
-    int packet_complete;
+    int packet_complete, more;
     struct ip6_hdr *ip6 = *pip6;
 
     frag_hdr_data = (struct ip6_ext_data_fragment *) &frag_hdr->ext_data;
@@ -465,44 +338,74 @@ int ip6_fragment(struct template *tmpl, struct ip6_hdr **pip6,
     addr_pack(&src, ADDR_TYPE_IP6, IP6_ADDR_BITS, &ip6->ip6_src, IP6_ADDR_LEN);
     addr_pack(&dst, ADDR_TYPE_IP6, IP6_ADDR_BITS, &ip6->ip6_dst, IP6_ADDR_LEN);
 
-    existing_fragment = ip6_fragment_find(&src, &dst, frag_hdr_data->ident);
-    if (existing_fragment == NULL )
+    /* overlaps are resolved the way the personality does it */
+    if (tmpl != NULL)
     {
-        existing_fragment = ip6_fragment_new(&src, &dst, frag_hdr_data->ident);
+        person = tmpl->person6 != NULL ? tmpl->person6 : tmpl->person;
+        if (person != NULL)
+            fragp = person->fragp;
+    }
+    if (fragp == FRAG_DROP)
+    {
+        syslog(LOG_DEBUG, "Dropping ipv6 fragment from %s", addr_ntoa(&src));
+        return 0;
     }
-
-    /* set the fragments next header */
-    existing_fragment->nxt_hdr = frag_hdr->ext_nxt;
 
     /* we dont need to multiply that by 8 because the flag field is 3 bit long */
     off = ntohs(frag_hdr_data->offlg & IP6_OFF_MASK);
-    plen = ntohs(ip6->ip6_plen);
-
-    /* TODO: check if the fragment has a valid length */
+    more = (frag_hdr_data->offlg & IP6_MORE_FRAG) != 0;
 
-    /* data follows the fragmentatfragmentation header header */
+    /* data follows the fragmentation header */
     data = (u_char *) (frag_hdr_data + 1);
-    /* TODO: data len is total len - all ext header lengths (unfragmentable part + fragment header)  */
-    data_len = plen + IP6_HDR_LEN - ((get_size_of_unfragmentable_part(ip6) + sizeof(struct ip6_ext_hdr)));
+    data_len = desc->len - desc->frag_off - SIZE_OF_IPV6_FRAGMENT_HEADER;
 
-    /* set the total len */
-    if (!(frag_hdr_data->offlg & IP6_MORE_FRAG))
+    /* All but the last fragment carry a multiple of eight bytes */
+    if ((more && (data_len == 0 || (data_len & 0x7))) ||
+            desc->unfrag_len - IP6_HDR_LEN + off + data_len > IP6_LEN_MAX)
     {
-        existing_fragment->total_len = off + data_len;
+        syslog(LOG_DEBUG, "Dropping bad ipv6 fragment from %s: %d@%d",
+               addr_ntoa(&src), data_len, off);
+        return 0;
+    }
+
+    existing_fragment = ip6_fragment_find(&src, &dst, frag_hdr_data->ident);
+    if (existing_fragment == NULL )
+    {
+        existing_fragment = ip6_fragment_new(&src, &dst, frag_hdr_data->ident,
+                                             fragp);
+        if (existing_fragment == NULL)
+            return 0;
     }
 
+    /* the first fragment tells us what follows the fragment header */
+    if (off == 0 || existing_fragment->reasm.nblocks == 0)
+        existing_fragment->nxt_hdr = frag_hdr->ext_nxt;
+
     syslog(LOG_DEBUG, "Received ipv6 fragment from %s: %d@%d", addr_ntoa(&src), data_len, off);
 
     /* insert the fragment and check if we are finished */
     packet_complete = ip6_insert_fragment(existing_fragment, off, data_len,
-                                          data);
+                                          data, more);
+    if (packet_complete == -1)
+        goto freeall;
     if (packet_complete)
     {
+        /* the headers in front of the payload have to fit, too */
+        if (desc->unfrag_len - IP6_HDR_LEN + existing_fragment->reasm.end >
+                IP6_LEN_MAX)
+            goto freeall;
+
         //build packet
-        *pip6 = assemble_fragments(ip6, existing_fragment);
+        *pip6 = assemble_fragments(desc, existing_fragment);
         free_fragments(existing_fragment);
         return 1;
     }
 
     return 0;
+
+freeall:
+    syslog(LOG_DEBUG, "Freeing ipv6 fragments from %s, id %d",
+           addr_ntoa(&src), ntohl(existing_fragment->ip6_id));
+    free_fragments(existing_fragment);
+    return 0;
 }
@@ -36,29 +36,35 @@
 
 #define IP6FRAG_TIMEOUT    30
 
-struct frag6ent {
-	TAILQ_ENTRY(frag6ent) next;
-	uint16_t len;
-	uint16_t off;
-	u_char *data;
+#define IP6FRAG_MAX_MEM		(25*1024*1024)
+#define IP6FRAG_MAX_FRAGS	(10000)
+
+/* Quota for all sources within one /64 */
+#define IP6FRAG_SRC_MEM		(1024*1024)
+#define IP6FRAG_SRC_FRAGS	(256)
+
+struct frag6src {
+	SPLAY_ENTRY(frag6src) node;
+	uint8_t prefix[8];
+	u_int nfragments;
+	u_int nfragmem;
 };
 
 struct fragment6 {
 	SPLAY_ENTRY(fragment6) node;
 	TAILQ_ENTRY(fragment6) next;
-	TAILQ_HEAD(frag6q, frag6ent) fraglist;
+	struct reasm reasm;
+	struct frag6src *source;
 	struct addr src_addr;
 	struct addr dst_addr;
 	uint32_t ip6_id;
-	uint32_t total_len;
 	uint8_t nxt_hdr;
+	u_int mem;		/* charged against the budget */
 	struct event timeout;
 };
 
 void ip6_fragment_init(void);
-int get_size_of_unfragmentable_part(struct ip6_hdr*);
-int get_last_unfragmentable_ext_hdr(struct ip6_hdr*,struct ip6_ext_hdr *);
-int ip6_fragment(struct template *, struct ip6_hdr **,struct ip6_ext_hdr *);
+int ip6_fragment(struct template *, struct ip6_hdr **, const struct ip6_desc *);
 
 
 #endif
@@ -61,10 +61,10 @@
 #include "honeyd.h"
 #include "template.h"
 #include "personality.h"
+#include "reasm.h"
 #include "ipfrag.h"
-#include "pool.h"
-
-extern struct pool *pool_pkt;
+#include "pktbuf.h"
+#include "cksum.h"
 
 static u_char buf[IP_LEN_MAX];  /* for complete packet */
 
@@ -126,32 +126,17 @@ ip_fragment_find(ip_addr_t src, ip_addr_t dst, u_short id, u_char proto)
 }
 
 /* Free a fragment by removing it from all lists, etc... */
-void
-ip_fragent_free(struct fragent *ent)
-{
-	nfragmem -= ent->size;
-
-	free(ent->data);
-	free(ent);
-}
-
 void
 ip_fragment_free(struct fragment *tmp)
 {
-	struct fragent *ent;
-
 	evtimer_del(&tmp->timeout);
 
 	SPLAY_REMOVE(fragtree, &fragments, tmp);
 	TAILQ_REMOVE(&fraglru, tmp, next);
 	nfragments--;
 
-	for (ent = TAILQ_FIRST(&tmp->fraglist); ent;
-	    ent = TAILQ_FIRST(&tmp->fraglist)) {
-		TAILQ_REMOVE(&tmp->fraglist, ent, next);
-
-		ip_fragent_free(ent);
-	}
+	nfragmem -= reasm_mem(&tmp->reasm);
+	reasm_free(&tmp->reasm);
 	free(tmp);
 }
 
@@ -206,9 +191,8 @@ ip_fragment_new(ip_addr_t src, ip_addr_t dst, u_short id, u_char proto,
 	tmp->ip_dst = dst;
 	tmp->ip_id = id;
 	tmp->ip_proto = proto;
-	tmp->fragp = pl;
+	reasm_init(&tmp->reasm, pl);
 
-	TAILQ_INIT(&tmp->fraglist);
 	evtimer_set(&tmp->timeout, ip_fragment_timeout, tmp);
 	evtimer_add(&tmp->timeout, &tv);
 
@@ -219,119 +203,6 @@ ip_fragment_new(ip_addr_t src, ip_addr_t dst, u_short id, u_char proto,
 	return (tmp);
 }
 
-int
-ip_fragment_insert(struct fragment *fragq, struct fragent *ent, short mf)
-{
-	struct fragent *prev, *after;
-	struct ip_hdr *ip;
-	u_char *data;
-	u_short overlap;
-	u_short max;
-	u_short off;
-	u_short len;
-
-	off = ent->off;
-	len = ent->len;
-	max = off + len;
-
-	if (fragq->maxlen < max)
-		fragq->maxlen = max;
-	if (!mf)
-		fragq->hadlastpacket = 1;
-
-	prev = NULL;
-	for (after = TAILQ_FIRST(&fragq->fraglist); after;
-	    after = TAILQ_NEXT(after, next)) {
-		if (off < after->off)
-			break;
-		prev = after;
-	}
-
-	if (prev && prev->off + prev->len > off) {
-		overlap = prev->off + prev->len - off;
-
-		if (overlap >= len) {
-			if (fragq->fragp == FRAG_NEW) {
-				u_char *odata = prev->data + off - prev->off;
-				memcpy(odata, ent->data, len);
-			}
-			goto free_fragment;
-		}
-
-		if (fragq->fragp == FRAG_OLD) {
-			u_char *odata = prev->data + prev->len - overlap;
-			memcpy(ent->data, odata, overlap);
-		}
-		prev->len -= overlap;
-	}
-
-	if (after && off + len > after->off) {
-		overlap = off + len - after->off;
-
-		if (overlap >= after->len) {
-			if (fragq->fragp == FRAG_OLD) {
-				u_char *ndata = ent->data + after->off - off;
-				memcpy(ndata, after->data, after->len);
-			}
-			
-			/* Drop the old fragment */
-			TAILQ_REMOVE(&fragq->fraglist, after, next);
-			ip_fragent_free(after);
-		} else {
-			/* Trim the overlap */
-			if (fragq->fragp == FRAG_NEW) {
-				u_char *ndata = ent->data + len - overlap;
-				memcpy(after->data, ndata, overlap);
-			}
-			len -= overlap;
-			ent->len = len;
-		}
-	}
-
-	if (prev)
-		TAILQ_INSERT_AFTER(&fragq->fraglist, prev, ent, next);
-	else
-		TAILQ_INSERT_HEAD(&fragq->fraglist, ent, next);
-
-	/* Waiting for more data */
-	if (!fragq->hadlastpacket)
-		return (0);
-
-	off = 0;
-	TAILQ_FOREACH(ent, &fragq->fraglist, next) {
-		if (ent->off != off)
-			break;
-		off = ent->off + ent->len;
-	}
-
-	if (ent)
-		return (0);
-
-	/* Completely assembled */
-
-	data = buf;
-	ip = (struct ip_hdr *)data;
-	for(ent = TAILQ_FIRST(&fragq->fraglist); ent;
-	    ent = TAILQ_FIRST(&fragq->fraglist)) {
-		TAILQ_REMOVE(&fragq->fraglist, ent, next);
-
-		memcpy(data, ent->data, ent->len);
-		data += ent->len;
-		ip_fragent_free(ent);
-	}
-
-	ip->ip_len = htons(fragq->maxlen);
-	ip->ip_off = 0;
-
-	ip_fragment_free(fragq);
-
-	return (1);
-
- free_fragment:
-	ip_fragent_free(ent);
-	return (0);
-}
-
 /*
  * Reassembles fragmented IP packets.
  *
@@ -347,11 +218,11 @@ ip_fragment(struct template *tmpl, struct ip_hdr *ip, u_short len,
 	struct addr src;
 	struct personality *person = NULL;
 	struct fragment *fragq;
-	struct fragent *ent;
 	u_char *dat;
 	short mf;
 	u_short off;
 	u_short hlen;
+	int res;
 	enum fragpolicy fragp = FRAG_OLD;
 	
 	addr_pack(&src, ADDR_TYPE_IP, IP_ADDR_BITS, &ip->ip_src, IP_ADDR_LEN);
@@ -372,18 +243,17 @@ ip_fragment(struct template *tmpl, struct ip_hdr *ip, u_short len,
 	off &= IP_OFFMASK;
 	off <<= 3;
 
-	dat = (u_char *)ip;
+	/* Offsets count from the end of the IP header */
 	hlen = ip->ip_hl << 2;
-	if (mf && ((len - hlen) & 0x7))
+	if (hlen < IP_HDR_LEN || hlen > len)
 		goto freeall;
+	dat = (u_char *)ip + hlen;
+	len -= hlen;
 
-	if (off) {
-		len -= hlen;
-		dat += hlen;
-		off += hlen;
-	}
+	if (mf && (len & 0x7))
+		goto freeall;
 
-	if (off + len > IP_LEN_MAX || len == 0)
+	if (hlen + off + len > IP_LEN_MAX || len == 0)
 		goto freeall;
 
 	if (fragq == NULL) {
@@ -393,33 +263,42 @@ ip_fragment(struct template *tmpl, struct ip_hdr *ip, u_short len,
 			goto drop;
 	}
 
-	if ((ent = calloc(1, sizeof(struct fragent))) == NULL)
-		goto freeall;
+	syslog(LOG_DEBUG,  "Received fragment from %s, id %d: %d@%d",
+	    addr_ntoa(&src), ntohs(ip->ip_id), len, off);
 
-	ent->off = off;
-	ent->len = len;
-	ent->size = len;
-	if ((ent->data = malloc(len)) == NULL) {
-		free(ent);
+	nfragmem -= reasm_mem(&fragq->reasm);
+	res = reasm_insert(&fragq->reasm, off, dat, len, mf);
+	nfragmem += reasm_mem(&fragq->reasm);
+	if (res == -1)
 		goto freeall;
+
+	/* The header of the first fragment is the header of the packet */
+	if (off == 0 && (fragq->hlen == 0 || fragp == FRAG_NEW)) {
+		fragq->hlen = hlen;
+		memcpy(fragq->hdr, ip, hlen);
 	}
-	memcpy(ent->data, dat, len);
-	nfragmem += len;
 
-	syslog(LOG_DEBUG,  "Received fragment from %s, id %d: %d@%d",
-	    addr_ntoa(&src), ntohs(ip->ip_id), len, off);
+	if (res == 0)
+		return (-1);
+
+	/* Completely assembled */
+	len = fragq->hlen + fragq->reasm.end;
+	if (len > IP_LEN_MAX)
+		goto freeall;
 
-	if (ip_fragment_insert(fragq, ent, mf)) {
-		ip = (struct ip_hdr *)buf;
-		len = ntohs(ip->ip_len);
+	memcpy(buf, fragq->hdr, fragq->hlen);
+	memcpy(buf + fragq->hlen, fragq->reasm.data, fragq->reasm.end);
+	ip_fragment_free(fragq);
 
-		*pip = ip;
-		*piplen = len;
+	ip = (struct ip_hdr *)buf;
+	ip->ip_len = htons(len);
+	ip->ip_off = 0;
 
-		/* Successfully reassembled */
-		return (0);
-	}
-	return (-1);
+	*pip = ip;
+	*piplen = len;
+
+	/* Successfully reassembled */
+	return (0);
 
  freeall:
 	syslog(LOG_DEBUG,  "%s fragment from %s, id %d: %d@%d",
@@ -444,7 +323,7 @@ ip_send_fragments(u_int mtu, struct ip_hdr *ip, u_int iplen, struct spoof spoof)
 	u_char *p;
 
 	/* Need to calculate the checksum for the protocol */
-	ip_checksum(ip, iplen);
+	cksum_ip(ip, iplen);
 
 	iphlen = ip->ip_hl << 2;
 	datlen = iplen - iphlen;
@@ -453,7 +332,7 @@ ip_send_fragments(u_int mtu, struct ip_hdr *ip, u_int iplen, struct spoof spoof)
 	offset = 0;
 	p = (u_char *)ip + iphlen;
 	while (datlen) {
-		nip = pool_alloc(pool_pkt);
+		nip = pktbuf_alloc(HONEYD_MTU);
 
 		size = datlen > pdatlen ? pdatlen : datlen;
 
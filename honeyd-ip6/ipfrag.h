@@ -32,30 +32,20 @@
 #ifndef _IPFRAG_H_
 #define _IPFRAG_H_
 
-struct fragent {
-	TAILQ_ENTRY(fragent) next;
-	u_short off;
-	u_short len;
-	u_short size;
-	u_char *data;
-};
-
 struct fragment {
 	SPLAY_ENTRY(fragment) node;
 	TAILQ_ENTRY(fragment) next;
 
-	TAILQ_HEAD(fragq, fragent) fraglist;
+	struct reasm reasm;	/* payload behind the IP header */
 	struct event timeout;
 
-	enum fragpolicy fragp;
-
 	ip_addr_t ip_src;	/* Network order */
 	ip_addr_t ip_dst;	/* Network order */
 	u_short ip_id;		/* Network order */
 	u_char ip_proto;
 
-	u_short maxlen;		
-	u_short hadlastpacket;
+	u_short hlen;		/* header of the first fragment */
+	u_char hdr[IP_HDR_LEN_MAX];
 };
 
 #define IPFRAG_TIMEOUT		30
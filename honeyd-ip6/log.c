@@ -255,13 +255,11 @@ static char *
 honeyd_log_comment(int proto, const struct tuple *hdr, const char *remark)
 {
 	static char comment[256];
-	struct ip_hdr ip;
 	char *name;
 
 	comment[0] = '\0';
 
-	ip.ip_src = hdr->ip_src;
-	name = honeyd_osfp_name(&ip);
+	name = honeyd_osfp_name(hdr);
 	if (name != NULL )
 		snprintf(comment, sizeof(comment), " [%s]", name);
 	if (remark != NULL )
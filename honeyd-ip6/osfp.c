@@ -63,36 +63,36 @@
 #include "template.h"
 #include "osfp.h"
 #include "hooks.h"
+#include "siphash.h"
 
 struct pf_osfp_enlist;
 int pfctl_file_fingerprints(int, int, const char *);
 void pf_osfp_initialize(void);
 int pf_osfp_match(struct pf_osfp_enlist *, pf_osfp_t);
 struct pf_osfp_enlist *pf_osfp_fingerprint_hdr(const struct ip_hdr *,
-		const struct tcp_hdr *);
+		const struct ip6_hdr *, const struct tcp_hdr *);
 
 void honeyd_osfp_input(struct tuple *, u_char *, u_int, void *);
-static struct osfp *honeyd_osfp_cache(const struct ip_hdr *);
+static struct osfp *honeyd_osfp_cache(const struct addr *);
+static void honeyd_osfp_sweep(int, short, void *);
 
-SPLAY_HEAD(osfptree, osfp)
-osfp_buckets[OSFP_HASHSIZE];
-
-int osfp_compare(struct osfp *a, struct osfp *b)
-{
-	if (a->src < b->src)
-		return (-1);
-	else if (a->src > b->src)
-		return (1);
-	return (0);
-}
+/*
+ * The cache has a fixed number of entries so that a flood of spoofed
+ * sources can not grow it.  Lookups go through a hash keyed at start-up;
+ * the buckets are as many as the entries.
+ */
+static struct osfp osfp_cache[OSFP_CACHE_SIZE];
+static LIST_HEAD(osfphash, osfp) osfp_buckets[OSFP_CACHE_SIZE];
+static u_int osfp_count;
+static u_int osfp_hand;
 
-SPLAY_PROTOTYPE(osfptree, osfp, node, osfp_compare)
-;
-SPLAY_GENERATE(osfptree, osfp, node, osfp_compare)
-;
+static struct siphash_key osfp_key;
+static struct event osfp_sweep_ev;
 
 int honeyd_osfp_init(const char *filename)
 {
+	u_char seed[SIPHASH_KEY_LEN];
+	rand_t *rnd;
 	int i;
 
 	pf_osfp_initialize();
@@ -103,151 +103,266 @@ int honeyd_osfp_init(const char *filename)
 	hooks_add_packet_hook(IP_PROTO_TCP, HD_INCOMING, honeyd_osfp_input, NULL );
 
 	/* Initialize hash buckets */
-	for (i = 0; i < OSFP_HASHSIZE; i++)
-		SPLAY_INIT(&osfp_buckets[i]);
+	for (i = 0; i < OSFP_CACHE_SIZE; i++)
+		LIST_INIT(&osfp_buckets[i]);
+
+	/* Attackers choose the source addresses, so the hash is keyed */
+	if ((rnd = rand_open()) == NULL)
+		err(1, "%s: rand_open", __func__);
+	rand_get(rnd, seed, sizeof(seed));
+	rand_close(rnd);
+	siphash_key_init(&osfp_key, seed, sizeof(seed));
+
+	evtimer_set(&osfp_sweep_ev, honeyd_osfp_sweep, NULL);
 
 	return (0);
 }
 
-static struct osfptree *
-honeyd_osfp_hash(const struct ip_hdr *ip)
+static struct osfphash *
+honeyd_osfp_hash(const struct addr *src)
 {
-	struct osfptree *root;
-	int i;
-	u_char *bin;
-	u_char h = 0;
+	size_t len;
 
-	bin = (u_char *) &ip->ip_src;
-	for (i = 0; i < sizeof(ip->ip_src); i++)
-		h ^= *bin++;
+	len = src->addr_type == ADDR_TYPE_IP6 ? IP6_ADDR_LEN : IP_ADDR_LEN;
 
-	root = &osfp_buckets[h & (OSFP_HASHSIZE - 1)];
-	return (root);
+	return (&osfp_buckets[siphash(&osfp_key, src->addr_data8, len) &
+		(OSFP_CACHE_SIZE - 1)]);
 }
 
-void honeyd_osfp_timeout(int fd, short what, void *arg)
+/*
+ * Finds the source address and, if there is one, the TCP header of an
+ * IPv4 or IPv6 packet.  IPv6 fragments are not looked into.
+ */
+
+static int
+honeyd_osfp_parse(const u_char *pkt, u_int len, struct addr *src,
+		const struct tcp_hdr **ptcp)
 {
-	struct osfp *entry = arg;
-	struct osfptree *root;
-	struct ip_hdr ip;
-	struct addr src;
+	const struct ip_hdr *ip = (const struct ip_hdr *) pkt;
+	const struct ip6_hdr *ip6 = (const struct ip6_hdr *) pkt;
+	const struct ip6_ext_hdr *ext;
+	u_int off;
+	uint8_t nxt;
+
+	*ptcp = NULL;
+
+	if (len < IP_HDR_LEN)
+		return (-1);
+
+	if (ip->ip_v == 4)
+	{
+		addr_pack(src, ADDR_TYPE_IP, IP_ADDR_BITS, &ip->ip_src,
+				IP_ADDR_LEN);
+		nxt = ip->ip_p;
+		off = ip->ip_hl << 2;
+	}
+	else if (ip->ip_v == 6 && len >= IP6_HDR_LEN)
+	{
+		addr_pack(src, ADDR_TYPE_IP6, IP6_ADDR_BITS, &ip6->ip6_src,
+				IP6_ADDR_LEN);
+		nxt = ip6->ip6_nxt;
+		off = IP6_HDR_LEN;
+		while (nxt == IP_PROTO_HOPOPTS || nxt == IP_PROTO_ROUTING ||
+				nxt == IP_PROTO_DSTOPTS)
+		{
+			if (off + 2 > len)
+				return (0);
+			ext = (const struct ip6_ext_hdr *) (pkt + off);
+			nxt = ext->ext_nxt;
+			off += (ext->ext_len + 1) << 3;
+		}
+	}
+	else
+		return (-1);
+
+	if (nxt == IP_PROTO_TCP && off + TCP_HDR_LEN <= len)
+		*ptcp = (const struct tcp_hdr *) (pkt + off);
 
-	addr_pack(&src, ADDR_TYPE_IP, IP_ADDR_BITS, &entry->src, IP_ADDR_LEN);
-	syslog(LOG_DEBUG, "Expiring OS fingerprint for %s", addr_ntoa(&src));
+	return (0);
+}
 
-	ip.ip_src = entry->src;
-	root = honeyd_osfp_hash(&ip);
-	SPLAY_REMOVE(osfptree, root, entry);
+static struct pf_osfp_enlist *
+honeyd_osfp_fingerprint(const u_char *pkt, const struct tcp_hdr *tcp)
+{
+	const struct ip_hdr *ip = (const struct ip_hdr *) pkt;
 
-	free(entry);
+	if (ip->ip_v == 4)
+		return (pf_osfp_fingerprint_hdr(ip, NULL, tcp));
+	return (pf_osfp_fingerprint_hdr(NULL, (const struct ip6_hdr *) pkt,
+			tcp));
 }
 
-static void honeyd_osfp_cache_insert(const struct ip_hdr *ip,
-		struct pf_osfp_enlist *list)
+static void
+honeyd_osfp_remove(struct osfp *entry)
+{
+	LIST_REMOVE(entry, next);
+	entry->list = NULL;
+	osfp_count--;
+}
+
+/*
+ * Drops all entries that have not been used for OSFP_TIMEOUT seconds.
+ */
+
+static void
+honeyd_osfp_expire(time_t now)
 {
-	struct timeval tv;
-	struct osfptree *root;
 	struct osfp *entry;
+	int i, expired = 0;
 
-	/* Create a new entry unless we have it cached already */
-	if ((entry = honeyd_osfp_cache(ip)) == NULL )
+	for (i = 0; i < OSFP_CACHE_SIZE && osfp_count; i++)
 	{
-		if ((entry = calloc(1, sizeof(struct osfp))) == NULL )
-		{
-			warn("%s: calloc", __func__);
-			return;
-		}
-
-		entry->src = ip->ip_src;
-		evtimer_set(&entry->timeout, honeyd_osfp_timeout, entry);
-		root = honeyd_osfp_hash(ip);
+		entry = &osfp_cache[i];
+		if (entry->list == NULL || now - entry->lastuse < OSFP_TIMEOUT)
+			continue;
 
-		SPLAY_INSERT(osfptree, root, entry);
+		honeyd_osfp_remove(entry);
+		expired++;
 	}
 
-	entry->list = list;
+	if (expired)
+		syslog(LOG_DEBUG, "Expired %d OS fingerprints, %u left",
+				expired, osfp_count);
+}
+
+static void
+honeyd_osfp_sweep(int fd, short what, void *arg)
+{
+	struct timeval tv;
+
+	honeyd_osfp_expire(time(NULL));
 
-	timerclear(&tv);
-	tv.tv_sec = OSFP_TIMEOUT;
-	evtimer_add(&entry->timeout, &tv);
+	if (osfp_count)
+	{
+		timerclear(&tv);
+		tv.tv_sec = OSFP_SWEEP;
+		evtimer_add(&osfp_sweep_ev, &tv);
+	}
 }
 
+/*
+ * CLOCK replacement: free slots are taken right away, entries that have
+ * been hit since the last pass of the hand get a second chance.
+ */
+
 static struct osfp *
-honeyd_osfp_cache(const struct ip_hdr *ip)
+honeyd_osfp_victim(void)
+{
+	struct osfp *entry;
+
+	for (;;)
+	{
+		entry = &osfp_cache[osfp_hand];
+		osfp_hand = (osfp_hand + 1) & (OSFP_CACHE_SIZE - 1);
+
+		if (entry->list == NULL || !entry->referenced)
+			return (entry);
+		entry->referenced = 0;
+	}
+}
+
+static void honeyd_osfp_cache_insert(const struct addr *src,
+		struct pf_osfp_enlist *list)
 {
 	struct timeval tv;
-	struct osfptree *root;
-	struct osfp tmp, *entry;
+	struct osfp *entry;
 
-	root = honeyd_osfp_hash(ip);
+	/* Create a new entry unless we have it cached already */
+	if ((entry = honeyd_osfp_cache(src)) == NULL )
+	{
+		entry = honeyd_osfp_victim();
+		if (entry->list != NULL)
+			honeyd_osfp_remove(entry);
+
+		entry->src = *src;
+		entry->lastuse = time(NULL);
+		entry->referenced = 0;
+		LIST_INSERT_HEAD(honeyd_osfp_hash(src), entry, next);
+		osfp_count++;
+	}
 
-	tmp.src = ip->ip_src;
+	entry->list = list;
 
-	entry = SPLAY_FIND(osfptree, root, &tmp);
-	if (entry == NULL )
-		return (NULL );
+	if (!evtimer_pending(&osfp_sweep_ev, NULL))
+	{
+		timerclear(&tv);
+		tv.tv_sec = OSFP_SWEEP;
+		evtimer_add(&osfp_sweep_ev, &tv);
+	}
+}
 
-	assert(entry->src == ip->ip_src);
+static struct osfp *
+honeyd_osfp_cache(const struct addr *src)
+{
+	struct osfp *entry;
 
-	/* Update timeout */
-	timerclear(&tv);
-	tv.tv_sec = OSFP_TIMEOUT;
-	evtimer_add(&entry->timeout, &tv);
+	LIST_FOREACH(entry, honeyd_osfp_hash(src), next)
+	{
+		if (addr_cmp(&entry->src, src) == 0)
+		{
+			entry->lastuse = time(NULL);
+			entry->referenced = 1;
+			return (entry);
+		}
+	}
 
-	return (entry);
+	return (NULL);
 }
 
-int honeyd_osfp_match(const struct ip_hdr *ip, pf_osfp_t fp)
+int honeyd_osfp_match(const u_char *pkt, u_short iplen, pf_osfp_t fp)
 {
-	struct pf_osfp_enlist *list;
+	struct pf_osfp_enlist *list = NULL;
 	const struct tcp_hdr *tcp;
+	struct osfp *entry;
+	struct addr src;
 
-	tcp = (const struct tcp_hdr *) ((u_char *) ip + (ip->ip_hl << 2));
+	if (honeyd_osfp_parse(pkt, iplen, &src, &tcp) == -1)
+		return (pf_osfp_match(NULL, fp));
 
-	list = pf_osfp_fingerprint_hdr(ip, tcp);
-	if (list == NULL )
-	{
-		struct osfp *entry = honeyd_osfp_cache(ip);
-		if (entry != NULL )
-			list = entry->list;
-	}
+	if (tcp != NULL)
+		list = honeyd_osfp_fingerprint(pkt, tcp);
+	if (list == NULL && (entry = honeyd_osfp_cache(&src)) != NULL)
+		list = entry->list;
 
 	return (pf_osfp_match(list, fp));
 }
 
 void honeyd_osfp_input(struct tuple *conhdr, u_char *pkt, u_int plen, void *arg)
 {
-	const struct ip_hdr *ip = (struct ip_hdr *) pkt;
 	const struct tcp_hdr *tcp;
 	struct pf_osfp_enlist *list;
-	u_short iphlen = ip->ip_hl << 2;
+	struct addr src;
 
-	/* Sanity check */
-	if (iphlen + sizeof(struct tcp_hdr) > plen)
+	if (honeyd_osfp_parse(pkt, plen, &src, &tcp) == -1 || tcp == NULL)
 		return;
 
-	tcp = (const struct tcp_hdr *) (pkt + iphlen);
-
 	/* Only intercept syn packets */
 	if ((tcp->th_flags & (TH_SYN | TH_ACK)) != TH_SYN)
 		return;
 
-	list = pf_osfp_fingerprint_hdr(ip, tcp);
+	list = honeyd_osfp_fingerprint(pkt, tcp);
 	if (list == NULL )
 		return;
 
-	honeyd_osfp_cache_insert(ip, list);
+	honeyd_osfp_cache_insert(&src, list);
 }
 
 char *
-honeyd_osfp_name(struct ip_hdr *ip)
+honeyd_osfp_name(const struct tuple *hdr)
 {
 	static char name[128];
 	struct osfp *cache;
 	struct pf_osfp_enlist *list;
 	struct pf_osfp_entry *entry;
+	struct addr src;
+
+	if (hdr->src_addr.addr_type == ADDR_TYPE_IP6)
+		src = hdr->src_addr;
+	else
+		addr_pack(&src, ADDR_TYPE_IP, IP_ADDR_BITS, &hdr->ip_src,
+				IP_ADDR_LEN);
 
-	cache = honeyd_osfp_cache(ip);
+	cache = honeyd_osfp_cache(&src);
 	if (cache == NULL )
 		return (NULL );
 	list = cache->list;
@@ -259,3 +374,53 @@ honeyd_osfp_name(struct ip_hdr *ip)
 
 	return (name);
 }
+
+void
+osfp_test(void)
+{
+	struct pf_osfp_enlist list;
+	struct addr src, first, second;
+	ip_addr_t ip;
+	int i;
+
+	for (i = 0; i < OSFP_CACHE_SIZE; i++)
+		if (osfp_cache[i].list != NULL)
+			honeyd_osfp_remove(&osfp_cache[i]);
+	osfp_hand = 0;
+	SLIST_INIT(&list);
+
+	/* Fill the cache with IPv4 sources */
+	for (i = 0; i < OSFP_CACHE_SIZE; i++)
+	{
+		ip = htonl(0x0a000000 + i);
+		addr_pack(&src, ADDR_TYPE_IP, IP_ADDR_BITS, &ip, IP_ADDR_LEN);
+		honeyd_osfp_cache_insert(&src, &list);
+		if (i == 0)
+			first = src;
+		else if (i == 1)
+			second = src;
+	}
+	if (osfp_count != OSFP_CACHE_SIZE)
+		errx(1, "%s: cache holds %u entries", __func__, osfp_count);
+
+	/* The first entry gets a second chance, the next one is evicted */
+	if (honeyd_osfp_cache(&first) == NULL)
+		errx(1, "%s: first entry missing", __func__);
+	addr_pton("2001:db8::a00:0", &src);
+	honeyd_osfp_cache_insert(&src, &list);
+	if (osfp_count != OSFP_CACHE_SIZE)
+		errx(1, "%s: cache grew to %u", __func__, osfp_count);
+	if (honeyd_osfp_cache(&src) == NULL)
+		errx(1, "%s: IPv6 entry missing", __func__);
+	if (honeyd_osfp_cache(&first) == NULL)
+		errx(1, "%s: referenced entry was evicted", __func__);
+	if (honeyd_osfp_cache(&second) != NULL)
+		errx(1, "%s: CLOCK did not evict", __func__);
+
+	/* One sweep expires everything that is idle */
+	honeyd_osfp_expire(time(NULL) + OSFP_TIMEOUT);
+	if (osfp_count != 0)
+		errx(1, "%s: %u entries survived expiry", __func__, osfp_count);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
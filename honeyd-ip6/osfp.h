@@ -34,20 +34,30 @@
 
 #include "pfvar.h"
 
-#define OSFP_HASHSIZE	256		/* Needs to be power of 2 */
+#define OSFP_CACHE_SIZE	4096		/* Needs to be power of 2 */
 #define OSFP_TIMEOUT	(5 * 60)
+#define OSFP_SWEEP	60		/* seconds between expiry sweeps */
 
+/*
+ * A cached fingerprint.  The entries live in a fixed array that is
+ * recycled by a CLOCK hand; a free slot has no list.
+ */
 struct osfp {
-	SPLAY_ENTRY(osfp) node;
-	struct event timeout;
+	LIST_ENTRY(osfp) next;		/* hash chain */
 
-	ip_addr_t	src;
+	struct addr	src;		/* IPv4 or IPv6 source */
+	time_t		lastuse;
+	int		referenced;	/* hit since the hand last passed */
 
 	struct pf_osfp_enlist *list;
 };
 
+struct tuple;
+
 int honeyd_osfp_init(const char *);
-int honeyd_osfp_match(const struct ip_hdr *, pf_osfp_t);
-char *honeyd_osfp_name(struct ip_hdr *);
+int honeyd_osfp_match(const u_char *, u_short, pf_osfp_t);
+char *honeyd_osfp_name(const struct tuple *);
+
+void osfp_test(void);
 
 #endif
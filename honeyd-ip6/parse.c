@@ -1,21 +1,22 @@
-/* A Bison parser, made by GNU Bison 2.5.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
-   
-      Copyright (C) 1984, 1989-1990, 2000-2011 Free Software Foundation, Inc.
-   
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
    the Free Software Foundation, either version 3 of the License, or
    (at your option) any later version.
-   
+
    This program is distributed in the hope that it will be useful,
    but WITHOUT ANY WARRANTY; without even the implied warranty of
    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
    GNU General Public License for more details.
-   
+
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -26,13 +27,17 @@
    special exception, which will cause the skeleton and the resulting
    Bison output files to be licensed under the GNU General Public
    License without this special exception.
-   
+
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -40,11 +45,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "2.5"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -58,14 +63,10 @@
 /* Pull parsers.  */
 #define YYPULL 1
 
-/* Using locations.  */
-#define YYLSP_NEEDED 0
 
 
 
-/* Copy the first part of user declarations.  */
-
-/* Line 268 of yacc.c  */
+/* First part of user prologue.  */
 #line 32 "parse.y"
 
 #include <sys/types.h>
@@ -144,124 +145,144 @@ int errors = 0;
 int curtype = -1;	/* Lex sets it to SOCK_STREAM or _DGRAM */
 
 
+#line 149 "parse.c"
 
-/* Line 268 of yacc.c  */
-#line 150 "parse.c"
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
 
-/* Enabling traces.  */
+/* Use api.header.include to #include this header
+   instead of duplicating it here.  */
+#ifndef YY_YY_Y_TAB_H_INCLUDED
+# define YY_YY_Y_TAB_H_INCLUDED
+/* Debug traces.  */
 #ifndef YYDEBUG
 # define YYDEBUG 0
 #endif
-
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
-
-/* Enabling the token table.  */
-#ifndef YYTOKEN_TABLE
-# define YYTOKEN_TABLE 0
+#if YYDEBUG
+extern int yydebug;
 #endif
 
-
-/* Tokens.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
-   /* Put the tokens into the symbol table, so that GDB and other debuggers
-      know about them.  */
-   enum yytokentype {
-     CREATE = 258,
-     ADD = 259,
-     PORT = 260,
-     BIND = 261,
-     CLONE = 262,
-     DOT = 263,
-     BLOCK = 264,
-     OPEN = 265,
-     RESET = 266,
-     DEFAULT = 267,
-     SET = 268,
-     ACTION = 269,
-     PERSONALITY = 270,
-     RANDOM = 271,
-     ANNOTATE = 272,
-     NO = 273,
-     FINSCAN = 274,
-     FRAGMENT = 275,
-     DROP = 276,
-     OLD = 277,
-     NEW = 278,
-     COLON = 279,
-     PROXY = 280,
-     UPTIME = 281,
-     DROPRATE = 282,
-     IN = 283,
-     SYN = 284,
-     UID = 285,
-     GID = 286,
-     ROUTE = 287,
-     ENTRY = 288,
-     LINK = 289,
-     NET = 290,
-     UNREACH = 291,
-     SLASH = 292,
-     LATENCY = 293,
-     MS = 294,
-     LOSS = 295,
-     BANDWIDTH = 296,
-     SUBSYSTEM = 297,
-     OPTION = 298,
-     TO = 299,
-     SHARED = 300,
-     NETWORK = 301,
-     SPOOF = 302,
-     FROM = 303,
-     TEMPLATE = 304,
-     OBRACKET = 305,
-     CBRACKET = 306,
-     RBRACKET = 307,
-     LBRACKET = 308,
-     TUNNEL = 309,
-     TARPIT = 310,
-     DYNAMIC = 311,
-     USE = 312,
-     IF = 313,
-     OTHERWISE = 314,
-     EQUAL = 315,
-     SOURCE = 316,
-     OS = 317,
-     IP = 318,
-     BETWEEN = 319,
-     DELETE = 320,
-     LIST = 321,
-     ETHERNET = 322,
-     DHCP = 323,
-     ON = 324,
-     MAXFDS = 325,
-     RESTART = 326,
-     DEBUG = 327,
-     DASH = 328,
-     TIME = 329,
-     INTERNAL = 330,
-     RANDOMIPVS = 331,
-     RANDOMEXCLUDE = 332,
-     SUBMISSION = 333,
-     STRING = 334,
-     CMDSTRING = 335,
-     IPSTRING = 336,
-     IPSSTRING = 337,
-     FILENAMESTRING = 338,
-     YESNO = 339,
-     NUMBER = 340,
-     LONG = 341,
-     PROTO = 342,
-     FLOAT = 343
-   };
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    CREATE = 258,                  /* CREATE  */
+    ADD = 259,                     /* ADD  */
+    PORT = 260,                    /* PORT  */
+    BIND = 261,                    /* BIND  */
+    CLONE = 262,                   /* CLONE  */
+    DOT = 263,                     /* DOT  */
+    BLOCK = 264,                   /* BLOCK  */
+    OPEN = 265,                    /* OPEN  */
+    RESET = 266,                   /* RESET  */
+    DEFAULT = 267,                 /* DEFAULT  */
+    SET = 268,                     /* SET  */
+    ACTION = 269,                  /* ACTION  */
+    PERSONALITY = 270,             /* PERSONALITY  */
+    RANDOM = 271,                  /* RANDOM  */
+    ANNOTATE = 272,                /* ANNOTATE  */
+    NO = 273,                      /* NO  */
+    FINSCAN = 274,                 /* FINSCAN  */
+    FRAGMENT = 275,                /* FRAGMENT  */
+    DROP = 276,                    /* DROP  */
+    OLD = 277,                     /* OLD  */
+    NEW = 278,                     /* NEW  */
+    COLON = 279,                   /* COLON  */
+    PROXY = 280,                   /* PROXY  */
+    UPTIME = 281,                  /* UPTIME  */
+    DROPRATE = 282,                /* DROPRATE  */
+    IN = 283,                      /* IN  */
+    SYN = 284,                     /* SYN  */
+    UID = 285,                     /* UID  */
+    GID = 286,                     /* GID  */
+    ROUTE = 287,                   /* ROUTE  */
+    ENTRY = 288,                   /* ENTRY  */
+    LINK = 289,                    /* LINK  */
+    NET = 290,                     /* NET  */
+    UNREACH = 291,                 /* UNREACH  */
+    SLASH = 292,                   /* SLASH  */
+    LATENCY = 293,                 /* LATENCY  */
+    MS = 294,                      /* MS  */
+    LOSS = 295,                    /* LOSS  */
+    BANDWIDTH = 296,               /* BANDWIDTH  */
+    SUBSYSTEM = 297,               /* SUBSYSTEM  */
+    OPTION = 298,                  /* OPTION  */
+    TO = 299,                      /* TO  */
+    SHARED = 300,                  /* SHARED  */
+    NETWORK = 301,                 /* NETWORK  */
+    SPOOF = 302,                   /* SPOOF  */
+    FROM = 303,                    /* FROM  */
+    TEMPLATE = 304,                /* TEMPLATE  */
+    OBRACKET = 305,                /* OBRACKET  */
+    CBRACKET = 306,                /* CBRACKET  */
+    RBRACKET = 307,                /* RBRACKET  */
+    LBRACKET = 308,                /* LBRACKET  */
+    TUNNEL = 309,                  /* TUNNEL  */
+    TARPIT = 310,                  /* TARPIT  */
+    DYNAMIC = 311,                 /* DYNAMIC  */
+    USE = 312,                     /* USE  */
+    IF = 313,                      /* IF  */
+    OTHERWISE = 314,               /* OTHERWISE  */
+    EQUAL = 315,                   /* EQUAL  */
+    SOURCE = 316,                  /* SOURCE  */
+    OS = 317,                      /* OS  */
+    IP = 318,                      /* IP  */
+    BETWEEN = 319,                 /* BETWEEN  */
+    DELETE = 320,                  /* DELETE  */
+    LIST = 321,                    /* LIST  */
+    ETHERNET = 322,                /* ETHERNET  */
+    DHCP = 323,                    /* DHCP  */
+    ON = 324,                      /* ON  */
+    MAXFDS = 325,                  /* MAXFDS  */
+    RESTART = 326,                 /* RESTART  */
+    DEBUG = 327,                   /* DEBUG  */
+    DASH = 328,                    /* DASH  */
+    TIME = 329,                    /* TIME  */
+    INTERNAL = 330,                /* INTERNAL  */
+    RANDOMIPVS = 331,              /* RANDOMIPVS  */
+    RANDOMEXCLUDE = 332,           /* RANDOMEXCLUDE  */
+    SUBMISSION = 333,              /* SUBMISSION  */
+    STRING = 334,                  /* STRING  */
+    CMDSTRING = 335,               /* CMDSTRING  */
+    IPSTRING = 336,                /* IPSTRING  */
+    IPSSTRING = 337,               /* IPSSTRING  */
+    FILENAMESTRING = 338,          /* FILENAMESTRING  */
+    YESNO = 339,                   /* YESNO  */
+    NUMBER = 340,                  /* NUMBER  */
+    LONG = 341,                    /* LONG  */
+    PROTO = 342,                   /* PROTO  */
+    FLOAT = 343                    /* FLOAT  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
-/* Tokens.  */
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
 #define CREATE 258
 #define ADD 259
 #define PORT 260
@@ -349,14 +370,10 @@ int curtype = -1;	/* Lex sets it to SOCK_STREAM or _DGRAM */
 #define PROTO 342
 #define FLOAT 343
 
-
-
-
+/* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef union YYSTYPE
+union YYSTYPE
 {
-
-/* Line 293 of yacc.c  */
 #line 154 "parse.y"
 
 	char *string;
@@ -374,52 +391,241 @@ typedef union YYSTYPE
 	struct tm time;
 	struct condition_time timecondition;
 
+#line 395 "parse.c"
 
-
-/* Line 293 of yacc.c  */
-#line 381 "parse.c"
-} YYSTYPE;
+};
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
-# define yystype YYSTYPE /* obsolescent; will be withdrawn */
 # define YYSTYPE_IS_DECLARED 1
 #endif
 
 
-/* Copy the second part of user declarations.  */
+extern YYSTYPE yylval;
+
+
+int yyparse (void);
+
+
+#endif /* !YY_YY_Y_TAB_H_INCLUDED  */
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_CREATE = 3,                     /* CREATE  */
+  YYSYMBOL_ADD = 4,                        /* ADD  */
+  YYSYMBOL_PORT = 5,                       /* PORT  */
+  YYSYMBOL_BIND = 6,                       /* BIND  */
+  YYSYMBOL_CLONE = 7,                      /* CLONE  */
+  YYSYMBOL_DOT = 8,                        /* DOT  */
+  YYSYMBOL_BLOCK = 9,                      /* BLOCK  */
+  YYSYMBOL_OPEN = 10,                      /* OPEN  */
+  YYSYMBOL_RESET = 11,                     /* RESET  */
+  YYSYMBOL_DEFAULT = 12,                   /* DEFAULT  */
+  YYSYMBOL_SET = 13,                       /* SET  */
+  YYSYMBOL_ACTION = 14,                    /* ACTION  */
+  YYSYMBOL_PERSONALITY = 15,               /* PERSONALITY  */
+  YYSYMBOL_RANDOM = 16,                    /* RANDOM  */
+  YYSYMBOL_ANNOTATE = 17,                  /* ANNOTATE  */
+  YYSYMBOL_NO = 18,                        /* NO  */
+  YYSYMBOL_FINSCAN = 19,                   /* FINSCAN  */
+  YYSYMBOL_FRAGMENT = 20,                  /* FRAGMENT  */
+  YYSYMBOL_DROP = 21,                      /* DROP  */
+  YYSYMBOL_OLD = 22,                       /* OLD  */
+  YYSYMBOL_NEW = 23,                       /* NEW  */
+  YYSYMBOL_COLON = 24,                     /* COLON  */
+  YYSYMBOL_PROXY = 25,                     /* PROXY  */
+  YYSYMBOL_UPTIME = 26,                    /* UPTIME  */
+  YYSYMBOL_DROPRATE = 27,                  /* DROPRATE  */
+  YYSYMBOL_IN = 28,                        /* IN  */
+  YYSYMBOL_SYN = 29,                       /* SYN  */
+  YYSYMBOL_UID = 30,                       /* UID  */
+  YYSYMBOL_GID = 31,                       /* GID  */
+  YYSYMBOL_ROUTE = 32,                     /* ROUTE  */
+  YYSYMBOL_ENTRY = 33,                     /* ENTRY  */
+  YYSYMBOL_LINK = 34,                      /* LINK  */
+  YYSYMBOL_NET = 35,                       /* NET  */
+  YYSYMBOL_UNREACH = 36,                   /* UNREACH  */
+  YYSYMBOL_SLASH = 37,                     /* SLASH  */
+  YYSYMBOL_LATENCY = 38,                   /* LATENCY  */
+  YYSYMBOL_MS = 39,                        /* MS  */
+  YYSYMBOL_LOSS = 40,                      /* LOSS  */
+  YYSYMBOL_BANDWIDTH = 41,                 /* BANDWIDTH  */
+  YYSYMBOL_SUBSYSTEM = 42,                 /* SUBSYSTEM  */
+  YYSYMBOL_OPTION = 43,                    /* OPTION  */
+  YYSYMBOL_TO = 44,                        /* TO  */
+  YYSYMBOL_SHARED = 45,                    /* SHARED  */
+  YYSYMBOL_NETWORK = 46,                   /* NETWORK  */
+  YYSYMBOL_SPOOF = 47,                     /* SPOOF  */
+  YYSYMBOL_FROM = 48,                      /* FROM  */
+  YYSYMBOL_TEMPLATE = 49,                  /* TEMPLATE  */
+  YYSYMBOL_OBRACKET = 50,                  /* OBRACKET  */
+  YYSYMBOL_CBRACKET = 51,                  /* CBRACKET  */
+  YYSYMBOL_RBRACKET = 52,                  /* RBRACKET  */
+  YYSYMBOL_LBRACKET = 53,                  /* LBRACKET  */
+  YYSYMBOL_TUNNEL = 54,                    /* TUNNEL  */
+  YYSYMBOL_TARPIT = 55,                    /* TARPIT  */
+  YYSYMBOL_DYNAMIC = 56,                   /* DYNAMIC  */
+  YYSYMBOL_USE = 57,                       /* USE  */
+  YYSYMBOL_IF = 58,                        /* IF  */
+  YYSYMBOL_OTHERWISE = 59,                 /* OTHERWISE  */
+  YYSYMBOL_EQUAL = 60,                     /* EQUAL  */
+  YYSYMBOL_SOURCE = 61,                    /* SOURCE  */
+  YYSYMBOL_OS = 62,                        /* OS  */
+  YYSYMBOL_IP = 63,                        /* IP  */
+  YYSYMBOL_BETWEEN = 64,                   /* BETWEEN  */
+  YYSYMBOL_DELETE = 65,                    /* DELETE  */
+  YYSYMBOL_LIST = 66,                      /* LIST  */
+  YYSYMBOL_ETHERNET = 67,                  /* ETHERNET  */
+  YYSYMBOL_DHCP = 68,                      /* DHCP  */
+  YYSYMBOL_ON = 69,                        /* ON  */
+  YYSYMBOL_MAXFDS = 70,                    /* MAXFDS  */
+  YYSYMBOL_RESTART = 71,                   /* RESTART  */
+  YYSYMBOL_DEBUG = 72,                     /* DEBUG  */
+  YYSYMBOL_DASH = 73,                      /* DASH  */
+  YYSYMBOL_TIME = 74,                      /* TIME  */
+  YYSYMBOL_INTERNAL = 75,                  /* INTERNAL  */
+  YYSYMBOL_RANDOMIPVS = 76,                /* RANDOMIPVS  */
+  YYSYMBOL_RANDOMEXCLUDE = 77,             /* RANDOMEXCLUDE  */
+  YYSYMBOL_SUBMISSION = 78,                /* SUBMISSION  */
+  YYSYMBOL_STRING = 79,                    /* STRING  */
+  YYSYMBOL_CMDSTRING = 80,                 /* CMDSTRING  */
+  YYSYMBOL_IPSTRING = 81,                  /* IPSTRING  */
+  YYSYMBOL_IPSSTRING = 82,                 /* IPSSTRING  */
+  YYSYMBOL_FILENAMESTRING = 83,            /* FILENAMESTRING  */
+  YYSYMBOL_YESNO = 84,                     /* YESNO  */
+  YYSYMBOL_NUMBER = 85,                    /* NUMBER  */
+  YYSYMBOL_LONG = 86,                      /* LONG  */
+  YYSYMBOL_PROTO = 87,                     /* PROTO  */
+  YYSYMBOL_FLOAT = 88,                     /* FLOAT  */
+  YYSYMBOL_YYACCEPT = 89,                  /* $accept  */
+  YYSYMBOL_config = 90,                    /* config  */
+  YYSYMBOL_randomipv6mode = 91,            /* randomipv6mode  */
+  YYSYMBOL_randomexclude = 92,             /* randomexclude  */
+  YYSYMBOL_creation = 93,                  /* creation  */
+  YYSYMBOL_delete = 94,                    /* delete  */
+  YYSYMBOL_addition = 95,                  /* addition  */
+  YYSYMBOL_subsystem = 96,                 /* subsystem  */
+  YYSYMBOL_binding = 97,                   /* binding  */
+  YYSYMBOL_set = 98,                       /* set  */
+  YYSYMBOL_annotate = 99,                  /* annotate  */
+  YYSYMBOL_route = 100,                    /* route  */
+  YYSYMBOL_finscan = 101,                  /* finscan  */
+  YYSYMBOL_fragment = 102,                 /* fragment  */
+  YYSYMBOL_ipaddr = 103,                   /* ipaddr  */
+  YYSYMBOL_ip6addr = 104,                  /* ip6addr  */
+  YYSYMBOL_ipnet = 105,                    /* ipnet  */
+  YYSYMBOL_ip6net = 106,                   /* ip6net  */
+  YYSYMBOL_ipaddrplusport = 107,           /* ipaddrplusport  */
+  YYSYMBOL_action = 108,                   /* action  */
+  YYSYMBOL_template = 109,                 /* template  */
+  YYSYMBOL_personality = 110,              /* personality  */
+  YYSYMBOL_rate = 111,                     /* rate  */
+  YYSYMBOL_latency = 112,                  /* latency  */
+  YYSYMBOL_packetloss = 113,               /* packetloss  */
+  YYSYMBOL_bandwidth = 114,                /* bandwidth  */
+  YYSYMBOL_randomearlydrop = 115,          /* randomearlydrop  */
+  YYSYMBOL_option = 116,                   /* option  */
+  YYSYMBOL_ui = 117,                       /* ui  */
+  YYSYMBOL_shared = 118,                   /* shared  */
+  YYSYMBOL_restart = 119,                  /* restart  */
+  YYSYMBOL_flags = 120,                    /* flags  */
+  YYSYMBOL_condition = 121,                /* condition  */
+  YYSYMBOL_timecondition = 122,            /* timecondition  */
+  YYSYMBOL_time = 123                      /* time  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
 
 
-/* Line 343 of yacc.c  */
-#line 393 "parse.c"
 
 #ifdef short
 # undef short
 #endif
 
-#ifdef YYTYPE_UINT8
-typedef YYTYPE_UINT8 yytype_uint8;
-#else
-typedef unsigned char yytype_uint8;
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
 #endif
 
-#ifdef YYTYPE_INT8
-typedef YYTYPE_INT8 yytype_int8;
-#elif (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
 typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
 #else
-typedef short int yytype_int8;
+typedef short yytype_int16;
 #endif
 
-#ifdef YYTYPE_UINT16
-typedef YYTYPE_UINT16 yytype_uint16;
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
 #else
-typedef unsigned short int yytype_uint16;
+typedef short yytype_uint8;
 #endif
 
-#ifdef YYTYPE_INT16
-typedef YYTYPE_INT16 yytype_int16;
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
 #else
-typedef short int yytype_int16;
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
 #endif
 
 #ifndef YYSIZE_T
@@ -427,55 +633,106 @@ typedef short int yytype_int16;
 #  define YYSIZE_T __SIZE_TYPE__
 # elif defined size_t
 #  define YYSIZE_T size_t
-# elif ! defined YYSIZE_T && (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
 #  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
 #  define YYSIZE_T size_t
 # else
-#  define YYSIZE_T unsigned int
+#  define YYSIZE_T unsigned
 # endif
 #endif
 
-#define YYSIZE_MAXIMUM ((YYSIZE_T) -1)
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_uint8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
 
 #ifndef YY_
 # if defined YYENABLE_NLS && YYENABLE_NLS
 #  if ENABLE_NLS
 #   include <libintl.h> /* INFRINGES ON USER NAME SPACE */
-#   define YY_(msgid) dgettext ("bison-runtime", msgid)
+#   define YY_(Msgid) dgettext ("bison-runtime", Msgid)
 #  endif
 # endif
 # ifndef YY_
-#  define YY_(msgid) msgid
+#  define YY_(Msgid) Msgid
+# endif
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
 # endif
 #endif
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(e) ((void) (e))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(e) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-/* Identity function, used to suppress warnings about constant conditions.  */
-#ifndef lint
-# define YYID(n) (n)
-#else
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static int
-YYID (int yyi)
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
 #else
-static int
-YYID (yyi)
-    int yyi;
+# define YY_INITIAL_VALUE(Value) Value
 #endif
-{
-  return yyi;
-}
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
 #endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -492,9 +749,9 @@ YYID (yyi)
 #    define alloca _alloca
 #   else
 #    define YYSTACK_ALLOC alloca
-#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS && (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
 #     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+      /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
 #     ifndef EXIT_SUCCESS
 #      define EXIT_SUCCESS 0
 #     endif
@@ -504,8 +761,8 @@ YYID (yyi)
 # endif
 
 # ifdef YYSTACK_ALLOC
-   /* Pacify GCC's `empty if-body' warning.  */
-#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (YYID (0))
+   /* Pacify GCC's 'empty if-body' warning.  */
+#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
 #  ifndef YYSTACK_ALLOC_MAXIMUM
     /* The OS might guarantee only one guard page at the bottom of the stack,
        and a page size can be as small as 4096 bytes.  So we cannot safely
@@ -521,7 +778,7 @@ YYID (yyi)
 #  endif
 #  if (defined __cplusplus && ! defined EXIT_SUCCESS \
        && ! ((defined YYMALLOC || defined malloc) \
-	     && (defined YYFREE || defined free)))
+             && (defined YYFREE || defined free)))
 #   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
 #   ifndef EXIT_SUCCESS
 #    define EXIT_SUCCESS 0
@@ -529,40 +786,37 @@ YYID (yyi)
 #  endif
 #  ifndef YYMALLOC
 #   define YYMALLOC malloc
-#   if ! defined malloc && ! defined EXIT_SUCCESS && (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+#   if ! defined malloc && ! defined EXIT_SUCCESS
 void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 #  ifndef YYFREE
 #   define YYFREE free
-#   if ! defined free && ! defined EXIT_SUCCESS && (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+#   if ! defined free && ! defined EXIT_SUCCESS
 void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
-	 || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
 
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  yytype_int16 yyss_alloc;
+  yy_state_t yyss_alloc;
   YYSTYPE yyvs_alloc;
 };
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (yytype_int16) + sizeof (YYSTYPE)) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
       + YYSTACK_GAP_MAXIMUM)
 
 # define YYCOPY_NEEDED 1
@@ -572,35 +826,35 @@ union yyalloc
    elements in the stack, and YYPTR gives the new location of the
    stack.  Advance YYPTR to a properly aligned location for the next
    stack.  */
-# define YYSTACK_RELOCATE(Stack_alloc, Stack)				\
-    do									\
-      {									\
-	YYSIZE_T yynewbytes;						\
-	YYCOPY (&yyptr->Stack_alloc, Stack, yysize);			\
-	Stack = &yyptr->Stack_alloc;					\
-	yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-	yyptr += yynewbytes / sizeof (*yyptr);				\
-      }									\
-    while (YYID (0))
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
+    while (0)
 
 #endif
 
 #if defined YYCOPY_NEEDED && YYCOPY_NEEDED
-/* Copy COUNT objects from FROM to TO.  The source and destination do
+/* Copy COUNT objects from SRC to DST.  The source and destination do
    not overlap.  */
 # ifndef YYCOPY
 #  if defined __GNUC__ && 1 < __GNUC__
-#   define YYCOPY(To, From, Count) \
-      __builtin_memcpy (To, From, (Count) * sizeof (*(From)))
+#   define YYCOPY(Dst, Src, Count) \
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
 #  else
-#   define YYCOPY(To, From, Count)		\
-      do					\
-	{					\
-	  YYSIZE_T yyi;				\
-	  for (yyi = 0; yyi < (Count); yyi++)	\
-	    (To)[yyi] = (From)[yyi];		\
-	}					\
-      while (YYID (0))
+#   define YYCOPY(Dst, Src, Count)              \
+      do                                        \
+        {                                       \
+          YYPTRDIFF_T yyi;                      \
+          for (yyi = 0; yyi < (Count); yyi++)   \
+            (Dst)[yyi] = (Src)[yyi];            \
+        }                                       \
+      while (0)
 #  endif
 # endif
 #endif /* !YYCOPY_NEEDED */
@@ -615,19 +869,24 @@ union yyalloc
 /* YYNNTS -- Number of nonterminals.  */
 #define YYNNTS  35
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  121
-/* YYNRULES -- Number of states.  */
-#define YYNSTATES  241
+#define YYNRULES  122
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  243
 
-/* YYTRANSLATE(YYLEX) -- Bison symbol number corresponding to YYLEX.  */
-#define YYUNDEFTOK  2
+/* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   343
 
-#define YYTRANSLATE(YYX)						\
-  ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
 
-/* YYTRANSLATE[YYLEX] -- Bison symbol number corresponding to YYLEX.  */
-static const yytype_uint8 yytranslate[] =
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
+
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -667,80 +926,8 @@ static const yytype_uint8 yytranslate[] =
 };
 
 #if YYDEBUG
-/* YYPRHS[YYN] -- Index of the first RHS symbol of rule number YYN in
-   YYRHS.  */
-static const yytype_uint16 yyprhs[] =
-{
-       0,     0,     3,     4,     7,    10,    13,    16,    19,    22,
-      25,    28,    31,    34,    37,    40,    45,    48,    51,    54,
-      57,    60,    63,    69,    76,    83,    89,    96,   100,   104,
-     109,   114,   119,   126,   130,   136,   142,   150,   157,   162,
-     167,   172,   178,   184,   189,   194,   201,   205,   209,   213,
-     219,   230,   239,   244,   249,   255,   266,   271,   273,   276,
-     279,   282,   285,   287,   289,   291,   295,   299,   303,   309,
-     312,   315,   319,   323,   329,   335,   341,   343,   345,   348,
-     350,   352,   354,   356,   358,   360,   362,   364,   365,   369,
-     370,   373,   374,   378,   381,   382,   390,   395,   400,   405,
-     411,   414,   418,   422,   425,   429,   433,   437,   438,   440,
-     441,   443,   444,   446,   451,   456,   461,   464,   466,   468,
-     473,   478
-};
-
-/* YYRHS -- A `-1'-separated list of the rules' RHS.  */
-static const yytype_int8 yyrhs[] =
-{
-      90,     0,    -1,    -1,    90,    93,    -1,    90,    95,    -1,
-      90,    94,    -1,    90,    96,    -1,    90,    97,    -1,    90,
-      98,    -1,    90,    99,    -1,    90,   100,    -1,    90,   116,
-      -1,    90,   117,    -1,    90,    91,    -1,    90,    92,    -1,
-      76,    88,   109,    86,    -1,    77,   104,    -1,     3,    79,
-      -1,     3,    49,    -1,     3,    12,    -1,    56,    79,    -1,
-      65,   109,    -1,    65,   109,    87,     5,    85,    -1,     4,
-     109,    87,     5,    85,   108,    -1,     4,   109,    57,   109,
-      58,   121,    -1,     4,   109,    59,    57,   109,    -1,     4,
-     109,    42,    80,   118,   119,    -1,     6,   103,   109,    -1,
-       6,   104,   109,    -1,     6,   121,   103,   109,    -1,     6,
-     103,    44,    79,    -1,    68,   109,    69,    79,    -1,    68,
-     109,    69,    79,    67,    80,    -1,     7,    79,   109,    -1,
-      13,   109,    47,    48,   103,    -1,    13,   109,    47,    44,
-     103,    -1,    13,   109,    47,    48,   103,    44,   103,    -1,
-      13,   109,    12,    87,    14,   108,    -1,    13,   109,    15,
-     110,    -1,    13,   109,    67,    80,    -1,    13,   109,    26,
-      85,    -1,    13,   109,    27,    28,   111,    -1,    13,   109,
-      27,    29,   111,    -1,    13,   109,    70,    85,    -1,    13,
-     109,    30,    85,    -1,    13,   109,    30,    85,    31,    85,
-      -1,    17,   110,   101,    -1,    17,   110,   102,    -1,    32,
-      33,   103,    -1,    32,    33,   103,    46,   105,    -1,    32,
-     103,     4,    35,   105,   103,   112,   113,   114,   115,    -1,
-      32,   103,     4,    35,   105,    54,   103,   103,    -1,    32,
-     103,    34,   105,    -1,    32,   103,    36,   105,    -1,    32,
-      33,   104,    46,   106,    -1,    32,   104,     4,    35,   106,
-     104,   112,   113,   114,   115,    -1,    32,   104,    34,   106,
-      -1,    19,    -1,    18,    19,    -1,    20,    21,    -1,    20,
-      22,    -1,    20,    23,    -1,    81,    -1,    80,    -1,    82,
-      -1,   103,    37,    85,    -1,   104,    37,    85,    -1,   103,
-      24,    85,    -1,    53,   104,    52,    24,    85,    -1,   120,
-      79,    -1,   120,    80,    -1,   120,    75,    80,    -1,   120,
-      25,   107,    -1,   120,    25,    79,    24,    85,    -1,   120,
-      25,    79,    24,    79,    -1,   120,    25,   103,    24,    79,
-      -1,     9,    -1,    11,    -1,   120,    10,    -1,    79,    -1,
-      49,    -1,    12,    -1,   103,    -1,    80,    -1,    16,    -1,
-      88,    -1,    85,    -1,    -1,    38,    85,    39,    -1,    -1,
-      40,   111,    -1,    -1,    41,    85,    85,    -1,    41,    85,
-      -1,    -1,    21,    64,    85,    39,    73,    85,    39,    -1,
-      43,    79,    79,    85,    -1,    43,    79,    79,    88,    -1,
-      43,    79,    79,    79,    -1,    43,    79,    79,    37,    79,
-      -1,    66,    49,    -1,    66,    49,    80,    -1,    66,    49,
-      79,    -1,    66,    42,    -1,    66,    42,    79,    -1,    66,
-      42,    80,    -1,    72,    79,    85,    -1,    -1,    45,    -1,
-      -1,    71,    -1,    -1,    55,    -1,    61,    62,    60,    80,
-      -1,    61,    63,    60,   103,    -1,    61,    63,    60,   105,
-      -1,    74,   122,    -1,    87,    -1,    59,    -1,    64,   123,
-      73,   123,    -1,    85,    24,    85,    79,    -1,    80,    -1
-};
-
-/* YYRLINE[YYN] -- source line where rule number YYN was defined.  */
-static const yytype_uint16 yyrline[] =
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
 {
        0,   172,   172,   173,   174,   175,   176,   177,   178,   179,
      180,   181,   182,   183,   184,   187,   197,   203,   209,   214,
@@ -753,242 +940,204 @@ static const yytype_uint16 yyrline[] =
      934,   940,   946,   953,   964,   973,   977,   982,   983,   988,
      989,   994,   995,   999,  1004,  1005,  1014,  1025,  1036,  1048,
     1064,  1068,  1076,  1080,  1084,  1088,  1094,  1115,  1118,  1125,
-    1128,  1135,  1138,  1144,  1157,  1165,  1173,  1181,  1189,  1197,
-    1204,  1226
+    1128,  1135,  1138,  1142,  1151,  1164,  1172,  1180,  1188,  1196,
+    1204,  1211,  1233
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || YYTOKEN_TABLE
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "CREATE", "ADD", "PORT", "BIND", "CLONE",
-  "DOT", "BLOCK", "OPEN", "RESET", "DEFAULT", "SET", "ACTION",
-  "PERSONALITY", "RANDOM", "ANNOTATE", "NO", "FINSCAN", "FRAGMENT", "DROP",
-  "OLD", "NEW", "COLON", "PROXY", "UPTIME", "DROPRATE", "IN", "SYN", "UID",
-  "GID", "ROUTE", "ENTRY", "LINK", "NET", "UNREACH", "SLASH", "LATENCY",
-  "MS", "LOSS", "BANDWIDTH", "SUBSYSTEM", "OPTION", "TO", "SHARED",
-  "NETWORK", "SPOOF", "FROM", "TEMPLATE", "OBRACKET", "CBRACKET",
-  "RBRACKET", "LBRACKET", "TUNNEL", "TARPIT", "DYNAMIC", "USE", "IF",
-  "OTHERWISE", "EQUAL", "SOURCE", "OS", "IP", "BETWEEN", "DELETE", "LIST",
-  "ETHERNET", "DHCP", "ON", "MAXFDS", "RESTART", "DEBUG", "DASH", "TIME",
-  "INTERNAL", "RANDOMIPVS", "RANDOMEXCLUDE", "SUBMISSION", "STRING",
-  "CMDSTRING", "IPSTRING", "IPSSTRING", "FILENAMESTRING", "YESNO",
-  "NUMBER", "LONG", "PROTO", "FLOAT", "$accept", "config",
+  "\"end of file\"", "error", "\"invalid token\"", "CREATE", "ADD",
+  "PORT", "BIND", "CLONE", "DOT", "BLOCK", "OPEN", "RESET", "DEFAULT",
+  "SET", "ACTION", "PERSONALITY", "RANDOM", "ANNOTATE", "NO", "FINSCAN",
+  "FRAGMENT", "DROP", "OLD", "NEW", "COLON", "PROXY", "UPTIME", "DROPRATE",
+  "IN", "SYN", "UID", "GID", "ROUTE", "ENTRY", "LINK", "NET", "UNREACH",
+  "SLASH", "LATENCY", "MS", "LOSS", "BANDWIDTH", "SUBSYSTEM", "OPTION",
+  "TO", "SHARED", "NETWORK", "SPOOF", "FROM", "TEMPLATE", "OBRACKET",
+  "CBRACKET", "RBRACKET", "LBRACKET", "TUNNEL", "TARPIT", "DYNAMIC", "USE",
+  "IF", "OTHERWISE", "EQUAL", "SOURCE", "OS", "IP", "BETWEEN", "DELETE",
+  "LIST", "ETHERNET", "DHCP", "ON", "MAXFDS", "RESTART", "DEBUG", "DASH",
+  "TIME", "INTERNAL", "RANDOMIPVS", "RANDOMEXCLUDE", "SUBMISSION",
+  "STRING", "CMDSTRING", "IPSTRING", "IPSSTRING", "FILENAMESTRING",
+  "YESNO", "NUMBER", "LONG", "PROTO", "FLOAT", "$accept", "config",
   "randomipv6mode", "randomexclude", "creation", "delete", "addition",
   "subsystem", "binding", "set", "annotate", "route", "finscan",
   "fragment", "ipaddr", "ip6addr", "ipnet", "ip6net", "ipaddrplusport",
   "action", "template", "personality", "rate", "latency", "packetloss",
   "bandwidth", "randomearlydrop", "option", "ui", "shared", "restart",
-  "flags", "condition", "timecondition", "time", 0
+  "flags", "condition", "timecondition", "time", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[YYLEX-NUM] -- Internal token number corresponding to
-   token YYLEX-NUM.  */
-static const yytype_uint16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279,   280,   281,   282,   283,   284,
-     285,   286,   287,   288,   289,   290,   291,   292,   293,   294,
-     295,   296,   297,   298,   299,   300,   301,   302,   303,   304,
-     305,   306,   307,   308,   309,   310,   311,   312,   313,   314,
-     315,   316,   317,   318,   319,   320,   321,   322,   323,   324,
-     325,   326,   327,   328,   329,   330,   331,   332,   333,   334,
-     335,   336,   337,   338,   339,   340,   341,   342,   343
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-/* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const yytype_uint8 yyr1[] =
-{
-       0,    89,    90,    90,    90,    90,    90,    90,    90,    90,
-      90,    90,    90,    90,    90,    91,    92,    93,    93,    93,
-      93,    94,    94,    95,    95,    95,    96,    97,    97,    97,
-      97,    97,    97,    97,    97,    97,    97,    98,    98,    98,
-      98,    98,    98,    98,    98,    98,    99,    99,   100,   100,
-     100,   100,   100,   100,   100,   100,   100,   101,   101,   102,
-     102,   102,   103,   103,   104,   105,   106,   107,   107,   108,
-     108,   108,   108,   108,   108,   108,   108,   108,   108,   109,
-     109,   109,   109,   110,   110,   111,   111,   112,   112,   113,
-     113,   114,   114,   114,   115,   115,   116,   116,   116,   116,
-     117,   117,   117,   117,   117,   117,   117,   118,   118,   119,
-     119,   120,   120,   121,   121,   121,   121,   121,   121,   122,
-     123,   123
-};
+#define YYPACT_NINF (-121)
+
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
 
-/* YYR2[YYN] -- Number of symbols composing right hand side of rule YYN.  */
-static const yytype_uint8 yyr2[] =
+#define YYTABLE_NINF (-1)
+
+#define yytable_value_is_error(Yyn) \
+  0
+
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int16 yypact[] =
 {
-       0,     2,     0,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,     2,     2,     4,     2,     2,     2,     2,
-       2,     2,     5,     6,     6,     5,     6,     3,     3,     4,
-       4,     4,     6,     3,     5,     5,     7,     6,     4,     4,
-       4,     5,     5,     4,     4,     6,     3,     3,     3,     5,
-      10,     8,     4,     4,     5,    10,     4,     1,     2,     2,
-       2,     2,     1,     1,     1,     3,     3,     3,     5,     2,
-       2,     3,     3,     5,     5,     5,     1,     1,     2,     1,
-       1,     1,     1,     1,     1,     1,     1,     0,     3,     0,
-       2,     0,     3,     2,     0,     7,     4,     4,     4,     5,
-       2,     3,     3,     2,     3,     3,     3,     0,     1,     0,
-       1,     0,     1,     4,     4,     4,     2,     1,     1,     4,
-       4,     1
+    -121,    21,  -121,    -9,    30,    57,   -72,    30,    -6,   -19,
+     -60,   -48,    30,   -20,    30,   -46,   -33,    -7,  -121,  -121,
+    -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,
+    -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,   -27,
+    -121,   -18,    14,  -121,  -121,    24,    30,    52,    30,    87,
+    -121,  -121,   140,    81,    31,    12,    16,  -121,    13,    56,
+      62,    38,    27,    30,  -121,    39,    30,    67,   121,    91,
+      92,   -14,  -121,    50,  -121,  -121,    30,  -121,    68,    -6,
+      71,   118,    84,    44,    90,    86,   153,  -121,   145,  -121,
+    -121,   127,   128,   141,    52,    52,   142,    -7,   -29,   170,
+    -121,  -121,  -121,  -121,    99,  -121,    93,   135,   123,    30,
+      97,   103,    52,  -121,   162,   114,  -121,  -121,   174,  -121,
+    -121,   -79,   -79,   158,    52,    52,  -121,  -121,  -121,  -121,
+    -121,  -121,    52,    -7,    52,   154,  -121,  -121,    -7,   155,
+    -121,   111,  -121,  -121,  -121,   109,   129,  -121,  -121,   124,
+      66,  -121,    28,  -121,   154,  -121,   112,   -14,    28,  -121,
+    -121,  -121,  -121,   113,  -121,   156,  -121,  -121,     4,   116,
+      -7,   119,  -121,  -121,   125,  -121,  -121,  -121,  -121,  -121,
+     130,  -121,  -121,     1,   131,  -121,  -121,  -121,    52,    52,
+     165,  -121,   165,  -121,  -121,  -121,  -121,    69,   126,  -121,
+    -121,  -121,  -121,    52,   122,   168,   168,    -7,   187,   188,
+    -121,  -121,  -121,   175,   -79,   172,   172,   163,   -62,   -38,
+    -121,  -121,   132,   195,   195,   194,  -121,  -121,  -121,  -121,
+     134,   157,  -121,  -121,   137,  -121,   138,  -121,   181,   151,
+     143,   186,  -121
 };
 
-/* YYDEFACT[STATE-NAME] -- Default reduction number in state STATE-NUM.
-   Performed when YYTABLE doesn't specify something else to do.  Zero
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
    means the default is an error.  */
-static const yytype_uint8 yydefact[] =
+static const yytype_int8 yydefact[] =
 {
        2,     0,     1,     0,     0,     0,     0,     0,     0,     0,
        0,     0,     0,     0,     0,     0,     0,     0,    13,    14,
        3,     5,     4,     6,     7,     8,     9,    10,    11,    12,
       19,    18,    17,    81,    80,    79,    63,    62,    82,     0,
-     118,     0,     0,    64,   117,     0,     0,     0,     0,     0,
+     119,     0,     0,    64,   118,     0,     0,     0,     0,     0,
       84,    83,     0,     0,     0,     0,     0,    20,    21,   103,
      100,     0,     0,     0,    16,     0,     0,     0,     0,     0,
-       0,     0,   116,     0,    27,    28,     0,    33,     0,     0,
+       0,     0,   117,     0,    27,    28,     0,    33,     0,     0,
        0,     0,     0,     0,     0,     0,     0,    57,     0,    46,
       47,    48,     0,     0,     0,     0,     0,     0,     0,     0,
      104,   105,   102,   101,     0,   106,     0,   107,     0,     0,
-       0,     0,     0,   121,     0,     0,    30,    29,     0,    38,
+       0,     0,     0,   122,     0,     0,    30,    29,     0,    38,
       40,     0,     0,    44,     0,     0,    39,    43,    58,    59,
       60,    61,     0,     0,     0,     0,    52,    53,     0,     0,
       56,     0,    98,    96,    97,     0,    31,    15,   108,   109,
-       0,    25,   111,   113,   114,   115,     0,     0,   111,    86,
+       0,    25,   111,   114,   115,   116,     0,     0,   111,    86,
       85,    41,    42,     0,    35,    34,    49,    54,     0,     0,
        0,     0,    99,    22,     0,   110,    26,    24,    76,    77,
-     112,    23,     0,     0,   119,    37,    45,     0,     0,    87,
-      65,    87,    66,    32,    78,     0,     0,    69,    70,   120,
-      36,     0,     0,    89,    89,     0,     0,     0,    72,    71,
-      51,     0,     0,    91,    91,     0,     0,     0,    88,    90,
-       0,    94,    94,     0,    74,    73,    75,    67,    93,     0,
-      50,    55,     0,    92,     0,    68,     0,     0,     0,     0,
-      95
-};
-
-/* YYDEFGOTO[NTERM-NUM].  */
-static const yytype_int16 yydefgoto[] =
-{
-      -1,     1,    18,    19,    20,    21,    22,    23,    24,    25,
-      26,    27,    89,    90,    38,   139,   136,   140,   208,   181,
-      39,    52,   161,   203,   213,   221,   230,    28,    29,   149,
-     176,   182,    47,    72,   115
+       0,   112,    23,     0,     0,   120,    37,    45,     0,     0,
+      87,    65,    87,    66,    32,   113,    78,     0,     0,    69,
+      70,   121,    36,     0,     0,    89,    89,     0,     0,     0,
+      72,    71,    51,     0,     0,    91,    91,     0,     0,     0,
+      88,    90,     0,    94,    94,     0,    74,    73,    75,    67,
+      93,     0,    50,    55,     0,    92,     0,    68,     0,     0,
+       0,     0,    95
 };
 
-/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-   STATE-NUM.  */
-#define YYPACT_NINF -121
-static const yytype_int16 yypact[] =
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int16 yypgoto[] =
 {
-    -121,    21,  -121,    -9,    30,    57,   -60,    30,    -6,   -19,
-     -57,   -46,    30,    16,    30,   -32,   -33,   -15,  -121,  -121,
     -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,
-    -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,   -27,
-    -121,   -18,    14,  -121,  -121,    24,    30,    55,    30,    87,
-    -121,  -121,   132,    78,     3,    12,     9,  -121,     7,    62,
-      67,    27,    22,    30,  -121,    32,    30,    44,   114,    64,
-      72,   -14,  -121,    47,  -121,  -121,    30,  -121,    79,    -6,
-      82,   127,    83,    85,    89,    86,   151,  -121,   140,  -121,
-    -121,   126,   128,   138,    55,    55,   141,   -15,   -29,   170,
-    -121,  -121,  -121,  -121,    98,  -121,    92,   134,   122,    30,
-      96,   102,    55,  -121,   161,   113,  -121,  -121,   173,  -121,
-    -121,   -79,   -79,   157,    55,    55,  -121,  -121,  -121,  -121,
-    -121,  -121,    55,   -15,    55,   152,  -121,  -121,   -15,   153,
-    -121,   115,  -121,  -121,  -121,   107,   129,  -121,  -121,   124,
-      66,  -121,    20,  -121,   152,  -121,   108,   -14,    20,  -121,
-    -121,  -121,  -121,   116,  -121,   154,  -121,  -121,    68,   117,
-     -15,   118,  -121,  -121,   119,  -121,  -121,  -121,  -121,  -121,
-    -121,  -121,     1,   125,  -121,  -121,  -121,    55,    55,   167,
-    -121,   167,  -121,  -121,  -121,     4,   130,  -121,  -121,  -121,
-    -121,    55,   121,   168,   168,   -15,   183,   185,  -121,  -121,
-    -121,   172,   -79,   171,   171,   162,   -62,   -44,  -121,  -121,
-     131,   192,   192,   191,  -121,  -121,  -121,  -121,   133,   155,
-    -121,  -121,   135,  -121,   136,  -121,   178,   149,   139,   184,
-    -121
+    -121,  -121,  -121,  -121,    -4,    -5,    11,   -37,  -121,    72,
+       6,   147,  -120,    35,    23,    15,     8,  -121,  -121,  -121,
+    -121,  -121,    83,  -121,    77
 };
 
-/* YYPGOTO[NTERM-NUM].  */
-static const yytype_int16 yypgoto[] =
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_uint8 yydefgoto[] =
 {
-    -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,  -121,
-    -121,  -121,  -121,  -121,    -4,    -5,    11,   -38,  -121,    69,
-       6,   146,  -120,    35,    25,    17,     8,  -121,  -121,  -121,
-    -121,  -121,    84,  -121,    71
+       0,     1,    18,    19,    20,    21,    22,    23,    24,    25,
+      26,    27,    89,    90,    38,   139,   136,   140,   210,   182,
+      39,    52,   161,   205,   215,   223,   232,    28,    29,   149,
+     176,   183,    47,    72,   115
 };
 
-/* YYTABLE[YYPACT[STATE-NUM]].  What to do in state STATE-NUM.  If
-   positive, shift that token.  If negative, reduce the rule which
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
-#define YYTABLE_NINF -1
 static const yytype_uint8 yytable[] =
 {
-      46,    45,   162,    30,    55,    54,   159,    93,   141,   160,
-      50,   194,    64,    49,    53,    65,    96,   224,    58,    48,
-      61,     2,    56,   225,     3,     4,   195,     5,     6,   178,
-      66,   179,    67,    57,     7,   226,    33,    94,     8,    95,
-      31,   227,    33,    76,    69,    70,    97,    62,    92,    91,
-     142,    74,    75,     9,    77,    63,   143,   205,    59,   144,
-      68,    36,    37,    43,    10,    60,   113,    43,    73,   106,
-      32,   114,   108,    34,    51,   180,   196,    11,    71,    34,
-     197,   198,   117,   206,    36,    37,    12,    13,    98,    14,
-     135,   135,   219,    15,    99,   167,   104,    16,    17,    78,
-     170,   109,    79,    35,    36,    37,   137,   105,   154,    35,
-      36,    37,   107,    80,    81,   151,    40,    82,    41,   110,
-     164,   165,   188,   155,   111,    40,   116,    41,   135,   124,
-     135,    42,   112,   125,    83,    36,    37,    36,    37,    43,
-      42,   100,   101,   166,    44,   168,   102,   103,    36,    37,
-      86,    87,    88,    44,    84,   121,   122,    85,    36,    37,
-      43,   129,   130,   131,   189,   191,   118,   120,   123,   126,
-     128,   127,   132,   134,   133,   145,   138,   146,   147,   148,
-     150,   152,   153,   200,   201,   156,   157,   158,   163,   169,
-     171,   207,   173,   183,   172,   175,   174,   210,   187,   193,
-     215,   186,   190,   192,   199,   202,   211,   216,   212,   217,
-     209,   218,   220,   229,   223,   232,   228,   237,   233,   234,
-     235,   236,   238,   240,   239,   119,   204,   185,   184,   214,
-     231,   222,     0,     0,   177
+      46,    45,   162,    30,    55,    54,   159,    48,   141,   160,
+      50,   196,    64,    49,    53,    65,    96,   226,    58,    56,
+      61,     2,    59,   227,     3,     4,   197,     5,     6,    60,
+      66,    57,    67,    62,     7,    93,    33,   178,     8,   179,
+      31,   228,    33,    76,    69,    70,    97,   229,    92,    91,
+     142,    74,    75,     9,    77,    63,   143,   180,   189,   144,
+      68,    36,    37,    43,    10,    94,   113,    95,    73,   106,
+      32,   114,   108,    34,    51,    43,   198,    11,    71,    34,
+     199,   200,   117,   181,    36,    37,    12,    13,   124,    14,
+     135,   135,   125,    15,   221,    98,   167,    16,    17,    78,
+      99,   170,    79,    35,    36,    37,   137,   104,   154,    35,
+      36,    37,   105,    80,    81,   151,    40,    82,    41,   107,
+     164,   165,   207,   155,   109,    40,   110,    41,   135,   116,
+     135,    42,    36,    37,    83,   100,   101,    36,    37,    43,
+      42,   102,   103,   166,    44,   168,   121,   122,   208,    36,
+      37,   111,   112,    44,    84,   118,   120,    85,    86,    87,
+      88,    36,    37,    43,   190,   192,   129,   130,   131,   123,
+     126,   127,   128,   132,   133,   145,   134,   138,   146,   147,
+     148,   150,   152,   153,   202,   203,   156,   157,   158,   163,
+     172,   169,   171,   209,   173,   175,   174,   184,   187,   212,
+     188,   191,   217,   204,   193,   194,   211,   213,   214,   195,
+     201,   218,   219,   222,   220,   225,   231,   230,   234,   235,
+     239,   236,   237,   238,   240,   242,   119,   206,   241,   216,
+     186,   224,   233,   177,   185
 };
 
-#define yypact_value_is_default(yystate) \
-  ((yystate) == (-121))
-
-#define yytable_value_is_error(yytable_value) \
-  YYID (0)
-
-static const yytype_int16 yycheck[] =
+static const yytype_uint8 yycheck[] =
 {
-       5,     5,   122,    12,     9,     9,    85,     4,    37,    88,
+       5,     5,   122,    12,     9,     9,    85,    79,    37,    88,
       16,    10,    17,     7,    33,    42,     4,    79,    12,    79,
-      14,     0,    79,    85,     3,     4,    25,     6,     7,     9,
-      57,    11,    59,    79,    13,    79,    12,    34,    17,    36,
-      49,    85,    12,    47,    62,    63,    34,    79,    53,    53,
-      79,    45,    46,    32,    48,    88,    85,    53,    42,    88,
-      87,    80,    81,    82,    43,    49,    80,    82,    44,    63,
-      79,    85,    66,    49,    80,    55,    75,    56,    64,    49,
-      79,    80,    76,    79,    80,    81,    65,    66,    79,    68,
-      94,    95,   212,    72,    87,   133,    69,    76,    77,    12,
-     138,    57,    15,    79,    80,    81,    95,    85,   112,    79,
-      80,    81,    80,    26,    27,   109,    59,    30,    61,     5,
-     124,   125,    54,   112,    60,    59,    79,    61,   132,    44,
-     134,    74,    60,    48,    47,    80,    81,    80,    81,    82,
-      74,    79,    80,   132,    87,   134,    79,    80,    80,    81,
-      18,    19,    20,    87,    67,    28,    29,    70,    80,    81,
-      82,    21,    22,    23,   168,   170,    87,    85,    85,    80,
-      19,    85,    46,    35,    46,     5,    35,    79,    86,    45,
-      58,    85,    80,   187,   188,    24,    73,    14,    31,    37,
-      37,   195,    85,    85,    79,    71,    67,   201,    44,    80,
-     205,    85,    85,    85,    79,    38,    85,    24,    40,    24,
-      80,    39,    41,    21,    52,    24,    85,    39,    85,    64,
-      85,    85,    73,    39,    85,    79,   191,   158,   157,   204,
-     222,   214,    -1,    -1,   150
+      14,     0,    42,    85,     3,     4,    25,     6,     7,    49,
+      57,    79,    59,    79,    13,     4,    12,     9,    17,    11,
+      49,    79,    12,    47,    62,    63,    34,    85,    53,    53,
+      79,    45,    46,    32,    48,    88,    85,    29,    54,    88,
+      87,    80,    81,    82,    43,    34,    80,    36,    44,    63,
+      79,    85,    66,    49,    80,    82,    75,    56,    64,    49,
+      79,    80,    76,    55,    80,    81,    65,    66,    44,    68,
+      94,    95,    48,    72,   214,    79,   133,    76,    77,    12,
+      87,   138,    15,    79,    80,    81,    95,    69,   112,    79,
+      80,    81,    85,    26,    27,   109,    59,    30,    61,    80,
+     124,   125,    53,   112,    57,    59,     5,    61,   132,    79,
+     134,    74,    80,    81,    47,    79,    80,    80,    81,    82,
+      74,    79,    80,   132,    87,   134,    28,    29,    79,    80,
+      81,    60,    60,    87,    67,    87,    85,    70,    18,    19,
+      20,    80,    81,    82,   168,   170,    21,    22,    23,    85,
+      80,    85,    19,    46,    46,     5,    35,    35,    79,    86,
+      45,    58,    85,    80,   188,   189,    24,    73,    14,    31,
+      79,    37,    37,   197,    85,    71,    67,    85,    85,   203,
+      44,    85,   207,    38,    85,    80,    80,    85,    40,    79,
+      79,    24,    24,    41,    39,    52,    21,    85,    24,    85,
+      39,    64,    85,    85,    73,    39,    79,   192,    85,   206,
+     158,   216,   224,   150,   157
 };
 
-/* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-   symbol of state STATE-NUM.  */
-static const yytype_uint8 yystos[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
        0,    90,     0,     3,     4,     6,     7,    13,    17,    32,
       43,    56,    65,    66,    68,    72,    76,    77,    91,    92,
@@ -1008,103 +1157,86 @@ static const yytype_uint8 yystos[] =
       58,   109,    85,    80,   103,   105,    24,    73,    14,    85,
       88,   111,   111,    31,   103,   103,   105,   106,   105,    37,
      106,    37,    79,    85,    67,    71,   119,   121,     9,    11,
-      55,   108,   120,    85,   123,   108,    85,    44,    54,   103,
-      85,   104,    85,    80,    10,    25,    75,    79,    80,    79,
-     103,   103,    38,   112,   112,    53,    79,   103,   107,    80,
-     103,    85,    40,   113,   113,   104,    24,    24,    39,   111,
-      41,   114,   114,    52,    79,    85,    79,    85,    85,    21,
-     115,   115,    24,    85,    64,    85,    85,    39,    73,    85,
-      39
+      29,    55,   108,   120,    85,   123,   108,    85,    44,    54,
+     103,    85,   104,    85,    80,    79,    10,    25,    75,    79,
+      80,    79,   103,   103,    38,   112,   112,    53,    79,   103,
+     107,    80,   103,    85,    40,   113,   113,   104,    24,    24,
+      39,   111,    41,   114,   114,    52,    79,    85,    79,    85,
+      85,    21,   115,   115,    24,    85,    64,    85,    85,    39,
+      73,    85,    39
 };
 
-#define yyerrok		(yyerrstatus = 0)
-#define yyclearin	(yychar = YYEMPTY)
-#define YYEMPTY		(-2)
-#define YYEOF		0
-
-#define YYACCEPT	goto yyacceptlab
-#define YYABORT		goto yyabortlab
-#define YYERROR		goto yyerrorlab
-
-
-/* Like YYERROR except do call yyerror.  This remains here temporarily
-   to ease the transition to the new meaning of YYERROR, for GCC.
-   Once GCC version 2 has supplanted version 1, this can go.  However,
-   YYFAIL appears to be in use.  Nevertheless, it is formally deprecated
-   in Bison 2.4.2's NEWS entry, where a plan to phase it out is
-   discussed.  */
-
-#define YYFAIL		goto yyerrlab
-#if defined YYFAIL
-  /* This is here to suppress warnings from the GCC cpp's
-     -Wunused-macros.  Normally we don't worry about that warning, but
-     some users do, and we want to make it easy for users to remove
-     YYFAIL uses, which will produce warnings from Bison 2.5.  */
-#endif
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
+{
+       0,    89,    90,    90,    90,    90,    90,    90,    90,    90,
+      90,    90,    90,    90,    90,    91,    92,    93,    93,    93,
+      93,    94,    94,    95,    95,    95,    96,    97,    97,    97,
+      97,    97,    97,    97,    97,    97,    97,    98,    98,    98,
+      98,    98,    98,    98,    98,    98,    99,    99,   100,   100,
+     100,   100,   100,   100,   100,   100,   100,   101,   101,   102,
+     102,   102,   103,   103,   104,   105,   106,   107,   107,   108,
+     108,   108,   108,   108,   108,   108,   108,   108,   108,   109,
+     109,   109,   109,   110,   110,   111,   111,   112,   112,   113,
+     113,   114,   114,   114,   115,   115,   116,   116,   116,   116,
+     117,   117,   117,   117,   117,   117,   117,   118,   118,   119,
+     119,   120,   120,   120,   121,   121,   121,   121,   121,   121,
+     122,   123,   123
+};
 
-#define YYRECOVERING()  (!!yyerrstatus)
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
+{
+       0,     2,     0,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     4,     2,     2,     2,     2,
+       2,     2,     5,     6,     6,     5,     6,     3,     3,     4,
+       4,     4,     6,     3,     5,     5,     7,     6,     4,     4,
+       4,     5,     5,     4,     4,     6,     3,     3,     3,     5,
+      10,     8,     4,     4,     5,    10,     4,     1,     2,     2,
+       2,     2,     1,     1,     1,     3,     3,     3,     5,     2,
+       2,     3,     3,     5,     5,     5,     1,     1,     2,     1,
+       1,     1,     1,     1,     1,     1,     1,     0,     3,     0,
+       2,     0,     3,     2,     0,     7,     4,     4,     4,     5,
+       2,     3,     3,     2,     3,     3,     3,     0,     1,     0,
+       1,     0,     1,     2,     4,     4,     4,     2,     1,     1,
+       4,     4,     1
+};
 
-#define YYBACKUP(Token, Value)					\
-do								\
-  if (yychar == YYEMPTY && yylen == 1)				\
-    {								\
-      yychar = (Token);						\
-      yylval = (Value);						\
-      YYPOPSTACK (1);						\
-      goto yybackup;						\
-    }								\
-  else								\
-    {								\
-      yyerror (YY_("syntax error: cannot back up")); \
-      YYERROR;							\
-    }								\
-while (YYID (0))
-
-
-#define YYTERROR	1
-#define YYERRCODE	256
-
-
-/* YYLLOC_DEFAULT -- Set CURRENT to span from RHS[1] to RHS[N].
-   If N is 0, then set CURRENT to the empty location which ends
-   the previous symbol: RHS[0] (always defined).  */
-
-#define YYRHSLOC(Rhs, K) ((Rhs)[K])
-#ifndef YYLLOC_DEFAULT
-# define YYLLOC_DEFAULT(Current, Rhs, N)				\
-    do									\
-      if (YYID (N))                                                    \
-	{								\
-	  (Current).first_line   = YYRHSLOC (Rhs, 1).first_line;	\
-	  (Current).first_column = YYRHSLOC (Rhs, 1).first_column;	\
-	  (Current).last_line    = YYRHSLOC (Rhs, N).last_line;		\
-	  (Current).last_column  = YYRHSLOC (Rhs, N).last_column;	\
-	}								\
-      else								\
-	{								\
-	  (Current).first_line   = (Current).last_line   =		\
-	    YYRHSLOC (Rhs, 0).last_line;				\
-	  (Current).first_column = (Current).last_column =		\
-	    YYRHSLOC (Rhs, 0).last_column;				\
-	}								\
-    while (YYID (0))
-#endif
 
+enum { YYENOMEM = -2 };
 
-/* This macro is provided for backward compatibility. */
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
 
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
-/* YYLEX -- calling `yylex' with the right arguments.  */
+#define YYRECOVERING()  (!!yyerrstatus)
+
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
-#ifdef YYLEX_PARAM
-# define YYLEX yylex (YYLEX_PARAM)
-#else
-# define YYLEX yylex ()
-#endif
 
 /* Enable debugging if requested.  */
 #if YYDEBUG
@@ -1114,80 +1246,58 @@ while (YYID (0))
 #  define YYFPRINTF fprintf
 # endif
 
-# define YYDPRINTF(Args)			\
-do {						\
-  if (yydebug)					\
-    YYFPRINTF Args;				\
-} while (YYID (0))
-
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)			  \
-do {									  \
-  if (yydebug)								  \
-    {									  \
-      YYFPRINTF (stderr, "%s ", Title);					  \
-      yy_symbol_print (stderr,						  \
-		  Type, Value); \
-      YYFPRINTF (stderr, "\n");						  \
-    }									  \
-} while (YYID (0))
-
-
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
-
-/*ARGSUSED*/
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep)
-#else
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
+} while (0)
+
+
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
+} while (0)
+
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
 static void
-yy_symbol_value_print (yyoutput, yytype, yyvaluep)
-    FILE *yyoutput;
-    int yytype;
-    YYSTYPE const * const yyvaluep;
-#endif
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
 {
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyoutput, yytoknum[yytype], *yyvaluep);
-# else
-  YYUSE (yyoutput);
-# endif
-  switch (yytype)
-    {
-      default:
-	break;
-    }
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
 
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep)
-#else
 static void
-yy_symbol_print (yyoutput, yytype, yyvaluep)
-    FILE *yyoutput;
-    int yytype;
-    YYSTYPE const * const yyvaluep;
-#endif
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
 {
-  if (yytype < YYNTOKENS)
-    YYFPRINTF (yyoutput, "token %s (", yytname[yytype]);
-  else
-    YYFPRINTF (yyoutput, "nterm %s (", yytname[yytype]);
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep);
-  YYFPRINTF (yyoutput, ")");
+  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  YYFPRINTF (yyo, ")");
 }
 
 /*------------------------------------------------------------------.
@@ -1195,16 +1305,8 @@ yy_symbol_print (yyoutput, yytype, yyvaluep)
 | TOP (included).                                                   |
 `------------------------------------------------------------------*/
 
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static void
-yy_stack_print (yytype_int16 *yybottom, yytype_int16 *yytop)
-#else
 static void
-yy_stack_print (yybottom, yytop)
-    yytype_int16 *yybottom;
-    yytype_int16 *yytop;
-#endif
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
   for (; yybottom <= yytop; yybottom++)
@@ -1215,63 +1317,56 @@ yy_stack_print (yybottom, yytop)
   YYFPRINTF (stderr, "\n");
 }
 
-# define YY_STACK_PRINT(Bottom, Top)				\
-do {								\
-  if (yydebug)							\
-    yy_stack_print ((Bottom), (Top));				\
-} while (YYID (0))
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
+} while (0)
 
 
 /*------------------------------------------------.
 | Report that the YYRULE is going to be reduced.  |
 `------------------------------------------------*/
 
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
 static void
-yy_reduce_print (YYSTYPE *yyvsp, int yyrule)
-#else
-static void
-yy_reduce_print (yyvsp, yyrule)
-    YYSTYPE *yyvsp;
-    int yyrule;
-#endif
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule)
 {
+  int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
   int yyi;
-  unsigned long int yylno = yyrline[yyrule];
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %lu):\n",
-	     yyrule - 1, yylno);
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
+             yyrule - 1, yylno);
   /* The symbols being reduced.  */
   for (yyi = 0; yyi < yynrhs; yyi++)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
-      yy_symbol_print (stderr, yyrhs[yyprhs[yyrule] + yyi],
-		       &(yyvsp[(yyi + 1) - (yynrhs)])
-		       		       );
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)]);
       YYFPRINTF (stderr, "\n");
     }
 }
 
-# define YY_REDUCE_PRINT(Rule)		\
-do {					\
-  if (yydebug)				\
-    yy_reduce_print (yyvsp, Rule); \
-} while (YYID (0))
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule); \
+} while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
 
 
 /* YYINITDEPTH -- initial size of the parser's stacks.  */
-#ifndef	YYINITDEPTH
+#ifndef YYINITDEPTH
 # define YYINITDEPTH 200
 #endif
 
@@ -1287,365 +1382,77 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
-
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen strlen
-#  else
-/* Return the length of YYSTR.  */
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static YYSIZE_T
-yystrlen (const char *yystr)
-#else
-static YYSIZE_T
-yystrlen (yystr)
-    const char *yystr;
-#endif
-{
-  YYSIZE_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
-
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-#else
-static char *
-yystpcpy (yydest, yysrc)
-    char *yydest;
-    const char *yysrc;
-#endif
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
-
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
-
-  return yyd - 1;
-}
-#  endif
-# endif
-
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYSIZE_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYSIZE_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-	switch (*++yyp)
-	  {
-	  case '\'':
-	  case ',':
-	    goto do_not_strip_quotes;
-
-	  case '\\':
-	    if (*++yyp != '\\')
-	      goto do_not_strip_quotes;
-	    /* Fall through.  */
-	  default:
-	    if (yyres)
-	      yyres[yyn] = *yyp;
-	    yyn++;
-	    break;
-
-	  case '"':
-	    if (yyres)
-	      yyres[yyn] = '\0';
-	    return yyn;
-	  }
-    do_not_strip_quotes: ;
-    }
-
-  if (! yyres)
-    return yystrlen (yystr);
-
-  return yystpcpy (yyres, yystr) - yyres;
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
-                yytype_int16 *yyssp, int yytoken)
-{
-  YYSIZE_T yysize0 = yytnamerr (0, yytname[yytoken]);
-  YYSIZE_T yysize = yysize0;
-  YYSIZE_T yysize1;
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = 0;
-  /* Arguments of yyformat. */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Number of reported tokens (one for the "unexpected", one per
-     "expected"). */
-  int yycount = 0;
-
-  /* There are many possibilities here to consider:
-     - Assume YYFAIL is not used.  It's too flawed to consider.  See
-       <http://lists.gnu.org/archive/html/bison-patches/2009-12/msg00024.html>
-       for details.  YYERROR is fine as it does not invoke this
-       function.
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[*yyssp];
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                yysize1 = yysize + yytnamerr (0, yytname[yyx]);
-                if (! (yysize <= yysize1
-                       && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-                  return 2;
-                yysize = yysize1;
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
 
-  yysize1 = yysize + yystrlen (yyformat);
-  if (! (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-    return 2;
-  yysize = yysize1;
 
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
 
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          yyp++;
-          yyformat++;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
-/*ARGSUSED*/
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep)
-#else
 static void
-yydestruct (yymsg, yytype, yyvaluep)
-    const char *yymsg;
-    int yytype;
-    YYSTYPE *yyvaluep;
-#endif
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
 {
-  YYUSE (yyvaluep);
-
+  YY_USE (yyvaluep);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
-  switch (yytype)
-    {
-
-      default:
-	break;
-    }
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-/* Prevent warnings from -Wmissing-prototypes.  */
-#ifdef YYPARSE_PARAM
-#if defined __STDC__ || defined __cplusplus
-int yyparse (void *YYPARSE_PARAM);
-#else
-int yyparse ();
-#endif
-#else /* ! YYPARSE_PARAM */
-#if defined __STDC__ || defined __cplusplus
-int yyparse (void);
-#else
-int yyparse ();
-#endif
-#endif /* ! YYPARSE_PARAM */
-
-
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 /* The semantic value of the lookahead symbol.  */
 YYSTYPE yylval;
-
 /* Number of syntax errors so far.  */
 int yynerrs;
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
 
-#ifdef YYPARSE_PARAM
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-int
-yyparse (void *YYPARSE_PARAM)
-#else
-int
-yyparse (YYPARSE_PARAM)
-    void *YYPARSE_PARAM;
-#endif
-#else /* ! YYPARSE_PARAM */
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
 int
 yyparse (void)
-#else
-int
-yyparse ()
-
-#endif
-#endif
 {
-    int yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
-
-    /* The stacks and their tools:
-       `yyss': related to states.
-       `yyvs': related to semantic values.
+    int yyerrstatus = 0;
 
-       Refer to the stacks thru separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
-    yytype_int16 yyssa[YYINITDEPTH];
-    yytype_int16 *yyss;
-    yytype_int16 *yyssp;
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
 
-    /* The semantic value stack.  */
-    YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    YYSIZE_T yystacksize;
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYSIZE_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1653,111 +1460,107 @@ yyparse ()
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yytoken = 0;
-  yyss = yyssa;
-  yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
 
-  /* Initialize stack pointers.
-     Waste one element of value and location stack
-     so that they stay on the same level as the state stack.
-     The wasted elements are never initialized.  */
-  yyssp = yyss;
-  yyvsp = yyvs;
-
   goto yysetstate;
 
+
 /*------------------------------------------------------------.
-| yynewstate -- Push a new state, which is found in yystate.  |
+| yynewstate -- push a new state, which is found in yystate.  |
 `------------------------------------------------------------*/
- yynewstate:
+yynewstate:
   /* In all cases, when you get here, the value and location stacks
      have just been pushed.  So pushing a state here evens the stacks.  */
   yyssp++;
 
- yysetstate:
-  *yyssp = yystate;
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = yyssp - yyss + 1;
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
-#ifdef yyoverflow
+# if defined yyoverflow
       {
-	/* Give user a chance to reallocate the stack.  Use copies of
-	   these so that the &'s don't force the real ones into
-	   memory.  */
-	YYSTYPE *yyvs1 = yyvs;
-	yytype_int16 *yyss1 = yyss;
-
-	/* Each stack pointer address is followed by the size of the
-	   data in use in that stack, in bytes.  This used to be a
-	   conditional around just the two extra args, but that might
-	   be undefined if yyoverflow is a macro.  */
-	yyoverflow (YY_("memory exhausted"),
-		    &yyss1, yysize * sizeof (*yyssp),
-		    &yyvs1, yysize * sizeof (*yyvsp),
-		    &yystacksize);
-
-	yyss = yyss1;
-	yyvs = yyvs1;
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
       }
-#else /* no yyoverflow */
-# ifndef YYSTACK_RELOCATE
-      goto yyexhaustedlab;
-# else
+# else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-	goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
-	yystacksize = YYMAXDEPTH;
+        yystacksize = YYMAXDEPTH;
 
       {
-	yytype_int16 *yyss1 = yyss;
-	union yyalloc *yyptr =
-	  (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
-	if (! yyptr)
-	  goto yyexhaustedlab;
-	YYSTACK_RELOCATE (yyss_alloc, yyss);
-	YYSTACK_RELOCATE (yyvs_alloc, yyvs);
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
 #  undef YYSTACK_RELOCATE
-	if (yyss1 != yyssa)
-	  YYSTACK_FREE (yyss1);
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
       }
 # endif
-#endif /* no yyoverflow */
 
       yyssp = yyss + yysize - 1;
       yyvsp = yyvs + yysize - 1;
 
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-		  (unsigned long int) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
-	YYABORT;
+        YYABORT;
     }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
-  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
 
   if (yystate == YYFINAL)
     YYACCEPT;
 
   goto yybackup;
 
+
 /*-----------.
 | yybackup.  |
 `-----------*/
 yybackup:
-
   /* Do appropriate processing given the current state.  Read a
      lookahead token if we need one and don't already have one.  */
 
@@ -1768,18 +1571,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
-      yychar = YYLEX;
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex ();
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1807,13 +1621,13 @@ yybackup:
 
   /* Shift the lookahead token.  */
   YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
-
-  /* Discard the shifted token.  */
-  yychar = YYEMPTY;
-
   yystate = yyn;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
   goto yynewstate;
 
 
@@ -1828,14 +1642,14 @@ yydefault:
 
 
 /*-----------------------------.
-| yyreduce -- Do a reduction.  |
+| yyreduce -- do a reduction.  |
 `-----------------------------*/
 yyreduce:
   /* yyn is the number of a rule to reduce with.  */
   yylen = yyr2[yyn];
 
   /* If YYLEN is nonzero, implement the default value of the action:
-     `$$ = $1'.
+     '$$ = $1'.
 
      Otherwise, the following line sets YYVAL to garbage.
      This behavior is undocumented and Bison
@@ -1848,205 +1662,190 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-        case 15:
-
-/* Line 1806 of yacc.c  */
+  case 15: /* randomipv6mode: RANDOMIPVS FLOAT template LONG  */
 #line 188 "parse.y"
-    {
-		enable_ipv6_random_mode((yyvsp[(2) - (4)].floatp),(yyvsp[(4) - (4)].longvalue));
+        {
+		enable_ipv6_random_mode((yyvsp[-2].floatp),(yyvsp[0].longvalue));
 		char *default_template = RANDOM_IPV6_DEFAULT_TEMPLATE;
-		if (template_clone(default_template, (yyvsp[(3) - (4)].tmpl), NULL, 1) == NULL) {
+		if (template_clone(default_template, (yyvsp[-1].tmpl), NULL, 1) == NULL) {
 			break;
 		}	
 	}
+#line 1675 "parse.c"
     break;
 
-  case 16:
-
-/* Line 1806 of yacc.c  */
+  case 16: /* randomexclude: RANDOMEXCLUDE ip6addr  */
 #line 198 "parse.y"
-    {
-		exclude_addr_from_generator(addr_ntoa(&(yyvsp[(2) - (2)].addr)));
+        {
+		exclude_addr_from_generator(addr_ntoa(&(yyvsp[0].addr)));
 	}
+#line 1683 "parse.c"
     break;
 
-  case 17:
-
-/* Line 1806 of yacc.c  */
+  case 17: /* creation: CREATE STRING  */
 #line 204 "parse.y"
-    {
-		if (template_create((yyvsp[(2) - (2)].string)) == NULL)
-			yyerror("Template \"%s\" exists already", (yyvsp[(2) - (2)].string));
-		free((yyvsp[(2) - (2)].string));
+        {
+		if (template_create((yyvsp[0].string)) == NULL)
+			yyerror("Template \"%s\" exists already", (yyvsp[0].string));
+		free((yyvsp[0].string));
 	}
+#line 1693 "parse.c"
     break;
 
-  case 18:
-
-/* Line 1806 of yacc.c  */
+  case 18: /* creation: CREATE TEMPLATE  */
 #line 210 "parse.y"
-    {
+        {
 		if (template_create("template") == NULL)
 			yyerror("Template \"template\" exists already");
 	}
+#line 1702 "parse.c"
     break;
 
-  case 19:
-
-/* Line 1806 of yacc.c  */
+  case 19: /* creation: CREATE DEFAULT  */
 #line 215 "parse.y"
-    {
+        {
 		if (template_create("default") == NULL)
 			yyerror("Template \"default\" exists already");
 	}
+#line 1711 "parse.c"
     break;
 
-  case 20:
-
-/* Line 1806 of yacc.c  */
+  case 20: /* creation: DYNAMIC STRING  */
 #line 220 "parse.y"
-    {		
+        {		
 		struct template *tmpl;
-		if ((tmpl = template_create((yyvsp[(2) - (2)].string))) == NULL)
-			yyerror("Template \"%s\" exists already", (yyvsp[(2) - (2)].string));
+		if ((tmpl = template_create((yyvsp[0].string))) == NULL)
+			yyerror("Template \"%s\" exists already", (yyvsp[0].string));
 		tmpl->flags |= TEMPLATE_DYNAMIC;
-		free((yyvsp[(2) - (2)].string));
+		free((yyvsp[0].string));
 	}
+#line 1723 "parse.c"
     break;
 
-  case 21:
-
-/* Line 1806 of yacc.c  */
+  case 21: /* delete: DELETE template  */
 #line 230 "parse.y"
-    {
-		if ((yyvsp[(2) - (2)].tmpl) != NULL)
-			template_free((yyvsp[(2) - (2)].tmpl));
+        {
+		if ((yyvsp[0].tmpl) != NULL)
+			template_free((yyvsp[0].tmpl));
 	}
+#line 1732 "parse.c"
     break;
 
-  case 22:
-
-/* Line 1806 of yacc.c  */
+  case 22: /* delete: DELETE template PROTO PORT NUMBER  */
 #line 235 "parse.y"
-    {
+        {
 		struct port *port;
-		if ((port = port_find((yyvsp[(2) - (5)].tmpl), (yyvsp[(3) - (5)].number), (yyvsp[(5) - (5)].number))) == NULL) {
+		if ((port = port_find((yyvsp[-3].tmpl), (yyvsp[-2].number), (yyvsp[0].number))) == NULL) {
 			yyerror("Cannot find port %d in \"%s\"",
-			    (yyvsp[(5) - (5)].number), (yyvsp[(2) - (5)].tmpl)->name);
+			    (yyvsp[0].number), (yyvsp[-3].tmpl)->name);
 		} else {
-			port_free((yyvsp[(2) - (5)].tmpl), port);
+			port_free((yyvsp[-3].tmpl), port);
 		}
 	}
+#line 1746 "parse.c"
     break;
 
-  case 23:
-
-/* Line 1806 of yacc.c  */
+  case 23: /* addition: ADD template PROTO PORT NUMBER action  */
 #line 246 "parse.y"
-    {
+        {
 		struct action *action;
-		if ((yyvsp[(2) - (6)].tmpl) == NULL) {
+		if ((yyvsp[-4].tmpl) == NULL) {
 			yyerror("No template");
 			break;
 		}
 		
-		if ((action = honeyd_protocol((yyvsp[(2) - (6)].tmpl), (yyvsp[(3) - (6)].number))) == NULL) {
+		if ((action = honeyd_protocol((yyvsp[-4].tmpl), (yyvsp[-3].number))) == NULL) {
 			yyerror("Bad protocol");
 			break;
 		}
-		if ((yyvsp[(2) - (6)].tmpl) != NULL && template_add((yyvsp[(2) - (6)].tmpl), (yyvsp[(3) - (6)].number), (yyvsp[(5) - (6)].number), &(yyvsp[(6) - (6)].action)) == -1)
+		if ((yyvsp[-4].tmpl) != NULL && template_add((yyvsp[-4].tmpl), (yyvsp[-3].number), (yyvsp[-1].number), &(yyvsp[0].action)) == -1)
 			yyerror("Cannot add port %d to template \"%s\"",
-			    (yyvsp[(5) - (6)].number), (yyvsp[(2) - (6)].tmpl) != NULL ? (yyvsp[(2) - (6)].tmpl)->name : "<unknown>");
-		if ((yyvsp[(6) - (6)].action).action)
-			free((yyvsp[(6) - (6)].action).action);
+			    (yyvsp[-1].number), (yyvsp[-4].tmpl) != NULL ? (yyvsp[-4].tmpl)->name : "<unknown>");
+		if ((yyvsp[0].action).action)
+			free((yyvsp[0].action).action);
 	}
+#line 1768 "parse.c"
     break;
 
-  case 24:
-
-/* Line 1806 of yacc.c  */
+  case 24: /* addition: ADD template USE template IF condition  */
 #line 264 "parse.y"
-    {	
-		if ((yyvsp[(2) - (6)].tmpl) == NULL || (yyvsp[(4) - (6)].tmpl) == NULL)
+        {	
+		if ((yyvsp[-4].tmpl) == NULL || (yyvsp[-2].tmpl) == NULL)
 			break;
-		if (!((yyvsp[(2) - (6)].tmpl)->flags & TEMPLATE_DYNAMIC))
-			yyerror("Cannot add templates to non-dynamic template \"%s\"", (yyvsp[(2) - (6)].tmpl)->name);
-		template_insert_dynamic((yyvsp[(2) - (6)].tmpl), (yyvsp[(4) - (6)].tmpl), &(yyvsp[(6) - (6)].condition));
+		if (!((yyvsp[-4].tmpl)->flags & TEMPLATE_DYNAMIC))
+			yyerror("Cannot add templates to non-dynamic template \"%s\"", (yyvsp[-4].tmpl)->name);
+		template_insert_dynamic((yyvsp[-4].tmpl), (yyvsp[-2].tmpl), &(yyvsp[0].condition));
 	}
+#line 1780 "parse.c"
     break;
 
-  case 25:
-
-/* Line 1806 of yacc.c  */
+  case 25: /* addition: ADD template OTHERWISE USE template  */
 #line 272 "parse.y"
-    {	
-		if ((yyvsp[(2) - (5)].tmpl) == NULL || (yyvsp[(5) - (5)].tmpl) == NULL)
+        {	
+		if ((yyvsp[-3].tmpl) == NULL || (yyvsp[0].tmpl) == NULL)
 			break;
-		if (!((yyvsp[(2) - (5)].tmpl)->flags & TEMPLATE_DYNAMIC))
-			yyerror("Cannot add templates to non-dynamic template \"%s\"", (yyvsp[(2) - (5)].tmpl)->name);
-		template_insert_dynamic((yyvsp[(2) - (5)].tmpl), (yyvsp[(5) - (5)].tmpl), NULL);
+		if (!((yyvsp[-3].tmpl)->flags & TEMPLATE_DYNAMIC))
+			yyerror("Cannot add templates to non-dynamic template \"%s\"", (yyvsp[-3].tmpl)->name);
+		template_insert_dynamic((yyvsp[-3].tmpl), (yyvsp[0].tmpl), NULL);
 	}
+#line 1792 "parse.c"
     break;
 
-  case 26:
-
-/* Line 1806 of yacc.c  */
+  case 26: /* subsystem: ADD template SUBSYSTEM CMDSTRING shared restart  */
 #line 281 "parse.y"
-    {
+        {
 		int flags = 0;
 
-		if ((yyvsp[(5) - (6)].number))
+		if ((yyvsp[-1].number))
 			flags |= SUBSYSTEM_SHARED;		
-		if ((yyvsp[(6) - (6)].number))
+		if ((yyvsp[0].number))
 			flags |= SUBSYSTEM_RESTART;		
 
-		(yyvsp[(4) - (6)].string)[strlen((yyvsp[(4) - (6)].string)) - 1] = '\0';
-		if ((yyvsp[(2) - (6)].tmpl) != NULL &&
-		    template_subsystem((yyvsp[(2) - (6)].tmpl), (yyvsp[(4) - (6)].string)+1, flags) == -1)
+		(yyvsp[-2].string)[strlen((yyvsp[-2].string)) - 1] = '\0';
+		if ((yyvsp[-4].tmpl) != NULL &&
+		    template_subsystem((yyvsp[-4].tmpl), (yyvsp[-2].string)+1, flags) == -1)
 			yyerror("Can not add subsystem \"%s\" to template \"%s\"",
-			    (yyvsp[(4) - (6)].string)+1, (yyvsp[(2) - (6)].tmpl) != NULL ? (yyvsp[(2) - (6)].tmpl)->name : "<unknown>");
-		free((yyvsp[(4) - (6)].string));
+			    (yyvsp[-2].string)+1, (yyvsp[-4].tmpl) != NULL ? (yyvsp[-4].tmpl)->name : "<unknown>");
+		free((yyvsp[-2].string));
 	}
+#line 1812 "parse.c"
     break;
 
-  case 27:
-
-/* Line 1806 of yacc.c  */
+  case 27: /* binding: BIND ipaddr template  */
 #line 298 "parse.y"
-    {
+        {
 		/* Bind to an IP address and start subsystems */
-		if ((yyvsp[(3) - (3)].tmpl) == NULL) {
+		if ((yyvsp[0].tmpl) == NULL) {
 			yyerror("Unknown template");
 			break;
 		}
 
-		if ((yyvsp[(3) - (3)].tmpl)->ethernet_addr != NULL) {
+		if ((yyvsp[0].tmpl)->ethernet_addr != NULL) {
 			struct interface *inter;
-			inter = interface_find_responsible(&(yyvsp[(2) - (3)].addr));
+			inter = interface_find_responsible(&(yyvsp[-1].addr));
 			if (inter == NULL ||
 			    inter->if_ent.intf_link_addr.addr_type != ADDR_TYPE_ETH) {
 				yyerror("Template \"%s\" is configured with "
 				    "ethernet address but there is no "
 				    "interface that can reach %s",
-				    (yyvsp[(3) - (3)].tmpl)->name, addr_ntoa(&(yyvsp[(2) - (3)].addr)));
+				    (yyvsp[0].tmpl)->name, addr_ntoa(&(yyvsp[-1].addr)));
 				break;
 			}
 		}
 
-		if (template_clone(addr_ntoa(&(yyvsp[(2) - (3)].addr)), (yyvsp[(3) - (3)].tmpl), NULL, 1) == NULL) {
-			yyerror("Binding to %s failed", addr_ntoa(&(yyvsp[(2) - (3)].addr)));
+		if (template_clone(addr_ntoa(&(yyvsp[-1].addr)), (yyvsp[0].tmpl), NULL, 1) == NULL) {
+			yyerror("Binding to %s failed", addr_ntoa(&(yyvsp[-1].addr)));
 			break;
 		}
 	}
+#line 1842 "parse.c"
     break;
 
-  case 28:
-
-/* Line 1806 of yacc.c  */
+  case 28: /* binding: BIND ip6addr template  */
 #line 324 "parse.y"
-    {
+        {
 		/* if template is invalid then break */
-		if((yyvsp[(3) - (3)].tmpl) == NULL){
+		if((yyvsp[0].tmpl) == NULL){
 			yyerror("Unknown template");
 			break;
 		}
@@ -2054,31 +1853,30 @@ yyreduce:
 		/* TODO: check if there is an interface that able to handle the passed ip address */
 		
 		/* add the template */
-		if (template_clone(addr_ntoa(&(yyvsp[(2) - (3)].addr)), (yyvsp[(3) - (3)].tmpl), NULL, 1) == NULL) {
-			yyerror("Binding of ipv6 address  to %s failed", addr_ntoa(&(yyvsp[(2) - (3)].addr)));
+		if (template_clone(addr_ntoa(&(yyvsp[-1].addr)), (yyvsp[0].tmpl), NULL, 1) == NULL) {
+			yyerror("Binding of ipv6 address  to %s failed", addr_ntoa(&(yyvsp[-1].addr)));
 			break;
 		}	
 	
 	}
+#line 1863 "parse.c"
     break;
 
-  case 29:
-
-/* Line 1806 of yacc.c  */
+  case 29: /* binding: BIND condition ipaddr template  */
 #line 342 "parse.y"
-    {
+        {
 		struct template *tmpl;
 
 		/* Special magic */
-		if ((tmpl = template_find(addr_ntoa(&(yyvsp[(3) - (4)].addr)))) != NULL) {
+		if ((tmpl = template_find(addr_ntoa(&(yyvsp[-1].addr)))) != NULL) {
 			if (!(tmpl->flags & TEMPLATE_DYNAMIC)) {
 				yyerror("Template \"%s\" already specified as "
-				    "non-dynamic template", addr_ntoa(&(yyvsp[(3) - (4)].addr)));
+				    "non-dynamic template", addr_ntoa(&(yyvsp[-1].addr)));
 				break;
 			}
-		} else if ((tmpl = template_create(addr_ntoa(&(yyvsp[(3) - (4)].addr)))) == NULL) {
+		} else if ((tmpl = template_create(addr_ntoa(&(yyvsp[-1].addr)))) == NULL) {
 			yyerror("Could not create template \"%s\"",
-			    addr_ntoa(&(yyvsp[(3) - (4)].addr)));
+			    addr_ntoa(&(yyvsp[-1].addr)));
 			break;
 		}
 		tmpl->flags |= TEMPLATE_DYNAMIC;
@@ -2087,332 +1885,311 @@ yyreduce:
 		 * Add this point we do have the right template.
 		 * We just need to add the proper condition.
 		 */
-		template_insert_dynamic(tmpl, (yyvsp[(4) - (4)].tmpl), &(yyvsp[(2) - (4)].condition));
+		template_insert_dynamic(tmpl, (yyvsp[0].tmpl), &(yyvsp[-2].condition));
 	}
+#line 1891 "parse.c"
     break;
 
-  case 30:
-
-/* Line 1806 of yacc.c  */
+  case 30: /* binding: BIND ipaddr TO STRING  */
 #line 366 "parse.y"
-    {
+        {
 		struct interface *inter;
 		struct template *tmpl;
 
 		/* Bind an IP address to an external interface */
-		if ((inter = interface_find((yyvsp[(4) - (4)].string))) == NULL) {
-			yyerror("Interface \"%s\" does not exist.", (yyvsp[(4) - (4)].string));
-			free((yyvsp[(4) - (4)].string));
+		if ((inter = interface_find((yyvsp[0].string))) == NULL) {
+			yyerror("Interface \"%s\" does not exist.", (yyvsp[0].string));
+			free((yyvsp[0].string));
 			break;
 		}
 		if (inter->if_ent.intf_link_addr.addr_type != ADDR_TYPE_ETH) {
-			yyerror("Interface \"%s\" does not support ARP.", (yyvsp[(4) - (4)].string));
-			free((yyvsp[(4) - (4)].string));
+			yyerror("Interface \"%s\" does not support ARP.", (yyvsp[0].string));
+			free((yyvsp[0].string));
 			break;
 		}
 
-		if ((tmpl = template_create(addr_ntoa(&(yyvsp[(2) - (4)].addr)))) == NULL) {
+		if ((tmpl = template_create(addr_ntoa(&(yyvsp[-2].addr)))) == NULL) {
 			yyerror("Template \"%s\" exists already",
-			    addr_ntoa(&(yyvsp[(2) - (4)].addr)));
+			    addr_ntoa(&(yyvsp[-2].addr)));
 			break;
 		}
 
 		/* Make this template external. */
 		tmpl->flags |= TEMPLATE_EXTERNAL;
 		tmpl->inter = inter;
-		free((yyvsp[(4) - (4)].string));
+		free((yyvsp[0].string));
 	}
+#line 1923 "parse.c"
     break;
 
-  case 31:
-
-/* Line 1806 of yacc.c  */
+  case 31: /* binding: DHCP template ON STRING  */
 #line 394 "parse.y"
-    {		
+        {		
 		/* Automagically assign DHCP address */
-		dhcp_template((yyvsp[(2) - (4)].tmpl), (yyvsp[(4) - (4)].string), NULL);
-		free((yyvsp[(4) - (4)].string));
+		dhcp_template((yyvsp[-2].tmpl), (yyvsp[0].string), NULL);
+		free((yyvsp[0].string));
 	}
+#line 1933 "parse.c"
     break;
 
-  case 32:
-
-/* Line 1806 of yacc.c  */
+  case 32: /* binding: DHCP template ON STRING ETHERNET CMDSTRING  */
 #line 400 "parse.y"
-    {		
+        {		
 		/* Automagically assign DHCP address with MAC address */
-		(yyvsp[(6) - (6)].string)[strlen((yyvsp[(6) - (6)].string)) - 1] = '\0';
-		dhcp_template((yyvsp[(2) - (6)].tmpl), (yyvsp[(4) - (6)].string), (yyvsp[(6) - (6)].string) + 1);
-		free((yyvsp[(4) - (6)].string));
-		free((yyvsp[(6) - (6)].string));
+		(yyvsp[0].string)[strlen((yyvsp[0].string)) - 1] = '\0';
+		dhcp_template((yyvsp[-4].tmpl), (yyvsp[-2].string), (yyvsp[0].string) + 1);
+		free((yyvsp[-2].string));
+		free((yyvsp[0].string));
 	}
+#line 1945 "parse.c"
     break;
 
-  case 33:
-
-/* Line 1806 of yacc.c  */
+  case 33: /* binding: CLONE STRING template  */
 #line 408 "parse.y"
-    {
+        {
 		/* Just clone.  This is not the final destination yet */
-		if ((yyvsp[(3) - (3)].tmpl) == NULL || template_clone((yyvsp[(2) - (3)].string), (yyvsp[(3) - (3)].tmpl), NULL, 0) == NULL)
-			yyerror("Cloning to %s failed", (yyvsp[(2) - (3)].string));
-		free((yyvsp[(2) - (3)].string));
+		if ((yyvsp[0].tmpl) == NULL || template_clone((yyvsp[-1].string), (yyvsp[0].tmpl), NULL, 0) == NULL)
+			yyerror("Cloning to %s failed", (yyvsp[-1].string));
+		free((yyvsp[-1].string));
 	}
+#line 1956 "parse.c"
     break;
 
-  case 34:
-
-/* Line 1806 of yacc.c  */
+  case 34: /* binding: SET template SPOOF FROM ipaddr  */
 #line 415 "parse.y"
-    {
-		if ((yyvsp[(2) - (5)].tmpl) == NULL) {
+        {
+		if ((yyvsp[-3].tmpl) == NULL) {
 			yyerror("No template");
 			break;
 		}
-		(yyvsp[(2) - (5)].tmpl)->spoof.new_src = (yyvsp[(5) - (5)].addr);
+		(yyvsp[-3].tmpl)->spoof.new_src = (yyvsp[0].addr);
 	}
+#line 1968 "parse.c"
     break;
 
-  case 35:
-
-/* Line 1806 of yacc.c  */
+  case 35: /* binding: SET template SPOOF TO ipaddr  */
 #line 423 "parse.y"
-    {
-		if ((yyvsp[(2) - (5)].tmpl) == NULL) {
+        {
+		if ((yyvsp[-3].tmpl) == NULL) {
 			yyerror("No template");
 			break;
 		}
-		(yyvsp[(2) - (5)].tmpl)->spoof.new_dst = (yyvsp[(5) - (5)].addr);
+		(yyvsp[-3].tmpl)->spoof.new_dst = (yyvsp[0].addr);
 	}
+#line 1980 "parse.c"
     break;
 
-  case 36:
-
-/* Line 1806 of yacc.c  */
+  case 36: /* binding: SET template SPOOF FROM ipaddr TO ipaddr  */
 #line 431 "parse.y"
-    {
-		if ((yyvsp[(2) - (7)].tmpl) == NULL) {
+        {
+		if ((yyvsp[-5].tmpl) == NULL) {
 			yyerror("No template");
 			break;
 		}
-		(yyvsp[(2) - (7)].tmpl)->spoof.new_src = (yyvsp[(5) - (7)].addr);
-		(yyvsp[(2) - (7)].tmpl)->spoof.new_dst = (yyvsp[(7) - (7)].addr);
+		(yyvsp[-5].tmpl)->spoof.new_src = (yyvsp[-2].addr);
+		(yyvsp[-5].tmpl)->spoof.new_dst = (yyvsp[0].addr);
 	}
+#line 1993 "parse.c"
     break;
 
-  case 37:
-
-/* Line 1806 of yacc.c  */
+  case 37: /* set: SET template DEFAULT PROTO ACTION action  */
 #line 441 "parse.y"
-    {
+        {
 		struct action *action;
-		if ((yyvsp[(2) - (6)].tmpl) == NULL) {
+		if ((yyvsp[-4].tmpl) == NULL) {
 			yyerror("No template");
 			break;
 		}
 		
-		if ((action = honeyd_protocol((yyvsp[(2) - (6)].tmpl), (yyvsp[(4) - (6)].number))) == NULL) {
+		if ((action = honeyd_protocol((yyvsp[-4].tmpl), (yyvsp[-2].number))) == NULL) {
 			yyerror("Bad protocol");
 			break;
 		}
 
-		port_action_clone(action, &(yyvsp[(6) - (6)].action));
-		if ((yyvsp[(6) - (6)].action).action != NULL)
-			free((yyvsp[(6) - (6)].action).action);
+		port_action_clone(action, &(yyvsp[0].action));
+		if ((yyvsp[0].action).action != NULL)
+			free((yyvsp[0].action).action);
 	}
+#line 2014 "parse.c"
     break;
 
-  case 38:
-
-/* Line 1806 of yacc.c  */
+  case 38: /* set: SET template PERSONALITY personality  */
 #line 458 "parse.y"
-    {
-		if ((yyvsp[(2) - (4)].tmpl) == NULL || (yyvsp[(4) - (4)].pers) == NULL)
+        {
+		if ((yyvsp[-2].tmpl) == NULL || (yyvsp[0].pers) == NULL)
 			break;
-		if((yyvsp[(4) - (4)].pers)->person4 != NULL)
-			(yyvsp[(2) - (4)].tmpl)->person = personality_clone((yyvsp[(4) - (4)].pers)->person4);
-		if((yyvsp[(4) - (4)].pers)->person6 != NULL)
-			(yyvsp[(2) - (4)].tmpl)->person6 = personality_clone((yyvsp[(4) - (4)].pers)->person6);	
+		if((yyvsp[0].pers)->person4 != NULL)
+			(yyvsp[-2].tmpl)->person = personality_clone((yyvsp[0].pers)->person4);
+		if((yyvsp[0].pers)->person6 != NULL)
+			(yyvsp[-2].tmpl)->person6 = personality_clone((yyvsp[0].pers)->person6);	
 	
 		
 	}
+#line 2029 "parse.c"
     break;
 
-  case 39:
-
-/* Line 1806 of yacc.c  */
+  case 39: /* set: SET template ETHERNET CMDSTRING  */
 #line 469 "parse.y"
-    {
+        {
 		extern int need_arp;
-		if ((yyvsp[(2) - (4)].tmpl) == NULL || (yyvsp[(4) - (4)].string) == NULL)
+		if ((yyvsp[-2].tmpl) == NULL || (yyvsp[0].string) == NULL)
 			break;
-		(yyvsp[(4) - (4)].string)[strlen((yyvsp[(4) - (4)].string)) - 1] = '\0';
-		(yyvsp[(2) - (4)].tmpl)->ethernet_addr = ethernetcode_make_address((yyvsp[(4) - (4)].string) + 1);
-		if ((yyvsp[(2) - (4)].tmpl)->ethernet_addr == NULL) {
-			yyerror("Unknown ethernet vendor \"%s\"", (yyvsp[(4) - (4)].string) + 1);
+		(yyvsp[0].string)[strlen((yyvsp[0].string)) - 1] = '\0';
+		(yyvsp[-2].tmpl)->ethernet_addr = ethernetcode_make_address((yyvsp[0].string) + 1);
+		if ((yyvsp[-2].tmpl)->ethernet_addr == NULL) {
+			yyerror("Unknown ethernet vendor \"%s\"", (yyvsp[0].string) + 1);
 		}
-		free ((yyvsp[(4) - (4)].string));
+		free ((yyvsp[0].string));
 
 		need_arp = 1;
 	}
+#line 2047 "parse.c"
     break;
 
-  case 40:
-
-/* Line 1806 of yacc.c  */
+  case 40: /* set: SET template UPTIME NUMBER  */
 #line 483 "parse.y"
-    {
-		if ((yyvsp[(2) - (4)].tmpl) == NULL || (yyvsp[(4) - (4)].number) == 0)
+        {
+		if ((yyvsp[-2].tmpl) == NULL || (yyvsp[0].number) == 0)
 			break;
-		(yyvsp[(2) - (4)].tmpl)->timestamp = (yyvsp[(4) - (4)].number) * 2;
+		(yyvsp[-2].tmpl)->timestamp = (yyvsp[0].number) * 2;
 	}
+#line 2057 "parse.c"
     break;
 
-  case 41:
-
-/* Line 1806 of yacc.c  */
+  case 41: /* set: SET template DROPRATE IN rate  */
 #line 489 "parse.y"
-    {
-		if ((yyvsp[(2) - (5)].tmpl) == NULL)
+        {
+		if ((yyvsp[-3].tmpl) == NULL)
 			break;
-		if ((yyvsp[(5) - (5)].floatp) > 100) {
-			yyerror("Droprate too high: %f", (yyvsp[(5) - (5)].floatp));
+		if ((yyvsp[0].floatp) > 100) {
+			yyerror("Droprate too high: %f", (yyvsp[0].floatp));
 			break;
 		}
 
-		(yyvsp[(2) - (5)].tmpl)->drop_inrate = (yyvsp[(5) - (5)].floatp) * 100;
+		(yyvsp[-3].tmpl)->drop_inrate = (yyvsp[0].floatp) * 100;
 	}
+#line 2072 "parse.c"
     break;
 
-  case 42:
-
-/* Line 1806 of yacc.c  */
+  case 42: /* set: SET template DROPRATE SYN rate  */
 #line 500 "parse.y"
-    {
-		if ((yyvsp[(2) - (5)].tmpl) == NULL)
+        {
+		if ((yyvsp[-3].tmpl) == NULL)
 			break;
-		if ((yyvsp[(5) - (5)].floatp) > 100) {
-			yyerror("Droprate too high: %f", (yyvsp[(5) - (5)].floatp));
+		if ((yyvsp[0].floatp) > 100) {
+			yyerror("Droprate too high: %f", (yyvsp[0].floatp));
 			break;
 		}
 
-		(yyvsp[(2) - (5)].tmpl)->drop_synrate = (yyvsp[(5) - (5)].floatp) * 100;
+		(yyvsp[-3].tmpl)->drop_synrate = (yyvsp[0].floatp) * 100;
 	}
+#line 2087 "parse.c"
     break;
 
-  case 43:
-
-/* Line 1806 of yacc.c  */
+  case 43: /* set: SET template MAXFDS NUMBER  */
 #line 511 "parse.y"
-    {
-		if ((yyvsp[(2) - (4)].tmpl) == NULL)
+        {
+		if ((yyvsp[-2].tmpl) == NULL)
 			break;
-		if ((yyvsp[(4) - (4)].number) <= 3) {
-			yyerror("Bad number of max file descriptors %d", (yyvsp[(4) - (4)].number));
+		if ((yyvsp[0].number) <= 3) {
+			yyerror("Bad number of max file descriptors %d", (yyvsp[0].number));
 			break;
 		}
-		(yyvsp[(2) - (4)].tmpl)->max_nofiles = (yyvsp[(4) - (4)].number);
+		(yyvsp[-2].tmpl)->max_nofiles = (yyvsp[0].number);
 	}
+#line 2101 "parse.c"
     break;
 
-  case 44:
-
-/* Line 1806 of yacc.c  */
+  case 44: /* set: SET template UID NUMBER  */
 #line 521 "parse.y"
-    {
-		if ((yyvsp[(2) - (4)].tmpl) == NULL)
+        {
+		if ((yyvsp[-2].tmpl) == NULL)
 			break;
-		if (!(yyvsp[(4) - (4)].number)) {
-			yyerror("Bad uid %d", (yyvsp[(4) - (4)].number));
+		if (!(yyvsp[0].number)) {
+			yyerror("Bad uid %d", (yyvsp[0].number));
 			break;
 		}
-		(yyvsp[(2) - (4)].tmpl)->uid = (yyvsp[(4) - (4)].number);
-		honeyd_use_uid((yyvsp[(4) - (4)].number));
+		(yyvsp[-2].tmpl)->uid = (yyvsp[0].number);
+		honeyd_use_uid((yyvsp[0].number));
 	}
+#line 2116 "parse.c"
     break;
 
-  case 45:
-
-/* Line 1806 of yacc.c  */
+  case 45: /* set: SET template UID NUMBER GID NUMBER  */
 #line 532 "parse.y"
-    {
-		if ((yyvsp[(2) - (6)].tmpl) == NULL)
+        {
+		if ((yyvsp[-4].tmpl) == NULL)
 			break;
-		if (!(yyvsp[(4) - (6)].number) || !(yyvsp[(6) - (6)].number)) {
-			yyerror("Bad uid %d, gid %d", (yyvsp[(4) - (6)].number), (yyvsp[(6) - (6)].number));
+		if (!(yyvsp[-2].number) || !(yyvsp[0].number)) {
+			yyerror("Bad uid %d, gid %d", (yyvsp[-2].number), (yyvsp[0].number));
 			break;
 		}
-		(yyvsp[(2) - (6)].tmpl)->uid = (yyvsp[(4) - (6)].number);
-		(yyvsp[(2) - (6)].tmpl)->gid = (yyvsp[(6) - (6)].number);
-		honeyd_use_uid((yyvsp[(4) - (6)].number));
-		honeyd_use_gid((yyvsp[(6) - (6)].number));
+		(yyvsp[-4].tmpl)->uid = (yyvsp[-2].number);
+		(yyvsp[-4].tmpl)->gid = (yyvsp[0].number);
+		honeyd_use_uid((yyvsp[-2].number));
+		honeyd_use_gid((yyvsp[0].number));
 	}
+#line 2133 "parse.c"
     break;
 
-  case 46:
-
-/* Line 1806 of yacc.c  */
+  case 46: /* annotate: ANNOTATE personality finscan  */
 #line 546 "parse.y"
-    {
-		if ((yyvsp[(2) - (3)].pers) == NULL)
+        {
+		if ((yyvsp[-1].pers) == NULL)
 			break;
-		(yyvsp[(2) - (3)].pers)->person4->disallow_finscan = !(yyvsp[(3) - (3)].number);
+		(yyvsp[-1].pers)->person4->disallow_finscan = !(yyvsp[0].number);
 	}
+#line 2143 "parse.c"
     break;
 
-  case 47:
-
-/* Line 1806 of yacc.c  */
+  case 47: /* annotate: ANNOTATE personality fragment  */
 #line 552 "parse.y"
-    {
-		if ((yyvsp[(2) - (3)].pers) == NULL)
+        {
+		if ((yyvsp[-1].pers) == NULL)
 			break;
-		(yyvsp[(2) - (3)].pers)->person4->fragp = (yyvsp[(3) - (3)].fragp);
+		(yyvsp[-1].pers)->person4->fragp = (yyvsp[0].fragp);
 	}
+#line 2153 "parse.c"
     break;
 
-  case 48:
-
-/* Line 1806 of yacc.c  */
+  case 48: /* route: ROUTE ENTRY ipaddr  */
 #line 559 "parse.y"
-    {
-		if (router_start(&(yyvsp[(3) - (3)].addr), NULL) == -1)
+        {
+		if (router_start(&(yyvsp[0].addr), NULL) == -1)
 			yyerror("Defining entry point failed: %s",
-			    addr_ntoa(&(yyvsp[(3) - (3)].addr)));
+			    addr_ntoa(&(yyvsp[0].addr)));
 	}
+#line 2163 "parse.c"
     break;
 
-  case 49:
-
-/* Line 1806 of yacc.c  */
+  case 49: /* route: ROUTE ENTRY ipaddr NETWORK ipnet  */
 #line 565 "parse.y"
-    {
-		if (router_start(&(yyvsp[(3) - (5)].addr), &(yyvsp[(5) - (5)].addr)) == -1)
+        {
+		if (router_start(&(yyvsp[-2].addr), &(yyvsp[0].addr)) == -1)
 			yyerror("Defining entry point failed: %s",
-			    addr_ntoa(&(yyvsp[(3) - (5)].addr)));
+			    addr_ntoa(&(yyvsp[-2].addr)));
 	}
+#line 2173 "parse.c"
     break;
 
-  case 50:
-
-/* Line 1806 of yacc.c  */
+  case 50: /* route: ROUTE ipaddr ADD NET ipnet ipaddr latency packetloss bandwidth randomearlydrop  */
 #line 571 "parse.y"
-    {
+        {
 		struct router *r, *newr;
 		struct addr defroute;
 
-		if ((r = router_find(&(yyvsp[(2) - (10)].addr))) == NULL &&
-		    (r = router_new(&(yyvsp[(2) - (10)].addr))) == NULL) {
+		if ((r = router_find(&(yyvsp[-8].addr))) == NULL &&
+		    (r = router_new(&(yyvsp[-8].addr))) == NULL) {
 			yyerror("Cannot make forward reference for router %s",
-			    addr_ntoa(&(yyvsp[(2) - (10)].addr)));
+			    addr_ntoa(&(yyvsp[-8].addr)));
 			break;
 		}
-		if ((newr = router_find(&(yyvsp[(6) - (10)].addr))) == NULL)
-			newr = router_new(&(yyvsp[(6) - (10)].addr));
-		if (router_add_net(r, &(yyvsp[(5) - (10)].addr), newr, (yyvsp[(7) - (10)].number), (yyvsp[(8) - (10)].number), (yyvsp[(9) - (10)].number), &(yyvsp[(10) - (10)].drop)) == -1)
-			yyerror("Could not add route to %s", addr_ntoa(&(yyvsp[(5) - (10)].addr)));
+		if ((newr = router_find(&(yyvsp[-4].addr))) == NULL)
+			newr = router_new(&(yyvsp[-4].addr));
+		if (router_add_net(r, &(yyvsp[-5].addr), newr, (yyvsp[-3].number), (yyvsp[-2].number), (yyvsp[-1].number), &(yyvsp[0].drop)) == -1)
+			yyerror("Could not add route to %s", addr_ntoa(&(yyvsp[-5].addr)));
 
-		if ((yyvsp[(9) - (10)].number) == 0 && (yyvsp[(10) - (10)].drop).high != 0)
+		if ((yyvsp[-1].number) == 0 && (yyvsp[0].drop).high != 0)
 			yywarn("Ignoring drop between statement without "
 			       "specified bandwidth.");
 
@@ -2422,100 +2199,95 @@ yyreduce:
 		/* Only insert a reverse route, if the current route is
 		 * not the default route.
 		 */
-		if (addr_cmp(&defroute, &(yyvsp[(5) - (10)].addr)) != 0 &&
-		    router_add_net(newr, &defroute, r, (yyvsp[(7) - (10)].number), (yyvsp[(8) - (10)].number), (yyvsp[(9) - (10)].number), &(yyvsp[(10) - (10)].drop)) == -1)
+		if (addr_cmp(&defroute, &(yyvsp[-5].addr)) != 0 &&
+		    router_add_net(newr, &defroute, r, (yyvsp[-3].number), (yyvsp[-2].number), (yyvsp[-1].number), &(yyvsp[0].drop)) == -1)
 			yyerror("Could not add default route to %s",
-			    addr_ntoa(&(yyvsp[(5) - (10)].addr)));
+			    addr_ntoa(&(yyvsp[-5].addr)));
 	}
+#line 2208 "parse.c"
     break;
 
-  case 51:
-
-/* Line 1806 of yacc.c  */
+  case 51: /* route: ROUTE ipaddr ADD NET ipnet TUNNEL ipaddr ipaddr  */
 #line 602 "parse.y"
-    {
+        {
 		struct router *r;
 
-		if ((r = router_find(&(yyvsp[(2) - (8)].addr))) == NULL &&
-		    (r = router_new(&(yyvsp[(2) - (8)].addr))) == NULL) {
+		if ((r = router_find(&(yyvsp[-6].addr))) == NULL &&
+		    (r = router_new(&(yyvsp[-6].addr))) == NULL) {
 			yyerror("Cannot make forward reference for router %s",
-			    addr_ntoa(&(yyvsp[(2) - (8)].addr)));
+			    addr_ntoa(&(yyvsp[-6].addr)));
 			break;
 		}
-		if (router_add_tunnel(r, &(yyvsp[(5) - (8)].addr), &(yyvsp[(7) - (8)].addr), &(yyvsp[(8) - (8)].addr)) == -1)
-			yyerror("Could not add tunnel to %s", addr_ntoa(&(yyvsp[(8) - (8)].addr)));
+		if (router_add_tunnel(r, &(yyvsp[-3].addr), &(yyvsp[-1].addr), &(yyvsp[0].addr)) == -1)
+			yyerror("Could not add tunnel to %s", addr_ntoa(&(yyvsp[0].addr)));
 	}
+#line 2225 "parse.c"
     break;
 
-  case 52:
-
-/* Line 1806 of yacc.c  */
+  case 52: /* route: ROUTE ipaddr LINK ipnet  */
 #line 615 "parse.y"
-    {
+        {
 		struct router *r;
 
-		if ((r = router_find(&(yyvsp[(2) - (4)].addr))) == NULL &&
-		    (r = router_new(&(yyvsp[(2) - (4)].addr))) == NULL) {
+		if ((r = router_find(&(yyvsp[-2].addr))) == NULL &&
+		    (r = router_new(&(yyvsp[-2].addr))) == NULL) {
 			yyerror("Cannot make forward reference for router %s",
-			    addr_ntoa(&(yyvsp[(2) - (4)].addr)));
+			    addr_ntoa(&(yyvsp[-2].addr)));
 			break;
 		}
-		if (router_add_link(r, &(yyvsp[(4) - (4)].addr)) == -1)
-			yyerror("Could not add link %s", addr_ntoa(&(yyvsp[(4) - (4)].addr)));
+		if (router_add_link(r, &(yyvsp[0].addr)) == -1)
+			yyerror("Could not add link %s", addr_ntoa(&(yyvsp[0].addr)));
 	}
+#line 2242 "parse.c"
     break;
 
-  case 53:
-
-/* Line 1806 of yacc.c  */
+  case 53: /* route: ROUTE ipaddr UNREACH ipnet  */
 #line 628 "parse.y"
-    {
+        {
 		struct router *r;
 
-		if ((r = router_find(&(yyvsp[(2) - (4)].addr))) == NULL &&
-		    (r = router_new(&(yyvsp[(2) - (4)].addr))) == NULL) {
+		if ((r = router_find(&(yyvsp[-2].addr))) == NULL &&
+		    (r = router_new(&(yyvsp[-2].addr))) == NULL) {
 			yyerror("Cannot make forward reference for router %s",
-			    addr_ntoa(&(yyvsp[(2) - (4)].addr)));
+			    addr_ntoa(&(yyvsp[-2].addr)));
 			break;
 		}
-		if (router_add_unreach(r, &(yyvsp[(4) - (4)].addr)) == -1)
+		if (router_add_unreach(r, &(yyvsp[0].addr)) == -1)
 			yyerror("Could not add unreachable net %s",
-			    addr_ntoa(&(yyvsp[(4) - (4)].addr)));
+			    addr_ntoa(&(yyvsp[0].addr)));
 	}
+#line 2260 "parse.c"
     break;
 
-  case 54:
-
-/* Line 1806 of yacc.c  */
+  case 54: /* route: ROUTE ENTRY ip6addr NETWORK ip6net  */
 #line 646 "parse.y"
-    {
-		syslog(LOG_DEBUG,"ipv6 entry router with %s for address space %s found",addr_ntoa(&(yyvsp[(3) - (5)].addr)),addr_ntoa(&(yyvsp[(5) - (5)].addr)));
-		if (router_start(&(yyvsp[(3) - (5)].addr), &(yyvsp[(5) - (5)].addr)) == -1)
+        {
+		syslog(LOG_DEBUG,"ipv6 entry router with %s for address space %s found",addr_ntoa(&(yyvsp[-2].addr)),addr_ntoa(&(yyvsp[0].addr)));
+		if (router_start(&(yyvsp[-2].addr), &(yyvsp[0].addr)) == -1)
 			yyerror("Defining entry point failed: %s",
-			    addr_ntoa(&(yyvsp[(3) - (5)].addr)));
+			    addr_ntoa(&(yyvsp[-2].addr)));
         }
+#line 2271 "parse.c"
     break;
 
-  case 55:
-
-/* Line 1806 of yacc.c  */
+  case 55: /* route: ROUTE ip6addr ADD NET ip6net ip6addr latency packetloss bandwidth randomearlydrop  */
 #line 653 "parse.y"
-    {
+        {
 		struct router *r, *newr;
 		struct addr defroute;
 
-		if ((r = router_find(&(yyvsp[(2) - (10)].addr))) == NULL &&
-		    (r = router_new(&(yyvsp[(2) - (10)].addr))) == NULL) {
+		if ((r = router_find(&(yyvsp[-8].addr))) == NULL &&
+		    (r = router_new(&(yyvsp[-8].addr))) == NULL) {
 			yyerror("Cannot make forward reference for router %s",
-			    addr_ntoa(&(yyvsp[(2) - (10)].addr)));
+			    addr_ntoa(&(yyvsp[-8].addr)));
 			break;
 		}
-		if ((newr = router_find(&(yyvsp[(6) - (10)].addr))) == NULL)
-			newr = router_new(&(yyvsp[(6) - (10)].addr));
-		if (router_add_net(r, &(yyvsp[(5) - (10)].addr), newr, (yyvsp[(7) - (10)].number), (yyvsp[(8) - (10)].number), (yyvsp[(9) - (10)].number), &(yyvsp[(10) - (10)].drop)) == -1)
-			yyerror("Could not add route to %s", addr_ntoa(&(yyvsp[(5) - (10)].addr)));
+		if ((newr = router_find(&(yyvsp[-4].addr))) == NULL)
+			newr = router_new(&(yyvsp[-4].addr));
+		if (router_add_net(r, &(yyvsp[-5].addr), newr, (yyvsp[-3].number), (yyvsp[-2].number), (yyvsp[-1].number), &(yyvsp[0].drop)) == -1)
+			yyerror("Could not add route to %s", addr_ntoa(&(yyvsp[-5].addr)));
 
-		if ((yyvsp[(9) - (10)].number) == 0 && (yyvsp[(10) - (10)].drop).high != 0)
+		if ((yyvsp[-1].number) == 0 && (yyvsp[0].drop).high != 0)
 			yywarn("Ignoring drop between statement without "
 			       "specified bandwidth.");
 
@@ -2525,82 +2297,74 @@ yyreduce:
 		/* Only insert a reverse route, if the current route is
 		 * not the default route.
 		 */
-		if (addr_cmp(&defroute, &(yyvsp[(5) - (10)].addr)) != 0 &&
-		    router_add_net(newr, &defroute, r, (yyvsp[(7) - (10)].number), (yyvsp[(8) - (10)].number), (yyvsp[(9) - (10)].number), &(yyvsp[(10) - (10)].drop)) == -1)
+		if (addr_cmp(&defroute, &(yyvsp[-5].addr)) != 0 &&
+		    router_add_net(newr, &defroute, r, (yyvsp[-3].number), (yyvsp[-2].number), (yyvsp[-1].number), &(yyvsp[0].drop)) == -1)
 			yyerror("Could not add default route to %s",
-			    addr_ntoa(&(yyvsp[(5) - (10)].addr)));
+			    addr_ntoa(&(yyvsp[-5].addr)));
         }
+#line 2306 "parse.c"
     break;
 
-  case 56:
-
-/* Line 1806 of yacc.c  */
+  case 56: /* route: ROUTE ip6addr LINK ip6net  */
 #line 687 "parse.y"
-    {
+        {
 		struct router *r;
 
-		if ((r = router_find(&(yyvsp[(2) - (4)].addr))) == NULL &&
-		    (r = router_new(&(yyvsp[(2) - (4)].addr))) == NULL) {
+		if ((r = router_find(&(yyvsp[-2].addr))) == NULL &&
+		    (r = router_new(&(yyvsp[-2].addr))) == NULL) {
 			yyerror("Cannot make forward reference for router %s",
-			    addr_ntoa(&(yyvsp[(2) - (4)].addr)));
+			    addr_ntoa(&(yyvsp[-2].addr)));
 			break;
 		}
-		if (router_add_link(r, &(yyvsp[(4) - (4)].addr)) == -1)
-			yyerror("Could not add link %s", addr_ntoa(&(yyvsp[(4) - (4)].addr)));
+		if (router_add_link(r, &(yyvsp[0].addr)) == -1)
+			yyerror("Could not add link %s", addr_ntoa(&(yyvsp[0].addr)));
         }
+#line 2323 "parse.c"
     break;
 
-  case 57:
-
-/* Line 1806 of yacc.c  */
+  case 57: /* finscan: FINSCAN  */
 #line 704 "parse.y"
-    { (yyval.number) = 1; }
+                                { (yyval.number) = 1; }
+#line 2329 "parse.c"
     break;
 
-  case 58:
-
-/* Line 1806 of yacc.c  */
+  case 58: /* finscan: NO FINSCAN  */
 #line 705 "parse.y"
-    { (yyval.number) = 0; }
+                                { (yyval.number) = 0; }
+#line 2335 "parse.c"
     break;
 
-  case 59:
-
-/* Line 1806 of yacc.c  */
+  case 59: /* fragment: FRAGMENT DROP  */
 #line 707 "parse.y"
-    { (yyval.fragp) = FRAG_DROP; }
+                                { (yyval.fragp) = FRAG_DROP; }
+#line 2341 "parse.c"
     break;
 
-  case 60:
-
-/* Line 1806 of yacc.c  */
+  case 60: /* fragment: FRAGMENT OLD  */
 #line 708 "parse.y"
-    { (yyval.fragp) = FRAG_OLD; }
+                                { (yyval.fragp) = FRAG_OLD; }
+#line 2347 "parse.c"
     break;
 
-  case 61:
-
-/* Line 1806 of yacc.c  */
+  case 61: /* fragment: FRAGMENT NEW  */
 #line 709 "parse.y"
-    { (yyval.fragp) = FRAG_NEW; }
+                                { (yyval.fragp) = FRAG_NEW; }
+#line 2353 "parse.c"
     break;
 
-  case 62:
-
-/* Line 1806 of yacc.c  */
+  case 62: /* ipaddr: IPSTRING  */
 #line 712 "parse.y"
-    {
-		if (addr_pton((yyvsp[(1) - (1)].string), &(yyval.addr)) < 0)
-			yyerror("Illegal IP address %s", (yyvsp[(1) - (1)].string));
-		free((yyvsp[(1) - (1)].string));
+        {
+		if (addr_pton((yyvsp[0].string), &(yyval.addr)) < 0)
+			yyerror("Illegal IP address %s", (yyvsp[0].string));
+		free((yyvsp[0].string));
 	}
+#line 2363 "parse.c"
     break;
 
-  case 63:
-
-/* Line 1806 of yacc.c  */
+  case 63: /* ipaddr: CMDSTRING  */
 #line 718 "parse.y"
-    {
+        {
 		struct addrinfo ai, *aitop;
 		memset(&ai, 0, sizeof (ai));
 		ai.ai_family = AF_INET;
@@ -2608,41 +2372,39 @@ yyreduce:
 		ai.ai_flags = 0;
 
 		/* Remove quotation marks */
-		(yyvsp[(1) - (1)].string)[strlen((yyvsp[(1) - (1)].string)) - 1] = '\0';
-		if (getaddrinfo((yyvsp[(1) - (1)].string)+1, NULL, &ai, &aitop) != 0) {
-			yyerror("getaddrinfo failed: %s", (yyvsp[(1) - (1)].string)+1);
+		(yyvsp[0].string)[strlen((yyvsp[0].string)) - 1] = '\0';
+		if (getaddrinfo((yyvsp[0].string)+1, NULL, &ai, &aitop) != 0) {
+			yyerror("getaddrinfo failed: %s", (yyvsp[0].string)+1);
 			break;
 		}
 		addr_ston(aitop->ai_addr, &(yyval.addr));
 		freeaddrinfo(aitop);
-		free((yyvsp[(1) - (1)].string));
+		free((yyvsp[0].string));
 	}
+#line 2385 "parse.c"
     break;
 
-  case 64:
-
-/* Line 1806 of yacc.c  */
+  case 64: /* ip6addr: IPSSTRING  */
 #line 737 "parse.y"
-    {
-		if(addr_pton((yyvsp[(1) - (1)].string),&(yyval.addr))<0)
-			yyerror("Illegal IPv6 address %s",(yyvsp[(1) - (1)].string));	
-		free((yyvsp[(1) - (1)].string));
+        {
+		if(addr_pton((yyvsp[0].string),&(yyval.addr))<0)
+			yyerror("Illegal IPv6 address %s",(yyvsp[0].string));	
+		free((yyvsp[0].string));
 	}
+#line 2395 "parse.c"
     break;
 
-  case 65:
-
-/* Line 1806 of yacc.c  */
+  case 65: /* ipnet: ipaddr SLASH NUMBER  */
 #line 744 "parse.y"
-    {
+        {
 		char src[25];
 		struct addr b;
 		snprintf(src, sizeof(src), "%s/%d",
-		    addr_ntoa(&(yyvsp[(1) - (3)].addr)), (yyvsp[(3) - (3)].number));
+		    addr_ntoa(&(yyvsp[-2].addr)), (yyvsp[0].number));
 		if (addr_pton(src, &(yyval.addr)) < 0)
 			yyerror("Illegal IP network %s", src);
 		/* Fix libdnet error */
-		if ((yyvsp[(3) - (3)].number) == 0)
+		if ((yyvsp[0].number) == 0)
 			(yyval.addr).addr_bits = 0;
 
 		/* Test if this is a legal network */
@@ -2653,21 +2415,20 @@ yyreduce:
 			yywarn("Bad network mask in %s", src);
 		}
 	}
+#line 2419 "parse.c"
     break;
 
-  case 66:
-
-/* Line 1806 of yacc.c  */
+  case 66: /* ip6net: ip6addr SLASH NUMBER  */
 #line 766 "parse.y"
-    {
+        {
 		char src[INET6_ADDRSTRLEN];
 		struct addr b;
 		snprintf(src, sizeof(src), "%s/%d",
-		    addr_ntoa(&(yyvsp[(1) - (3)].addr)), (yyvsp[(3) - (3)].number));
+		    addr_ntoa(&(yyvsp[-2].addr)), (yyvsp[0].number));
 		if (addr_pton(src, &(yyval.addr)) < 0)
 			yyerror("Illegal IPv6 network %s", src);
 		/* Fix libdnet error */
-		if ((yyvsp[(3) - (3)].number) == 0)
+		if ((yyvsp[0].number) == 0)
 			(yyval.addr).addr_bits = 0;
 
 		/* Test if this is a legal network */
@@ -2678,704 +2439,660 @@ yyreduce:
 			yywarn("Bad network mask in %s", src);
 		}
 	}
+#line 2443 "parse.c"
     break;
 
-  case 67:
-
-/* Line 1806 of yacc.c  */
+  case 67: /* ipaddrplusport: ipaddr COLON NUMBER  */
 #line 787 "parse.y"
-    {
+        {
 		if (curtype == -1) {
 			yyerror("Bad port type");
 			break;
 		}
-		(yyval.ai) = cmd_proxy_getinfo(addr_ntoa(&(yyvsp[(1) - (3)].addr)), curtype, (yyvsp[(3) - (3)].number));
+		(yyval.ai) = cmd_proxy_getinfo(addr_ntoa(&(yyvsp[-2].addr)), curtype, (yyvsp[0].number));
 		curtype = -1;
 		if ((yyval.ai) == NULL)
 			yyerror("Illegal IP address port pair");
 	}
+#line 2458 "parse.c"
     break;
 
-  case 68:
-
-/* Line 1806 of yacc.c  */
+  case 68: /* ipaddrplusport: LBRACKET ip6addr RBRACKET COLON NUMBER  */
 #line 798 "parse.y"
-    {
+        {
 		if (curtype == -1) {
 			yyerror("Bad port type");
 			break;
 		}
-		(yyval.ai) = cmd_proxy_getinfo(addr_ntoa(&(yyvsp[(2) - (5)].addr)), curtype, (yyvsp[(5) - (5)].number));
+		(yyval.ai) = cmd_proxy_getinfo(addr_ntoa(&(yyvsp[-3].addr)), curtype, (yyvsp[0].number));
 		curtype = -1;
 		if ((yyval.ai) == NULL)
 			yyerror("Illegal IP6 address port pair");
 	
 	}
+#line 2474 "parse.c"
     break;
 
-  case 69:
-
-/* Line 1806 of yacc.c  */
+  case 69: /* action: flags STRING  */
 #line 811 "parse.y"
-    {
+        {
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
-		(yyval.action).action = (yyvsp[(2) - (2)].string);
-		(yyval.action).flags = (yyvsp[(1) - (2)].number);
+		(yyval.action).action = (yyvsp[0].string);
+		(yyval.action).flags = (yyvsp[-1].number);
 		(yyval.action).status = PORT_OPEN;
 	}
+#line 2485 "parse.c"
     break;
 
-  case 70:
-
-/* Line 1806 of yacc.c  */
+  case 70: /* action: flags CMDSTRING  */
 #line 818 "parse.y"
-    {
+        {
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
-		(yyvsp[(2) - (2)].string)[strlen((yyvsp[(2) - (2)].string)) - 1] = '\0';
-		if (((yyval.action).action = strdup((yyvsp[(2) - (2)].string) + 1)) == NULL)
+		(yyvsp[0].string)[strlen((yyvsp[0].string)) - 1] = '\0';
+		if (((yyval.action).action = strdup((yyvsp[0].string) + 1)) == NULL)
 			yyerror("Out of memory");
 		(yyval.action).status = PORT_OPEN;
-		(yyval.action).flags = (yyvsp[(1) - (2)].number);
-		free((yyvsp[(2) - (2)].string));
+		(yyval.action).flags = (yyvsp[-1].number);
+		free((yyvsp[0].string));
 	}
+#line 2499 "parse.c"
     break;
 
-  case 71:
-
-/* Line 1806 of yacc.c  */
+  case 71: /* action: flags INTERNAL CMDSTRING  */
 #line 828 "parse.y"
-    {
+        {
 #ifdef HAVE_PYTHON
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
-		(yyvsp[(3) - (3)].string)[strlen((yyvsp[(3) - (3)].string)) - 1] = '\0';
-		if (((yyval.action).action_extend = pyextend_load_module((yyvsp[(3) - (3)].string)+1)) == NULL)
-			yyerror("Bad python module: \"%s\"", (yyvsp[(3) - (3)].string)+1);
+		(yyvsp[0].string)[strlen((yyvsp[0].string)) - 1] = '\0';
+		if (((yyval.action).action_extend = pyextend_load_module((yyvsp[0].string)+1)) == NULL)
+			yyerror("Bad python module: \"%s\"", (yyvsp[0].string)+1);
 		(yyval.action).status = PORT_PYTHON;
-		(yyval.action).flags = (yyvsp[(1) - (3)].number);
-		free((yyvsp[(3) - (3)].string));
+		(yyval.action).flags = (yyvsp[-2].number);
+		free((yyvsp[0].string));
 #else
 		yyerror("Python support is not available.");
 #endif
 	}
+#line 2517 "parse.c"
     break;
 
-  case 72:
-
-/* Line 1806 of yacc.c  */
+  case 72: /* action: flags PROXY ipaddrplusport  */
 #line 842 "parse.y"
-    {
+        {
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
 		(yyval.action).status = PORT_PROXY;
 		(yyval.action).action = NULL;
-		(yyval.action).aitop = (yyvsp[(3) - (3)].ai);
-		(yyval.action).flags = (yyvsp[(1) - (3)].number);
+		(yyval.action).aitop = (yyvsp[0].ai);
+		(yyval.action).flags = (yyvsp[-2].number);
 	}
+#line 2529 "parse.c"
     break;
 
-  case 73:
-
-/* Line 1806 of yacc.c  */
+  case 73: /* action: flags PROXY STRING COLON NUMBER  */
 #line 850 "parse.y"
-    {
+        {
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
 		(yyval.action).status = PORT_PROXY;
 		(yyval.action).action = NULL;
 		(yyval.action).aitop = NULL;
-		(yyval.action).flags = (yyvsp[(1) - (5)].number);
-		if ((yyvsp[(3) - (5)].string)[0] != '$') {
+		(yyval.action).flags = (yyvsp[-4].number);
+		if ((yyvsp[-2].string)[0] != '$') {
 			if (curtype == -1) {
 				yyerror("Bad port type");
 				break;
 			}
-			(yyval.action).aitop = cmd_proxy_getinfo((yyvsp[(3) - (5)].string), curtype, (yyvsp[(5) - (5)].number));
+			(yyval.action).aitop = cmd_proxy_getinfo((yyvsp[-2].string), curtype, (yyvsp[0].number));
 			curtype = -1;
 			if ((yyval.action).aitop == NULL)
 				yyerror("Illegal host name in proxy");
 		} else {
 			char proxy[1024];
 
-			snprintf(proxy, sizeof(proxy), "%s:%d", (yyvsp[(3) - (5)].string), (yyvsp[(5) - (5)].number));
+			snprintf(proxy, sizeof(proxy), "%s:%d", (yyvsp[-2].string), (yyvsp[0].number));
 			(yyval.action).action = strdup(proxy);
 			if ((yyval.action).action == NULL)
 				yyerror("Out of memory");
 		}
-		free((yyvsp[(3) - (5)].string));
+		free((yyvsp[-2].string));
 	}
+#line 2559 "parse.c"
     break;
 
-  case 74:
-
-/* Line 1806 of yacc.c  */
+  case 74: /* action: flags PROXY STRING COLON STRING  */
 #line 876 "parse.y"
-    {
+        {
 		char proxy[1024];
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
 		(yyval.action).status = PORT_PROXY;
 		(yyval.action).action = NULL;
 		(yyval.action).aitop = NULL;
-		(yyval.action).flags = (yyvsp[(1) - (5)].number);
+		(yyval.action).flags = (yyvsp[-4].number);
 
-		snprintf(proxy, sizeof(proxy), "%s:%s", (yyvsp[(3) - (5)].string), (yyvsp[(5) - (5)].string));
+		snprintf(proxy, sizeof(proxy), "%s:%s", (yyvsp[-2].string), (yyvsp[0].string));
 		(yyval.action).action = strdup(proxy);
 		if ((yyval.action).action == NULL)
 				yyerror("Out of memory");
-		free((yyvsp[(3) - (5)].string));
-		free((yyvsp[(5) - (5)].string));
+		free((yyvsp[-2].string));
+		free((yyvsp[0].string));
 	}
+#line 2579 "parse.c"
     break;
 
-  case 75:
-
-/* Line 1806 of yacc.c  */
+  case 75: /* action: flags PROXY ipaddr COLON STRING  */
 #line 892 "parse.y"
-    {
+        {
 		char proxy[1024];
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
 		(yyval.action).status = PORT_PROXY;
 		(yyval.action).action = NULL;
 		(yyval.action).aitop = NULL;
-		(yyval.action).flags = (yyvsp[(1) - (5)].number);
+		(yyval.action).flags = (yyvsp[-4].number);
 
-		snprintf(proxy, sizeof(proxy), "%s:%s", addr_ntoa(&(yyvsp[(3) - (5)].addr)), (yyvsp[(5) - (5)].string));
+		snprintf(proxy, sizeof(proxy), "%s:%s", addr_ntoa(&(yyvsp[-2].addr)), (yyvsp[0].string));
 		(yyval.action).action = strdup(proxy);
 		if ((yyval.action).action == NULL)
 				yyerror("Out of memory");
-		free((yyvsp[(5) - (5)].string));
+		free((yyvsp[0].string));
 	}
+#line 2598 "parse.c"
     break;
 
-  case 76:
-
-/* Line 1806 of yacc.c  */
+  case 76: /* action: BLOCK  */
 #line 907 "parse.y"
-    {
+        {
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
 		(yyval.action).status = PORT_BLOCK;
 		(yyval.action).action = NULL;
 	}
+#line 2608 "parse.c"
     break;
 
-  case 77:
-
-/* Line 1806 of yacc.c  */
+  case 77: /* action: RESET  */
 #line 913 "parse.y"
-    {
+        {
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
 		(yyval.action).status = PORT_RESET;
 		(yyval.action).action = NULL;
 	}
+#line 2618 "parse.c"
     break;
 
-  case 78:
-
-/* Line 1806 of yacc.c  */
+  case 78: /* action: flags OPEN  */
 #line 919 "parse.y"
-    {
+        {
 		memset(&(yyval.action), 0, sizeof((yyval.action)));
 		(yyval.action).status = PORT_OPEN;
 		(yyval.action).action = NULL;
-		(yyval.action).flags = (yyvsp[(1) - (2)].number);
+		(yyval.action).flags = (yyvsp[-1].number);
 	}
+#line 2629 "parse.c"
     break;
 
-  case 79:
-
-/* Line 1806 of yacc.c  */
+  case 79: /* template: STRING  */
 #line 928 "parse.y"
-    {
-		(yyval.tmpl) = template_find((yyvsp[(1) - (1)].string));
+        {
+		(yyval.tmpl) = template_find((yyvsp[0].string));
 		if ((yyval.tmpl) == NULL)
-			yyerror("Unknown template \"%s\"", (yyvsp[(1) - (1)].string));
-		free((yyvsp[(1) - (1)].string));
+			yyerror("Unknown template \"%s\"", (yyvsp[0].string));
+		free((yyvsp[0].string));
 	}
+#line 2640 "parse.c"
     break;
 
-  case 80:
-
-/* Line 1806 of yacc.c  */
+  case 80: /* template: TEMPLATE  */
 #line 935 "parse.y"
-    {
+        {
 		(yyval.tmpl) = template_find("template");
 		if ((yyval.tmpl) == NULL)
 			yyerror("Unknown template \"%s\"", "template");
 	}
+#line 2650 "parse.c"
     break;
 
-  case 81:
-
-/* Line 1806 of yacc.c  */
+  case 81: /* template: DEFAULT  */
 #line 941 "parse.y"
-    {
+        {
 		(yyval.tmpl) = template_find("default");
 		if ((yyval.tmpl) == NULL)
 			yyerror("Unknown template \"%s\"", "default");
 	}
+#line 2660 "parse.c"
     break;
 
-  case 82:
-
-/* Line 1806 of yacc.c  */
+  case 82: /* template: ipaddr  */
 #line 947 "parse.y"
-    {
-		(yyval.tmpl) = template_find(addr_ntoa(&(yyvsp[(1) - (1)].addr)));
+        {
+		(yyval.tmpl) = template_find(addr_ntoa(&(yyvsp[0].addr)));
 		if ((yyval.tmpl) == NULL)
-			yyerror("Unknown template \"%s\"", addr_ntoa(&(yyvsp[(1) - (1)].addr)));
+			yyerror("Unknown template \"%s\"", addr_ntoa(&(yyvsp[0].addr)));
 	}
+#line 2670 "parse.c"
     break;
 
-  case 83:
-
-/* Line 1806 of yacc.c  */
+  case 83: /* personality: CMDSTRING  */
 #line 954 "parse.y"
-    {
-		(yyvsp[(1) - (1)].string)[strlen((yyvsp[(1) - (1)].string)) - 1] = '\0';
+        {
+		(yyvsp[0].string)[strlen((yyvsp[0].string)) - 1] = '\0';
 		struct personality_set *person_set = malloc(sizeof(struct personality_set));
-		person_set->person4 = personality_find((yyvsp[(1) - (1)].string)+1);
-		person_set->person6 = personality_find6((yyvsp[(1) - (1)].string)+1);
+		person_set->person4 = personality_find((yyvsp[0].string)+1);
+		person_set->person6 = personality_find6((yyvsp[0].string)+1);
 		(yyval.pers) = person_set;
 		if ((yyval.pers)->person4 == NULL && (yyval.pers)->person6 == NULL)
-			yyerror("Unknown personality \"%s\"", (yyvsp[(1) - (1)].string)+1);
-		free((yyvsp[(1) - (1)].string));
+			yyerror("Unknown personality \"%s\"", (yyvsp[0].string)+1);
+		free((yyvsp[0].string));
 	}
+#line 2685 "parse.c"
     break;
 
-  case 84:
-
-/* Line 1806 of yacc.c  */
+  case 84: /* personality: RANDOM  */
 #line 965 "parse.y"
-    {
+        {
 		struct personality_set *person_set = malloc(sizeof(struct personality_set));
 		person_set->person4 = personality_random();
 		(yyval.pers) = person_set;	
 		if ((yyval.pers)->person4 == NULL)
 			yyerror("Random personality failed");
 	}
+#line 2697 "parse.c"
     break;
 
-  case 85:
-
-/* Line 1806 of yacc.c  */
+  case 85: /* rate: FLOAT  */
 #line 974 "parse.y"
-    {
-		(yyval.floatp) = (yyvsp[(1) - (1)].floatp);
+        {
+		(yyval.floatp) = (yyvsp[0].floatp);
 	}
+#line 2705 "parse.c"
     break;
 
-  case 86:
-
-/* Line 1806 of yacc.c  */
+  case 86: /* rate: NUMBER  */
 #line 978 "parse.y"
-    {
-		(yyval.floatp) = (yyvsp[(1) - (1)].number);
+        {
+		(yyval.floatp) = (yyvsp[0].number);
 	}
+#line 2713 "parse.c"
     break;
 
-  case 87:
-
-/* Line 1806 of yacc.c  */
+  case 87: /* latency: %empty  */
 #line 982 "parse.y"
-    { (yyval.number) = 0; }
+                              { (yyval.number) = 0; }
+#line 2719 "parse.c"
     break;
 
-  case 88:
-
-/* Line 1806 of yacc.c  */
+  case 88: /* latency: LATENCY NUMBER MS  */
 #line 984 "parse.y"
-    {
-		(yyval.number) = (yyvsp[(2) - (3)].number);
+        {
+		(yyval.number) = (yyvsp[-1].number);
 	}
+#line 2727 "parse.c"
     break;
 
-  case 89:
-
-/* Line 1806 of yacc.c  */
+  case 89: /* packetloss: %empty  */
 #line 988 "parse.y"
-    { (yyval.number) = 0; }
+                              { (yyval.number) = 0; }
+#line 2733 "parse.c"
     break;
 
-  case 90:
-
-/* Line 1806 of yacc.c  */
+  case 90: /* packetloss: LOSS rate  */
 #line 990 "parse.y"
-    {
-		(yyval.number) = (yyvsp[(2) - (2)].floatp) * 100;
+        {
+		(yyval.number) = (yyvsp[0].floatp) * 100;
 	}
+#line 2741 "parse.c"
     break;
 
-  case 91:
-
-/* Line 1806 of yacc.c  */
+  case 91: /* bandwidth: %empty  */
 #line 994 "parse.y"
-    { (yyval.number) = 0; }
+                              { (yyval.number) = 0; }
+#line 2747 "parse.c"
     break;
 
-  case 92:
-
-/* Line 1806 of yacc.c  */
+  case 92: /* bandwidth: BANDWIDTH NUMBER NUMBER  */
 #line 996 "parse.y"
-    {
-		(yyval.number) = (yyvsp[(2) - (3)].number) * (yyvsp[(3) - (3)].number);
+        {
+		(yyval.number) = (yyvsp[-1].number) * (yyvsp[0].number);
 	}
+#line 2755 "parse.c"
     break;
 
-  case 93:
-
-/* Line 1806 of yacc.c  */
+  case 93: /* bandwidth: BANDWIDTH NUMBER  */
 #line 1000 "parse.y"
-    {
-		(yyval.number) = (yyvsp[(2) - (2)].number);
+        {
+		(yyval.number) = (yyvsp[0].number);
 	}
+#line 2763 "parse.c"
     break;
 
-  case 94:
-
-/* Line 1806 of yacc.c  */
+  case 94: /* randomearlydrop: %empty  */
 #line 1004 "parse.y"
-    { memset(&(yyval.drop), 0, sizeof((yyval.drop))); }
+                              { memset(&(yyval.drop), 0, sizeof((yyval.drop))); }
+#line 2769 "parse.c"
     break;
 
-  case 95:
-
-/* Line 1806 of yacc.c  */
+  case 95: /* randomearlydrop: DROP BETWEEN NUMBER MS DASH NUMBER MS  */
 #line 1006 "parse.y"
-    {
-		if ((yyvsp[(6) - (7)].number) <= (yyvsp[(3) - (7)].number))
+        {
+		if ((yyvsp[-1].number) <= (yyvsp[-4].number))
 			yyerror("Incorrect thresholds. First number needs to "
 				"be smaller than second number.");
-		(yyval.drop).low = (yyvsp[(3) - (7)].number);
-		(yyval.drop).high = (yyvsp[(6) - (7)].number);
+		(yyval.drop).low = (yyvsp[-4].number);
+		(yyval.drop).high = (yyvsp[-1].number);
 	}
+#line 2781 "parse.c"
     break;
 
-  case 96:
-
-/* Line 1806 of yacc.c  */
+  case 96: /* option: OPTION STRING STRING NUMBER  */
 #line 1015 "parse.y"
-    {
+        {
 		struct honeyd_plugin_cfg cfg;
 
 		memset(&cfg, 0, sizeof(struct honeyd_plugin_cfg));
-		cfg.cfg_int = (yyvsp[(4) - (4)].number);
+		cfg.cfg_int = (yyvsp[0].number);
 		cfg.cfg_type = HD_CONFIG_INT;
-		plugins_config_item_add((yyvsp[(2) - (4)].string), (yyvsp[(3) - (4)].string), &cfg);
+		plugins_config_item_add((yyvsp[-2].string), (yyvsp[-1].string), &cfg);
 		
-		free((yyvsp[(2) - (4)].string)); free((yyvsp[(3) - (4)].string));
+		free((yyvsp[-2].string)); free((yyvsp[-1].string));
 	}
+#line 2796 "parse.c"
     break;
 
-  case 97:
-
-/* Line 1806 of yacc.c  */
+  case 97: /* option: OPTION STRING STRING FLOAT  */
 #line 1026 "parse.y"
-    {
+        {
 		struct honeyd_plugin_cfg cfg;
 
 		memset(&cfg, 0, sizeof(struct honeyd_plugin_cfg));
-		cfg.cfg_flt = (yyvsp[(4) - (4)].floatp);
+		cfg.cfg_flt = (yyvsp[0].floatp);
 		cfg.cfg_type = HD_CONFIG_FLT;
-		plugins_config_item_add((yyvsp[(2) - (4)].string), (yyvsp[(3) - (4)].string), &cfg);
+		plugins_config_item_add((yyvsp[-2].string), (yyvsp[-1].string), &cfg);
 
-		free((yyvsp[(2) - (4)].string)); free((yyvsp[(3) - (4)].string));
+		free((yyvsp[-2].string)); free((yyvsp[-1].string));
         }
+#line 2811 "parse.c"
     break;
 
-  case 98:
-
-/* Line 1806 of yacc.c  */
+  case 98: /* option: OPTION STRING STRING STRING  */
 #line 1037 "parse.y"
-    {
+        {
 		struct honeyd_plugin_cfg cfg;
 
 		memset(&cfg, 0, sizeof(struct honeyd_plugin_cfg));
-		cfg.cfg_str = (yyvsp[(4) - (4)].string);
+		cfg.cfg_str = (yyvsp[0].string);
 		cfg.cfg_type = HD_CONFIG_STR;
-		plugins_config_item_add((yyvsp[(2) - (4)].string), (yyvsp[(3) - (4)].string), &cfg);
+		plugins_config_item_add((yyvsp[-2].string), (yyvsp[-1].string), &cfg);
 
-		free((yyvsp[(2) - (4)].string)); free((yyvsp[(3) - (4)].string)); free((yyvsp[(4) - (4)].string));
+		free((yyvsp[-2].string)); free((yyvsp[-1].string)); free((yyvsp[0].string));
         }
+#line 2826 "parse.c"
     break;
 
-  case 99:
-
-/* Line 1806 of yacc.c  */
+  case 99: /* option: OPTION STRING STRING SLASH STRING  */
 #line 1049 "parse.y"
-    {
+        {
 		struct honeyd_plugin_cfg cfg;
 		char path[MAXPATHLEN];
 
-		snprintf(path, sizeof(path), "/%s", (yyvsp[(5) - (5)].string));
+		snprintf(path, sizeof(path), "/%s", (yyvsp[0].string));
 
 		memset(&cfg, 0, sizeof(struct honeyd_plugin_cfg));
 		cfg.cfg_str = path;
 		cfg.cfg_type = HD_CONFIG_STR;
-		plugins_config_item_add((yyvsp[(2) - (5)].string), (yyvsp[(3) - (5)].string), &cfg);
+		plugins_config_item_add((yyvsp[-3].string), (yyvsp[-2].string), &cfg);
 
-		free((yyvsp[(2) - (5)].string)); free((yyvsp[(3) - (5)].string)); free((yyvsp[(5) - (5)].string));
+		free((yyvsp[-3].string)); free((yyvsp[-2].string)); free((yyvsp[0].string));
         }
+#line 2844 "parse.c"
     break;
 
-  case 100:
-
-/* Line 1806 of yacc.c  */
+  case 100: /* ui: LIST TEMPLATE  */
 #line 1065 "parse.y"
-    {
+{
 	template_list_glob(buffer, "*");
 }
+#line 2852 "parse.c"
     break;
 
-  case 101:
-
-/* Line 1806 of yacc.c  */
+  case 101: /* ui: LIST TEMPLATE CMDSTRING  */
 #line 1069 "parse.y"
-    {
-	(yyvsp[(3) - (3)].string)[strlen((yyvsp[(3) - (3)].string))-1] = '\0';
+{
+	(yyvsp[0].string)[strlen((yyvsp[0].string))-1] = '\0';
 
-	template_list_glob(buffer, (yyvsp[(3) - (3)].string)+1);
+	template_list_glob(buffer, (yyvsp[0].string)+1);
 
-	free ((yyvsp[(3) - (3)].string));
+	free ((yyvsp[0].string));
 }
+#line 2864 "parse.c"
     break;
 
-  case 102:
-
-/* Line 1806 of yacc.c  */
+  case 102: /* ui: LIST TEMPLATE STRING  */
 #line 1077 "parse.y"
-    {
-	template_list_glob(buffer, (yyvsp[(3) - (3)].string));
+{
+	template_list_glob(buffer, (yyvsp[0].string));
 }
+#line 2872 "parse.c"
     break;
 
-  case 103:
-
-/* Line 1806 of yacc.c  */
+  case 103: /* ui: LIST SUBSYSTEM  */
 #line 1081 "parse.y"
-    {
+{
 	template_subsystem_list_glob(buffer, "*");
 }
+#line 2880 "parse.c"
     break;
 
-  case 104:
-
-/* Line 1806 of yacc.c  */
+  case 104: /* ui: LIST SUBSYSTEM STRING  */
 #line 1085 "parse.y"
-    {
-	template_subsystem_list_glob(buffer, (yyvsp[(3) - (3)].string));
+{
+	template_subsystem_list_glob(buffer, (yyvsp[0].string));
 }
+#line 2888 "parse.c"
     break;
 
-  case 105:
-
-/* Line 1806 of yacc.c  */
+  case 105: /* ui: LIST SUBSYSTEM CMDSTRING  */
 #line 1089 "parse.y"
-    {
-	(yyvsp[(3) - (3)].string)[strlen((yyvsp[(3) - (3)].string))-1] = '\0';
-	template_subsystem_list_glob(buffer, (yyvsp[(3) - (3)].string)+1);
-	free((yyvsp[(3) - (3)].string));
+{
+	(yyvsp[0].string)[strlen((yyvsp[0].string))-1] = '\0';
+	template_subsystem_list_glob(buffer, (yyvsp[0].string)+1);
+	free((yyvsp[0].string));
 }
+#line 2898 "parse.c"
     break;
 
-  case 106:
-
-/* Line 1806 of yacc.c  */
+  case 106: /* ui: DEBUG STRING NUMBER  */
 #line 1095 "parse.y"
-    {
-	if (strcasecmp((yyvsp[(2) - (3)].string), "fd") == 0) {
-		yyprintf("%d: %d\n", (yyvsp[(3) - (3)].number), fdshare_inspect((yyvsp[(3) - (3)].number)));
-	} else if (strcasecmp((yyvsp[(2) - (3)].string), "trace") == 0) {
+{
+	if (strcasecmp((yyvsp[-1].string), "fd") == 0) {
+		yyprintf("%d: %d\n", (yyvsp[0].number), fdshare_inspect((yyvsp[0].number)));
+	} else if (strcasecmp((yyvsp[-1].string), "trace") == 0) {
 		struct evbuffer *evbuf = evbuffer_new();
 		if (evbuf == NULL)
 			err(1, "%s: malloc");
 
-		trace_inspect((yyvsp[(3) - (3)].number), evbuf);
+		trace_inspect((yyvsp[0].number), evbuf);
 
 		yyprintf("%s", EVBUFFER_DATA(evbuf));
 
 		evbuffer_free(evbuf);
 	} else {
-		yyerror("Unsupported debug command: \"%s\"\n", (yyvsp[(2) - (3)].string));
+		yyerror("Unsupported debug command: \"%s\"\n", (yyvsp[-1].string));
 	}
-	free((yyvsp[(2) - (3)].string));
+	free((yyvsp[-1].string));
 }
+#line 2921 "parse.c"
     break;
 
-  case 107:
-
-/* Line 1806 of yacc.c  */
+  case 107: /* shared: %empty  */
 #line 1115 "parse.y"
-    {
+{
 	(yyval.number) = 0;
 }
+#line 2929 "parse.c"
     break;
 
-  case 108:
-
-/* Line 1806 of yacc.c  */
+  case 108: /* shared: SHARED  */
 #line 1119 "parse.y"
-    {
+{
 	(yyval.number) = 1;
 }
+#line 2937 "parse.c"
     break;
 
-  case 109:
-
-/* Line 1806 of yacc.c  */
+  case 109: /* restart: %empty  */
 #line 1125 "parse.y"
-    {
+{
 	(yyval.number) = 0;
 }
+#line 2945 "parse.c"
     break;
 
-  case 110:
-
-/* Line 1806 of yacc.c  */
+  case 110: /* restart: RESTART  */
 #line 1129 "parse.y"
-    {
+{
 	(yyval.number) = 1;
 }
+#line 2953 "parse.c"
     break;
 
-  case 111:
-
-/* Line 1806 of yacc.c  */
+  case 111: /* flags: %empty  */
 #line 1135 "parse.y"
-    {
+{
 	(yyval.number) = 0;
 }
+#line 2961 "parse.c"
     break;
 
-  case 112:
-
-/* Line 1806 of yacc.c  */
+  case 112: /* flags: TARPIT  */
 #line 1139 "parse.y"
-    {
+{
 	(yyval.number) = PORT_TARPIT;
 }
+#line 2969 "parse.c"
     break;
 
-  case 113:
+  case 113: /* flags: SYN STRING  */
+#line 1143 "parse.y"
+{
+	if (strcasecmp((yyvsp[0].string), "cookies"))
+		yyerror("Unknown syn flag \"%s\"", (yyvsp[0].string));
+	free((yyvsp[0].string));
+	(yyval.number) = PORT_SYNCOOKIE;
+}
+#line 2980 "parse.c"
+    break;
 
-/* Line 1806 of yacc.c  */
-#line 1145 "parse.y"
-    {
+  case 114: /* condition: SOURCE OS EQUAL CMDSTRING  */
+#line 1152 "parse.y"
+        {
 		pf_osfp_t fp;
-		(yyvsp[(4) - (4)].string)[strlen((yyvsp[(4) - (4)].string)) - 1] = '\0';
-		if ((fp = pfctl_get_fingerprint((yyvsp[(4) - (4)].string)+1)) == PF_OSFP_NOMATCH)
-			yyerror("Unknown fingerprint \"%s\"", (yyvsp[(4) - (4)].string)+1);
+		(yyvsp[0].string)[strlen((yyvsp[0].string)) - 1] = '\0';
+		if ((fp = pfctl_get_fingerprint((yyvsp[0].string)+1)) == PF_OSFP_NOMATCH)
+			yyerror("Unknown fingerprint \"%s\"", (yyvsp[0].string)+1);
 		if (((yyval.condition).match_arg = malloc(sizeof(fp))) == NULL)
 			yyerror("Out of memory");
 		memcpy((yyval.condition).match_arg, &fp, sizeof(fp));
 		(yyval.condition).match = condition_match_osfp;
 		(yyval.condition).match_arglen = sizeof(fp);
-		free ((yyvsp[(4) - (4)].string));
+		free ((yyvsp[0].string));
 	}
+#line 2997 "parse.c"
     break;
 
-  case 114:
-
-/* Line 1806 of yacc.c  */
-#line 1158 "parse.y"
-    {
+  case 115: /* condition: SOURCE IP EQUAL ipaddr  */
+#line 1165 "parse.y"
+        {
 		if (((yyval.condition).match_arg = malloc(sizeof(struct addr))) == NULL)
 			yyerror("Out of memory");
-		memcpy((yyval.condition).match_arg, &(yyvsp[(4) - (4)].addr), sizeof(struct addr));
+		memcpy((yyval.condition).match_arg, &(yyvsp[0].addr), sizeof(struct addr));
 		(yyval.condition).match = condition_match_addr;
 		(yyval.condition).match_arglen = sizeof(struct addr);
 	}
+#line 3009 "parse.c"
     break;
 
-  case 115:
-
-/* Line 1806 of yacc.c  */
-#line 1166 "parse.y"
-    {
+  case 116: /* condition: SOURCE IP EQUAL ipnet  */
+#line 1173 "parse.y"
+        {
 		if (((yyval.condition).match_arg = malloc(sizeof(struct addr))) == NULL)
 			yyerror("Out of memory");
-		memcpy((yyval.condition).match_arg, &(yyvsp[(4) - (4)].addr), sizeof(struct addr));
+		memcpy((yyval.condition).match_arg, &(yyvsp[0].addr), sizeof(struct addr));
 		(yyval.condition).match = condition_match_addr;
 		(yyval.condition).match_arglen = sizeof(struct addr);
 	}
+#line 3021 "parse.c"
     break;
 
-  case 116:
-
-/* Line 1806 of yacc.c  */
-#line 1174 "parse.y"
-    {
+  case 117: /* condition: TIME timecondition  */
+#line 1181 "parse.y"
+        {
 		if (((yyval.condition).match_arg = malloc(sizeof(struct condition_time))) == NULL)
 			yyerror("Out of memory");
-		memcpy((yyval.condition).match_arg, &(yyvsp[(2) - (2)].timecondition), sizeof(struct condition_time));
+		memcpy((yyval.condition).match_arg, &(yyvsp[0].timecondition), sizeof(struct condition_time));
 		(yyval.condition).match = condition_match_time;
 		(yyval.condition).match_arglen = sizeof(struct condition_time);
 	}
+#line 3033 "parse.c"
     break;
 
-  case 117:
-
-/* Line 1806 of yacc.c  */
-#line 1182 "parse.y"
-    {
+  case 118: /* condition: PROTO  */
+#line 1189 "parse.y"
+        {
 		if (((yyval.condition).match_arg = malloc(sizeof(struct addr))) == NULL)
 			yyerror("Out of memory");
-		memcpy((yyval.condition).match_arg, &(yyvsp[(1) - (1)].number), sizeof(int));
+		memcpy((yyval.condition).match_arg, &(yyvsp[0].number), sizeof(int));
 		(yyval.condition).match = condition_match_proto;
 		(yyval.condition).match_arglen = sizeof(int);
 	}
+#line 3045 "parse.c"
     break;
 
-  case 118:
-
-/* Line 1806 of yacc.c  */
-#line 1190 "parse.y"
-    {
+  case 119: /* condition: OTHERWISE  */
+#line 1197 "parse.y"
+        {
 		(yyval.condition).match_arg = 0;
 		(yyval.condition).match = condition_match_otherwise;
 		(yyval.condition).match_arglen = 0;
 	}
+#line 3055 "parse.c"
     break;
 
-  case 119:
-
-/* Line 1806 of yacc.c  */
-#line 1198 "parse.y"
-    {
-		(yyval.timecondition).tm_start = (yyvsp[(2) - (4)].time);
-		(yyval.timecondition).tm_end = (yyvsp[(4) - (4)].time);
+  case 120: /* timecondition: BETWEEN time DASH time  */
+#line 1205 "parse.y"
+        {
+		(yyval.timecondition).tm_start = (yyvsp[-2].time);
+		(yyval.timecondition).tm_end = (yyvsp[0].time);
 	}
+#line 3064 "parse.c"
     break;
 
-  case 120:
-
-/* Line 1806 of yacc.c  */
-#line 1205 "parse.y"
-    {
+  case 121: /* time: NUMBER COLON NUMBER STRING  */
+#line 1212 "parse.y"
+        {
 		int ispm = -1;
 		int hour, minute;
 
-		if (strcmp((yyvsp[(4) - (4)].string), "am") == 0) {
+		if (strcmp((yyvsp[0].string), "am") == 0) {
 			ispm = 0;
-		} else if (strcmp((yyvsp[(4) - (4)].string), "pm") == 0) {
+		} else if (strcmp((yyvsp[0].string), "pm") == 0) {
 			ispm = 1;
 		} else {
-			yyerror("Bad time specifier, use 'am' or 'pm': %s", (yyvsp[(4) - (4)].string));
+			yyerror("Bad time specifier, use 'am' or 'pm': %s", (yyvsp[0].string));
 			break;
 		}
-		free ((yyvsp[(4) - (4)].string));
+		free ((yyvsp[0].string));
 
-		hour = (yyvsp[(1) - (4)].number) + (ispm ? 12 : 0);
-		minute = (yyvsp[(3) - (4)].number);
+		hour = (yyvsp[-3].number) + (ispm ? 12 : 0);
+		minute = (yyvsp[-1].number);
 
 		memset(&(yyval.time), 0, sizeof((yyval.time)));
 		(yyval.time).tm_hour = hour;
 		(yyval.time).tm_min = minute;
 	}
+#line 3090 "parse.c"
     break;
 
-  case 121:
-
-/* Line 1806 of yacc.c  */
-#line 1227 "parse.y"
-    {
-		char *time = (yyvsp[(1) - (1)].string) + 1;
+  case 122: /* time: CMDSTRING  */
+#line 1234 "parse.y"
+        {
+		char *time = (yyvsp[0].string) + 1;
 		time[strlen(time)-1] = '\0';
 
 		if (strptime(time, "%T", &(yyval.time)) != NULL) {
@@ -3386,14 +3103,14 @@ yyreduce:
 			yyerror("Bad time specification; use \"hh:mm:ss\"");
 		}
 
-		free((yyvsp[(1) - (1)].string));
+		free((yyvsp[0].string));
 	}
+#line 3109 "parse.c"
     break;
 
 
+#line 3113 "parse.c"
 
-/* Line 1806 of yacc.c  */
-#line 3397 "parse.c"
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -3407,96 +3124,58 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
-  /* Now `shift' the result of the reduction.  Determine what state
+  /* Now 'shift' the result of the reduction.  Determine what state
      that goes to, based on the state we popped back to and the rule
      number reduced by.  */
-
-  yyn = yyr1[yyn];
-
-  yystate = yypgoto[yyn - YYNTOKENS] + *yyssp;
-  if (0 <= yystate && yystate <= YYLAST && yycheck[yystate] == *yyssp)
-    yystate = yytable[yystate];
-  else
-    yystate = yydefgoto[yyn - YYNTOKENS];
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
 
   goto yynewstate;
 
 
-/*------------------------------------.
-| yyerrlab -- here on detecting error |
-`------------------------------------*/
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
       yyerror (YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = (char *) YYSTACK_ALLOC (yymsg_alloc);
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
-	 error, discard it.  */
+         error, discard it.  */
 
       if (yychar <= YYEOF)
-	{
-	  /* Return failure if at end of input.  */
-	  if (yychar == YYEOF)
-	    YYABORT;
-	}
+        {
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
+        }
       else
-	{
-	  yydestruct ("Error: discarding",
-		      yytoken, &yylval);
-	  yychar = YYEMPTY;
-	}
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval);
+          yychar = YYEMPTY;
+        }
     }
 
   /* Else will try to reuse lookahead token after shifting the error
@@ -3508,14 +3187,13 @@ yyerrlab:
 | yyerrorlab -- error raised explicitly by YYERROR.  |
 `---------------------------------------------------*/
 yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
 
-  /* Pacify compilers like GCC when the user code never invokes
-     YYERROR and the label yyerrorlab therefore never appears in user
-     code.  */
-  if (/*CONSTCOND*/ 0)
-     goto yyerrorlab;
-
-  /* Do not reclaim the symbols of the rule which action triggered
+  /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
   YYPOPSTACK (yylen);
   yylen = 0;
@@ -3528,39 +3206,42 @@ yyerrorlab:
 | yyerrlab1 -- common code for both syntax error and YYERROR.  |
 `-------------------------------------------------------------*/
 yyerrlab1:
-  yyerrstatus = 3;	/* Each real token shifted decrements this.  */
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
-	{
-	  yyn += YYTERROR;
-	  if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
-	    {
-	      yyn = yytable[yyn];
-	      if (0 < yyn)
-		break;
-	    }
-	}
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
 
       /* Pop the current state because it cannot handle the error token.  */
       if (yyssp == yyss)
-	YYABORT;
+        YYABORT;
 
 
       yydestruct ("Error: popping",
-		  yystos[yystate], yyvsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
     }
 
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -3571,26 +3252,30 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
 /*-----------------------------------.
 | yyabortlab -- YYABORT comes here.  |
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
-#if !defined(yyoverflow) || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
-yyreturn:
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -3599,32 +3284,25 @@ yyreturn:
       yydestruct ("Cleanup: discarding lookahead",
                   yytoken, &yylval);
     }
-  /* Do not reclaim the symbols of the rule which action triggered
+  /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
   YYPOPSTACK (yylen);
   YY_STACK_PRINT (yyss, yyssp);
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-		  yystos[*yyssp], yyvsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
-  /* Make sure YYID is used.  */
-  return YYID (yyresult);
-}
-
 
+  return yyresult;
+}
 
-/* Line 2067 of yacc.c  */
-#line 1242 "parse.y"
+#line 1249 "parse.y"
 
 
 static void
@@ -3802,4 +3480,3 @@ add_slash(char *str) {
         sprintf(filename,"/%s",str); 
         return filename;
 }
-
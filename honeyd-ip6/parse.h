@@ -1,21 +1,22 @@
-/* A Bison parser, made by GNU Bison 2.5.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
-   
-      Copyright (C) 1984, 1989-1990, 2000-2011 Free Software Foundation, Inc.
-   
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
    the Free Software Foundation, either version 3 of the License, or
    (at your option) any later version.
-   
+
    This program is distributed in the hope that it will be useful,
    but WITHOUT ANY WARRANTY; without even the implied warranty of
    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
    GNU General Public License for more details.
-   
+
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -26,106 +27,127 @@
    special exception, which will cause the skeleton and the resulting
    Bison output files to be licensed under the GNU General Public
    License without this special exception.
-   
+
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_PARSE_H_INCLUDED
+# define YY_YY_PARSE_H_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
 
-/* Tokens.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
-   /* Put the tokens into the symbol table, so that GDB and other debuggers
-      know about them.  */
-   enum yytokentype {
-     CREATE = 258,
-     ADD = 259,
-     PORT = 260,
-     BIND = 261,
-     CLONE = 262,
-     DOT = 263,
-     BLOCK = 264,
-     OPEN = 265,
-     RESET = 266,
-     DEFAULT = 267,
-     SET = 268,
-     ACTION = 269,
-     PERSONALITY = 270,
-     RANDOM = 271,
-     ANNOTATE = 272,
-     NO = 273,
-     FINSCAN = 274,
-     FRAGMENT = 275,
-     DROP = 276,
-     OLD = 277,
-     NEW = 278,
-     COLON = 279,
-     PROXY = 280,
-     UPTIME = 281,
-     DROPRATE = 282,
-     IN = 283,
-     SYN = 284,
-     UID = 285,
-     GID = 286,
-     ROUTE = 287,
-     ENTRY = 288,
-     LINK = 289,
-     NET = 290,
-     UNREACH = 291,
-     SLASH = 292,
-     LATENCY = 293,
-     MS = 294,
-     LOSS = 295,
-     BANDWIDTH = 296,
-     SUBSYSTEM = 297,
-     OPTION = 298,
-     TO = 299,
-     SHARED = 300,
-     NETWORK = 301,
-     SPOOF = 302,
-     FROM = 303,
-     TEMPLATE = 304,
-     OBRACKET = 305,
-     CBRACKET = 306,
-     RBRACKET = 307,
-     LBRACKET = 308,
-     TUNNEL = 309,
-     TARPIT = 310,
-     DYNAMIC = 311,
-     USE = 312,
-     IF = 313,
-     OTHERWISE = 314,
-     EQUAL = 315,
-     SOURCE = 316,
-     OS = 317,
-     IP = 318,
-     BETWEEN = 319,
-     DELETE = 320,
-     LIST = 321,
-     ETHERNET = 322,
-     DHCP = 323,
-     ON = 324,
-     MAXFDS = 325,
-     RESTART = 326,
-     DEBUG = 327,
-     DASH = 328,
-     TIME = 329,
-     INTERNAL = 330,
-     RANDOMIPVS = 331,
-     RANDOMEXCLUDE = 332,
-     SUBMISSION = 333,
-     STRING = 334,
-     CMDSTRING = 335,
-     IPSTRING = 336,
-     IPSSTRING = 337,
-     FILENAMESTRING = 338,
-     YESNO = 339,
-     NUMBER = 340,
-     LONG = 341,
-     PROTO = 342,
-     FLOAT = 343
-   };
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    CREATE = 258,                  /* CREATE  */
+    ADD = 259,                     /* ADD  */
+    PORT = 260,                    /* PORT  */
+    BIND = 261,                    /* BIND  */
+    CLONE = 262,                   /* CLONE  */
+    DOT = 263,                     /* DOT  */
+    BLOCK = 264,                   /* BLOCK  */
+    OPEN = 265,                    /* OPEN  */
+    RESET = 266,                   /* RESET  */
+    DEFAULT = 267,                 /* DEFAULT  */
+    SET = 268,                     /* SET  */
+    ACTION = 269,                  /* ACTION  */
+    PERSONALITY = 270,             /* PERSONALITY  */
+    RANDOM = 271,                  /* RANDOM  */
+    ANNOTATE = 272,                /* ANNOTATE  */
+    NO = 273,                      /* NO  */
+    FINSCAN = 274,                 /* FINSCAN  */
+    FRAGMENT = 275,                /* FRAGMENT  */
+    DROP = 276,                    /* DROP  */
+    OLD = 277,                     /* OLD  */
+    NEW = 278,                     /* NEW  */
+    COLON = 279,                   /* COLON  */
+    PROXY = 280,                   /* PROXY  */
+    UPTIME = 281,                  /* UPTIME  */
+    DROPRATE = 282,                /* DROPRATE  */
+    IN = 283,                      /* IN  */
+    SYN = 284,                     /* SYN  */
+    UID = 285,                     /* UID  */
+    GID = 286,                     /* GID  */
+    ROUTE = 287,                   /* ROUTE  */
+    ENTRY = 288,                   /* ENTRY  */
+    LINK = 289,                    /* LINK  */
+    NET = 290,                     /* NET  */
+    UNREACH = 291,                 /* UNREACH  */
+    SLASH = 292,                   /* SLASH  */
+    LATENCY = 293,                 /* LATENCY  */
+    MS = 294,                      /* MS  */
+    LOSS = 295,                    /* LOSS  */
+    BANDWIDTH = 296,               /* BANDWIDTH  */
+    SUBSYSTEM = 297,               /* SUBSYSTEM  */
+    OPTION = 298,                  /* OPTION  */
+    TO = 299,                      /* TO  */
+    SHARED = 300,                  /* SHARED  */
+    NETWORK = 301,                 /* NETWORK  */
+    SPOOF = 302,                   /* SPOOF  */
+    FROM = 303,                    /* FROM  */
+    TEMPLATE = 304,                /* TEMPLATE  */
+    OBRACKET = 305,                /* OBRACKET  */
+    CBRACKET = 306,                /* CBRACKET  */
+    RBRACKET = 307,                /* RBRACKET  */
+    LBRACKET = 308,                /* LBRACKET  */
+    TUNNEL = 309,                  /* TUNNEL  */
+    TARPIT = 310,                  /* TARPIT  */
+    DYNAMIC = 311,                 /* DYNAMIC  */
+    USE = 312,                     /* USE  */
+    IF = 313,                      /* IF  */
+    OTHERWISE = 314,               /* OTHERWISE  */
+    EQUAL = 315,                   /* EQUAL  */
+    SOURCE = 316,                  /* SOURCE  */
+    OS = 317,                      /* OS  */
+    IP = 318,                      /* IP  */
+    BETWEEN = 319,                 /* BETWEEN  */
+    DELETE = 320,                  /* DELETE  */
+    LIST = 321,                    /* LIST  */
+    ETHERNET = 322,                /* ETHERNET  */
+    DHCP = 323,                    /* DHCP  */
+    ON = 324,                      /* ON  */
+    MAXFDS = 325,                  /* MAXFDS  */
+    RESTART = 326,                 /* RESTART  */
+    DEBUG = 327,                   /* DEBUG  */
+    DASH = 328,                    /* DASH  */
+    TIME = 329,                    /* TIME  */
+    INTERNAL = 330,                /* INTERNAL  */
+    RANDOMIPVS = 331,              /* RANDOMIPVS  */
+    RANDOMEXCLUDE = 332,           /* RANDOMEXCLUDE  */
+    SUBMISSION = 333,              /* SUBMISSION  */
+    STRING = 334,                  /* STRING  */
+    CMDSTRING = 335,               /* CMDSTRING  */
+    IPSTRING = 336,                /* IPSTRING  */
+    IPSSTRING = 337,               /* IPSSTRING  */
+    FILENAMESTRING = 338,          /* FILENAMESTRING  */
+    YESNO = 339,                   /* YESNO  */
+    NUMBER = 340,                  /* NUMBER  */
+    LONG = 341,                    /* LONG  */
+    PROTO = 342,                   /* PROTO  */
+    FLOAT = 343                    /* FLOAT  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
-/* Tokens.  */
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
 #define CREATE 258
 #define ADD 259
 #define PORT 260
@@ -213,14 +235,10 @@
 #define PROTO 342
 #define FLOAT 343
 
-
-
-
+/* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef union YYSTYPE
+union YYSTYPE
 {
-
-/* Line 2068 of yacc.c  */
 #line 154 "parse.y"
 
 	char *string;
@@ -238,16 +256,19 @@ typedef union YYSTYPE
 	struct tm time;
 	struct condition_time timecondition;
 
+#line 260 "parse.h"
 
-
-/* Line 2068 of yacc.c  */
-#line 245 "parse.h"
-} YYSTYPE;
+};
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
-# define yystype YYSTYPE /* obsolescent; will be withdrawn */
 # define YYSTYPE_IS_DECLARED 1
 #endif
 
+
 extern YYSTYPE yylval;
 
 
+int yyparse (void);
+
+
+#endif /* !YY_YY_PARSE_H_INCLUDED  */
@@ -1138,6 +1138,13 @@ flags	: /* Empty */
 		| TARPIT
 {
 	$$ = PORT_TARPIT;
+}
+		| SYN STRING
+{
+	if (strcasecmp($2, "cookies"))
+		yyerror("Unknown syn flag \"%s\"", $2);
+	free($2);
+	$$ = PORT_SYNCOOKIE;
 }
 ;
 
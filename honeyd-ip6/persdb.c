@@ -0,0 +1,571 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/mman.h>
+#include <sys/queue.h>
+#include <sys/stat.h>
+#include <sys/tree.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <dnet.h>
+#include <event.h>
+
+#include "honeyd.h"
+#include "personality.h"
+#include "persdb.h"
+
+extern int npersons;
+
+/* A mapped image */
+struct persdb {
+	void *base;
+	size_t len;
+
+	const struct persdb_hdr *hdr;
+	const struct persdb_pers *pers;
+	const struct persdb_xp *xp;
+	const char *str;
+};
+
+/*
+ * The string table of an image under construction.  The option strings
+ * of the nmap tests repeat a lot, so equal strings are stored once.
+ */
+struct persdb_strtab {
+	char *buf;
+	size_t len;
+	size_t size;
+
+	uint32_t *slots;	/* offsets into buf, 0 is empty */
+	u_int nslots;
+	u_int count;
+};
+
+#define PERSDB_ALIGN(x)	(((x) + 7) & ~7)
+
+static uint32_t
+persdb_strhash(const char *s)
+{
+	uint32_t h = 2166136261U;
+
+	while (*s)
+		h = (h ^ (u_char)*s++) * 16777619U;
+
+	return (h);
+}
+
+static void
+persdb_strtab_grow(struct persdb_strtab *st)
+{
+	uint32_t *slots, off;
+	u_int i, nslots, slot;
+
+	nslots = st->nslots ? st->nslots * 2 : 1024;
+	if ((slots = calloc(nslots, sizeof(uint32_t))) == NULL)
+		err(1, "%s: calloc", __func__);
+
+	for (i = 0; i < st->nslots; i++) {
+		if ((off = st->slots[i]) == 0)
+			continue;
+		slot = persdb_strhash(st->buf + off) & (nslots - 1);
+		while (slots[slot] != 0)
+			slot = (slot + 1) & (nslots - 1);
+		slots[slot] = off;
+	}
+
+	free(st->slots);
+	st->slots = slots;
+	st->nslots = nslots;
+}
+
+static uint32_t
+persdb_stradd(struct persdb_strtab *st, const char *s)
+{
+	size_t len;
+	uint32_t off;
+	u_int slot;
+
+	if (s == NULL || *s == '\0')
+		return (0);
+
+	if (2 * (st->count + 1) > st->nslots)
+		persdb_strtab_grow(st);
+
+	slot = persdb_strhash(s) & (st->nslots - 1);
+	while ((off = st->slots[slot]) != 0) {
+		if (strcmp(st->buf + off, s) == 0)
+			return (off);
+		slot = (slot + 1) & (st->nslots - 1);
+	}
+
+	len = strlen(s) + 1;
+	while (st->len + len > st->size) {
+		st->size = st->size ? st->size * 2 : 16384;
+		if ((st->buf = realloc(st->buf, st->size)) == NULL)
+			err(1, "%s: realloc", __func__);
+	}
+
+	off = st->len;
+	memcpy(st->buf + off, s, len);
+	st->len += len;
+
+	st->slots[slot] = off;
+	st->count++;
+
+	return (off);
+}
+
+static int
+persdb_xpcompare(const void *a, const void *b)
+{
+	const struct xp_fingerprint *xa = *(struct xp_fingerprint **)a;
+	const struct xp_fingerprint *xb = *(struct xp_fingerprint **)b;
+
+	return (strcmp(xa->os_id, xb->os_id));
+}
+
+/*
+ * Writes the personalities and xprobe fingerprints that are currently
+ * loaded to filename.  The image is written to a temporary file first
+ * and renamed, so that running honeyds never map a partial image.
+ */
+
+int
+persdb_compile(const char *filename)
+{
+	struct persdb_strtab st;
+	struct persdb_hdr *hdr;
+	struct persdb_pers *rec;
+	struct persdb_xp *xrec;
+	struct personality *pers;
+	struct xp_fingerprint *xp, **xps = NULL, **found;
+	char tmpname[MAXPATHLEN];
+	u_char *image;
+	size_t len;
+	u_int i, j, npers = 0, nxp = 0;
+	FILE *fp;
+	int res = -1;
+
+	memset(&st, 0, sizeof(st));
+	persdb_strtab_grow(&st);
+	st.size = 16384;
+	if ((st.buf = malloc(st.size)) == NULL)
+		err(1, "%s: malloc", __func__);
+	st.buf[st.len++] = '\0';
+
+	SPLAY_FOREACH(pers, perstree, &personalities)
+		npers++;
+	SPLAY_FOREACH(xp, xp_fprint_tree, &xp_fprints)
+		nxp++;
+
+	/* The tree is ordered by name, so the personalities can find theirs */
+	if ((xps = calloc(nxp + 1, sizeof(struct xp_fingerprint *))) == NULL)
+		err(1, "%s: calloc", __func__);
+	i = 0;
+	SPLAY_FOREACH(xp, xp_fprint_tree, &xp_fprints)
+		xps[i++] = xp;
+
+	if ((rec = calloc(npers + 1, sizeof(struct persdb_pers))) == NULL ||
+	    (xrec = calloc(nxp + 1, sizeof(struct persdb_xp))) == NULL)
+		err(1, "%s: calloc", __func__);
+
+	for (i = 0; i < nxp; i++) {
+		xrec[i].os_id = persdb_stradd(&st, xps[i]->os_id);
+		xrec[i].flags = xps[i]->flags;
+		xrec[i].ttl_vals = xps[i]->ttl_vals;
+	}
+
+	i = 0;
+	SPLAY_FOREACH(pers, perstree, &personalities) {
+		struct persdb_pers *r = &rec[i++];
+
+		r->name = persdb_stradd(&st, pers->name);
+		r->xp = -1;
+		if (pers->xp_fprint != NULL) {
+			found = bsearch(&pers->xp_fprint, xps, nxp,
+			    sizeof(struct xp_fingerprint *), persdb_xpcompare);
+			if (found != NULL)
+				r->xp = found - xps;
+		}
+
+		for (j = 0; j < 7; j++) {
+			r->tests[j].window = pers->tests[j].window;
+			r->tests[j].flags = pers->tests[j].flags;
+			r->tests[j].df = pers->tests[j].df;
+			r->tests[j].forceack = pers->tests[j].forceack;
+			r->tests[j].options = persdb_stradd(&st,
+			    pers->tests[j].options);
+		}
+		r->udptest = pers->udptest;
+
+		r->idt = pers->idt;
+		r->seqt = pers->seqt;
+		r->fragp = pers->fragp;
+		r->seqindex_min = pers->seqindex_min;
+		r->seqindex_max = pers->seqindex_max;
+		r->gcd = pers->gcd;
+		r->val = pers->val;
+		r->tstamphz = pers->tstamphz;
+		r->valset = pers->valset;
+		r->disallow_finscan = pers->disallow_finscan;
+		r->seqindex_amin = pers->seqindex_amin;
+		r->seqindex_amax = pers->seqindex_amax;
+		r->seqindex_aconst = pers->seqindex_aconst;
+	}
+
+	/* Lay out the image */
+	len = PERSDB_ALIGN(sizeof(struct persdb_hdr));
+	len += PERSDB_ALIGN(npers * sizeof(struct persdb_pers));
+	len += PERSDB_ALIGN(nxp * sizeof(struct persdb_xp));
+	len += st.len;
+	if ((image = calloc(1, len)) == NULL)
+		err(1, "%s: calloc", __func__);
+
+	hdr = (struct persdb_hdr *)image;
+	memcpy(hdr->magic, PERSDB_MAGIC, sizeof(hdr->magic));
+	hdr->version = PERSDB_VERSION;
+	hdr->byteorder = PERSDB_BYTEORDER;
+	hdr->perssize = sizeof(struct persdb_pers);
+	hdr->xpsize = sizeof(struct persdb_xp);
+	hdr->npers = npers;
+	hdr->nxp = nxp;
+	hdr->pers_off = PERSDB_ALIGN(sizeof(struct persdb_hdr));
+	hdr->xp_off = hdr->pers_off +
+	    PERSDB_ALIGN(npers * sizeof(struct persdb_pers));
+	hdr->str_off = hdr->xp_off + PERSDB_ALIGN(nxp * sizeof(struct persdb_xp));
+	hdr->str_len = st.len;
+
+	memcpy(image + hdr->pers_off, rec, npers * sizeof(struct persdb_pers));
+	memcpy(image + hdr->xp_off, xrec, nxp * sizeof(struct persdb_xp));
+	memcpy(image + hdr->str_off, st.buf, st.len);
+
+	snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+	if ((fp = fopen(tmpname, "w")) == NULL) {
+		warn("%s: fopen(%s)", __func__, tmpname);
+		goto out;
+	}
+	if (fwrite(image, len, 1, fp) != 1 || fclose(fp) == EOF) {
+		warn("%s: write(%s)", __func__, tmpname);
+		unlink(tmpname);
+		goto out;
+	}
+	if (rename(tmpname, filename) == -1) {
+		warn("%s: rename(%s)", __func__, filename);
+		unlink(tmpname);
+		goto out;
+	}
+
+	syslog(LOG_INFO, "compiled %u personalities and %u xprobe prints "
+	    "into %s", npers, nxp, filename);
+	res = 0;
+
+ out:
+	free(image);
+	free(rec);
+	free(xrec);
+	free(xps);
+	free(st.buf);
+	free(st.slots);
+
+	return (res);
+}
+
+static void
+persdb_unmap(struct persdb *db)
+{
+	munmap(db->base, db->len);
+}
+
+/*
+ * Maps filename and checks that it is an image we can use.  Returns 0
+ * if the file is not an image at all, so that the caller can fall back
+ * to parsing it as text.
+ */
+
+static int
+persdb_map(const char *filename, struct persdb *db)
+{
+	const struct persdb_hdr *hdr;
+	struct stat sb;
+	uint64_t end;
+	int fd;
+
+	if ((fd = open(filename, O_RDONLY, 0)) == -1) {
+		warn("%s: open(%s)", __func__, filename);
+		return (-1);
+	}
+	if (fstat(fd, &sb) == -1) {
+		warn("%s: fstat(%s)", __func__, filename);
+		close(fd);
+		return (-1);
+	}
+	if (sb.st_size < sizeof(struct persdb_hdr)) {
+		close(fd);
+		return (0);
+	}
+
+	db->len = sb.st_size;
+	db->base = mmap(NULL, db->len, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (db->base == MAP_FAILED) {
+		warn("%s: mmap(%s)", __func__, filename);
+		return (-1);
+	}
+
+	db->hdr = hdr = db->base;
+	if (memcmp(hdr->magic, PERSDB_MAGIC, sizeof(hdr->magic)) != 0) {
+		persdb_unmap(db);
+		return (0);
+	}
+
+	if (hdr->version != PERSDB_VERSION ||
+	    hdr->byteorder != PERSDB_BYTEORDER ||
+	    hdr->perssize != sizeof(struct persdb_pers) ||
+	    hdr->xpsize != sizeof(struct persdb_xp)) {
+		warnx("%s: %s was compiled by a different honeyd",
+		    __func__, filename);
+		goto error;
+	}
+
+	/* Everything has to be inside the file and properly aligned */
+	end = (uint64_t)hdr->pers_off + (uint64_t)hdr->npers * hdr->perssize;
+	if (hdr->pers_off % 8 || end > db->len)
+		goto corrupt;
+	end = (uint64_t)hdr->xp_off + (uint64_t)hdr->nxp * hdr->xpsize;
+	if (hdr->xp_off % 8 || end > db->len)
+		goto corrupt;
+	end = (uint64_t)hdr->str_off + hdr->str_len;
+	if (hdr->str_len == 0 || end > db->len)
+		goto corrupt;
+
+	db->pers = (const struct persdb_pers *)((u_char *)db->base +
+	    hdr->pers_off);
+	db->xp = (const struct persdb_xp *)((u_char *)db->base + hdr->xp_off);
+	db->str = (const char *)db->base + hdr->str_off;
+
+	/* Any offset into the table yields a terminated string */
+	if (db->str[hdr->str_len - 1] != '\0')
+		goto corrupt;
+
+	return (1);
+
+ corrupt:
+	warnx("%s: %s is corrupt", __func__, filename);
+ error:
+	persdb_unmap(db);
+	return (-1);
+}
+
+static int
+persdb_str(const struct persdb *db, uint32_t off, char **pstr)
+{
+	if (off >= db->hdr->str_len)
+		return (-1);
+
+	*pstr = off ? (char *)db->str + off : NULL;
+	return (0);
+}
+
+/*
+ * Loads a compiled image into the personality and xprobe trees.  The
+ * image stays mapped for the lifetime of the process; names and option
+ * strings point into it and are shared with every other honeyd that
+ * maps the same file.  Returns 0 if filename is not an image, 1 if it
+ * was loaded and -1 on error.
+ */
+
+int
+persdb_load(const char *filename)
+{
+	struct persdb db;
+	const struct persdb_pers *r;
+	const struct persdb_xp *x;
+	struct personality *perss, *pers;
+	struct xp_fingerprint *xps = NULL;
+	u_int i, j;
+	int res;
+
+	if ((res = persdb_map(filename, &db)) != 1)
+		return (res);
+
+	/* Neither array is ever freed, just like the parsed personalities */
+	if ((perss = calloc(db.hdr->npers + 1,
+		 sizeof(struct personality))) == NULL ||
+	    (xps = calloc(db.hdr->nxp + 1,
+		 sizeof(struct xp_fingerprint))) == NULL)
+		err(1, "%s: calloc", __func__);
+
+	for (i = 0; i < db.hdr->nxp; i++) {
+		x = &db.xp[i];
+		if (persdb_str(&db, x->os_id, &xps[i].os_id) == -1 ||
+		    xps[i].os_id == NULL)
+			goto corrupt;
+		xps[i].flags = x->flags;
+		xps[i].ttl_vals = x->ttl_vals;
+
+		SPLAY_INSERT(xp_fprint_tree, &xp_fprints, &xps[i]);
+	}
+
+	for (i = 0; i < db.hdr->npers; i++) {
+		r = &db.pers[i];
+		pers = &perss[i];
+
+		if (persdb_str(&db, r->name, &pers->name) == -1 ||
+		    pers->name == NULL)
+			goto corrupt;
+		if (r->xp >= (int32_t)db.hdr->nxp)
+			goto corrupt;
+		if (r->xp >= 0)
+			pers->xp_fprint = &xps[r->xp];
+
+		for (j = 0; j < 7; j++) {
+			pers->tests[j].window = r->tests[j].window;
+			pers->tests[j].flags = r->tests[j].flags;
+			pers->tests[j].df = r->tests[j].df;
+			pers->tests[j].forceack = r->tests[j].forceack;
+			if (persdb_str(&db, r->tests[j].options,
+				&pers->tests[j].options) == -1)
+				goto corrupt;
+			tcp_personality_compile(pers->tests[j].options,
+			    &pers->tests[j].opts);
+		}
+		pers->udptest = r->udptest;
+
+		pers->idt = r->idt;
+		pers->seqt = r->seqt;
+		pers->fragp = r->fragp;
+		pers->seqindex_min = r->seqindex_min;
+		pers->seqindex_max = r->seqindex_max;
+		pers->gcd = r->gcd;
+		pers->val = r->val;
+		pers->tstamphz = r->tstamphz;
+		pers->valset = r->valset;
+		pers->disallow_finscan = r->disallow_finscan;
+		pers->seqindex_amin = r->seqindex_amin;
+		pers->seqindex_amax = r->seqindex_amax;
+		pers->seqindex_aconst = r->seqindex_aconst;
+
+		if (SPLAY_INSERT(perstree, &personalities, pers) == NULL)
+			npersons++;
+	}
+
+	syslog(LOG_INFO, "loaded %u personalities and %u xprobe prints from %s",
+	    db.hdr->npers, db.hdr->nxp, filename);
+
+	return (1);
+
+ corrupt:
+	warnx("%s: %s has a bad record", __func__, filename);
+	return (-1);
+}
+
+void
+persdb_test(void)
+{
+	char path[] = "/tmp/honeyd.pdb.XXXXXX";
+	const struct persdb_pers *r;
+	struct personality *pers = NULL;
+	struct persdb db;
+	char *name = NULL, *options = NULL;
+	u_int i, j;
+	FILE *fp;
+	int fd;
+
+	if ((fd = mkstemp(path)) == -1)
+		err(1, "%s: mkstemp", __func__);
+	close(fd);
+
+	if (persdb_compile(path) == -1)
+		errx(1, "%s: compile failed", __func__);
+	if (persdb_map(path, &db) != 1)
+		errx(1, "%s: map failed", __func__);
+	if (db.hdr->npers != npersons)
+		errx(1, "%s: %u personalities, expected %d", __func__,
+		    db.hdr->npers, npersons);
+
+	/* Every record has to reproduce the parsed personality */
+	for (i = 0; i < db.hdr->npers; i++) {
+		r = &db.pers[i];
+		if (persdb_str(&db, r->name, &name) == -1 || name == NULL)
+			errx(1, "%s: record %u has no name", __func__, i);
+		if ((pers = personality_find(name)) == NULL)
+			errx(1, "%s: record %u has no personality", __func__, i);
+
+		for (j = 0; j < 7; j++) {
+			if (persdb_str(&db, r->tests[j].options, &options) == -1)
+				errx(1, "%s: %s: bad options", __func__, name);
+			if (r->tests[j].window != pers->tests[j].window ||
+			    r->tests[j].flags != pers->tests[j].flags ||
+			    (options == NULL) != (pers->tests[j].options == NULL) ||
+			    (options != NULL &&
+				strcmp(options, pers->tests[j].options) != 0))
+				errx(1, "%s: %s: test %u differs", __func__,
+				    name, j);
+		}
+		if (r->seqt != pers->seqt || r->gcd != pers->gcd ||
+		    r->seqindex_aconst != pers->seqindex_aconst)
+			errx(1, "%s: %s: sequence differs", __func__, name);
+		if ((r->xp == -1) != (pers->xp_fprint == NULL))
+			errx(1, "%s: %s: xprobe print differs", __func__, name);
+		if (r->xp != -1 &&
+		    strcmp(db.str + db.xp[r->xp].os_id,
+			pers->xp_fprint->os_id) != 0)
+			errx(1, "%s: %s: wrong xprobe print", __func__, name);
+	}
+	persdb_unmap(&db);
+
+	/* Text files are not images */
+	if ((fp = fopen(path, "w")) == NULL)
+		err(1, "%s: fopen", __func__);
+	fprintf(fp, "Fingerprint Test\nTSeq(Class=C)\n# plenty of padding\n");
+	fclose(fp);
+	if (persdb_map(path, &db) != 0)
+		errx(1, "%s: text file taken for an image", __func__);
+
+	unlink(path);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _PERSDB_H_
+#define _PERSDB_H_
+
+/*
+ * A compiled personality database.  The nmap and xprobe fingerprints
+ * and their associations are parsed once and written as an image that
+ * honeyd maps read-only at startup instead of parsing the text files.
+ * Strings are referenced by offset into a string table; offset 0 is the
+ * empty string and stands for NULL.  Images are only valid on the kind
+ * of host that wrote them.
+ */
+
+#define PERSDB_MAGIC		"HONEYDPD"
+#define PERSDB_VERSION		1
+#define PERSDB_BYTEORDER	0x01020304
+
+struct persdb_hdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteorder;
+	uint32_t perssize;	/* sizeof(struct persdb_pers) */
+	uint32_t xpsize;	/* sizeof(struct persdb_xp) */
+
+	uint32_t npers;
+	uint32_t nxp;
+	uint32_t pers_off;
+	uint32_t xp_off;
+	uint32_t str_off;
+	uint32_t str_len;
+};
+
+struct persdb_test {
+	int32_t window;
+	uint8_t flags;
+	uint8_t df;
+	uint8_t forceack;
+	uint32_t options;
+};
+
+struct persdb_pers {
+	uint32_t name;
+	int32_t xp;		/* index of the xprobe print, -1 for none */
+
+	struct persdb_test tests[7];
+	struct persudp udptest;
+
+	uint32_t idt;
+	uint32_t seqt;
+	uint32_t fragp;
+	uint32_t seqindex_min;
+	uint32_t seqindex_max;
+	uint32_t gcd;
+	uint32_t val;
+	int32_t tstamphz;
+	uint8_t valset;
+	uint8_t disallow_finscan;
+
+	double seqindex_amin;
+	double seqindex_amax;
+	double seqindex_aconst;
+};
+
+struct persdb_xp {
+	uint32_t os_id;
+	struct xp_fp_flags flags;
+	struct xp_fp_ttlvals ttl_vals;
+};
+
+int persdb_compile(const char *);
+int persdb_load(const char *);
+
+void persdb_test(void);
+
+#endif /* _PERSDB_H_ */
@@ -64,6 +64,7 @@
 #include "xprobe_assoc.h"
 #include "template.h"
 #include "debug.h"
+#include "cksum.h"
 
 /* ET - Moved SPLAY_HEAD to personality.h so xprobe_assoc.c could use it. */
 int npersons;
@@ -73,6 +74,30 @@ struct personate person_drop = {};
 static struct event personality_time_ev;
 static struct timeval tv_periodic;
 
+/* Default TCP options is timestamp, noop, noop */
+static struct persopts persopts_default;
+/* SYN segments that no test matches just carry an MSS */
+struct persopts persopts_mss;
+
+/*
+ * The nmap probes that we answer according to the personality, told
+ * apart by their TCP flags.  tcp_probe_class is indexed by the flags
+ * without ECE and CWR.
+ */
+enum tcp_probe {
+	PROBE_NONE = 0,
+	PROBE_SYN,		/* T1, T5 and the sequence probes */
+	PROBE_NULL,		/* T2 */
+	PROBE_SYNFPU,		/* T3 */
+	PROBE_ACK,		/* T4, T6 */
+	PROBE_FPU,		/* T7 */
+	PROBE_FIN		/* FIN scans */
+};
+
+#define TCP_PROBE_FLAGS	(TH_FIN|TH_SYN|TH_RST|TH_PUSH|TH_ACK|TH_URG)
+
+static uint8_t tcp_probe_class[TCP_PROBE_FLAGS + 1];
+
 SPLAY_GENERATE(perstree, personality, node, perscompare);
 
 /* ipv6 (nmap) fingerprint tree */
@@ -102,12 +127,39 @@ xprobe_personality_init(void)
 }
 
 
+static void
+tcp_probe_init(void)
+{
+	int flags;
+
+	for (flags = 0; flags <= TCP_PROBE_FLAGS; flags++) {
+		if (flags == TH_SYN)
+			tcp_probe_class[flags] = PROBE_SYN;
+		else if (flags == 0)
+			tcp_probe_class[flags] = PROBE_NULL;
+		else if (flags == (TH_SYN|TH_PUSH|TH_FIN|TH_URG))
+			tcp_probe_class[flags] = PROBE_SYNFPU;
+		else if (flags == TH_ACK)
+			tcp_probe_class[flags] = PROBE_ACK;
+		else if (flags == (TH_FIN|TH_PUSH|TH_URG))
+			tcp_probe_class[flags] = PROBE_FPU;
+		else if ((flags & TH_FIN) && (flags & (TH_SYN|TH_ACK)) == 0)
+			tcp_probe_class[flags] = PROBE_FIN;
+		else
+			tcp_probe_class[flags] = PROBE_NONE;
+	}
+}
+
 void
 personality_init(void)
 {
 	npersons = 0;
 	SPLAY_INIT(&personalities);
 
+	tcp_probe_init();
+	tcp_personality_compile("tnn", &persopts_default);
+	tcp_personality_compile("m", &persopts_mss);
+
 	/* Start a timer that keeps track of the current system time */
 	evtimer_set(&personality_time_ev,
 	    personality_time_evcb, &personality_time_ev);
@@ -206,6 +258,7 @@ void
 personality_free(struct personality *pers)
 {
 	SPLAY_REMOVE(perstree, &personalities, pers);
+	npersons--;
 
 	free(pers->name);
 	free(pers);
@@ -289,8 +342,9 @@ tcp_personality_test(const struct tcp_con *con, struct personality *person,
 	 * sane.  This allows us to get TCP options right, too.
 	 */
         
-	flags = con->rcv_flags & (TH_FIN|TH_RST|TH_PUSH|TH_ACK|TH_URG|TH_SYN);
-	if (flags == TH_SYN) {
+	flags = con->rcv_flags & TCP_PROBE_FLAGS;
+	switch (tcp_probe_class[flags]) {
+	case PROBE_SYN: {
 		int hasece = con->rcv_flags & TH_ECE;
 
 		switch (con->state) {
@@ -316,14 +370,15 @@ tcp_personality_test(const struct tcp_con *con, struct personality *person,
 		default:
 			return (NULL);
 		}
-	} else if (flags == 0) {
+	}
+	case PROBE_NULL:
 		switch (con->state) {
 		case TCP_STATE_LISTEN:
 			return (&person->tests[1]);
 		default:
 			return (NULL);
 		}
-	} else if (flags == (TH_SYN|TH_PUSH|TH_FIN|TH_URG)) {
+	case PROBE_SYNFPU:
 		switch (con->state) {
 		case TCP_STATE_LISTEN:
 		case TCP_STATE_SYN_RECEIVED:
@@ -331,7 +386,7 @@ tcp_personality_test(const struct tcp_con *con, struct personality *person,
 		default:
 			return (NULL);
 		}
-	} else if (flags == TH_ACK) {
+	case PROBE_ACK:
 		switch (con->state) {
 		case TCP_STATE_LISTEN:
 		case TCP_STATE_SYN_RECEIVED:
@@ -341,14 +396,14 @@ tcp_personality_test(const struct tcp_con *con, struct personality *person,
 		default:
 			return (NULL);
 		}
-	} else if (flags == (TH_FIN|TH_PUSH|TH_URG)) {
+	case PROBE_FPU:
 		switch (con->state) {
 		case TCP_STATE_CLOSED:
 			return (&person->tests[6]);
 		default:
 			return (NULL);
 		}
-	} else if ((flags & TH_FIN) && (flags & (TH_SYN|TH_ACK)) == 0) {
+	case PROBE_FIN:
 		/*
 		 * If we get a FIN flag and do not allow fin scanning, then
 		 * we just let the regular state engine run its course.
@@ -590,9 +645,6 @@ tcp_personality_seq(struct template *tmpl, struct personality *person)
 	}
 }
 
-/* Default TCP options is timestamp, noop, noop */
-static char *default_opts = "tnn";
-
 int
 tcp_personality_match(struct tcp_con *con, int flags)
 {
@@ -611,15 +663,15 @@ tcp_personality_match(struct tcp_con *con, int flags)
 
 int
 tcp_personality(struct tcp_con *con, uint8_t *pflags, int *pwindow, int *pdf,
-    uint16_t *pid, char **poptions)
+    uint16_t *pid, const struct persopts **popts)
 {
 	struct template *tmpl = con->tmpl;
 	struct personality *person;
 	struct personate *pers;
 	uint8_t flags = *pflags;
 
-	if (poptions != NULL)
-		*poptions = NULL;
+	if (popts != NULL)
+		*popts = NULL;
 
 	/* XXX - We need to find some template to use here */
 
@@ -639,16 +691,16 @@ tcp_personality(struct tcp_con *con, uint8_t *pflags, int *pwindow, int *pdf,
 			con->snd_una = tcp_personality_seq(tmpl, person);
 
 		/* If we support timestamps, always set them */
-		if (person->tstamphz >= 0 && poptions != NULL)
-			*poptions = default_opts;
+		if (person->tstamphz >= 0 && popts != NULL)
+			*popts = &persopts_default;
 		return (-1);
 	}
 
 	*pwindow = pers->window;
 	*pflags = pers->flags;
 	*pdf = pers->df;
-	if (poptions != NULL)
-		*poptions = pers->options;
+	if (popts != NULL && pers->opts.len)
+		*popts = &pers->opts;
 
 	switch (pers->forceack) {
 	case ACK_ZERO:
@@ -669,83 +721,141 @@ tcp_personality(struct tcp_con *con, uint8_t *pflags, int *pwindow, int *pdf,
 	return (0);
 }
 
-#define SET(y, x, w, l) do { \
-	(x)->opt_type = w; \
-	(x)->opt_len = l; \
-	memcpy(y, x, l); \
-} while (0)
-
 /* 
  * Given a character string that describe TCP options, create the
- * corresponding packet data.
+ * corresponding packet data.  The values that depend on the connection
+ * are left empty and filled in by tcp_personality_options().
  */
 
 void
-tcp_personality_options(struct tcp_con *con, struct tcp_hdr *tcp,
-    char *options)
+tcp_personality_compile(const char *options, struct persopts *opts)
 {
-	extern rand_t *honeyd_rand;
-	u_char *p = (u_char *)tcp + TCP_HDR_LEN;
-	struct template *tmpl = con->tmpl;
-	struct tcp_opt opt;
-	int optlen = 0, simple = 0;
-	uint32_t timestamp;
-	short mss = 1460;
-	char *o;
-	
+	u_char *p = opts->data;
+	int optlen = 0, simple = 0, len;
+	const char *o;
+
+	memset(opts, 0, sizeof(struct persopts));
+	if (options == NULL)
+		return;
+
 	for (o = options; *o; o++) {
-		opt.opt_len = 0;
 		switch(*o) {
 		case 'm':
-			if (o[1] == 'e') {
-				o++;
-				if (con->mss)
-					mss = con->mss;
-			}
-			if (con->flags & TCP_TARPIT)
-				mss = 64;
-			opt.opt_data.mss = htons(mss);
-			SET(p, &opt, TCP_OPT_MSS, 4);
+			len = 4;
 			break;
 		case 'w':
-			opt.opt_data.wscale = 0;
-			SET(p, &opt, TCP_OPT_WSCALE, 3);
+			len = 3;
 			break;
 		case 't':
-			if (tmpl != NULL) {
-				struct timeval tv;
-				tcp_personality_time(tmpl, &tv);
-				timestamp = htonl(tmpl->timestamp);
-			} else {
-				timestamp = rand_uint32(honeyd_rand);
-			}
-			opt.opt_data.timestamp[0] = timestamp;
-			opt.opt_data.timestamp[1] = 0;
-			if (con->sawtimestamp)
-				opt.opt_data.timestamp[1] = con->echotimestamp;
-			SET(p, &opt, TCP_OPT_TIMESTAMP, 2 + 4 + 4);
+			len = 2 + 4 + 4;
 			break;
 		case 'n':
-			simple++;
-			SET(p, &opt, TCP_OPT_NOP, 1);
+			len = 1;
 			break;
 		case 'l':
-			SET(p, &opt, TCP_OPT_EOL, 2);
+			len = 2;
 			break;
 		default:
-			opt.opt_len = 0;
+			continue;
+		}
+
+		if (optlen + len > PERSOPTS_MAX)
+			break;
+
+		switch (*o) {
+		case 'm':
+			if (opts->nmss < PERSOPTS_PATCH) {
+				if (o[1] == 'e')
+					opts->mss_echo |= 1 << opts->nmss;
+				opts->mss_off[opts->nmss++] = optlen + 2;
+			}
+			if (o[1] == 'e')
+				o++;
+			p[0] = TCP_OPT_MSS;
+			p[1] = len;
+			p[2] = 1460 >> 8;
+			p[3] = 1460 & 0xff;
+			break;
+		case 'w':
+			p[0] = TCP_OPT_WSCALE;
+			p[1] = len;
+			p[2] = 0;
+			break;
+		case 't':
+			if (opts->nts < PERSOPTS_PATCH)
+				opts->ts_off[opts->nts++] = optlen + 2;
+			p[0] = TCP_OPT_TIMESTAMP;
+			p[1] = len;
+			break;
+		case 'n':
+			simple++;
+			p[0] = TCP_OPT_NOP;
+			break;
+		case 'l':
+			p[0] = TCP_OPT_EOL;
+			p[1] = len;
 			break;
 		}
-		optlen += opt.opt_len;
-		p += opt.opt_len;
+		optlen += len;
+		p += len;
 	}
 
 	/* Check if we have only unreasonable options */
-	if (simple == optlen)
-		optlen = 0;
+	if (simple == optlen) {
+		memset(opts, 0, sizeof(struct persopts));
+		return;
+	}
+
+	/* The rest of the last word stays zero, i.e. end of options */
+	opts->len = (optlen + 3) & ~3;
+}
+
+/*
+ * Copies the compiled options behind the TCP header and fills in the
+ * MSS and the timestamps for this connection.
+ */
+
+void
+tcp_personality_options(struct tcp_con *con, struct tcp_hdr *tcp,
+    const struct persopts *opts)
+{
+	extern rand_t *honeyd_rand;
+	u_char *p = (u_char *)tcp + TCP_HDR_LEN;
+	struct template *tmpl = con->tmpl;
+	uint32_t timestamp[2];
+	uint16_t mss;
+	int i;
+
+	if (!opts->len)
+		return;
 
-	if (optlen)
-		tcp->th_off += (optlen + 3) / 4;
+	memcpy(p, opts->data, opts->len);
+
+	for (i = 0; i < opts->nmss; i++) {
+		mss = 1460;
+		if ((opts->mss_echo & (1 << i)) && con->mss)
+			mss = con->mss;
+		if (con->flags & TCP_TARPIT)
+			mss = 64;
+		mss = htons(mss);
+		memcpy(p + opts->mss_off[i], &mss, sizeof(mss));
+	}
+
+	for (i = 0; i < opts->nts; i++) {
+		if (tmpl != NULL) {
+			struct timeval tv;
+			tcp_personality_time(tmpl, &tv);
+			timestamp[0] = htonl(tmpl->timestamp);
+		} else {
+			timestamp[0] = rand_uint32(honeyd_rand);
+		}
+		timestamp[1] = 0;
+		if (con->sawtimestamp)
+			timestamp[1] = con->echotimestamp;
+		memcpy(p + opts->ts_off[i], timestamp, sizeof(timestamp));
+	}
+
+	tcp->th_off += opts->len / 4;
 }
 
 /* JVR - added '+1' in default case below for situations where IP checksum does not
@@ -799,7 +909,7 @@ icmp_error_personality(struct template *tmpl,
 	/* We need to recompute the ip header checksum in some cases */
 	if (test->ripck == RVAL_OKAY) {
 		if (iphdr_changed)
-			ip_checksum(ip, ip->ip_hl << 2);
+			cksum_ip_hdr(ip);
 	} else
 		RVAL_DO(ip->ip_sum, test->ripck);
 
@@ -1215,6 +1325,8 @@ parse_tl(struct personality *pers, int off, char *line)
 					*p3 = tolower(*p3);
 				if ((test->options = strdup(p2)) == NULL)
 					err(1, "%s: strdup", __FUNCTION__);
+				tcp_personality_compile(test->options,
+				    &test->opts);
 			}
 		} else
 		      return (-1);
@@ -1805,3 +1917,55 @@ xprobe_personality_parse(FILE *fp)
 
 	return (0);
 }
+
+void
+personality_test(void)
+{
+	struct persopts opts;
+	struct tcp_con con;
+	u_char buf[TCP_HDR_LEN + PERSOPTS_MAX];
+	struct tcp_hdr *tcp = (struct tcp_hdr *)buf;
+	uint16_t mss;
+
+	tcp_personality_compile("mnwnnt", &opts);
+	if (opts.len != 20 || opts.nmss != 1 || opts.mss_off[0] != 2 ||
+	    opts.nts != 1 || opts.ts_off[0] != 12 || opts.mss_echo)
+		errx(1, "%s: mnwnnt compiled badly", __func__);
+	if (opts.data[0] != TCP_OPT_MSS || opts.data[4] != TCP_OPT_NOP ||
+	    opts.data[5] != TCP_OPT_WSCALE || opts.data[10] != TCP_OPT_TIMESTAMP)
+		errx(1, "%s: mnwnnt encoded badly", __func__);
+
+	/* Nothing but noops is no options at all */
+	tcp_personality_compile("nn", &opts);
+	if (opts.len != 0)
+		errx(1, "%s: nn should be empty", __func__);
+
+	/* Padded to a full word with end of options */
+	tcp_personality_compile("mnl", &opts);
+	if (opts.len != 8 || opts.data[5] != TCP_OPT_EOL || opts.data[7] != 0)
+		errx(1, "%s: mnl padded badly", __func__);
+
+	/* The MSS of the peer is echoed */
+	tcp_personality_compile("me", &opts);
+	if (opts.len != 4 || !opts.mss_echo)
+		errx(1, "%s: me compiled badly", __func__);
+
+	memset(&con, 0, sizeof(con));
+	memset(buf, 0xff, sizeof(buf));
+	con.mss = 536;
+	tcp->th_off = TCP_HDR_LEN >> 2;
+	tcp_personality_options(&con, tcp, &opts);
+	memcpy(&mss, buf + TCP_HDR_LEN + opts.mss_off[0], sizeof(mss));
+	if (tcp->th_off != (TCP_HDR_LEN >> 2) + 1 || ntohs(mss) != 536)
+		errx(1, "%s: MSS not patched: %d", __func__, ntohs(mss));
+
+	/* Probes are told apart without ECE */
+	if (tcp_probe_class[TH_SYN] != PROBE_SYN ||
+	    tcp_probe_class[0] != PROBE_NULL ||
+	    tcp_probe_class[TH_FIN] != PROBE_FIN ||
+	    tcp_probe_class[TH_FIN|TH_PUSH|TH_URG] != PROBE_FPU ||
+	    tcp_probe_class[TH_SYN|TH_ACK] != PROBE_NONE)
+		errx(1, "%s: bad probe classes", __func__);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
@@ -34,11 +34,30 @@
 
 enum ackchange { ACK_KEEP = 0, ACK_ZERO, ACK_DECREMENT };
 
+#define PERSOPTS_MAX	40	/* room for TCP options in a header */
+#define PERSOPTS_PATCH	4	/* MSS or timestamp options we fill in */
+
+/*
+ * TCP options of a response, encoded into wire format when the
+ * personality is read.  Only the MSS and the timestamps depend on the
+ * connection and get patched in when a segment is sent.
+ */
+struct persopts {
+	u_char len;		/* padded to 32 bits; 0 for no options */
+	u_char nmss;
+	u_char nts;
+	u_char mss_echo;	/* bit n: MSS n is the one the peer sent */
+	u_char mss_off[PERSOPTS_PATCH];	/* offsets of the MSS values */
+	u_char ts_off[PERSOPTS_PATCH];	/* offsets of the timestamp values */
+	u_char data[PERSOPTS_MAX];
+};
+
 struct personate {
 	int window;
 	u_char flags;
 	u_char df;
 	char *options;
+	struct persopts opts;	/* options compiled */
 	enum ackchange forceack;
 };
 
@@ -172,10 +191,14 @@ void personality_free(struct personality *);
 
 void ip_personality(struct template *, uint16_t *);
 int tcp_personality(struct tcp_con *, uint8_t *, int *, int *,
-    uint16_t *, char **);
-void tcp_personality_options(struct tcp_con *, struct tcp_hdr *, char *);
+    uint16_t *, const struct persopts **);
+void tcp_personality_options(struct tcp_con *, struct tcp_hdr *,
+    const struct persopts *);
+void tcp_personality_compile(const char *, struct persopts *);
 int tcp_personality_match(struct tcp_con *, int);
 
+extern struct persopts persopts_mss;
+
 int icmp_error_personality(struct template *, struct addr *,
     struct ip_hdr *ip, uint8_t *, uint8_t *, int *, uint8_t *);
 
@@ -184,6 +207,8 @@ int xprobe_personality_parse(FILE *fp);
 void xprobe_personality_init(void);
 void print_perstree(void);
 
+void personality_test(void);
+
 /* Splay stuff here so other modules can use it */
 /* tree containing the ipv4 (nmap) fingerprints */
 static int
@@ -64,23 +64,42 @@ void				 pf_osfp_insert(struct pf_osfp_list *,
 #define TCP_OLEN_MSS		4
 #define TCP_OLEN_TIMESTAMP	10
 
+/*
+ * Fingerprint a TCP SYN carried in either an IPv4 (ip) or an IPv6 (ip6)
+ * header; exactly one of them must be non-NULL.  The caller is expected
+ * to have skipped the IPv6 extension headers and rejected fragments.
+ */
 struct pf_osfp_enlist *
-pf_osfp_fingerprint_hdr(const struct ip_hdr *ip, const struct tcp_hdr *tcp)
+pf_osfp_fingerprint_hdr(const struct ip_hdr *ip, const struct ip6_hdr *ip6,
+    const struct tcp_hdr *tcp)
 {
 	struct pf_os_fingerprint fp, *fpresult;
 	int cnt, optlen = 0;
 	u_int8_t *optp;
 
-	if ((tcp->th_flags & (TH_SYN|TH_ACK)) != TH_SYN || (ip->ip_off &
-	    htons(IP_OFFMASK)))
+	if ((tcp->th_flags & (TH_SYN|TH_ACK)) != TH_SYN)
 		return (NULL);
 
 	memset(&fp, 0, sizeof(fp));
 
-	fp.fp_psize = ntohs(ip->ip_len);
-	fp.fp_ttl = ip->ip_ttl;
-	if (ip->ip_off & htons(IP_DF))
+	if (ip != NULL) {
+		if (ip->ip_off & htons(IP_OFFMASK))
+			return (NULL);
+		fp.fp_psize = ntohs(ip->ip_len);
+		fp.fp_ttl = ip->ip_ttl;
+		if (ip->ip_off & htons(IP_DF))
+			fp.fp_flags |= PF_OSFP_DF;
+	} else {
+		/*
+		 * The signatures are all taken over IPv4, so size the SYN
+		 * as if it had come with a plain IPv4 header.  IPv6 never
+		 * fragments in transit, which is what DF says for IPv4.
+		 */
+		fp.fp_psize = IP_HDR_LEN + IP6_HDR_LEN +
+		    ntohs(ip6->ip6_plen) - ((u_char *)tcp - (u_char *)ip6);
+		fp.fp_ttl = ip6->ip6_hlim;
 		fp.fp_flags |= PF_OSFP_DF;
+	}
 	fp.fp_wsize = ntohs(tcp->th_win);
 
 
@@ -143,7 +162,8 @@ pf_osfp_fingerprint_hdr(const struct ip_hdr *ip, const struct tcp_hdr *tcp)
 
 	DPFPRINTF("fingerprinted %s:%d  %d:%d:%d:%d:%llx (%d) "
 	    "(TS=%s,M=%s%d,W=%s%d)\n",
-	    inet_ntoa(ip->ip_src), ntohs(tcp->th_sport),
+	    ip != NULL ? ip_ntoa(&ip->ip_src) : ip6_ntoa(&ip6->ip6_src),
+	    ntohs(tcp->th_sport),
 	    fp.fp_wsize, fp.fp_ttl, (fp.fp_flags & PF_OSFP_DF) != 0,
 	    fp.fp_psize, (long long int)fp.fp_tcpopts, fp.fp_optcnt,
 	    (fp.fp_flags & PF_OSFP_TS0) ? "0" : "",
@@ -141,7 +141,8 @@ struct pf_osfp_ioctl {
 /* The fingerprint functions can be linked into userland programs (tcpdump) */
 int	pf_osfp_add(struct pf_osfp_ioctl *);
 struct pf_osfp_enlist *
-	pf_osfp_fingerprint_hdr(const struct ip_hdr *, const struct tcp_hdr *);
+	pf_osfp_fingerprint_hdr(const struct ip_hdr *, const struct ip6_hdr *,
+	    const struct tcp_hdr *);
 void	pf_osfp_flush(void);
 int	pf_osfp_get(struct pf_osfp_ioctl *);
 void	pf_osfp_initialize(void);
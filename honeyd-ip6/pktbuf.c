@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/queue.h>
+#include <sys/tree.h>
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dnet.h>
+#include <event.h>
+
+#include "honeyd.h"
+#include "pool.h"
+#include "pktbuf.h"
+
+struct pktstats pktstats;
+
+static struct pool *pool_pkt;
+
+void
+pktbuf_init(void)
+{
+	pool_pkt = pool_init("packet", sizeof(struct pktbuf) + HONEYD_MTU);
+}
+
+/*
+ * Returns a packet buffer with a single reference.  Anything larger than
+ * the MTU is allocated separately and goes back to malloc when freed.
+ */
+
+void *
+pktbuf_alloc(u_int size)
+{
+	struct pktbuf *pb;
+
+	if (size <= HONEYD_MTU)
+		pb = pool_alloc(pool_pkt);
+	else
+		pb = pool_alloc_size(pool_pkt, sizeof(struct pktbuf) + size);
+
+	pb->pb_refcnt = 1;
+	pb->pb_size = size <= HONEYD_MTU ? HONEYD_MTU : size;
+	pktstats.allocs++;
+
+	return ((u_char *)pb + sizeof(struct pktbuf));
+}
+
+void *
+pktbuf_copy(const void *data, u_int len)
+{
+	void *p = pktbuf_alloc(len);
+
+	memcpy(p, data, len);
+	pktstats.copies++;
+
+	return (p);
+}
+
+void
+pktbuf_free(void *p)
+{
+	struct pktbuf *pb = PKTBUF_HDR(p);
+
+	if (pb->pb_refcnt == 0)
+		errx(1, "%s: %p has no references", __func__, p);
+	if (--pb->pb_refcnt)
+		return;
+
+	pool_free(pool_pkt, pb);
+}
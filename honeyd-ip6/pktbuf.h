@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _PKTBUF_
+#define _PKTBUF_
+
+/*
+ * Packets that honeyd generates or has to keep around live in reference
+ * counted buffers.  The rest of the code only sees the packet data; the
+ * header sits in front of it, the same way the pool keeps its entries.
+ * Frames coming from the capture interface are not packet buffers: they
+ * belong to pcap or the packet ring and are only copied when they need
+ * to outlive the receive callback.
+ */
+
+struct pktbuf {
+	u_int pb_refcnt;
+	u_int pb_size;
+};
+
+#define PKTBUF_HDR(p)	((struct pktbuf *)((u_char *)(p) - sizeof(struct pktbuf)))
+
+struct pktstats {
+	uint64_t allocs;
+	uint64_t copies;	/* captured frames that had to be kept */
+	uint64_t refs;		/* buffers shared instead of copied */
+};
+
+void pktbuf_init(void);
+void *pktbuf_alloc(u_int);
+void *pktbuf_copy(const void *, u_int);
+void pktbuf_free(void *);
+
+extern struct pktstats pktstats;
+
+static __inline void *
+pktbuf_ref(void *p)
+{
+	PKTBUF_HDR(p)->pb_refcnt++;
+	pktstats.refs++;
+	return (p);
+}
+
+#endif /* _PKTBUF_ */
@@ -41,61 +41,262 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "pool.h"
 
+#define POOL_PAGE_HDR \
+	((sizeof(struct pool_page) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+struct poolq pools = TAILQ_HEAD_INITIALIZER(pools);
+
+static u_int pool_generation;
+
 struct pool*
-pool_init(size_t size)
+pool_init(const char *name, size_t size)
 {
 	struct pool *pool;
 
-	if (POOL_PAGE_SIZE / (sizeof(struct pool_entry) + size) < 1)
+	/* Keep the objects aligned */
+	size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+	if ((POOL_PAGE_SIZE - POOL_PAGE_HDR) /
+	    (sizeof(struct pool_entry) + size) < 1)
 		errx(1, "%s: object size too large for pool", __func__);
 
 	if ((pool = calloc(1, sizeof(struct pool))) == NULL)
 		err(1, "%s: calloc", __func__);
 
-	SLIST_INIT(&pool->entries);
+	TAILQ_INIT(&pool->partial);
+	TAILQ_INIT(&pool->full);
+	TAILQ_INIT(&pool->empty);
+	pool->name = name;
 	pool->size = size;
+	pool->perpage = (POOL_PAGE_SIZE - POOL_PAGE_HDR) /
+	    (sizeof(struct pool_entry) + size);
+
+	TAILQ_INSERT_TAIL(&pools, pool, next);
 
 	return (pool);
 }
 
+static void
+pool_page_release(struct pool *pool, struct pool_page *page)
+{
+	TAILQ_REMOVE(&pool->empty, page, next);
+	free(page);
+
+	pool->npages--;
+	pool->released++;
+}
+
+/*
+ * Gives all empty pages back that are not needed for the reserve.  If
+ * force is not set, a page has to have been empty for a few rounds, so
+ * that a bursty load does not keep going back to malloc.
+ */
+
+static void
+pool_reclaim_pool(struct pool *pool, int force)
+{
+	struct pool_page *page, *prev;
+
+	/* The oldest empty pages are at the end */
+	for (page = TAILQ_LAST(&pool->empty, pool_pageq); page != NULL;
+	    page = prev) {
+		prev = TAILQ_PREV(page, pool_pageq, next);
+		if (!force &&
+		    pool_generation - page->generation < POOL_RECLAIM_AGE)
+			break;
+		if ((pool->npages - 1) * pool->perpage < pool->reserve)
+			break;
+		pool_page_release(pool, page);
+	}
+}
+
+void
+pool_reclaim(void)
+{
+	struct pool *pool;
+
+	pool_generation++;
+	TAILQ_FOREACH(pool, &pools, next)
+		pool_reclaim_pool(pool, 0);
+}
+
+static struct pool_page *
+pool_page_new(struct pool *pool)
+{
+	struct pool_page *page;
+	struct pool_entry *entry;
+	u_char *p;
+	u_int i;
+
+	if ((page = malloc(POOL_PAGE_SIZE)) == NULL) {
+		struct pool *tmp;
+
+		/* Try again after giving back everything we can */
+		pool->failures++;
+		TAILQ_FOREACH(tmp, &pools, next)
+			pool_reclaim_pool(tmp, 1);
+		if ((page = malloc(POOL_PAGE_SIZE)) == NULL)
+			err(1, "%s: malloc", __func__);
+	}
+
+	SLIST_INIT(&page->entries);
+	page->nfree = pool->perpage;
+	page->generation = pool_generation;
+
+	p = (u_char *)page + POOL_PAGE_HDR;
+	for (i = 0; i < pool->perpage; i++) {
+		entry = (struct pool_entry *)p;
+		entry->data = p + sizeof(struct pool_entry);
+		entry->page = page;
+		entry->size = pool->size;
+		SLIST_INSERT_HEAD(&page->entries, entry, next);
+		p += sizeof(struct pool_entry) + pool->size;
+	}
+
+	pool->npages++;
+
+	return (page);
+}
+
 void *
 pool_alloc_size(struct pool *pool, size_t size)
 {
 	struct pool_entry *entry = NULL;
+	struct pool_page *page;
 
 	if (size) {
 		entry = malloc(size + sizeof(struct pool_entry));
-		if (entry == NULL)
-			err(1, "%s: malloc", __func__);
+		if (entry == NULL) {
+			struct pool *tmp;
+
+			pool->failures++;
+			TAILQ_FOREACH(tmp, &pools, next)
+				pool_reclaim_pool(tmp, 1);
+			entry = malloc(size + sizeof(struct pool_entry));
+			if (entry == NULL)
+				err(1, "%s: malloc", __func__);
+		}
 		
-		entry->data = (void *)entry + sizeof(struct pool_entry);;
+		entry->data = (void *)entry + sizeof(struct pool_entry);
+		entry->page = NULL;
 		entry->size = size;
-		pool->nalloc++;
 	} else {
-		void *p = malloc(POOL_PAGE_SIZE);
-		int i, max;
+		/* Reuse the most recently emptied page first */
+		if ((page = TAILQ_FIRST(&pool->empty)) != NULL)
+			TAILQ_REMOVE(&pool->empty, page, next);
+		else
+			page = pool_page_new(pool);
+		TAILQ_INSERT_HEAD(&pool->partial, page, next);
 
-		if (p == NULL)
-			err(1, "%s: malloc", __func__);
-
-		size = pool->size;
-		max = POOL_PAGE_SIZE / (sizeof(struct pool_entry) + size);
-		pool->nalloc += max;
-		for (i = 0; i < max; i++) {
-			entry = p;
-			entry->data = (void *)entry+ sizeof(struct pool_entry);
-			entry->size = size;
-
-			/* We want to use the last one as return */
-			if (i < max - 1) {
-				SLIST_INSERT_HEAD(&pool->entries, entry, next);
-				p += sizeof(struct pool_entry) + size;
-			}
-		}
+		return (pool_alloc(pool));
 	}
 
+	if (++pool->inuse > pool->highwater)
+		pool->highwater = pool->inuse;
 	return (entry->data);
 }
+
+/*
+ * Returns an object whose page needs to move to a different list, or
+ * that has been allocated by itself.
+ */
+
+void
+pool_free_page(struct pool *pool, struct pool_entry *entry)
+{
+	struct pool_page *page = entry->page;
+	struct pool_pageq *from;
+
+	if (page == NULL) {
+		free(entry);
+		return;
+	}
+
+	from = page->nfree == 0 ? &pool->full : &pool->partial;
+	SLIST_INSERT_HEAD(&page->entries, entry, next);
+	page->nfree++;
+
+	TAILQ_REMOVE(from, page, next);
+	if (page->nfree == pool->perpage) {
+		page->generation = pool_generation;
+		TAILQ_INSERT_HEAD(&pool->empty, page, next);
+	} else
+		TAILQ_INSERT_HEAD(&pool->partial, page, next);
+}
+
+/*
+ * Fills the pool with enough pages to hold at least n objects,
+ * so that later allocations do not have to go to malloc.  These
+ * pages are kept even when they are not used.
+ */
+
+void
+pool_prealloc(struct pool *pool, int n)
+{
+	struct pool_page *page;
+
+	pool->reserve = n;
+	while (pool->npages * pool->perpage < n) {
+		page = pool_page_new(pool);
+		TAILQ_INSERT_TAIL(&pool->empty, page, next);
+	}
+}
+
+void
+pool_test(void)
+{
+	struct pool *pool = pool_init("test", 100);
+	void *objs[100];
+	int i, n = sizeof(objs) / sizeof(objs[0]);
+	u_int npages;
+
+	for (i = 0; i < n; i++)
+		objs[i] = pool_alloc(pool);
+	if (pool->inuse != n || pool->highwater != n)
+		errx(1, "%s: bad accounting", __func__);
+	npages = (n + pool->perpage - 1) / pool->perpage;
+	if (pool->npages != npages)
+		errx(1, "%s: %u pages instead of %u", __func__,
+		    pool->npages, npages);
+
+	/* No page becomes empty while half of its objects are in use */
+	for (i = 0; i < n; i += 2)
+		pool_free(pool, objs[i]);
+	if (!TAILQ_EMPTY(&pool->empty) || !TAILQ_EMPTY(&pool->full))
+		errx(1, "%s: pages on the wrong list", __func__);
+
+	for (i = 1; i < n; i += 2)
+		pool_free(pool, objs[i]);
+	if (pool->inuse != 0 || pool->highwater != n ||
+	    !TAILQ_EMPTY(&pool->partial))
+		errx(1, "%s: pages still in use", __func__);
+
+	/* Empty pages are only given back after a while */
+	pool_reclaim();
+	if (pool->npages != npages)
+		errx(1, "%s: pages released too early", __func__);
+	for (i = 1; i < POOL_RECLAIM_AGE; i++)
+		pool_reclaim();
+	if (pool->npages != 0 || pool->released != npages)
+		errx(1, "%s: empty pages were not released", __func__);
+
+	/* But never the reserve */
+	pool_prealloc(pool, 2 * pool->perpage);
+	for (i = 0; i <= POOL_RECLAIM_AGE; i++)
+		pool_reclaim();
+	if (pool->npages != 2)
+		errx(1, "%s: reserve was released", __func__);
+
+	pool_prealloc(pool, 0);
+	pool_reclaim();
+	if (pool->npages != 0)
+		errx(1, "%s: pages left after dropping the reserve", __func__);
+
+	TAILQ_REMOVE(&pools, pool, next);
+	free(pool);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
@@ -33,22 +33,61 @@
 #ifndef _POOL_
 #define _POOL_
 
-#define POOL_PAGE_SIZE	4096
+#define POOL_PAGE_SIZE		4096
+#define POOL_RECLAIM_INTERVAL	10	/* seconds between pool_reclaim() */
+#define POOL_RECLAIM_AGE	3	/* rounds a page stays empty */
+
+struct pool_page;
 
 struct pool_entry {
 	SLIST_ENTRY(pool_entry) next;
 	void *data;
+	struct pool_page *page;		/* NULL if allocated by itself */
 	size_t size;
 };
 
+/*
+ * Every page keeps its own free list, so that we know when all of its
+ * objects have been returned and the page can go back to the system.
+ */
+
+struct pool_page {
+	TAILQ_ENTRY(pool_page) next;
+	SLIST_HEAD(, pool_entry) entries;
+	u_int nfree;
+	u_int generation;		/* reclaim round it became empty */
+};
+
+TAILQ_HEAD(pool_pageq, pool_page);
+
 struct pool {
-	SLIST_HEAD(poolq, pool_entry) entries;
+	struct pool_pageq partial;	/* pages with free objects */
+	struct pool_pageq full;
+	struct pool_pageq empty;	/* waiting to be released */
+	TAILQ_ENTRY(pool) next;
+
+	const char *name;
 	size_t size;
-	int nalloc;
+	u_int perpage;
+	u_int reserve;			/* objects that are never released */
+
+	u_int npages;
+	u_int inuse;
+	u_int highwater;
+	u_int failures;			/* malloc failed and we had to reclaim */
+	u_int released;			/* pages given back to the system */
 };
 
-struct pool *pool_init(size_t);
+TAILQ_HEAD(poolq, pool);
+extern struct poolq pools;
+
+struct pool *pool_init(const char *, size_t);
 void *pool_alloc_size(struct pool *, size_t);
+void pool_free_page(struct pool *, struct pool_entry *);
+void pool_prealloc(struct pool *, int);
+void pool_reclaim(void);
+
+void pool_test(void);
 
 /* 
  * The pool interface cached allocation of fixed sized objects,
@@ -58,33 +97,45 @@ void *pool_alloc_size(struct pool *, size_t);
 static __inline void *
 pool_alloc(struct pool *pool)
 {
+	struct pool_page *page;
 	struct pool_entry *entry;
 
-	if ((entry = SLIST_FIRST(&pool->entries)) == NULL)
+	if ((page = TAILQ_FIRST(&pool->partial)) == NULL)
 		return (pool_alloc_size(pool, 0));
 
-	SLIST_REMOVE_HEAD(&pool->entries, next);
+	entry = SLIST_FIRST(&page->entries);
+	SLIST_REMOVE_HEAD(&page->entries, next);
+	if (--page->nfree == 0) {
+		TAILQ_REMOVE(&pool->partial, page, next);
+		TAILQ_INSERT_HEAD(&pool->full, page, next);
+	}
+
+	if (++pool->inuse > pool->highwater)
+		pool->highwater = pool->inuse;
 	return (entry->data);
 }
 
-#include <syslog.h>
 static __inline void
 pool_free(struct pool *pool, void *addr)
 {
 	struct pool_entry *entry = addr - sizeof(struct pool_entry);
+	struct pool_page *page = entry->page;
 
 	if (entry->data != addr)
 		errx(1, "%s: bad address: %p != %p", __func__,
 		    addr, entry->data);
 
+	pool->inuse--;
 
-
-	if (entry->size == pool->size)
-		SLIST_INSERT_HEAD(&pool->entries, entry, next);
-	else {
-		free(entry);
-		pool->nalloc--;
+	/* Only pages that change their list need extra work */
+	if (page == NULL || page->nfree == 0 ||
+	    page->nfree + 1 == pool->perpage) {
+		pool_free_page(pool, entry);
+		return;
 	}
+
+	SLIST_INSERT_HEAD(&page->entries, entry, next);
+	page->nfree++;
 }
 
 #endif /* _POOL_ */
@@ -73,6 +73,9 @@
 #include "histogram.h"
 #include "osfp.h"
 #include "debug.h"
+#include "txqueue.h"
+#include "pool.h"
+#include "pktbuf.h"
 
 int make_socket(int (*f)(int, const struct sockaddr *, socklen_t), int type,
     char *, uint16_t);
@@ -141,6 +144,10 @@ static PyObject *pyextend_uptime(PyObject *, PyObject *);
 static PyObject *pyextend_interfaces(PyObject *, PyObject *);
 static PyObject *pyextend_stats_network(PyObject *, PyObject *);
 static PyObject *pyextend_status_connections(PyObject *, PyObject *);
+static PyObject *pyextend_stats_connections(PyObject *, PyObject *);
+static PyObject *pyextend_stats_transmit(PyObject *, PyObject *);
+static PyObject *pyextend_stats_delay(PyObject *, PyObject *);
+static PyObject *pyextend_stats_pools(PyObject *, PyObject *);
 static PyObject *pyextend_config(PyObject *, PyObject *);
 static PyObject *pyextend_config_ips(PyObject *, PyObject *);
 static PyObject *pyextend_delete_template(PyObject *, PyObject *);
@@ -164,6 +171,14 @@ static PyMethodDef HoneydMethods[] = {
      "Returns a dictionary with network statistics."},
     {"status_connections", pyextend_status_connections, METH_VARARGS,
      "Returns a list of active UDP or TCP connections."},
+    {"stats_connections", pyextend_stats_connections, METH_VARARGS,
+     "Returns a dictionary with the connection budget and evictions."},
+    {"stats_transmit", pyextend_stats_transmit, METH_VARARGS,
+     "Returns a dictionary with transmit queue statistics."},
+    {"stats_delay", pyextend_stats_delay, METH_VARARGS,
+     "Returns a dictionary with statistics about delayed packets."},
+    {"stats_pools", pyextend_stats_pools, METH_VARARGS,
+     "Returns a dictionary with the memory usage of each pool."},
     {"config", pyextend_config, METH_VARARGS,
      "Returns an associative array with config information."},
     {"config_ips", pyextend_config_ips, METH_VARARGS,
@@ -391,7 +406,7 @@ pyextend_stats_network(PyObject *self, PyObject *args)
 	PyObject *pValue;
 	extern struct stats_network stats_network;
 	
-	pValue = Py_BuildValue("{s:(d,d,d),s:(d,d,d)}",
+	pValue = Py_BuildValue("{s:(d,d,d),s:(d,d,d),s:(d,d,d)}",
 	    "Input Bytes", 
 	    (double)count_get_minute(stats_network.input_bytes)/60.0,
 	    (double)count_get_hour(stats_network.input_bytes)/3600.0,
@@ -399,7 +414,11 @@ pyextend_stats_network(PyObject *self, PyObject *args)
 	    "Output Bytes",
 	    (double)count_get_minute(stats_network.output_bytes)/60.0,
 	    (double)count_get_hour(stats_network.output_bytes)/3600.0,
-	    (double)count_get_day(stats_network.output_bytes)/86400.0);
+	    (double)count_get_day(stats_network.output_bytes)/86400.0,
+	    "Input Drops",
+	    (double)count_get_minute(stats_network.input_drops)/60.0,
+	    (double)count_get_hour(stats_network.input_drops)/3600.0,
+	    (double)count_get_day(stats_network.input_drops)/86400.0);
 
 	if (pValue == NULL) {
 		PyErr_Print();
@@ -409,6 +428,105 @@ pyextend_stats_network(PyObject *self, PyObject *args)
 	return (pValue);
 }
 
+static PyObject*
+pyextend_stats_connections(PyObject *self, PyObject *args)
+{
+	PyObject *pValue;
+	extern struct conbudget honeyd_conbudget;
+	extern int honeyd_nconnects;
+	struct conbudget *budget = &honeyd_conbudget;
+
+	pValue = Py_BuildValue("{s:i,s:i,s:i,s:i,s:K,s:K}",
+	    "connections", honeyd_nconnects,
+	    "max_connections", budget->max_connects,
+	    "max_per_source", budget->max_per_source,
+	    "sources", budget->nsources,
+	    "evicted_idle",
+	    (unsigned PY_LONG_LONG)budget->evictions[CON_EVICT_IDLE],
+	    "evicted_source",
+	    (unsigned PY_LONG_LONG)budget->evictions[CON_EVICT_SOURCE]);
+
+	if (pValue == NULL) {
+		PyErr_Print();
+		errx(1, "%s: failed to build argument list", __func__);
+	}
+
+	return (pValue);
+}
+
+static PyObject*
+pyextend_stats_transmit(PyObject *self, PyObject *args)
+{
+	PyObject *pValue;
+
+	pValue = Py_BuildValue("{s:K,s:K,s:K,s:K,s:i,s:i,s:i}",
+	    "packets", (unsigned PY_LONG_LONG)txstats.packets,
+	    "flushes", (unsigned PY_LONG_LONG)txstats.flushes,
+	    "syscalls", (unsigned PY_LONG_LONG)txstats.syscalls,
+	    "errors", (unsigned PY_LONG_LONG)txstats.errors,
+	    "depth", txstats.depth,
+	    "max_depth", txstats.max_depth,
+	    "last_flush", txstats.last_flush);
+
+	if (pValue == NULL) {
+		PyErr_Print();
+		errx(1, "%s: failed to build argument list", __func__);
+	}
+
+	return (pValue);
+}
+
+static PyObject*
+pyextend_stats_delay(PyObject *self, PyObject *args)
+{
+	PyObject *pValue;
+
+	pValue = Py_BuildValue("{s:K,s:K,s:K,s:K,s:i,s:i,s:i,s:K,s:K,s:K}",
+	    "scheduled", (unsigned PY_LONG_LONG)twstats.scheduled,
+	    "fired", (unsigned PY_LONG_LONG)twstats.fired,
+	    "ticks", (unsigned PY_LONG_LONG)twstats.ticks,
+	    "cascaded", (unsigned PY_LONG_LONG)twstats.cascaded,
+	    "pending", twstats.pending,
+	    "max_pending", twstats.max_pending,
+	    "max_batch", twstats.max_batch,
+	    "buffers", (unsigned PY_LONG_LONG)pktstats.allocs,
+	    "copies", (unsigned PY_LONG_LONG)pktstats.copies,
+	    "shared", (unsigned PY_LONG_LONG)pktstats.refs);
+
+	if (pValue == NULL) {
+		PyErr_Print();
+		errx(1, "%s: failed to build argument list", __func__);
+	}
+
+	return (pValue);
+}
+
+static PyObject*
+pyextend_stats_pools(PyObject *self, PyObject *args)
+{
+	PyObject *pDict, *pValue;
+	struct pool *pool;
+
+	pDict = PyDict_New();
+	TAILQ_FOREACH(pool, &pools, next) {
+		pValue = Py_BuildValue("{s:i,s:i,s:i,s:i,s:i,s:i}",
+		    "size", (int)pool->size,
+		    "current", pool->inuse,
+		    "high_water", pool->highwater,
+		    "pages", pool->npages,
+		    "failures", pool->failures,
+		    "released", pool->released);
+		if (pValue == NULL) {
+			PyErr_Print();
+			errx(1, "%s: failed to build argument list", __func__);
+		}
+		PyDict_SetItemString(pDict, pool->name, pValue);
+		Py_DECREF(pValue);
+	}
+
+	return (pDict);
+}
+
 static PyObject*
 pyextend_config(PyObject *self, PyObject *args)
 {
@@ -494,8 +612,8 @@ pyextend_delete_template(PyObject *self, PyObject *args)
 static PyObject*
 pyextend_delete_connection(PyObject *self, PyObject *args)
 {
-	extern struct tree tcpcons;
-	extern struct tree udpcons;
+	extern struct flowtable tcpcons;
+	extern struct flowtable udpcons;
 	struct tuple tmp, *hdr;
 	char *protocol;
 	char *asrc, *adst, *asport, *adport;
@@ -511,8 +629,14 @@ pyextend_delete_connection(PyObject *self, PyObject *args)
 	if (addr_aton(adst, &dst) == -1)
 		goto done;
 
-	tmp.ip_src = src.addr_ip;
-	tmp.ip_dst = dst.addr_ip;
+	memset(&tmp, 0, sizeof(tmp));
+	if (src.addr_type == ADDR_TYPE_IP6 && dst.addr_type == ADDR_TYPE_IP6) {
+		tmp.src_addr = src;
+		tmp.dst_addr = dst;
+	} else {
+		tmp.ip_src = src.addr_ip;
+		tmp.ip_dst = dst.addr_ip;
+	}
 	tmp.sport = atoi(asport);
 	tmp.dport = atoi(adport);
 
@@ -1030,7 +1154,6 @@ pyextend_connection_start(struct tuple *hdr, struct command *cmd,
 	struct pystate *state;
 	PyObject *pArgs, *pValue;
 	struct addr src, dst;
-	struct ip_hdr ip;
 	char *os_name = NULL;
 
 	if ((state = pyextend_newstate(cmd, con, pye)) == NULL)
@@ -1049,8 +1172,7 @@ pyextend_connection_start(struct tuple *hdr, struct command *cmd,
 	addr_pack(&dst, ADDR_TYPE_IP, IP_ADDR_BITS, &hdr->ip_dst,IP_ADDR_LEN);
 
 	/* Determine the remote operating system */
-	ip.ip_src = hdr->ip_src;
-	os_name = honeyd_osfp_name(&ip);
+	os_name = honeyd_osfp_name(hdr);
 
 	pArgs = PyTuple_New(1);
 	pValue = Py_BuildValue("{sssssisiss}",
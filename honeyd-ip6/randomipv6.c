@@ -39,6 +39,7 @@
 #endif
 
 #include <stdlib.h>
+#include <time.h>
 #include <sys/tree.h>
 #include <sys/queue.h>
 #include <dnet.h>
@@ -52,6 +53,8 @@
 #include "template.h"
 #include "randomipv6.h"
 #include "bloom.h"
+#include "siphash.h"
+#include "plugins_config.h"
 
 #include <netinet/icmp6.h>
 #include "icmp6.h"
@@ -59,21 +62,190 @@
 #include <arpa/inet.h>
 
 
-BLOOM *blocked_addr_bloom_filter;
+extern rand_t *honeyd_rand;
+
+/*
+ * Addresses excluded by the configuration stay blocked forever.  Addresses
+ * that were rejected at random go into a generational filter, so that they
+ * may be offered again once they have expired.
+ */
+static struct bloom excluded_addrs;
+static struct bloomgen rejected_addrs;
 int number_of_collisions = 0;
 
-void init_blocked_addr_bloom_filter()
+/*
+ * With a configured secret, whether an address gets a template is decided
+ * by a keyed hash of the address.  The answer is the same every time and
+ * after restarts, so rejected addresses need not be remembered at all.
+ */
+static struct siphash_key admission_key;
+static int admission_keyed;
+
+/*
+ * Templates that were created on demand are reclaimed when they have been
+ * idle for too long or when they would exceed the memory budget.
+ */
+static int template_idle = RANDOM_IPV6_IDLE;
+static u_int template_max;		/* from the memory budget, 0 if none */
+static struct event template_reap_ev;
+static struct randomipv6_stats stats;
+
+void randomipv6_init()
 {
-    blocked_addr_bloom_filter = bloom_create(40000000);
-    if (!blocked_addr_bloom_filter)
+    if (bloom_init(&excluded_addrs, RANDOM_IPV6_EXCLUDE_CAPACITY,
+                   RANDOM_IPV6_EXCLUDE_FPRATE, rand_uint32(honeyd_rand)) == -1)
     {
         errx(1,"could not create bloom filter!");
     }
 }
 
-void randomipv6_init()
+/* What an on-demand template costs us, roughly */
+
+static size_t randomipv6_template_cost(void)
+{
+    return (sizeof(struct template) + sizeof(struct addr) +
+            sizeof(struct ndp_neighbor_req) +
+            INET6_ADDRSTRLEN);
+}
+
+static void randomipv6_reap_cb(int fd, short what, void *arg)
+{
+    struct timeval tv;
+    int n;
+
+    if ((n = template_reclaim_idle(time(NULL), template_idle)) > 0)
+    {
+        stats.reclaimed_idle += n;
+        syslog(LOG_DEBUG, "reclaimed %d idle random ipv6 templates", n);
+    }
+
+    timerclear(&tv);
+    tv.tv_sec = RANDOM_IPV6_REAP_INTERVAL;
+    evtimer_add(&template_reap_ev, &tv);
+}
+
+/*
+ * Reads how long on-demand templates may stay idle (randomipv6_idle, in
+ * seconds) and how much memory they may take (randomipv6_memory, in
+ * megabytes).  Neither is limited by default.
+ */
+
+static void randomipv6_templates_config(void)
+{
+    const struct honeyd_plugin_cfg *cfg;
+    struct timeval tv;
+
+    if ((cfg = plugins_config_find_item("honeyd",
+                 "randomipv6_idle", HD_CONFIG_INT)) != NULL && cfg->cfg_int >= 0)
+        template_idle = cfg->cfg_int;
+    if ((cfg = plugins_config_find_item("honeyd",
+                 "randomipv6_memory", HD_CONFIG_INT)) != NULL && cfg->cfg_int > 0)
+    {
+        template_max = ((size_t)cfg->cfg_int << 20) / randomipv6_template_cost();
+        if (template_max == 0)
+            template_max = 1;
+    }
+
+    evtimer_set(&template_reap_ev, randomipv6_reap_cb, NULL);
+    timerclear(&tv);
+    tv.tv_sec = RANDOM_IPV6_REAP_INTERVAL;
+    evtimer_add(&template_reap_ev, &tv);
+}
+
+/*
+ * Sizes the filter of rejected addresses from the configuration.  Each
+ * generation holds randomipv6_capacity addresses at the false positive
+ * rate given by randomipv6_fprate; rejected addresses are forgotten after
+ * randomipv6_expire seconds, or never if it is 0.
+ */
+
+void randomipv6_config(void)
+{
+    const struct honeyd_plugin_cfg *cfg;
+    int capacity = RANDOM_IPV6_CAPACITY;
+    double fprate = RANDOM_IPV6_FPRATE;
+    int expire = RANDOM_IPV6_EXPIRE;
+    int interval;
+    uint64_t seed;
+
+    randomipv6_templates_config();
+
+    if ((cfg = plugins_config_find_item("honeyd",
+                 "randomipv6_secret", HD_CONFIG_STR)) != NULL
+            && cfg->cfg_str != NULL && *cfg->cfg_str != '\0')
+    {
+        siphash_key_init(&admission_key, cfg->cfg_str, strlen(cfg->cfg_str));
+        admission_keyed = 1;
+        syslog(LOG_INFO, "random ipv6 addresses are admitted by keyed hash");
+        return;
+    }
+
+    if ((cfg = plugins_config_find_item("honeyd",
+                 "randomipv6_capacity", HD_CONFIG_INT)) != NULL && cfg->cfg_int > 0)
+        capacity = cfg->cfg_int;
+    if ((cfg = plugins_config_find_item("honeyd",
+                 "randomipv6_fprate", HD_CONFIG_FLT)) != NULL)
+        fprate = cfg->cfg_flt;
+    if ((cfg = plugins_config_find_item("honeyd",
+                 "randomipv6_expire", HD_CONFIG_INT)) != NULL && cfg->cfg_int >= 0)
+        expire = cfg->cfg_int;
+
+    /* An interval of 0 never rotates, a short expiry must still expire */
+    interval = expire > 0 ? MAX(1, expire / BLOOM_GENERATIONS) : 0;
+
+    rand_get(honeyd_rand, &seed, sizeof(seed));
+    if (bloomgen_init(&rejected_addrs, capacity, fprate, interval, seed) == -1)
+    {
+        errx(1, "could not create bloom filter for %d addresses at %f",
+             capacity, fprate);
+    }
+
+    syslog(LOG_INFO, "rejecting up to %d addresses per %d seconds "
+           "with %d hashes and %lu KB per generation", capacity,
+           interval, rejected_addrs.gen[0].nhashes,
+           (u_long)((rejected_addrs.gen[0].mask + 1) >> 13));
+}
+
+static void randomipv6_rotate(time_t now)
+{
+    int n;
+
+    if ((n = bloomgen_rotate(&rejected_addrs, now)) == 0)
+        return;
+
+    syslog(LOG_INFO, "expired %d generations of rejected addresses: "
+           "%llu remembered, estimated false positive rate %f",
+           n, (unsigned long long)bloomgen_count(&rejected_addrs),
+           bloomgen_fprate(&rejected_addrs));
+}
+
+static int randomipv6_blocked(const struct addr *addr)
+{
+    if (bloom_check(&excluded_addrs, &addr->addr_ip6, IP6_ADDR_LEN))
+        return (1);
+    if (admission_keyed)
+        return (0);
+
+    randomipv6_rotate(time(NULL));
+    return (bloomgen_check(&rejected_addrs, &addr->addr_ip6, IP6_ADDR_LEN));
+}
+
+/*
+ * Accepts the given fraction of the address space: the address passes if
+ * its hash falls below that fraction of the 64-bit range.
+ */
+
+static int is_keyed_accepted(const struct addr *addr, float randomipv6_percentage)
 {
-    init_blocked_addr_bloom_filter();
+    uint64_t hash;
+
+    if (randomipv6_percentage >= 1.0)
+        return (1);
+    if (randomipv6_percentage <= 0.0)
+        return (0);
+
+    hash = siphash(&admission_key, &addr->addr_ip6, IP6_ADDR_LEN);
+    return (hash < (uint64_t)(randomipv6_percentage * 18446744073709551616.0));
 }
 
 int is_randomly_accepted(float randomipv6_percentage)
@@ -94,14 +266,14 @@ int is_randomly_accepted(float randomipv6_percentage)
     }
 }
 
-char *get_template_name_from_packet(struct ip6_hdr *ip6) 
+char *get_template_name_from_packet(const struct ip6_desc *desc) 
 {
+    struct ip6_hdr *ip6 = desc->ip6;
     struct icmp6_hdr *icmp6;
-    u_char *tcp=NULL,*udp=NULL;
     char *template_name = NULL;
     int use_ip6_dst_address = 0;
     /* in case of a neighbor solicitation get the solicited address */
-    get_ip6_next_hdr((u_char**) &icmp6, ip6, IPPROTO_ICMPV6);
+    icmp6 = (struct icmp6_hdr *) IP6_DESC_UPPER(desc, IPPROTO_ICMPV6);
     if (icmp6 != NULL && icmp6->icmp6_type==ND_NEIGHBOR_SOLICIT)
     {
       template_name = get_solicited_addr_as_str(icmp6);
@@ -109,9 +281,7 @@ char *get_template_name_from_packet(struct ip6_hdr *ip6)
    
 
     /* in case of tcp, udp or an echo request */
-    get_ip6_next_hdr((u_char**) &tcp, ip6, IPPROTO_TCP);
-    get_ip6_next_hdr((u_char**) &udp, ip6, IPPROTO_UDP);
-    use_ip6_dst_address = tcp!=NULL || udp!=NULL || (icmp6 != NULL && icmp6->icmp6_type==ICMP6_ECHO_REQUEST);
+    use_ip6_dst_address = desc->proto == IPPROTO_TCP || desc->proto == IPPROTO_UDP || (icmp6 != NULL && icmp6->icmp6_type==ICMP6_ECHO_REQUEST);
     if(use_ip6_dst_address)
     {
       template_name = (char *)malloc(INET6_ADDRSTRLEN);
@@ -128,7 +298,7 @@ char *get_template_name_from_packet(struct ip6_hdr *ip6)
   return template_name;
 }
 
-void create_template(char *template_name, const struct interface *inter,FILE *logfp)
+int create_template(const char *template_name, const struct interface *inter,FILE *logfp)
 {
     struct template *default_template=NULL,*new_template=NULL;
     syslog(LOG_DEBUG,"create template for %s to handle dynamic request",template_name);
@@ -143,11 +313,23 @@ void create_template(char *template_name, const struct interface *inter,FILE *lo
     /* insert the template */
     if(default_template!=NULL)
     {
-        new_template = template_clone(template_name, default_template,inter,0);
+        /* Stay within the memory budget by giving up the oldest template */
+        if (template_max != 0 && template_lru_count() >= template_max)
+        {
+            template_reclaim(template_lru_oldest());
+            stats.reclaimed_memory++;
+        }
+
+        new_template = template_clone_shared(template_name, default_template,inter);
 
         if(new_template != NULL)
         {
             template_insert(new_template);
+            template_lru_insert(new_template);
+            if (new_template->parent != NULL)
+                stats.shared++;
+            stats.created++;
+            return 0;
         }
         else
         {
@@ -159,6 +341,8 @@ void create_template(char *template_name, const struct interface *inter,FILE *lo
     {
         syslog(LOG_DEBUG,"could not find a default template, cancel dynamic template creation");
     }
+
+    return -1;
 }
 
 /*
@@ -169,16 +353,25 @@ void create_template(char *template_name, const struct interface *inter,FILE *lo
  * a template or not. Therefore, calling this function does not necessarily
  * create a new template. It also does not create more templates than allowed.
  * Once the function decides not to create a certain template it will never
- * again create a template with the requested address (consistency).
+ * again create a template with the requested address (consistency): either
+ * because the address is remembered as rejected or, with a secret, because
+ * the decision only depends on the address.
  * Returns 1 if a template was created.
  */
 int random_create_ipv6_template(const char *template_name, const struct interface *inter,float randomipv6_percentage,unsigned long long max_random_ipv6_hosts, FILE *logfp)
 {
-    static long dynamically_created_templates = 0;//remember number of templates we created dynamically
+    struct addr addr;
+
+    if (addr_pton(template_name, &addr) == -1 || addr.addr_type != ADDR_TYPE_IP6)
+    {
+        syslog(LOG_DEBUG,"cannot create template for %s",template_name);
+        return 0;
+    }
 
     /* check if we are allowed to create more templates */
-    if(max_random_ipv6_hosts != 0 && dynamically_created_templates>=max_random_ipv6_hosts)
+    if(max_random_ipv6_hosts != 0 && template_lru_count()>=max_random_ipv6_hosts)
     {
+        stats.refused++;
         syslog(LOG_DEBUG,"reached max number of allowed dynamically created templates, cancel creation for %s",template_name);
         fprintf(logfp, "reached max number of allowed dynamically created templates, cancel creation for %s\n",template_name);
         return 0;
@@ -186,25 +379,34 @@ int random_create_ipv6_template(const char *template_name, const struct interfac
 
 
     syslog(LOG_DEBUG,"check if address belongs to rejected addresses");
-    if(bloom_check(blocked_addr_bloom_filter,template_name))
+    if(randomipv6_blocked(&addr))
     {
         syslog(LOG_DEBUG, "probably blocked address %s requested...",template_name);
         return 0;
     }
 
+    if (admission_keyed)
+    {
+        if (!is_keyed_accepted(&addr, randomipv6_percentage))
+        {
+            syslog(LOG_DEBUG,"%s rejected by keyed hash",template_name);
+            return 0;
+        }
+
+        return (create_template(template_name,inter,logfp) == 0);
+    }
+
     syslog(LOG_DEBUG,"check if randomly accept address");
     if(is_randomly_accepted(randomipv6_percentage))
     {
-        create_template(template_name,inter,logfp);
-        dynamically_created_templates++;
-        return 1;
+        return (create_template(template_name,inter,logfp) == 0);
     }
     else
     {
         syslog(LOG_DEBUG,"%s added to blocked addresses...",template_name);
         fprintf(logfp, "added address %s to blocked addresses\n",template_name);
         /* add entry to the blocked list */
-        bloom_add(blocked_addr_bloom_filter,template_name);
+        bloomgen_add(&rejected_addrs,&addr.addr_ip6,IP6_ADDR_LEN);
         return 0;
     }
 
@@ -219,23 +421,34 @@ int random_create_ipv6_template(const char *template_name, const struct interfac
  */
 void exclude_addr_from_generator(char * addr_str)
 {
-    if(addr_str == NULL)
+    struct addr addr;
+
+    if(addr_str == NULL || addr_pton(addr_str, &addr) == -1 ||
+       addr.addr_type != ADDR_TYPE_IP6)
     {
-        syslog(LOG_DEBUG,"cannot block NULL address");
+        syslog(LOG_DEBUG,"cannot block address %s",
+               addr_str != NULL ? addr_str : "(null)");
         return;
     }
 
-    if(bloom_check(blocked_addr_bloom_filter,addr_str))
+    if(bloom_check(&excluded_addrs,&addr.addr_ip6,IP6_ADDR_LEN))
     {
         number_of_collisions++;
     }
 
     //syslog(LOG_DEBUG,"blocking %s...",addr_str);
-    bloom_add(blocked_addr_bloom_filter,addr_str);
+    bloom_add(&excluded_addrs,&addr.addr_ip6,IP6_ADDR_LEN);
 }
 
 
 
+void randomipv6_stats(struct randomipv6_stats *out)
+{
+    *out = stats;
+    out->active = template_lru_count();
+    out->limit = template_max;
+}
+
 void generate_mock_blocked_entries(int number_of_mocked_entries)
 {
     syslog(LOG_DEBUG,"generating mock blocked entries...");
@@ -38,20 +38,50 @@
 
 #define RANDOM_IPV6_DEFAULT_TEMPLATE "randomipv6default"
 
+/* Addresses excluded by the configuration */
+#define RANDOM_IPV6_EXCLUDE_CAPACITY	(1 << 20)
+#define RANDOM_IPV6_EXCLUDE_FPRATE	0.0001
+
+/* Defaults for the rejected addresses, per generation */
+#define RANDOM_IPV6_CAPACITY		(1 << 20)
+#define RANDOM_IPV6_FPRATE		0.001
+#define RANDOM_IPV6_EXPIRE		86400
+
+/* On-demand templates never expire unless configured */
+#define RANDOM_IPV6_IDLE		0
+#define RANDOM_IPV6_REAP_INTERVAL	10	/* seconds */
+
+struct randomipv6_stats {
+	u_int active;			/* templates that exist now */
+	u_int limit;			/* allowed by the memory budget */
+	uint64_t created;
+	uint64_t shared;		/* created sharing the default */
+	uint64_t reclaimed_idle;
+	uint64_t reclaimed_memory;
+	uint64_t refused;		/* max_random_ipv6_hosts reached */
+};
+
 struct rejected_ipv6_addr{
 	RB_ENTRY(rejected_ipv6_addr) next_rejected_ipv6_addr;
 	char *addr_str;
 };
 
 
+struct ip6_desc;
+struct interface;
+
 int random_create_ipv6_template(const char *template_name, const struct interface *inter,float randomipv6_percentage,unsigned long long max_random_ipv6_hosts,FILE * logfp);
 
 void randomipv6_init();
 
+void randomipv6_config(void);
+
+void randomipv6_stats(struct randomipv6_stats *);
+
 void exclude_addr_from_generator(char * addr_str);
 
 void generate_mock_blocked_entries(int);
 
-char *get_template_name_from_packet(struct ip6_hdr *ip6);
+char *get_template_name_from_packet(const struct ip6_desc *desc);
 
 #endif
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/queue.h>
+#include <sys/tree.h>
+
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dnet.h>
+#include <event.h>
+
+#include "honeyd.h"
+#include "template.h"
+#include "personality.h"
+#include "pool.h"
+#include "reasm.h"
+
+static struct pool *pool_reasm;
+
+void
+reasm_init(struct reasm *r, enum fragpolicy policy)
+{
+	if (pool_reasm == NULL)
+		pool_reasm = pool_init("reasm", REASM_BUFSIZE);
+
+	memset(r, 0, sizeof(struct reasm));
+	r->policy = policy;
+}
+
+void
+reasm_free(struct reasm *r)
+{
+	if (r->data != NULL)
+		pool_free(pool_reasm, r->data);
+	r->data = NULL;
+	r->map = NULL;
+	r->size = 0;
+}
+
+/*
+ * How large the buffer needs to be to hold the payload up to end.  Once
+ * the length of the datagram is known it is exact, before that the
+ * buffer grows by doubling.  Sizes are multiples of 64 bytes, so that
+ * the bitmap behind the payload starts on a word boundary.
+ */
+
+static u_int
+reasm_size(const struct reasm *r, u_int end, u_int total)
+{
+	u_int size;
+
+	if (end <= r->size)
+		return (r->size);
+
+	if (total)
+		size = total;
+	else
+		size = MIN(MAX(end, r->size * 2), REASM_MAXLEN);
+
+	return ((size + 63) & ~63);
+}
+
+/* Additional memory that inserting the fragment would take */
+
+u_int
+reasm_need(const struct reasm *r, u_int off, u_int len, int more)
+{
+	u_int size = reasm_size(r, off + len, more ? r->end : off + len);
+
+	return (size + REASM_MAPLEN(size) - reasm_mem(r));
+}
+
+static void
+reasm_grow(struct reasm *r, u_int size)
+{
+	u_char *data;
+	size_t mem = size + REASM_MAPLEN(size);
+
+	if (mem <= REASM_BUFSIZE)
+		data = pool_alloc(pool_reasm);
+	else
+		data = pool_alloc_size(pool_reasm, mem);
+	memset(data + size, 0, REASM_MAPLEN(size));
+
+	if (r->data != NULL) {
+		memcpy(data, r->data, r->size);
+		memcpy(data + size, r->map, REASM_MAPLEN(r->size));
+		pool_free(pool_reasm, r->data);
+	}
+
+	r->data = data;
+	r->map = (uint64_t *)(data + size);
+	r->size = size;
+}
+
+/*
+ * Copies the blocks [first, last) of the fragment into place.  Blocks
+ * that have been received before keep their old data under FRAG_OLD
+ * and are overwritten under FRAG_NEW.
+ */
+
+static void
+reasm_copy(struct reasm *r, u_int off, const u_char *data, u_int len)
+{
+	u_int block = off >> 3, last = REASM_BLOCKS(off + len);
+	u_int start, stop;
+	uint64_t bit;
+
+	while (block < last) {
+		bit = 1ULL << (block & 63);
+		if (r->map[block >> 6] & bit) {
+			block++;
+			if (r->policy != FRAG_NEW)
+				continue;
+			start = (block - 1) << 3;
+		} else {
+			r->map[block >> 6] |= bit;
+			r->nblocks++;
+			start = block++ << 3;
+		}
+
+		/* Copy runs of blocks at once */
+		while (block < last) {
+			bit = 1ULL << (block & 63);
+			if (r->map[block >> 6] & bit) {
+				if (r->policy != FRAG_NEW)
+					break;
+			} else {
+				r->map[block >> 6] |= bit;
+				r->nblocks++;
+			}
+			block++;
+		}
+
+		stop = MIN(block << 3, off + len);
+		memcpy(r->data + start, data + (start - off), stop - start);
+	}
+}
+
+/*
+ * Adds a fragment of len bytes at offset off of the payload.  Returns 1
+ * if the datagram is complete, 0 if fragments are missing, and -1 if the
+ * fragment is not consistent with the ones before and the datagram
+ * should be dropped.
+ */
+
+int
+reasm_insert(struct reasm *r, u_int off, const u_char *data, u_int len,
+    int more)
+{
+	u_int end = off + len;
+
+	if (len == 0 || (off & 7) || end > REASM_MAXLEN)
+		return (-1);
+	/* Only the last fragment may end within a block */
+	if (more && (len & 7))
+		return (-1);
+
+	/* The end of the datagram may not move once it is known */
+	if (!more) {
+		if (r->end != 0 && r->end != end)
+			return (-1);
+		/* Nothing may have arrived beyond the end */
+		if (r->high > end)
+			return (-1);
+		r->end = end;
+	} else if (r->end != 0 && end > r->end)
+		return (-1);
+
+	if (end > r->size)
+		reasm_grow(r, reasm_size(r, end, r->end));
+	if (end > r->high)
+		r->high = end;
+
+	reasm_copy(r, off, data, len);
+
+	return (reasm_complete(r));
+}
+
+/* Unittests */
+
+static void
+reasm_test_policy(enum fragpolicy policy, u_char expect)
+{
+	struct reasm r;
+	u_char a[64], b[64];
+	int res;
+
+	memset(a, 'a', sizeof(a));
+	memset(b, 'b', sizeof(b));
+
+	reasm_init(&r, policy);
+
+	/* Out of order with an overlap in the middle */
+	if (reasm_insert(&r, 48, a, 13, 0) != 0)
+		errx(1, "%s: last fragment", __func__);
+	if (reasm_insert(&r, 16, a, 32, 1) != 0)
+		errx(1, "%s: middle fragment", __func__);
+	if (reasm_insert(&r, 8, b, 16, 1) != 0)
+		errx(1, "%s: overlapping fragment", __func__);
+	if (r.data[16] != expect || r.data[8] != 'b' || r.data[24] != 'a')
+		errx(1, "%s: bad overlap %c%c%c", __func__,
+		    r.data[8], r.data[16], r.data[24]);
+	if ((res = reasm_insert(&r, 0, b, 8, 1)) != 1)
+		errx(1, "%s: not complete: %d", __func__, res);
+	if (r.end != 61 || r.data[60] != 'a')
+		errx(1, "%s: bad end", __func__);
+
+	reasm_free(&r);
+}
+
+void
+reasm_test(void)
+{
+	struct reasm r;
+	u_char data[1024];
+	u_int off;
+
+	memset(data, 0, sizeof(data));
+
+	reasm_test_policy(FRAG_OLD, 'a');
+	reasm_test_policy(FRAG_NEW, 'b');
+
+	/* Tiny fragments in reverse order, growing the buffer */
+	reasm_init(&r, FRAG_OLD);
+	if (reasm_insert(&r, 8000, data, 4, 0) != 0)
+		errx(1, "%s: last tiny fragment", __func__);
+	for (off = 8000; off > 8; off -= 8)
+		if (reasm_insert(&r, off - 8, data, 8, 1) != 0)
+			errx(1, "%s: tiny fragment at %u", __func__, off - 8);
+	if (reasm_insert(&r, 0, data, 8, 1) != 1)
+		errx(1, "%s: tiny fragments not complete", __func__);
+	reasm_free(&r);
+
+	/* Inconsistent ends */
+	reasm_init(&r, FRAG_OLD);
+	if (reasm_insert(&r, 0, data, 64, 1) != 0 ||
+	    reasm_insert(&r, 32, data, 16, 0) != -1)
+		errx(1, "%s: end before received data", __func__);
+	if (reasm_insert(&r, 80, data, 16, 0) != 0 ||
+	    reasm_insert(&r, 80, data, 24, 1) != -1 ||
+	    reasm_insert(&r, 80, data, 20, 0) != -1)
+		errx(1, "%s: data beyond the end", __func__);
+	if (reasm_insert(&r, 8, data, 12, 1) != -1 ||
+	    reasm_insert(&r, 4, data, 8, 1) != -1)
+		errx(1, "%s: misaligned fragment", __func__);
+	reasm_free(&r);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
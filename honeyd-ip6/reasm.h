@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _REASM_H_
+#define _REASM_H_
+
+/*
+ * Reassembly of a single datagram, shared by IPv4 and IPv6.  The payload
+ * is kept in one buffer at its final offset, and a bitmap records which
+ * eight byte blocks have arrived.  Fragments start at multiples of eight,
+ * so the bitmap describes coverage exactly and the datagram is complete
+ * when the number of blocks received matches its length.
+ */
+
+#define REASM_MAXLEN		65535	/* largest payload we reassemble */
+#define REASM_BUFSIZE		1984	/* buffers up to this come from a pool */
+
+#define REASM_BLOCKS(len)	(((len) + 7) >> 3)
+/* Bytes of bitmap for a payload of size bytes, one bit per block */
+#define REASM_MAPLEN(size)	\
+	((((size) >> 3) + 63) / 64 * sizeof(uint64_t))
+
+struct reasm {
+	u_char *data;			/* payload, followed by the bitmap */
+	uint64_t *map;
+	u_int size;			/* payload bytes that fit */
+	u_int end;			/* payload length; 0 while unknown */
+	u_int high;			/* furthest byte received */
+	u_int nblocks;			/* blocks received */
+	enum fragpolicy policy;		/* FRAG_OLD or FRAG_NEW */
+};
+
+#define reasm_complete(r)	((r)->end != 0 && \
+				    (r)->nblocks == REASM_BLOCKS((r)->end))
+#define reasm_mem(r)		((r)->size + REASM_MAPLEN((r)->size))
+
+void reasm_init(struct reasm *, enum fragpolicy);
+void reasm_free(struct reasm *);
+u_int reasm_need(const struct reasm *, u_int, u_int, int);
+int reasm_insert(struct reasm *, u_int, const u_char *, u_int, int);
+
+void reasm_test(void);
+
+#endif /* _REASM_H_ */
@@ -56,7 +56,6 @@
 
 #include "network.h"
 #include "router.h"
-#include "pool.h"
 #include "interface.h"
 #include <syslog.h>
 
@@ -108,282 +107,253 @@ SPLAY_GENERATE(tunneltree, router_entry, node, tunnelcompare)
 
 /* Exported */
 int router_used = 0;
-struct network *entry_routers_ip4 = NULL;
-struct network *entry_routers_ip6 = NULL;
-struct network *reverse = NULL;
-struct network *reverse6 = NULL;
+struct nettable *entry_routers_ip4 = NULL;
+struct nettable *entry_routers_ip6 = NULL;
+struct nettable *reverse = NULL;
+struct nettable *reverse6 = NULL;
 
 /* Internal */
 
-static struct pool *pool_network;
+static struct routepath routecache[ROUTECACHE_SIZE];
+static u_int router_generation = 1;	/* bumped on every topology change */
 
-/* Network trinary tree code by Bill Cheswick; stylified and munged by NP */
+/*
+ * Longest prefix match on multibit tries with a stride of eight bits.
+ * Every node covers one byte of the address; prefixes that end inside a
+ * byte are expanded into all slots they cover.  An IPv4 lookup touches
+ * at most four nodes, an IPv6 lookup at most sixteen and both stop at
+ * the first slot without a child.  Routes are queued by network_add()
+ * and inserted in bulk, shortest first, on the next lookup, so loading
+ * a large topology does not rewrite the same slots over and over.
+ */
+
+#define NETNODE_BITS	8
+#define NETNODE_SLOTS	(1 << NETNODE_BITS)
+
+struct netslot {
+	void *data;
+	struct netnode *child;
+};
 
-static void network_addnode(struct network **, struct network *,
-		struct network **);
+struct netnode {
+	struct netslot slots[NETNODE_SLOTS];
+	uint8_t plen[NETNODE_SLOTS];	/* prefix that filled the slot */
+};
 
-static void network_copydata(struct network *dst, struct network *src)
+struct netprefix {
+	struct addr net;
+	void *data;
+	u_int seq;			/* later routes win on equal prefixes */
+};
+
+static struct netnode *
+netnode_new(struct nettable *table)
 {
-	memmove(&dst->data, &src->data, sizeof(dst->data));
+	struct netnode *node;
+
+	if ((node = calloc(1, sizeof(struct netnode))) == NULL)
+		err(1, "%s: calloc", __func__);
+	table->nnodes++;
+
+	return (node);
 }
 
-/*
- *  walk down a tree adding nodes back in
- */
-static void network_walkadd(struct network **root, struct network *net,
-		struct network **netqueue)
+static void
+netnode_free(struct netnode *node)
 {
-	struct network *left, *right;
+	int i;
 
-	left = net->left;
-	right = net->right;
-	net->left = NULL;
-	net->right = NULL;
+	for (i = 0; i < NETNODE_SLOTS; i++)
+		if (node->slots[i].child != NULL)
+			netnode_free(node->slots[i].child);
+	free(node);
+}
 
-	network_addnode(root, net, netqueue);
-	if (left != NULL )
-		network_walkadd(root, left, netqueue);
-	if (right != NULL )
-		network_walkadd(root, right, netqueue);
+static const u_char *
+network_key(const struct addr *addr, int *bits)
+{
+	switch (addr->addr_type) {
+	case ADDR_TYPE_IP:
+		*bits = IP_ADDR_BITS;
+		return ((const u_char *)&addr->addr_ip);
+	case ADDR_TYPE_IP6:
+		*bits = IP6_ADDR_BITS;
+		return (addr->addr_data8);
+	default:
+		*bits = 0;
+		return (NULL);
+	}
 }
 
-/*
- *  calculate depth
- */
-static void network_calcd(struct network *net)
+static void
+network_insert(struct nettable *table, struct netprefix *pfx)
 {
-	struct network *tmp;
-	int depth;
+	struct netnode **pnode, *node;
+	const u_char *key;
+	int bits, len = pfx->net.addr_bits, level, span, i, base;
 
-	if (net == NULL )
+	if ((key = network_key(&pfx->net, &bits)) == NULL)
+		return;
+	if (len > bits)
+		len = bits;
+
+	if (len == 0) {
+		if (bits == IP_ADDR_BITS)
+			table->default4 = pfx->data;
+		else
+			table->default6 = pfx->data;
 		return;
+	}
 
-	depth = 0;
-	if ((tmp = net->left) != NULL )
-		depth = tmp->depth;
+	pnode = bits == IP_ADDR_BITS ? &table->root4 : &table->root6;
+	for (level = 0; ; level++) {
+		if (*pnode == NULL)
+			*pnode = netnode_new(table);
+		node = *pnode;
+		if (len <= (level + 1) * NETNODE_BITS)
+			break;
+		pnode = &node->slots[key[level]].child;
+	}
 
-	tmp = net->right;
-	if (tmp != NULL && tmp->depth > depth)
-		depth = tmp->depth;
+	/* Expand the prefix into the slots it covers in this node */
+	span = 1 << ((level + 1) * NETNODE_BITS - len);
+	base = key[level] & ~(span - 1);
+	for (i = base; i < base + span; i++) {
+		if (node->plen[i] > len)
+			continue;
+		node->slots[i].data = pfx->data;
+		node->plen[i] = len;
+	}
+}
 
-	tmp = net->mid;
-	if (tmp != NULL && tmp->depth > depth)
-		depth = tmp->depth;
+static int
+network_prefixcompare(const void *a, const void *b)
+{
+	const struct netprefix *pa = a, *pb = b;
 
-	net->depth = depth + 1;
+	if (pa->net.addr_bits != pb->net.addr_bits)
+		return (pa->net.addr_bits - pb->net.addr_bits);
+	return (pa->seq < pb->seq ? -1 : 1);
 }
 
-/*
- *  balance the tree at the current node
- */
-static void network_balancetree(struct network **cur)
-{
-	struct network *net, *left, *right;
-	int dl, dr;
+/* Inserts the routes that have been added since the last lookup */
 
-	/*
-	 * if left and right are too out of balance, rotate tree node
-	 */
-	net = *cur;
-	dl = dr = 0;
-	if ((left = net->left) != NULL )
-		dl = left->depth;
-	if ((right = net->right) != NULL )
-		dr = right->depth;
-
-	if (dl > dr + 1)
-	{
-		/* Rotate left */
-		net->left = left->right;
-		left->right = net;
-		*cur = left;
+static void
+network_build(struct nettable *table)
+{
+	u_int i;
 
-		network_calcd(net);
-		network_calcd(left);
-	}
-	else if (dr > dl + 1)
-	{
-		/* Rotate right */
-		net->right = right->left;
-		right->left = net;
-		*cur = right;
+	if (table->built == table->nprefixes)
+		return;
 
-		network_calcd(net);
-		network_calcd(right);
-	}
-	else
-		network_calcd(net);
+	qsort(table->prefixes + table->built,
+	    table->nprefixes - table->built, sizeof(struct netprefix),
+	    network_prefixcompare);
+	for (i = table->built; i < table->nprefixes; i++)
+		network_insert(table, &table->prefixes[i]);
+	table->built = table->nprefixes;
 }
 
 /*
- *  add a new node to the tree
+ * Add a route to the table.  Adding the same network again overrides
+ * the previous route.
  */
-static void network_addnode(struct network **root, struct network *new,
-		struct network **netqueue)
+void
+network_add(struct nettable **ptable, struct addr *addr, void *data)
 {
-	struct network *net, *left;
+	struct nettable *table = *ptable;
+	struct netprefix *pfx;
+	const u_char *key;
+	int bits;
 
-	if ((net = *root) == NULL )
-	{
-		*root = new;
-		new->depth = 1;
+	if ((key = network_key(addr, &bits)) == NULL)
 		return;
+
+	if (table == NULL) {
+		if ((table = calloc(1, sizeof(struct nettable))) == NULL)
+			err(1, "%s: calloc", __func__);
+		*ptable = table;
 	}
 
-	switch (network_compare(new, net))
-	{
-	case NET_PRECEEDS:
-		//syslog(LOG_DEBUG,"net %s precedes %s",addr_ntoa(&new->net),addr_ntoa(&net->net));
-		network_addnode(&net->left, new, netqueue);
-		break;
-
-	case NET_FOLLOWS:
-		//syslog(LOG_DEBUG,"net %s follows %s",addr_ntoa(&new->net),addr_ntoa(&net->net));
-		network_addnode(&net->right, new, netqueue);
-		break;
-
-	case NET_CONTAINS:
-		//syslog(LOG_DEBUG,"net %s contains %s",addr_ntoa(&new->net),addr_ntoa(&net->net));
-		/*
-		 *  if new node is superset of tree node, replace tree
-		 *  node and queue tree node to be merged into root.
-		 */
-		*root = new;
-		new->depth = 1;
-		left = pool_alloc(pool_network);
-		memset(left, 0, sizeof(struct network));
-		left->mid = *netqueue;
-		*netqueue = left;
-		left->left = net;
-		break;
-
-	case NET_EQUALS:
-		//syslog(LOG_DEBUG,"net %s equals %s",addr_ntoa(&new->net),addr_ntoa(&net->net));
-		network_copydata(net, new);
-		pool_free(pool_network, new);
-		break;
-
-	case NET_CONTAINED:
-		//syslog(LOG_DEBUG,"net %s is contained in %s",addr_ntoa(&new->net),addr_ntoa(&net->net));
-		network_addnode(&net->mid, new, netqueue);
-		break;
+	if (table->nprefixes == table->size) {
+		u_int size = table->size ? table->size * 2 : 16;
+
+		pfx = realloc(table->prefixes, size * sizeof(struct netprefix));
+		if (pfx == NULL)
+			err(1, "%s: realloc", __func__);
+		table->prefixes = pfx;
+		table->size = size;
 	}
 
-	network_balancetree(root);
+	pfx = &table->prefixes[table->nprefixes];
+	addr_net(addr, &pfx->net);
+	pfx->net.addr_bits = MIN(addr->addr_bits, bits);
+	pfx->data = data;
+	pfx->seq = table->nprefixes++;
 }
 
 /*
- * Add a route to the structure.  a and mask must be in host byte order.
+ * Find the most specific route for addr.
  */
-void network_add(struct network **root, struct addr *addr, void *data)
+void *
+network_lookup(struct nettable *table, struct addr *addr)
 {
-	struct network *netqueue = NULL;
-	struct network *p;
-
-	p = pool_alloc(pool_network);
-	memset(p, 0, sizeof(struct network));
-	p->net = *addr;
-	p->data = data;
-	network_addnode(root, p, &netqueue);
+	struct netnode *node;
+	struct netslot *slot;
+	const u_char *key;
+	void *best;
+	int bits, i;
+
+	if (table == NULL || (key = network_key(addr, &bits)) == NULL)
+		return (NULL);
+
+	network_build(table);
+
+	if (bits == IP_ADDR_BITS) {
+		node = table->root4;
+		best = table->default4;
+	} else {
+		node = table->root6;
+		best = table->default6;
+	}
 
-	while ((p = netqueue) != NULL )
-	{
-		netqueue = p->mid;
-		network_walkadd(root, p->left, &netqueue);
-		pool_free(pool_network, p);
+	for (i = 0; node != NULL && i < bits / NETNODE_BITS; i++) {
+		slot = &node->slots[key[i]];
+		if (slot->data != NULL)
+			best = slot->data;
+		node = slot->child;
 	}
+
+	return (best);
 }
 
-/*
- * Find address la. Must be in host byte order.
- */
+/* Returns the route that was added first */
+
 void *
-network_lookup(struct network *root, struct addr *addr)
+network_first(struct nettable *table)
 {
-	struct network *net, *last;
-	int addr_bits = (
-			addr->addr_type == ADDR_TYPE_IP6 ? IP6_ADDR_BITS : IP_ADDR_BITS);
-
-	last = NULL;
-	if (addr->addr_type == ADDR_TYPE_IP6)
-	{
-		//if(strcmp(addr_ntoa(addr),"2001:db8::2")==0)
-		//	return NULL;
-		for (net = root; net != NULL ;)
-		{
-			enum net_order order;
-			struct network net_root, net_addr;
-			net_root.net = net->net;
-			net_addr.net = *addr;
-
-			order = network_compare(&net_addr, &net_root);
-			//syslog(LOG_DEBUG,"compare %s to %s",addr_ntoa(&net_addr.net),addr_ntoa(&net_root.net));
-			switch (order)
-			{
-			case NET_PRECEEDS:
-				//syslog(LOG_DEBUG,"%s preceeds %s",addr_ntoa(&net_addr.net),addr_ntoa(&net_root.net));
-				net = net->left;
-				break;
-			case NET_FOLLOWS:
-				//syslog(LOG_DEBUG,"%s follows %s",addr_ntoa(&net_addr.net),addr_ntoa(&net_root.net));
-				net = net->right;
-				break;
-			case NET_EQUALS: /* same as contained */
-			case NET_CONTAINED:
-				//syslog(LOG_DEBUG,"%s equals or is contained in %s",addr_ntoa(&net_addr.net),addr_ntoa(&net_root.net));
-				last = net;
-				net = net->mid;
-				break;
-			default:
-				syslog(LOG_DEBUG, "error, this should not happen");
-				break;
-			}
-		}
-
-	}
-	else
-	{
-		for (net = root; net != NULL ;)
-		{
-			struct addr tmp;
-
-			tmp = net->net;
-			tmp.addr_bits = addr_bits;
-			if (addr_cmp(addr, &tmp) >= 0)
-			{
-				addr_bcast(&net->net, &tmp);
-				tmp.addr_bits = addr_bits;
-				if (addr_cmp(addr, &tmp) <= 0)
-				{
-					last = net;
-					net = net->mid;
-				}
-				else
-				{
-					net = net->right;
-				}
-			}
-			else
-			{
-				net = net->left;
-			}
-		}
-	}
+	if (table == NULL || table->nprefixes == 0)
+		return (NULL);
 
-	return (last != NULL ? last->data : NULL );
+	return (table->prefixes[0].data);
 }
 
-void network_cleanup(struct network *net, int needfree)
+void
+network_cleanup(struct nettable *table, int needfree)
 {
-	if (net->mid != NULL )
-		network_cleanup(net->mid, needfree);
-	if (net->left != NULL )
-		network_cleanup(net->left, needfree);
-	if (net->right != NULL )
-		network_cleanup(net->right, needfree);
-	if (needfree && net->data != NULL )
-		free(net->data);
-	pool_free(pool_network, net);
+	u_int i;
+
+	if (needfree) {
+		for (i = 0; i < table->nprefixes; i++)
+			if (table->prefixes[i].data != NULL)
+				free(table->prefixes[i].data);
+	}
+	if (table->root4 != NULL)
+		netnode_free(table->root4);
+	if (table->root6 != NULL)
+		netnode_free(table->root6);
+	free(table->prefixes);
+	free(table);
 }
 
 /* Functions to deal with Honeyd virtual routers */
@@ -392,8 +362,6 @@ void router_init(void)
 {
 	SPLAY_INIT(&routers);
 	SPLAY_INIT(&tunnels);
-
-	pool_network = pool_init(sizeof(struct network));
 }
 
 struct router *
@@ -418,6 +386,7 @@ router_new(struct addr *addr)
 
 	new->routes = NULL;
 	new->addr = *addr;
+	router_generation++;
 
 	SPLAY_INIT(&new->links);
 
@@ -451,8 +420,17 @@ void router_end(void)
 
 	if (reverse != NULL )
 		network_cleanup(reverse, 0);
+	if (reverse6 != NULL )
+		network_cleanup(reverse6, 0);
 	if (entry_routers_ip4 != NULL )
 		network_cleanup(entry_routers_ip4, 0);
+	if (entry_routers_ip6 != NULL )
+		network_cleanup(entry_routers_ip6, 0);
+	reverse = reverse6 = NULL;
+	entry_routers_ip4 = entry_routers_ip6 = NULL;
+
+	/* Cached paths point into the routers that were just freed */
+	router_generation++;
 
 	router_used = 0;
 }
@@ -504,6 +482,7 @@ int router_start(struct addr *addr, struct addr *pnetwork)
 
 	entry->network = network;
 	entry->flags |= ROUTER_ISENTRY;
+	router_generation++;
 
 	if (addr->addr_type == ADDR_TYPE_IP6)
 	{
@@ -561,6 +540,7 @@ int router_add_link(struct router *r, struct addr *addr)
 
 	rte = router_entry_new(addr, r, NULL, ROUTE_LINK);
 	network_add(&r->routes, addr, rte);
+	router_generation++;
 
 	/* add ipv4 and ipv6 links into different ireverse lookup tables */
 	if (addr->addr_type == ADDR_TYPE_IP)
@@ -581,6 +561,7 @@ int router_add_unreach(struct router *r, struct addr *addr)
 	rte = router_entry_new(addr, r, NULL, ROUTE_UNREACH);
 
 	network_add(&r->routes, addr, rte);
+	router_generation++;
 
 	return (0);
 }
@@ -631,6 +612,7 @@ int router_add_net(struct router *r, struct addr *net, struct router *gw,
 	}
 
 	network_add(&r->routes, net, rte);
+	router_generation++;
 
 	return (0);
 }
@@ -652,6 +634,7 @@ int router_add_tunnel(struct router *r, struct addr *net,
 	rte->tunnel_dst = *tunnel_dst;
 
 	network_add(&r->routes, net, rte);
+	router_generation++;
 
 	SPLAY_INSERT(tunneltree, &tunnels, rte);
 
@@ -668,3 +651,201 @@ router_find_tunnel(struct addr *src, struct addr *dst)
 
 	return (SPLAY_FIND(tunneltree, &tunnels, &tmp));
 }
+
+/*
+ * Paths through the virtual topology only change when the configuration
+ * does.  For every pair of entry router and destination we remember the
+ * hops a packet takes, the latency and the chance to survive packet
+ * loss up to every hop, and how the walk ends.  Only the bandwidth and
+ * queue state of the links has to be looked at for each packet.
+ */
+
+static uint32_t
+routepath_hash(const struct addr *gw, const struct addr *dst)
+{
+	const uint32_t *w;
+	uint32_t h = 0x9e3779b9;
+	int i;
+
+	w = (const uint32_t *)gw->addr_data8;
+	for (i = 0; i < (gw->addr_type == ADDR_TYPE_IP6 ? 4 : 1); i++)
+		h = (h ^ w[i]) * 0x01000193;
+	w = (const uint32_t *)dst->addr_data8;
+	for (i = 0; i < (dst->addr_type == ADDR_TYPE_IP6 ? 4 : 1); i++)
+		h = (h ^ w[i]) * 0x01000193;
+
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+
+	return (h);
+}
+
+static void
+routepath_addhop(struct routepath *path, struct router *next,
+    struct link_entry *link, int delay, double survive)
+{
+	struct routehop *hop;
+
+	if (path->nhops == path->size) {
+		int size = path->size ? path->size * 2 : 8;
+
+		hop = realloc(path->hops, size * sizeof(struct routehop));
+		if (hop == NULL)
+			err(1, "%s: realloc", __func__);
+		path->hops = hop;
+		path->size = size;
+	}
+
+	hop = &path->hops[path->nhops++];
+	hop->router = next;
+	hop->link = link;
+	hop->delay = delay;
+	hop->survive = survive;
+}
+
+/* Walks the topology the same way every packet used to */
+
+static void
+routepath_build(struct routepath *path)
+{
+	struct router *r;
+	struct router_entry *rte;
+	struct link_entry *link;
+	struct addr host = path->gw;
+	double survive = 1;
+	int delay = 0;
+
+	path->nhops = 0;
+	path->bandwidth = 0;
+	path->rte = NULL;
+	path->end = ROUTE_END_ARRIVED;
+
+	r = router_find(&host);
+	while (addr_cmp(&host, &path->dst) != 0) {
+		/* A loop; no TTL lasts this long */
+		if (path->nhops == ROUTE_MAXHOPS) {
+			path->end = ROUTE_END_LOOP;
+			break;
+		}
+
+		if (r == NULL ||
+		    (rte = network_lookup(r->routes, &path->dst)) == NULL) {
+			path->end = r != NULL && (r->flags & ROUTER_ISENTRY) ?
+			    ROUTE_END_EXTERNAL : ROUTE_END_NOROUTE;
+			break;
+		}
+
+		if (rte->type != ROUTE_NET) {
+			path->end = ROUTE_END_ROUTE;
+			path->rte = rte;
+			break;
+		}
+
+		/* Get the attributes for this link */
+		link = rte->link;
+		delay += link->latency ? link->latency : 3;
+		if (link->packetloss)
+			survive *= 1 - ((double)link->packetloss / 10000.0);
+		if (link->bandwidth)
+			path->bandwidth = 1;
+
+		r = rte->gw;
+		host = r->addr;
+
+		routepath_addhop(path, r, link, delay, survive);
+	}
+}
+
+/*
+ * Returns the path from router gw to dst.  The result is only valid
+ * until the next change to the topology.
+ */
+
+struct routepath *
+router_path(struct addr *gw, struct addr *dst)
+{
+	struct routepath *path;
+
+	path = &routecache[routepath_hash(gw, dst) & (ROUTECACHE_SIZE - 1)];
+	if (path->generation == router_generation &&
+	    addr_cmp(&path->gw, gw) == 0 && addr_cmp(&path->dst, dst) == 0)
+		return (path);
+
+	path->gw = *gw;
+	path->dst = *dst;
+	path->generation = router_generation;
+	routepath_build(path);
+
+	return (path);
+}
+
+/* Unittests */
+
+static void
+router_test_lookup(struct nettable *table, const char *addrstr,
+    const char *expect)
+{
+	struct addr addr;
+	const char *result;
+
+	if (addr_pton(addrstr, &addr) == -1)
+		errx(1, "%s: bad address %s", __func__, addrstr);
+	result = network_lookup(table, &addr);
+	if (result != expect && (result == NULL || expect == NULL ||
+		strcmp(result, expect)))
+		errx(1, "%s: %s matched %s instead of %s", __func__,
+		    addrstr, result != NULL ? result : "nothing",
+		    expect != NULL ? expect : "nothing");
+}
+
+static void
+router_test_add(struct nettable **table, const char *net, char *data)
+{
+	struct addr addr;
+
+	if (addr_pton(net, &addr) == -1)
+		errx(1, "%s: bad network %s", __func__, net);
+	network_add(table, &addr, data);
+}
+
+void
+router_test(void)
+{
+	struct nettable *table = NULL;
+
+	router_test_lookup(table, "10.0.0.1", NULL);
+
+	router_test_add(&table, "10.0.0.0/8", "ten");
+	router_test_add(&table, "10.1.2.0/23", "twentythree");
+	router_test_add(&table, "10.1.2.128/25", "twentyfive");
+	router_test_add(&table, "10.1.2.3/32", "host");
+	router_test_add(&table, "2001:db8::/32", "doc");
+	router_test_add(&table, "2001:db8:1::1/64", "net");
+
+	router_test_lookup(table, "10.200.0.1", "ten");
+	router_test_lookup(table, "10.1.3.255", "twentythree");
+	router_test_lookup(table, "10.1.2.200", "twentyfive");
+	router_test_lookup(table, "10.1.2.3", "host");
+	router_test_lookup(table, "10.1.2.4", "twentythree");
+	router_test_lookup(table, "11.0.0.1", NULL);
+	router_test_lookup(table, "2001:db8:1::ffff", "net");
+	router_test_lookup(table, "2001:db8:2::1", "doc");
+	router_test_lookup(table, "2001:db9::1", NULL);
+
+	/* Routes added after a lookup, a default route and an override */
+	router_test_add(&table, "10.1.0.0/16", "sixteen");
+	router_test_add(&table, "0.0.0.0/0", "default");
+	router_test_add(&table, "10.1.2.128/25", "override");
+	router_test_add(&table, "::/0", "default6");
+
+	router_test_lookup(table, "10.1.200.1", "sixteen");
+	router_test_lookup(table, "10.1.2.200", "override");
+	router_test_lookup(table, "10.1.2.3", "host");
+	router_test_lookup(table, "11.0.0.1", "default");
+	router_test_lookup(table, "2001:db9::1", "default6");
+
+	network_cleanup(table, 0);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
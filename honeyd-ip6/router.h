@@ -32,7 +32,7 @@
 #ifndef _ROUTER_H_
 #define _ROUTER_H_
 
-struct network;
+struct nettable;
 
 enum route_type {ROUTE_LINK = 0, ROUTE_NET, ROUTE_UNREACH, ROUTE_TUNNEL};
 
@@ -75,7 +75,7 @@ struct router_entry {
 struct router {
 	SPLAY_ENTRY(router) node;
 
-	struct network *routes;
+	struct nettable *routes;
 
 	struct addr addr;		/* IP address of router */
 	struct addr network;		/* Responsible (entry router only) */
@@ -88,8 +88,8 @@ struct router {
 #define ROUTER_ISENTRY	0x0001
 
 extern int router_used;
-extern struct network *entry_routers_ip4;
-extern struct network *entry_routers_ip6;
+extern struct nettable *entry_routers_ip4;
+extern struct nettable *entry_routers_ip6;
 
 void router_init(void);
 struct router *router_new(struct addr *);
@@ -108,5 +108,59 @@ struct link_entry *link_entry_new(struct addr *);
 struct router_entry *router_find_tunnel(struct addr *, struct addr *);
 struct router_entry *router_find_nexthop(struct router *, struct addr *);
 
-void *network_lookup(struct network *, struct addr *);
+/* Longest prefix match tables for IPv4 and IPv6 routes */
+struct nettable {
+	struct netnode *root4;
+	struct netnode *root6;
+	void *default4;			/* data of 0.0.0.0/0 */
+	void *default6;			/* data of ::/0 */
+
+	struct netprefix *prefixes;	/* all routes, for bulk insert */
+	u_int nprefixes;
+	u_int size;
+	u_int built;			/* routes inserted into the tries */
+	u_int nnodes;
+};
+
+#define ROUTE_MAXHOPS	255	/* no TTL lets a packet go further */
+#define ROUTECACHE_SIZE	4096	/* must be a power of two */
+
+/* How the walk through the topology ends */
+enum route_end {
+	ROUTE_END_ARRIVED = 0,		/* reached the destination */
+	ROUTE_END_ROUTE,		/* link, unreach or tunnel route */
+	ROUTE_END_EXTERNAL,		/* leaves through an entry router */
+	ROUTE_END_NOROUTE,
+	ROUTE_END_LOOP
+};
+
+struct routehop {
+	struct router *router;		/* router the hop leads to */
+	struct link_entry *link;
+	int delay;			/* base latency up to here */
+	double survive;			/* chance to survive loss up to here */
+};
+
+struct routepath {
+	struct addr gw;
+	struct addr dst;
+	u_int generation;
+
+	enum route_end end;
+	struct router_entry *rte;	/* for ROUTE_END_ROUTE */
+	int bandwidth;			/* some link is bandwidth limited */
+
+	struct routehop *hops;
+	int nhops;
+	int size;
+};
+
+struct routepath *router_path(struct addr *, struct addr *);
+
+void network_add(struct nettable **, struct addr *, void *);
+void *network_lookup(struct nettable *, struct addr *);
+void *network_first(struct nettable *);
+void network_cleanup(struct nettable *, int);
+
+void router_test(void);
 #endif
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * SipHash-2-4 by Jean-Philippe Aumasson and Daniel J. Bernstein.  A
+ * keyed hash that an outsider cannot predict without the key, so that
+ * decisions based on it can neither be guessed nor steered.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "siphash.h"
+
+#define SIP_ROTL(x, b)	(uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIP_ROUND(v0, v1, v2, v3) do {					\
+	v0 += v1; v1 = SIP_ROTL(v1, 13); v1 ^= v0; v0 = SIP_ROTL(v0, 32); \
+	v2 += v3; v3 = SIP_ROTL(v3, 16); v3 ^= v2;			\
+	v0 += v3; v3 = SIP_ROTL(v3, 21); v3 ^= v0;			\
+	v2 += v1; v1 = SIP_ROTL(v1, 17); v1 ^= v2; v2 = SIP_ROTL(v2, 32); \
+} while (0)
+
+static __inline uint64_t
+sip_le64(const u_char *p)
+{
+	return ((uint64_t)p[0] | (uint64_t)p[1] << 8 |
+	    (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+	    (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 |
+	    (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56);
+}
+
+/*
+ * Sets up a key from the given material.  Exactly SIPHASH_KEY_LEN bytes
+ * are used as they are, anything else is hashed down to a key first.
+ */
+
+void
+siphash_key_init(struct siphash_key *key, const void *data, size_t len)
+{
+	static const struct siphash_key zero = { 0, 1 };
+	const u_char *p = data;
+
+	if (len == SIPHASH_KEY_LEN) {
+		key->k0 = sip_le64(p);
+		key->k1 = sip_le64(p + 8);
+		return;
+	}
+
+	key->k0 = siphash(&zero, data, len);
+	key->k1 = siphash(&zero, &key->k0, sizeof(key->k0)) ^ len;
+}
+
+uint64_t
+siphash(const struct siphash_key *key, const void *data, size_t len)
+{
+	const u_char *p = data, *end = p + (len & ~7);
+	uint64_t v0 = key->k0 ^ 0x736f6d6570736575ULL;
+	uint64_t v1 = key->k1 ^ 0x646f72616e646f6dULL;
+	uint64_t v2 = key->k0 ^ 0x6c7967656e657261ULL;
+	uint64_t v3 = key->k1 ^ 0x7465646279746573ULL;
+	uint64_t m, b = (uint64_t)len << 56;
+
+	for (; p != end; p += 8) {
+		m = sip_le64(p);
+		v3 ^= m;
+		SIP_ROUND(v0, v1, v2, v3);
+		SIP_ROUND(v0, v1, v2, v3);
+		v0 ^= m;
+	}
+
+	switch (len & 7) {
+	case 7: b |= (uint64_t)p[6] << 48;
+	case 6: b |= (uint64_t)p[5] << 40;
+	case 5: b |= (uint64_t)p[4] << 32;
+	case 4: b |= (uint64_t)p[3] << 24;
+	case 3: b |= (uint64_t)p[2] << 16;
+	case 2: b |= (uint64_t)p[1] << 8;
+	case 1: b |= (uint64_t)p[0];
+	}
+
+	v3 ^= b;
+	SIP_ROUND(v0, v1, v2, v3);
+	SIP_ROUND(v0, v1, v2, v3);
+	v0 ^= b;
+
+	v2 ^= 0xff;
+	SIP_ROUND(v0, v1, v2, v3);
+	SIP_ROUND(v0, v1, v2, v3);
+	SIP_ROUND(v0, v1, v2, v3);
+	SIP_ROUND(v0, v1, v2, v3);
+
+	return (v0 ^ v1 ^ v2 ^ v3);
+}
+
+/* Unittests */
+
+void
+siphash_test(void)
+{
+	/* Reference vectors for key 00..0f and messages 00..len-1 */
+	static const struct {
+		size_t len;
+		uint64_t hash;
+	} vectors[] = {
+		{ 0, 0x726fdb47dd0e0e31ULL },
+		{ 1, 0x74f839c593dc67fdULL },
+		{ 8, 0x93f5f5799a932462ULL },
+		{ 15, 0xa129ca6149be45e5ULL },
+		{ 63, 0x958a324ceb064572ULL }
+	};
+	struct siphash_key key;
+	u_char data[64];
+	int i;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i;
+	siphash_key_init(&key, data, SIPHASH_KEY_LEN);
+
+	for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+		uint64_t hash = siphash(&key, data, vectors[i].len);
+		if (hash != vectors[i].hash)
+			errx(1, "%s: length %u hashes to %016llx", __func__,
+			    (u_int)vectors[i].len, (unsigned long long)hash);
+	}
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
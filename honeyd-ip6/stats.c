@@ -653,7 +653,6 @@ record_add_hash(struct hashq *hashes, void *data, size_t len)
 void
 record_fill(struct record *r, const struct tuple *hdr)
 {
-	struct ip_hdr ip;
 	char *name;
 
 	TAILQ_INIT(&r->hashes);
@@ -669,8 +668,7 @@ record_fill(struct record *r, const struct tuple *hdr)
 	gettimeofday(&r->tv_start, NULL);
 	r->proto = hdr->type == SOCK_STREAM ? IP_PROTO_TCP : IP_PROTO_UDP;
 
-        ip.ip_src = hdr->ip_src;
-        name = honeyd_osfp_name(&ip);
+	name = honeyd_osfp_name(hdr);
 	if (name != NULL)
 		r->os_fp = strdup(name);
 
@@ -746,9 +744,7 @@ stats_tcp_input(struct tuple *conhdr, u_char *pkt, u_int pktlen, void *arg)
 	else if (stats->record.os_fp == NULL) {
 		/* Update the passive fingerprint, if possible */
 		char *name;
-		struct ip_hdr ip;
-		ip.ip_src = conhdr->ip_src;
-		name = honeyd_osfp_name(&ip);
+		name = honeyd_osfp_name(conhdr);
 		if (name != NULL)
 			stats->record.os_fp = strdup(name);
 	}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * SYN cookies for ports that should not hold state for half-open
+ * connections.  The ISN of the SYN-ACK has to come from the sequence
+ * model of the personality, so it can not carry the cookie itself.
+ * Instead, a MAC over the tuple, the ISN and the current period is
+ * remembered in a fixed table, together with the options of the SYN
+ * that the connection needs later.  A slot is picked by the MAC as
+ * well, so there is no per connection memory and collisions simply
+ * forget the older handshake.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/time.h>
+#include <sys/queue.h>
+#include <sys/tree.h>
+
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dnet.h>
+
+#include <event.h>
+
+#include "honeyd.h"
+#include "siphash.h"
+#include "syncookie.h"
+
+struct syncookie {
+	uint32_t tag;
+	struct syncookie_opts opts;
+};
+
+static struct siphash_key syncookie_key;
+static struct syncookie *syncookie_jar;
+
+static uint64_t
+syncookie_mac(const struct tuple *hdr, uint32_t isn, uint32_t period)
+{
+	struct {
+		u_char src[IP6_ADDR_LEN];
+		u_char dst[IP6_ADDR_LEN];
+		uint16_t sport;
+		uint16_t dport;
+		uint32_t isn;
+		uint32_t period;
+	} msg;
+
+	memset(&msg, 0, sizeof(msg));
+	if (hdr->src_addr.addr_type == ADDR_TYPE_IP6) {
+		memcpy(msg.src, &hdr->src_addr.addr_ip6, IP6_ADDR_LEN);
+		memcpy(msg.dst, &hdr->dst_addr.addr_ip6, IP6_ADDR_LEN);
+	} else {
+		memcpy(msg.src, &hdr->ip_src, IP_ADDR_LEN);
+		memcpy(msg.dst, &hdr->ip_dst, IP_ADDR_LEN);
+	}
+	msg.sport = hdr->sport;
+	msg.dport = hdr->dport;
+	msg.isn = isn;
+	msg.period = period;
+
+	return (siphash(&syncookie_key, &msg, sizeof(msg)));
+}
+
+#define SYNCOOKIE_SLOT(mac)	((mac) >> (64 - SYNCOOKIE_BITS))
+#define SYNCOOKIE_TAG(mac)	((uint32_t)(mac) | 1)
+
+/*
+ * Remembers that we sent a SYN-ACK with the given ISN.  The table is
+ * only allocated once a port actually uses SYN cookies.
+ */
+
+void
+syncookie_add(const struct tuple *hdr, uint32_t isn,
+    const struct syncookie_opts *opts)
+{
+	struct syncookie *slot;
+	uint64_t mac;
+
+	if (syncookie_jar == NULL) {
+		u_char seed[SIPHASH_KEY_LEN];
+		rand_t *rnd;
+
+		if ((syncookie_jar = calloc(SYNCOOKIE_SLOTS,
+			 sizeof(struct syncookie))) == NULL)
+			err(1, "%s: calloc", __func__);
+
+		/* Forged ACKs must not be able to hit a valid tag */
+		if ((rnd = rand_open()) == NULL)
+			err(1, "%s: rand_open", __func__);
+		rand_get(rnd, seed, sizeof(seed));
+		rand_close(rnd);
+		siphash_key_init(&syncookie_key, seed, sizeof(seed));
+	}
+
+	mac = syncookie_mac(hdr, isn, time(NULL) / SYNCOOKIE_PERIOD);
+	slot = &syncookie_jar[SYNCOOKIE_SLOT(mac)];
+	slot->tag = SYNCOOKIE_TAG(mac);
+	slot->opts = *opts;
+}
+
+/*
+ * Checks if the acknowledged ISN belongs to a SYN-ACK that we sent for
+ * this tuple during the current or the previous period.  A cookie can
+ * be used only once.  Returns 0 and the options of the SYN in opts on
+ * success and -1 otherwise.
+ */
+
+int
+syncookie_check(const struct tuple *hdr, uint32_t isn,
+    struct syncookie_opts *opts)
+{
+	struct syncookie *slot;
+	uint32_t period;
+	uint64_t mac;
+	int i;
+
+	if (syncookie_jar == NULL)
+		return (-1);
+
+	period = time(NULL) / SYNCOOKIE_PERIOD;
+	for (i = 0; i < 2; i++) {
+		mac = syncookie_mac(hdr, isn, period - i);
+		slot = &syncookie_jar[SYNCOOKIE_SLOT(mac)];
+		if (slot->tag == SYNCOOKIE_TAG(mac)) {
+			slot->tag = 0;
+			*opts = slot->opts;
+			return (0);
+		}
+	}
+
+	return (-1);
+}
+
+/* Unittests */
+
+void
+syncookie_test(void)
+{
+	struct syncookie_opts opts, got;
+	struct tuple hdr, other;
+	struct addr src, dst;
+	uint32_t isn = 0x12345678;
+	int i, found;
+
+	memset(&hdr, 0, sizeof(hdr));
+	addr_pton("10.0.0.1", &src);
+	addr_pton("10.0.0.2", &dst);
+	hdr.ip_src = src.addr_ip;
+	hdr.ip_dst = dst.addr_ip;
+	hdr.sport = 31337;
+	hdr.dport = 80;
+	hdr.type = SOCK_STREAM;
+	memset(&opts, 0, sizeof(opts));
+	opts.mss = 1380;
+	opts.sawtimestamp = 1;
+	opts.echotimestamp = 0xdeadbeef;
+
+	if (syncookie_check(&hdr, isn, &got) != -1)
+		errx(1, "%s: cookie accepted before any was sent", __func__);
+
+	syncookie_add(&hdr, isn, &opts);
+	if (syncookie_check(&hdr, isn + 1, &got) != -1)
+		errx(1, "%s: wrong ISN accepted", __func__);
+	other = hdr;
+	other.sport++;
+	if (syncookie_check(&other, isn, &got) != -1)
+		errx(1, "%s: cookie accepted for another port", __func__);
+	if (syncookie_check(&hdr, isn, &got) != 0)
+		errx(1, "%s: valid cookie rejected", __func__);
+	if (got.mss != opts.mss || !got.sawtimestamp ||
+	    got.echotimestamp != opts.echotimestamp)
+		errx(1, "%s: options of the SYN were not kept", __func__);
+	if (syncookie_check(&hdr, isn, &got) != -1)
+		errx(1, "%s: cookie accepted twice", __func__);
+
+	/* IPv6 tuples hash their full addresses */
+	memset(&hdr, 0, sizeof(hdr));
+	addr_pton("2001:db8::1", &hdr.src_addr);
+	addr_pton("2001:db8::2", &hdr.dst_addr);
+	hdr.sport = 31337;
+	hdr.dport = 80;
+	other = hdr;
+	addr_pton("2001:db8::3", &other.src_addr);
+	syncookie_add(&hdr, isn, &opts);
+	if (syncookie_check(&other, isn, &got) != -1)
+		errx(1, "%s: cookie accepted for another address", __func__);
+	if (syncookie_check(&hdr, isn, &got) != 0)
+		errx(1, "%s: valid IPv6 cookie rejected", __func__);
+
+	/* A flood only overwrites a fraction of the pending handshakes */
+	for (i = 0; i < 1000; i++) {
+		hdr.sport = i;
+		syncookie_add(&hdr, isn + i, &opts);
+	}
+	for (i = 0; i < SYNCOOKIE_SLOTS / 4; i++) {
+		other.sport = i;
+		syncookie_add(&other, i, &opts);
+	}
+	for (found = i = 0; i < 1000; i++) {
+		hdr.sport = i;
+		if (syncookie_check(&hdr, isn + i, &got) == 0)
+			found++;
+	}
+	if (found < 700)
+		errx(1, "%s: only %d of 1000 cookies survived", __func__,
+		    found);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _SYNCOOKIE_H_
+#define _SYNCOOKIE_H_
+
+#define SYNCOOKIE_BITS		16
+#define SYNCOOKIE_SLOTS		(1 << SYNCOOKIE_BITS)
+#define SYNCOOKIE_PERIOD	64	/* seconds, cookies live one or two */
+
+/* What the SYN told us, restored when the handshake completes */
+struct syncookie_opts {
+	uint32_t echotimestamp;
+	uint16_t mss;			/* 0 if the peer did not announce one */
+	uint16_t sawtimestamp;
+};
+
+void syncookie_add(const struct tuple *, uint32_t,
+    const struct syncookie_opts *);
+int syncookie_check(const struct tuple *, uint32_t, struct syncookie_opts *);
+
+void syncookie_test(void);
+
+#endif /* _SYNCOOKIE_H_ */
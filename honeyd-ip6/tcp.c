@@ -40,6 +40,7 @@
 #include <sys/queue.h>
 #include <sys/socket.h>
 #include <sys/resource.h>
+#include <sys/uio.h>
 
 #include <err.h>
 #include <errno.h>
@@ -61,71 +62,77 @@
 #include "log.h"
 #include "hooks.h"
 #include "util.h"
+#include "plugins_config.h"
 
 #include <syslog.h>
 
 struct callback cb_tcp =
 { cmd_tcp_read, cmd_tcp_write, cmd_tcp_eread, cmd_tcp_connect_cb };
 
-void tcp_increase_buf(u_char **pbuf, u_int *psize, u_int maxsize)
-{
-	u_int size = *psize;
-	u_char *p;
+u_int tcp_max_size = TCP_MAX_SIZE;
+u_int tcp_max_send = TCP_MAX_SEND;
 
-	if (size >= maxsize)
-		return;
-	size *= 2;
-	if (size >= maxsize)
-		size = maxsize;
-
-	p = realloc(*pbuf, size);
-	if (p == NULL )
-		return;
+/* The configuration may change how much we buffer and send at once */
+void tcp_config(void)
+{
+	const struct honeyd_plugin_cfg *cfg;
+
+	if ((cfg = plugins_config_find_item("honeyd", "tcp_max_size",
+		    HD_CONFIG_INT)) != NULL && cfg->cfg_int > 0)
+		tcp_max_size = cfg->cfg_int;
+	if ((cfg = plugins_config_find_item("honeyd", "tcp_max_send",
+		    HD_CONFIG_INT)) != NULL && cfg->cfg_int > 0)
+		tcp_max_send = cfg->cfg_int;
+}
 
-	*psize = size;
-	*pbuf = p;
+/*
+ * The largest segment that we send on this connection: the MSS of the
+ * peer, limited by tcp_max_send and by what fits into a packet.
+ */
+u_int tcp_segsize(const struct tcp_con *con)
+{
+	u_int size = con->snd_mss ? con->snd_mss : TCP_DEFAULT_MSS;
+	u_int room = HONEYD_MTU - TCP_HDR_LEN_MAX -
+	    (con->addr_family == AF_INET6 ? IP6_HDR_LEN : IP_HDR_LEN);
+
+	if (size > tcp_max_send)
+		size = tcp_max_send;
+	if (size > room)
+		size = room;
+	return (size);
 }
 
+/* Space left in a buffer, which may be over the limit after a reload */
+#define TCP_BUFSPACE(buf) \
+	((buf)->len < tcp_max_size ? tcp_max_size - (buf)->len : 0)
+
 void tcp_drain_payload(struct tcp_con *con, u_int len)
 {
-	if (len == 0 || con->payload == NULL )
+	if (len == 0)
 		return;
 
-	if (len >= con->plen)
-	{
-		con->plen = 0;
-		con->poff = 0;
-		goto out;
-	}
+	tcpbuf_drain(&con->sendbuf, len);
+	con->poff = len < con->poff ? con->poff - len : 0;
 
-	memmove(con->payload, con->payload + len, con->plen - len);
-	con->plen -= len;
-	con->poff -= len;
-	out: cmd_trigger_read(&con->cmd, con->psize - con->plen);
+	cmd_trigger_read(&con->cmd, TCP_BUFSPACE(&con->sendbuf));
 }
 
 int tcp_add_readbuf(struct tcp_con *con, u_char *dat, u_int datlen)
 {
-	int space;
+	u_int space;
 
 	hooks_dispatch(IP_PROTO_TCP, HD_INCOMING_STREAM, &con->conhdr, dat, datlen);
 
 	if (con->cmd_pfd == -1)
 		return (datlen);
 
-	space = con->rsize - con->rlen;
+	space = TCP_BUFSPACE(&con->readbuf);
 	if (space < datlen)
-	{
-		tcp_increase_buf(&con->readbuf, &con->rsize, TCP_MAX_SIZE);
-		space = con->rsize - con->rlen;
-		if (space < datlen)
-			datlen = space;
-	}
+		datlen = space;
 
-	memcpy(con->readbuf + con->rlen, dat, datlen);
-	con->rlen += datlen;
+	tcpbuf_add(&con->readbuf, dat, datlen);
 
-	cmd_trigger_write(&con->cmd, con->rlen);
+	cmd_trigger_write(&con->cmd, con->readbuf.len);
 
 	return (datlen);
 }
@@ -169,14 +176,21 @@ void cmd_tcp_eread(int fd, short which, void *arg)
 void cmd_tcp_read(int fd, short which, void *arg)
 {
 	struct tcp_con *con = arg;
-	int len, space;
+	int len;
+	u_int space, room;
 	struct command *cmd = &con->cmd;
+	u_char *p;
 
-	space = con->psize - con->plen;
-	if (space <= 0)
+	space = TCP_BUFSPACE(&con->sendbuf);
+	if (space == 0)
 		return;
 
-	TRACE(fd, len = read(fd, con->payload + con->plen, space));
+	/* Read straight into the last segment of the chain */
+	p = tcpbuf_reserve(&con->sendbuf, &room);
+	if (space > room)
+		space = room;
+
+	TRACE(fd, len = read(fd, p, space));
 	if (len == -1)
 	{
 		if (errno == EINTR || errno == EAGAIN)
@@ -198,22 +212,22 @@ void cmd_tcp_read(int fd, short which, void *arg)
 		return;
 	}
 
-	con->plen += len;
-	if (con->plen == con->psize)
-		tcp_increase_buf(&con->payload, &con->psize, TCP_MAX_SIZE);
+	tcpbuf_commit(&con->sendbuf, len);
 
 	/* XXX - Trigger write */
 	tcp_senddata(con, TH_ACK);
 
-	again: cmd_trigger_read(&con->cmd, con->psize - con->plen);
+	again: cmd_trigger_read(&con->cmd, TCP_BUFSPACE(&con->sendbuf));
 }
 
 void cmd_tcp_write(int fd, short which, void *arg)
 {
 	struct tcp_con *con = arg;
-	int len;
+	struct iovec iov[TCPBUF_IOVMAX];
+	int len, niov = TCPBUF_IOVMAX;
 
-	TRACE(fd, len = write(fd, con->readbuf, con->rlen));
+	tcpbuf_iovec(&con->readbuf, 0, con->readbuf.len, iov, &niov);
+	TRACE(fd, len = writev(fd, iov, niov));
 
 
 	if (len == -1)
@@ -229,14 +243,13 @@ void cmd_tcp_write(int fd, short which, void *arg)
 		return;
 	}
 
-	memmove(con->readbuf, con->readbuf + len, con->rlen - len);
-	con->rlen -= len;
+	tcpbuf_drain(&con->readbuf, len);
 
 	/* Shut down the connection if we received a FIN and sent all data */
-	if (con->rlen == 0 && con->cmd.fdgotfin)
+	if (con->readbuf.len == 0 && con->cmd.fdgotfin)
 		TRACE(con->cmd_pfd, shutdown(con->cmd_pfd, SHUT_WR));
 
-	again: cmd_trigger_write(&con->cmd, con->rlen);
+	again: cmd_trigger_write(&con->cmd, con->readbuf.len);
 }
 
 void cmd_tcp_connect_cb(int fd, short which, void *arg)
@@ -264,8 +277,8 @@ void cmd_tcp_connect_cb(int fd, short which, void *arg)
 		goto out;
 	}
 
-	cmd_trigger_read(&con->cmd, con->psize - con->plen);
-	cmd_trigger_write(&con->cmd, con->rlen);
+	cmd_trigger_read(&con->cmd, TCP_BUFSPACE(&con->sendbuf));
+	cmd_trigger_write(&con->cmd, con->readbuf.len);
 	return;
 
 	out:
@@ -32,9 +32,14 @@
 #ifndef _TCP_H_
 #define _TCP_H_
 
+extern u_int tcp_max_size;
+extern u_int tcp_max_send;
+
+void tcp_config(void);
+u_int tcp_segsize(const struct tcp_con *);
+
 int tcp_add_readbuf(struct tcp_con *, u_char *, u_int);
 void tcp_drain_payload(struct tcp_con *, u_int);
-void tcp_increase_buf(u_char **, u_int *, u_int);
 
 void cmd_tcp_eread(int, short, void *);
 void cmd_tcp_read(int, short, void *);
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/queue.h>
+#include <sys/uio.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+#include "tcpbuf.h"
+
+static struct pool *pool_tcpseg;
+
+void
+tcpbuf_init(void)
+{
+	pool_tcpseg = pool_init("tcpseg", sizeof(struct tcpseg));
+}
+
+void
+tcpbuf_free(struct tcpbuf *buf)
+{
+	struct tcpseg *seg;
+
+	while ((seg = buf->head) != NULL) {
+		buf->head = seg->next;
+		pool_free(pool_tcpseg, seg);
+	}
+	buf->tail = NULL;
+	buf->len = 0;
+}
+
+/*
+ * Returns the free space behind the last byte of the buffer and stores
+ * its size in *space.  A new segment is chained on if the last one is
+ * full.  The caller fills in the data and then calls tcpbuf_commit().
+ */
+
+u_char *
+tcpbuf_reserve(struct tcpbuf *buf, u_int *space)
+{
+	struct tcpseg *seg = buf->tail;
+
+	if (seg == NULL || seg->off + seg->len == TCPBUF_SEGSIZE) {
+		seg = pool_alloc(pool_tcpseg);
+		seg->next = NULL;
+		seg->off = seg->len = 0;
+		if (buf->tail != NULL)
+			buf->tail->next = seg;
+		else
+			buf->head = seg;
+		buf->tail = seg;
+	}
+
+	*space = TCPBUF_SEGSIZE - (seg->off + seg->len);
+	return (seg->data + seg->off + seg->len);
+}
+
+void
+tcpbuf_commit(struct tcpbuf *buf, u_int len)
+{
+	buf->tail->len += len;
+	buf->len += len;
+}
+
+u_int
+tcpbuf_add(struct tcpbuf *buf, const void *data, u_int len)
+{
+	const u_char *p = data;
+	u_int space, left = len;
+	u_char *dst;
+
+	while (left) {
+		dst = tcpbuf_reserve(buf, &space);
+		if (space > left)
+			space = left;
+		memcpy(dst, p, space);
+		tcpbuf_commit(buf, space);
+		p += space;
+		left -= space;
+	}
+
+	return (len);
+}
+
+/* Removes len bytes from the front and returns empty segments */
+
+void
+tcpbuf_drain(struct tcpbuf *buf, u_int len)
+{
+	struct tcpseg *seg;
+
+	if (len > buf->len)
+		len = buf->len;
+	buf->len -= len;
+
+	while ((seg = buf->head) != NULL && len >= seg->len) {
+		len -= seg->len;
+		buf->head = seg->next;
+		pool_free(pool_tcpseg, seg);
+	}
+	if (seg == NULL) {
+		buf->tail = NULL;
+		return;
+	}
+
+	seg->off += len;
+	seg->len -= len;
+}
+
+/*
+ * Describes len bytes starting at offset off with at most *niov io
+ * vectors that point into the segments.  Returns the number of bytes
+ * that are described and the number of vectors in *niov.
+ */
+
+u_int
+tcpbuf_iovec(const struct tcpbuf *buf, u_int off, u_int len,
+    struct iovec *iov, int *niov)
+{
+	struct tcpseg *seg;
+	u_int n, total = 0;
+	int i = 0;
+
+	for (seg = buf->head; seg != NULL && off >= seg->len; seg = seg->next)
+		off -= seg->len;
+
+	for (; seg != NULL && len && i < *niov; seg = seg->next) {
+		n = seg->len - off;
+		if (n > len)
+			n = len;
+		if (n == 0)
+			continue;
+		iov[i].iov_base = seg->data + seg->off + off;
+		iov[i].iov_len = n;
+		i++;
+		off = 0;
+		len -= n;
+		total += n;
+	}
+
+	*niov = i;
+	return (total);
+}
+
+/* Unittests */
+
+static void
+tcpbuf_check(struct tcpbuf *buf, const u_char *ref, u_int off, u_int len)
+{
+	struct iovec iov[TCPBUF_IOVMAX];
+	u_int i, n, total;
+	int niov = TCPBUF_IOVMAX;
+	u_char *p;
+
+	total = tcpbuf_iovec(buf, off, len, iov, &niov);
+	if (total != len)
+		errx(1, "%s: described %u of %u bytes", __func__, total, len);
+	for (i = 0; i < niov; i++) {
+		p = iov[i].iov_base;
+		for (n = 0; n < iov[i].iov_len; n++)
+			if (p[n] != ref[off++])
+				errx(1, "%s: data mismatch", __func__);
+	}
+}
+
+void
+tcpbuf_test(void)
+{
+	struct tcpbuf buf;
+	u_char ref[8 * TCPBUF_SEGSIZE], *p;
+	u_int i, off, len, space;
+
+	for (i = 0; i < sizeof(ref); i++)
+		ref[i] = i * 7 + (i >> 8);
+
+	memset(&buf, 0, sizeof(buf));
+	if (tcpbuf_add(&buf, ref, 3000) != 3000 || buf.len != 3000)
+		errx(1, "%s: tcpbuf_add failed", __func__);
+	tcpbuf_check(&buf, ref, 0, 3000);
+	tcpbuf_check(&buf, ref, 1000, 1460);
+
+	/* Fill the rest through reserve and commit like read(2) does */
+	off = 3000;
+	while (off < sizeof(ref)) {
+		p = tcpbuf_reserve(&buf, &space);
+		len = MIN(space, MIN(700, sizeof(ref) - off));
+		memcpy(p, ref + off, len);
+		tcpbuf_commit(&buf, len);
+		off += len;
+	}
+	tcpbuf_check(&buf, ref, 0, sizeof(ref));
+
+	/* Acknowledged data goes away, the rest stays where it is */
+	tcpbuf_drain(&buf, 100);
+	tcpbuf_check(&buf, ref + 100, 0, sizeof(ref) - 100);
+	tcpbuf_drain(&buf, 2 * TCPBUF_SEGSIZE);
+	off = 100 + 2 * TCPBUF_SEGSIZE;
+	tcpbuf_check(&buf, ref + off, 50, buf.len - 50);
+
+	tcpbuf_drain(&buf, buf.len + 10);
+	if (buf.len != 0 || buf.head != NULL || buf.tail != NULL)
+		errx(1, "%s: buffer not empty after draining", __func__);
+
+	/* An empty segment left by a failed read is harmless */
+	tcpbuf_reserve(&buf, &space);
+	tcpbuf_add(&buf, ref, 10);
+	tcpbuf_check(&buf, ref, 0, 10);
+	tcpbuf_free(&buf);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _TCPBUF_H_
+#define _TCPBUF_H_
+
+#define TCPBUF_SEGSIZE		1460	/* data bytes in a pooled segment */
+#define TCPBUF_IOVMAX		16	/* segments handed to writev at once */
+
+struct tcpseg {
+	struct tcpseg *next;
+	u_short off;			/* first byte that is still queued */
+	u_short len;			/* queued bytes following off */
+	u_char data[TCPBUF_SEGSIZE];
+};
+
+/*
+ * The stream data of a TCP connection, kept as a chain of segments.
+ * Data is appended at the tail and consumed from the head, so nothing
+ * ever has to be moved.  A zeroed tcpbuf is a valid empty buffer.
+ */
+
+struct tcpbuf {
+	struct tcpseg *head;
+	struct tcpseg *tail;
+	u_int len;			/* bytes in all segments */
+};
+
+struct iovec;
+
+void tcpbuf_init(void);
+void tcpbuf_free(struct tcpbuf *);
+
+u_char *tcpbuf_reserve(struct tcpbuf *, u_int *);
+void tcpbuf_commit(struct tcpbuf *, u_int);
+u_int tcpbuf_add(struct tcpbuf *, const void *, u_int);
+void tcpbuf_drain(struct tcpbuf *, u_int);
+u_int tcpbuf_iovec(const struct tcpbuf *, u_int, u_int, struct iovec *, int *);
+
+void tcpbuf_test(void);
+
+#endif /* _TCPBUF_H_ */
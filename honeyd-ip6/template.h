@@ -55,6 +55,7 @@ struct template
 	SPLAY_ENTRY(template) node;
 
 	char *name;
+	struct addr addr;	/* binary form of name, if it is an address */
 
 	struct porttree ports;
 
@@ -104,15 +105,27 @@ struct template
 	/* optional spoof source and destination for the reply */
 	struct spoof spoof;
 
-	/* Reference counter */
-	uint16_t refcnt;
+	/* Reference counter, shared clones hold one on their parent */
+	u_int refcnt;
 
 	struct interface *inter;
+
+	/* Ports and personality are the parent's until they are changed */
+	struct template *parent;
+
+	/* On-demand templates, least recently used first */
+	TAILQ_ENTRY(template) lru;
+	time_t lastuse;
+
+	/* Templates that share the solicited-node group of this one */
+	LIST_ENTRY(template) solnode;
 };
 
 #define TEMPLATE_EXTERNAL	0x0001	/* Real machine on external network */
 #define TEMPLATE_DYNAMIC	0x0002	/* Pointer to templates */
 #define TEMPLATE_DYNAMIC_CHILD	0x0004  /* Is dynamic child */
+#define TEMPLATE_ONDEMAND	0x0008	/* Created for a packet, reclaimable */
+#define TEMPLATE_SOLNODE	0x0010	/* Member of a solicited-node group */
 
 /* Required to access template from different source files */
 SPLAY_HEAD( templtree, template);
@@ -125,15 +138,28 @@ int template_subsystem(struct template *, char *, int);
 void template_subsystem_start(struct template *tmpl, struct subsystem *sub);
 struct template *template_clone(const char *, const struct template *,
 		const struct interface *, int);
+struct template *template_clone_shared(const char *, struct template *,
+		const struct interface *);
 
 struct template *template_find(const char *);
+struct template *template_find_addr(const struct addr *);
 
-struct template *template_find_best(const char *, const struct ip_hdr *,
+struct template *template_find_best(const struct addr *, const struct ip_hdr *,
 		u_short);
+struct template *template_dynamic(const struct template *,
+		const u_char *, u_short);
 void template_list_glob(struct evbuffer *buffer, const char *pattern);
 
 void template_post_arp(struct template *, struct addr *);
 void template_remove_arp(struct template *);
+void template_remove_ndp(struct template *);
+
+void template_lru_insert(struct template *);
+void template_touch(struct template *);
+void template_reclaim(struct template *);
+int template_reclaim_idle(time_t, int);
+struct template *template_lru_oldest(void);
+u_int template_lru_count(void);
 
 int template_insert_dynamic(struct template *, struct template *,
 		struct condition *);
@@ -180,5 +206,7 @@ template_ref(struct template *tmpl)
 }
 
 void template_test(void);
+void template_index_test(void);
+void template_share_test(void);
 
 #endif /* _TEMPLATE_ */
@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/queue.h>
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <event.h>
+
+#include "timerwheel.h"
+
+#define TW_ROOTMASK	(TIMERWHEEL_ROOTSIZE - 1)
+#define TW_LEVELMASK	(TIMERWHEEL_LEVELSIZE - 1)
+#define TW_SHIFT(l)	(TIMERWHEEL_ROOTBITS + (l) * TIMERWHEEL_LEVELBITS)
+#define TW_INDEX(t, l)	(((t) >> TW_SHIFT(l)) & TW_LEVELMASK)
+
+struct twstats twstats;
+
+static struct twlist tw_root[TIMERWHEEL_ROOTSIZE];
+static struct twlist tw_level[TIMERWHEEL_LEVELS][TIMERWHEEL_LEVELSIZE];
+static uint64_t tw_now;			/* last millisecond processed */
+static uint64_t tw_deadline;		/* when the event is due to fire */
+static int tw_initialized;
+static struct event tw_ev;
+
+static void timerwheel_cb(int, short, void *);
+
+static void
+timerwheel_init(void)
+{
+	int i, j;
+
+	for (i = 0; i < TIMERWHEEL_ROOTSIZE; i++)
+		TAILQ_INIT(&tw_root[i]);
+	for (i = 0; i < TIMERWHEEL_LEVELS; i++)
+		for (j = 0; j < TIMERWHEEL_LEVELSIZE; j++)
+			TAILQ_INIT(&tw_level[i][j]);
+
+	evtimer_set(&tw_ev, timerwheel_cb, NULL);
+	tw_initialized = 1;
+}
+
+static uint64_t
+timerwheel_msec(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000);
+}
+
+/*
+ * Finds the list for an entry relative to the current position of the
+ * wheel.  Entries further out than the wheel can represent are parked
+ * in the last slot and get sorted in again when it cascades.
+ */
+
+static struct twlist *
+timerwheel_slot(uint64_t expire)
+{
+	uint64_t delta;
+	int level;
+
+	if (expire <= tw_now)
+		expire = tw_now + 1;
+	delta = expire - tw_now;
+	if (delta < TIMERWHEEL_ROOTSIZE)
+		return (&tw_root[expire & TW_ROOTMASK]);
+
+	if (delta > TIMERWHEEL_MAXDELAY) {
+		delta = TIMERWHEEL_MAXDELAY;
+		expire = tw_now + delta;
+	}
+	for (level = 0; level < TIMERWHEEL_LEVELS - 1; level++) {
+		if (delta < (1ULL << TW_SHIFT(level + 1)))
+			break;
+	}
+	return (&tw_level[level][TW_INDEX(expire, level)]);
+}
+
+static void
+timerwheel_schedule(uint64_t now, uint64_t when)
+{
+	struct timeval tv;
+
+	if (evtimer_pending(&tw_ev, NULL)) {
+		if (tw_deadline <= when)
+			return;
+		evtimer_del(&tw_ev);
+	}
+
+	tw_deadline = when;
+	when = when > now ? when - now : 0;
+
+	timerclear(&tv);
+	tv.tv_sec = when / 1000;
+	tv.tv_usec = (when % 1000) * 1000;
+	evtimer_add(&tw_ev, &tv);
+}
+
+static void
+timerwheel_add_at(uint64_t now, struct twentry *entry, u_int ms,
+    void (*cb)(int, short, void *), void *arg)
+{
+	if (!tw_initialized)
+		timerwheel_init();
+
+	if (entry->tw_list != NULL)
+		timerwheel_del(entry);
+
+	/* An idle wheel catches up with the clock immediately */
+	if (twstats.pending == 0)
+		tw_now = now;
+
+	entry->tw_expire = now + (ms ? ms : 1);
+	entry->tw_cb = cb;
+	entry->tw_arg = arg;
+	entry->tw_list = timerwheel_slot(entry->tw_expire);
+	TAILQ_INSERT_TAIL(entry->tw_list, entry, tw_next);
+
+	twstats.scheduled++;
+	if (++twstats.pending > twstats.max_pending)
+		twstats.max_pending = twstats.pending;
+
+	timerwheel_schedule(now, entry->tw_expire);
+}
+
+/*
+ * Schedules cb to be called with arg after ms milliseconds.  The
+ * callback has the signature of a libevent timeout.
+ */
+
+void
+timerwheel_add(struct twentry *entry, u_int ms,
+    void (*cb)(int, short, void *), void *arg)
+{
+	timerwheel_add_at(timerwheel_msec(), entry, ms, cb, arg);
+}
+
+void
+timerwheel_del(struct twentry *entry)
+{
+	if (entry->tw_list == NULL)
+		return;
+
+	TAILQ_REMOVE(entry->tw_list, entry, tw_next);
+	entry->tw_list = NULL;
+	twstats.pending--;
+}
+
+int
+timerwheel_pending(struct twentry *entry)
+{
+	return (entry->tw_list != NULL);
+}
+
+/*
+ * Moves all entries of a higher level slot down the wheel.  Everything
+ * in the slot was scheduled before the entries that are already in the
+ * lower level lists, so they go in front to keep the order in which
+ * packets were delayed.
+ */
+
+static int
+timerwheel_cascade(int level, int index)
+{
+	struct twlist *list = &tw_level[level][index], tmp;
+	struct twentry *entry;
+
+	TAILQ_INIT(&tmp);
+	while ((entry = TAILQ_FIRST(list)) != NULL) {
+		TAILQ_REMOVE(list, entry, tw_next);
+		TAILQ_INSERT_TAIL(&tmp, entry, tw_next);
+	}
+
+	while ((entry = TAILQ_LAST(&tmp, twlist)) != NULL) {
+		TAILQ_REMOVE(&tmp, entry, tw_next);
+		entry->tw_list = timerwheel_slot(entry->tw_expire);
+		TAILQ_INSERT_HEAD(entry->tw_list, entry, tw_next);
+		twstats.cascaded++;
+	}
+
+	return (index);
+}
+
+static void
+timerwheel_tick(void)
+{
+	struct twlist batch;
+	struct twentry *entry;
+	u_int count = 0;
+	int level;
+
+	tw_now++;
+	twstats.ticks++;
+
+	if ((tw_now & TW_ROOTMASK) == 0) {
+		for (level = 0; level < TIMERWHEEL_LEVELS; level++)
+			if (timerwheel_cascade(level,
+				TW_INDEX(tw_now, level)) != 0)
+				break;
+	}
+
+	/*
+	 * Take the whole slot before running the callbacks, they are
+	 * likely to schedule more packets.
+	 */
+	TAILQ_INIT(&batch);
+	while ((entry = TAILQ_FIRST(&tw_root[tw_now & TW_ROOTMASK])) != NULL) {
+		TAILQ_REMOVE(entry->tw_list, entry, tw_next);
+		TAILQ_INSERT_TAIL(&batch, entry, tw_next);
+		entry->tw_list = NULL;
+		count++;
+	}
+	if (count == 0)
+		return;
+
+	twstats.pending -= count;
+	twstats.fired += count;
+	if (count > twstats.max_batch)
+		twstats.max_batch = count;
+
+	while ((entry = TAILQ_FIRST(&batch)) != NULL) {
+		TAILQ_REMOVE(&batch, entry, tw_next);
+		(*entry->tw_cb)(-1, EV_TIMEOUT, entry->tw_arg);
+	}
+}
+
+/*
+ * Advances the wheel up to now and arms the event for the next slot
+ * that has work.  Without anything close by, we wake up when the root
+ * wheel wraps around to cascade the next level.
+ */
+
+static void
+timerwheel_run(uint64_t now)
+{
+	uint64_t next;
+
+	while (tw_now < now && twstats.pending)
+		timerwheel_tick();
+
+	if (twstats.pending == 0) {
+		tw_now = now;
+		return;
+	}
+
+	for (next = tw_now + 1; next & TW_ROOTMASK; next++)
+		if (TAILQ_FIRST(&tw_root[next & TW_ROOTMASK]) != NULL)
+			break;
+
+	timerwheel_schedule(now, next);
+}
+
+static void
+timerwheel_cb(int fd, short which, void *arg)
+{
+	timerwheel_run(timerwheel_msec());
+}
+
+/* Unittests */
+
+static int tw_test_seq;
+
+static void
+timerwheel_test_cb(int fd, short which, void *arg)
+{
+	struct twentry *entry = arg;
+
+	if (tw_now != entry->tw_expire)
+		errx(1, "%s: fired at %llu instead of %llu", __func__,
+		    (unsigned long long)tw_now,
+		    (unsigned long long)entry->tw_expire);
+
+	/* Entries with the same expiry have to fire in order */
+	entry->tw_expire = ++tw_test_seq;
+}
+
+void
+timerwheel_test(void)
+{
+	static const u_int delays[] = {
+		1, 2, 255, 256, 257, 1000, 16383, 16384, 20000, 1 << 21
+	};
+	struct twentry entries[20], same[3];
+	uint64_t now = 123456789, end;
+	int i, n = sizeof(delays) / sizeof(delays[0]);
+
+	memset(entries, 0, sizeof(entries));
+	memset(same, 0, sizeof(same));
+
+	for (i = 0; i < n; i++)
+		timerwheel_add_at(now, &entries[i], delays[i],
+		    timerwheel_test_cb, &entries[i]);
+	for (i = 0; i < n; i++)
+		timerwheel_add_at(now + 100, &entries[n + i], delays[i],
+		    timerwheel_test_cb, &entries[n + i]);
+
+	if (twstats.pending != 2 * n)
+		errx(1, "%s: bad number of pending entries", __func__);
+
+	timerwheel_del(&entries[2]);
+	if (timerwheel_pending(&entries[2]))
+		errx(1, "%s: entry still pending", __func__);
+
+	end = now + 100 + (1 << 21);
+	for (now += 7; now <= end; now += 7)
+		timerwheel_run(now);
+	timerwheel_run(now);
+
+	if (twstats.pending != 0)
+		errx(1, "%s: %u entries left", __func__, twstats.pending);
+	for (i = 0; i < 2 * n; i++) {
+		if (i == 2)
+			continue;
+		if (timerwheel_pending(&entries[i]) ||
+		    entries[i].tw_expire > 2 * n)
+			errx(1, "%s: entry %d did not fire", __func__, i);
+	}
+
+	/*
+	 * The first entry waits on the next level while the second one
+	 * goes straight to the root wheel; both expire together.
+	 */
+	now = (now | TW_ROOTMASK) + 11;
+	timerwheel_run(now);
+	timerwheel_add_at(now, &same[0], 400, timerwheel_test_cb, &same[0]);
+	timerwheel_run(now + 200);
+	timerwheel_add_at(now + 200, &same[1], 200, timerwheel_test_cb,
+	    &same[1]);
+	timerwheel_run(now + 399);
+	timerwheel_add_at(now + 399, &same[2], 1, timerwheel_test_cb,
+	    &same[2]);
+	timerwheel_run(now + 400);
+
+	if (same[0].tw_expire + 1 != same[1].tw_expire ||
+	    same[1].tw_expire + 1 != same[2].tw_expire)
+		errx(1, "%s: entries fired out of order", __func__);
+
+	evtimer_del(&tw_ev);
+
+	fprintf(stderr, "\t%s: OK\n", __func__);
+}
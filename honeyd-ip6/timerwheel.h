@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _TIMERWHEEL_
+#define _TIMERWHEEL_
+
+/*
+ * Hierarchical timing wheel with millisecond resolution.  It is used
+ * for the routing delay of packets, so that a simulated topology with
+ * large latencies does not keep one libevent timer per packet.  A
+ * single event drives the wheel and all entries that expire in the
+ * same millisecond are run as one batch.
+ */
+
+#define TIMERWHEEL_ROOTBITS	8
+#define TIMERWHEEL_ROOTSIZE	(1 << TIMERWHEEL_ROOTBITS)
+#define TIMERWHEEL_LEVELBITS	6
+#define TIMERWHEEL_LEVELSIZE	(1 << TIMERWHEEL_LEVELBITS)
+#define TIMERWHEEL_LEVELS	3	/* in addition to the root wheel */
+#define TIMERWHEEL_MAXDELAY	\
+	((1ULL << (TIMERWHEEL_ROOTBITS + \
+	    TIMERWHEEL_LEVELS * TIMERWHEEL_LEVELBITS)) - 1)
+
+struct twentry {
+	TAILQ_ENTRY(twentry) tw_next;
+	struct twlist *tw_list;		/* NULL if not scheduled */
+
+	uint64_t tw_expire;		/* absolute time in ms */
+	void (*tw_cb)(int, short, void *);
+	void *tw_arg;
+};
+
+TAILQ_HEAD(twlist, twentry);
+
+struct twstats {
+	uint64_t scheduled;
+	uint64_t fired;
+	uint64_t ticks;		/* milliseconds the wheel advanced */
+	uint64_t cascaded;	/* entries moved to a lower level */
+
+	u_int pending;
+	u_int max_pending;
+	u_int max_batch;	/* largest number of entries in one tick */
+};
+
+void timerwheel_add(struct twentry *, u_int,
+    void (*)(int, short, void *), void *);
+void timerwheel_del(struct twentry *);
+int timerwheel_pending(struct twentry *);
+
+void timerwheel_test(void);
+
+extern struct twstats twstats;
+
+#endif /* _TIMERWHEEL_ */
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE		/* for sendmmsg */
+#endif
+
+#include <sys/types.h>
+#include <sys/param.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/queue.h>
+#include <sys/tree.h>
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#include <pcap.h>
+#include <dnet.h>
+#include <event.h>
+
+#include "honeyd.h"
+#include "interface.h"
+#include "histogram.h"
+#include "txqueue.h"
+
+struct txentry {
+	int fd;			/* -1 if the packet needs the slow path */
+	int ethernet;
+	struct interface *inter;
+	struct sockaddr_in sin;
+	u_int len;
+	u_int iplen;		/* payload for the network statistics */
+};
+
+extern struct stats_network stats_network;
+
+struct txstats txstats;
+
+static struct txentry txq[TXQUEUE_MAX];
+static u_char txbuf[TXQUEUE_MAX][TXQUEUE_BUFSIZE];
+static struct iovec txiov[TXQUEUE_MAX];
+#ifdef __linux__
+static struct mmsghdr txmsg[TXQUEUE_MAX];
+#else
+static struct msghdr txmsg[TXQUEUE_MAX];
+#endif
+
+static int txq_fd = -1;		/* raw IP socket */
+static ip_t *txq_ip;		/* libdnet fallback */
+static struct event txq_ev;
+
+static void txqueue_cb(int, short, void *);
+
+/*
+ * Only Linux takes raw IP headers in network byte order, elsewhere
+ * libdnet has to fix them up and we send through ip_send().
+ */
+
+void
+txqueue_init(ip_t *ip)
+{
+#ifdef __linux__
+	int on = 1;
+#endif
+
+	txq_ip = ip;
+
+#ifdef __linux__
+	if ((txq_fd = socket(AF_INET, SOCK_RAW, IPPROTO_RAW)) == -1) {
+		syslog(LOG_WARNING, "%s: socket: %m", __func__);
+		return;
+	}
+	if (setsockopt(txq_fd, IPPROTO_IP, IP_HDRINCL, &on, sizeof(on)) == -1) {
+		syslog(LOG_WARNING, "%s: IP_HDRINCL: %m", __func__);
+		close(txq_fd);
+		txq_fd = -1;
+	}
+#endif
+}
+
+/* Flushing happens in the next loop iteration, after the current events */
+
+static void
+txqueue_schedule(void)
+{
+	struct timeval tv;
+
+	if (txstats.depth == 1) {
+		if (!evtimer_initialized(&txq_ev))
+			evtimer_set(&txq_ev, txqueue_cb, NULL);
+		timerclear(&tv);
+		evtimer_add(&txq_ev, &tv);
+	}
+	if (txstats.depth > txstats.max_depth)
+		txstats.max_depth = txstats.depth;
+	if (txstats.depth == TXQUEUE_MAX)
+		txqueue_flush();
+}
+
+static void
+txqueue_cb(int fd, short what, void *arg)
+{
+	txqueue_flush();
+}
+
+static void
+txqueue_error(struct txentry *entry, int error)
+{
+	int level = LOG_ERR;
+
+	txstats.errors++;
+	if (!entry->ethernet && (error == EHOSTDOWN || error == EHOSTUNREACH))
+		level = LOG_DEBUG;
+	syslog(level, "%s: couldn't send packet size %d: %s", __func__,
+	    entry->len, strerror(error));
+}
+
+/* Packets that cannot be batched go out one at a time */
+
+static void
+txqueue_send_single(struct txentry *entry, const u_char *buf)
+{
+	ssize_t res;
+
+	txstats.syscalls++;
+	if (entry->ethernet)
+		res = eth_send(entry->inter->if_eth, buf, entry->len);
+	else
+		res = ip_send(txq_ip, buf, entry->len);
+
+	if (res != entry->len)
+		txqueue_error(entry, errno);
+	else
+		count_increment(stats_network.output_bytes, entry->iplen);
+}
+
+/* Sends entries [first, last) which all go to the same socket */
+
+static void
+txqueue_send_batch(int first, int last)
+{
+	int fd = txq[first].fd, i, res;
+
+	for (i = first; i < last; i++) {
+		struct txentry *entry = &txq[i];
+#ifdef __linux__
+		struct msghdr *msg = &txmsg[i].msg_hdr;
+#else
+		struct msghdr *msg = &txmsg[i];
+#endif
+
+		memset(msg, 0, sizeof(struct msghdr));
+		txiov[i].iov_base = txbuf[i];
+		txiov[i].iov_len = entry->len;
+		msg->msg_iov = &txiov[i];
+		msg->msg_iovlen = 1;
+
+		/* Packet sockets are bound to their interface */
+		if (!entry->ethernet) {
+			msg->msg_name = &entry->sin;
+			msg->msg_namelen = sizeof(entry->sin);
+		}
+	}
+
+	while (first < last) {
+		txstats.syscalls++;
+#ifdef __linux__
+		res = sendmmsg(fd, &txmsg[first], last - first, 0);
+#else
+		res = sendmsg(fd, &txmsg[first], 0) == -1 ? -1 : 1;
+#endif
+		if (res == -1) {
+			/* The first packet failed, skip over it */
+			txqueue_error(&txq[first], errno);
+			first++;
+			continue;
+		}
+
+		for (i = first; i < first + res; i++)
+			count_increment(stats_network.output_bytes,
+			    txq[i].iplen);
+		first += res;
+	}
+}
+
+void
+txqueue_flush(void)
+{
+	int i, first;
+
+	if (txstats.depth == 0)
+		return;
+
+	evtimer_del(&txq_ev);
+
+	/* Consecutive packets for the same socket share a system call */
+	for (first = 0; first < txstats.depth; first = i) {
+		if (txq[first].fd == -1) {
+			txqueue_send_single(&txq[first], txbuf[first]);
+			i = first + 1;
+			continue;
+		}
+
+		for (i = first + 1; i < txstats.depth; i++)
+			if (txq[i].fd != txq[first].fd)
+				break;
+		txqueue_send_batch(first, i);
+	}
+
+	txstats.packets += txstats.depth;
+	txstats.flushes++;
+	txstats.last_flush = txstats.depth;
+	txstats.depth = 0;
+}
+
+/* Queues an IP packet with its checksum already computed */
+
+void
+txqueue_ip(const struct ip_hdr *ip, u_int iplen)
+{
+	struct txentry *entry = &txq[txstats.depth], large;
+
+	/*
+	 * Forwarded packets may come from captures with jumbo frames or
+	 * offloading.  Send them right away, after what is queued.
+	 */
+	if (iplen > TXQUEUE_BUFSIZE) {
+		txqueue_flush();
+
+		memset(&large, 0, sizeof(large));
+		large.fd = -1;
+		large.len = large.iplen = iplen;
+		txqueue_send_single(&large, (const u_char *)ip);
+		txstats.packets++;
+		return;
+	}
+
+	entry->fd = txq_fd;
+	entry->ethernet = 0;
+	entry->inter = NULL;
+	entry->len = entry->iplen = iplen;
+	memset(&entry->sin, 0, sizeof(entry->sin));
+	entry->sin.sin_family = AF_INET;
+	entry->sin.sin_addr.s_addr = ip->ip_dst;
+	memcpy(txbuf[txstats.depth], ip, iplen);
+
+	txstats.depth++;
+	txqueue_schedule();
+}
+
+/* Encapsulates a packet into Ethernet and queues it for the interface */
+
+void
+txqueue_ether(struct interface *inter, const struct addr *dst_mac,
+    const struct addr *src_mac, int eth_type, const void *pkt, u_int iplen)
+{
+	struct txentry *entry = &txq[txstats.depth];
+	u_char *buf = txbuf[txstats.depth];
+	u_int len = ETH_HDR_LEN + iplen;
+
+	if (len > TXQUEUE_BUFSIZE) {
+		syslog(LOG_WARNING, "%s: IP packet is larger than buffer: %d",
+		    __func__, len);
+		return;
+	}
+
+	entry->fd = inter->if_txfd;
+	entry->ethernet = 1;
+	entry->inter = inter;
+	entry->len = len;
+	entry->iplen = iplen;
+	eth_pack_hdr(buf, dst_mac->addr_eth, src_mac->addr_eth, eth_type);
+	memcpy(buf + ETH_HDR_LEN, pkt, iplen);
+
+	txstats.depth++;
+	txqueue_schedule();
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2003-2007 Niels Provos <provos@citi.umich.edu>
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _TXQUEUE_
+#define _TXQUEUE_
+
+/*
+ * Outgoing packets are gathered during an iteration of the event loop
+ * and handed to the kernel in batches.  The queue keeps packets in the
+ * order in which they were sent.
+ */
+
+#define TXQUEUE_MAX		64
+#define TXQUEUE_BUFSIZE		(HONEYD_MTU + 40)
+
+struct txstats {
+	uint64_t packets;	/* packets passed to the kernel */
+	uint64_t flushes;	/* number of times the queue was drained */
+	uint64_t syscalls;	/* send calls needed for the flushes */
+	uint64_t errors;
+
+	u_int depth;		/* packets currently queued */
+	u_int max_depth;
+	u_int last_flush;	/* size of the most recent flush */
+};
+
+struct interface;
+struct addr;
+
+void txqueue_init(ip_t *);
+void txqueue_ip(const struct ip_hdr *, u_int);
+void txqueue_ether(struct interface *, const struct addr *,
+    const struct addr *, int, const void *, u_int);
+void txqueue_flush(void);
+
+extern struct txstats txstats;
+
+#endif /* _TXQUEUE_ */
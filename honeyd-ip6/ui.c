@@ -58,6 +58,8 @@
 
 #include "ui.h"
 #include "parser.h"
+#include "pool.h"
+#include "randomipv6.h"
 #ifdef HAVE_PYTHON
 #include "pyextend.h"
 #endif
@@ -71,6 +73,8 @@ char *strnsep(char **, char *);
 
 int ui_command_help(struct evbuffer *, char *);
 int ui_command_python(struct evbuffer *, char *);
+int ui_command_pools(struct evbuffer *, char *);
+int ui_command_random(struct evbuffer *, char *);
 
 struct command {
 	char *cmd;
@@ -92,6 +96,18 @@ struct command commands[] = {
 		"! <command >",
 		ui_command_python
 	},
+	{
+		"pools",
+		"pools\t\t shows memory usage of the allocation pools\n",
+		"pools\n",
+		ui_command_pools
+	},
+	{
+		"random",
+		"random\t\t shows the templates of the random IPv6 mode\n",
+		"random\n",
+		ui_command_random
+	},
 	{
 		"delete",
 		"delete\t\t removes configured templates and ports\n",
@@ -172,6 +188,44 @@ ui_command_python(struct evbuffer *buf, char *line)
 	return (0);
 }
 
+int
+ui_command_random(struct evbuffer *buf, char *line)
+{
+	struct randomipv6_stats stats;
+
+	randomipv6_stats(&stats);
+
+	evbuffer_add_printf(buf, "templates: %u", stats.active);
+	if (stats.limit)
+		evbuffer_add_printf(buf, " of %u", stats.limit);
+	evbuffer_add_printf(buf, "\ncreated: %llu (%llu shared)\n"
+	    "reclaimed: %llu idle, %llu for memory\nrefused: %llu\n",
+	    (unsigned long long)stats.created,
+	    (unsigned long long)stats.shared,
+	    (unsigned long long)stats.reclaimed_idle,
+	    (unsigned long long)stats.reclaimed_memory,
+	    (unsigned long long)stats.refused);
+
+	return (0);
+}
+
+int
+ui_command_pools(struct evbuffer *buf, char *line)
+{
+	struct pool *pool;
+
+	evbuffer_add_printf(buf, "%-12s %6s %8s %8s %6s %8s %8s\n",
+	    "pool", "size", "inuse", "high", "pages", "released", "failures");
+	TAILQ_FOREACH(pool, &pools, next) {
+		evbuffer_add_printf(buf, "%-12s %6u %8u %8u %6u %8u %8u\n",
+		    pool->name, (u_int)pool->size, pool->inuse,
+		    pool->highwater, pool->npages,
+		    pool->released, pool->failures);
+	}
+
+	return (0);
+}
+
 int
 ui_command_help(struct evbuffer *buf, char *line)
 {
@@ -399,3 +453,15 @@ ui_init(void)
 	event_priority_set(&ev_accept, 0);
 	event_add(&ev_accept, NULL);
 }
+
+/* Workers leave the management socket to the master process */
+
+void
+ui_close(void)
+{
+	if (!event_initialized(&ev_accept))
+		return;
+
+	event_del(&ev_accept);
+	close(EVENT_FD(&ev_accept));
+}
@@ -45,6 +45,7 @@ struct uiclient {
 };
 
 void ui_init(void);
+void ui_close(void);
 
 #define UI_FIFO		"/var/run/honeyd.sock"
 